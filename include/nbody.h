@@ -12,20 +12,144 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <stdint.h>
 #include <time.h>
+#include <pthread.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
 
 /* ============================================================================
  * SIMULATION PARAMETERS
  * ============================================================================ */
-#define WIDTH 800              // Image width in pixels
-#define HEIGHT 800             // Image height in pixels
-#define MAX_BODIES 20          // Maximum number of gravitating bodies
-#define MAX_ROCKETS 10         // Maximum number of rockets
+#define WIDTH 800              // Default image width in pixels (config.txt: width)
+#define HEIGHT 800             // Default image height in pixels (config.txt: height)
+#define VIEW_SCALE 50.0        // Pixels per unit at the default image size
+#define MAX_IMAGE_SIZE 16384   // Largest accepted image width or height
+#define RASTER_TILE 64         // Tile edge in pixels of the threaded rasterizer
+#define RASTER_BATCH 16384     // Primitives queued before the rasterizer draws them
+
+/* Rasterizer primitives */
+#define RASTER_NONE 0          // Placeholder, draws nothing
+#define RASTER_LINE 1          // Bresenham line (x0, y0) - (x1, y1)
+#define RASTER_CIRCLE 2        // Filled circle at (x0, y0), radius x1
+#define BMP_HEADER_SIZE 54     // File + info header of a 24-bit BMP
+#define INITIAL_CAPACITY 16    // Starting array capacity before growth
+#define SOA_ALIGNMENT 64       // Byte alignment of structure-of-arrays columns
+#define BODY_CHUNK 64          // Bodies per work item in the threaded step
+#define ROCKET_CHUNK 1024      // Rockets per work item (multiple of SIMD width)
+#define THETA 0.5              // Default Barnes-Hut opening angle
+#define BH_LEAF_SIZE 8         // Max bodies per Barnes-Hut leaf cell
+
+/* Gravity solvers (config.txt: solver=direct|bh) */
+#define SOLVER_DIRECT 0        // O(N^2) pairwise sum
+#define SOLVER_BH 1            // O(N log N) Barnes-Hut quadtree
+
+/* Integrators (config.txt: integrator=kdk|euler) */
+#define INTEGRATOR_KDK 0       // Kick-drift-kick leapfrog, one force pass per step
+#define INTEGRATOR_EULER 1     // Semi-implicit (symplectic) Euler
+
+/* Force arithmetic (config.txt: precision=double|mixed|float; positions stay double) */
+#define PRECISION_DOUBLE 0     // Double throughout (reference results)
+#define PRECISION_MIXED 1      // Differences taken in double, rest in float
+#define PRECISION_FLOAT 2      // Positions rounded to float, all float
+
+/* Rocket block time-steps (config.txt: block_steps=1, KDK only) */
+#define BLOCK_MAX_LEVEL 10     // Finest rocket step is dt / 2^BLOCK_MAX_LEVEL
+#define BLOCK_ETA 0.02         // Default accuracy parameter for dt_i = eta |a| / |j|
+
+/* OpenMP num_threads() argument for a config thread count (0 = serial) */
+#define OMP_THREADS(t) ((t) > 0 ? (t) : 1)
 #define DT 0.01                // Default time step
 #define STEPS 5000             // Default total steps
 #define FRAMES 100             // Default number of frames
 #define G 1.0                  // Default gravitational constant
 #define SOFTENING 0.1          // Softening parameter
+#define ESCAPE_RADIUS 50.0     // Default escape_radius: rockets beyond it are deactivated
+#define TRAIL_WINDOW 5000      // Trail points kept in memory per rocket (rendering)
+#define TRAIL_CHUNK 256        // Trail points per chunk written by the trail sink
+
+/* Render modes (config.txt: render_mode=full|incremental|density) */
+#define RENDER_FULL 0          // Redraw every trail from its first point each frame
+#define RENDER_INCREMENTAL 1   // Persistent trail layer, only new segments drawn
+#define RENDER_DENSITY 2       // Log heatmap of rocket positions, no trails or markers
+#define DENSITY_SUBPIXEL 16    // Splat weight steps per pixel and axis (256 per rocket)
+#define GRID_LEVEL 20          // Grid line brightness
+#define TRAIL_DECAY 0.99       // Default per-frame fade of the incremental trail layer
+#define TRAIL_FADE_FRAMES 1024 // Fade table length; older trail pixels use the last entry
+
+/* Asynchronous frame output (config.txt: frame_threads, frame_buffers) */
+#define FRAME_THREADS 1        // Default frame worker threads (0 = render inline)
+#define FRAME_BUFFERS 4        // Default snapshots in flight before stepping waits
+#define FRAME_SLOT_FREE 0      // Slot available to the simulation thread
+#define FRAME_SLOT_READY 1     // Snapshot taken, waiting for a worker
+#define FRAME_SLOT_BUSY 2      // Being rendered and written
+
+/* Frame output (config.txt: video_output=bmp|ffmpeg|y4m) */
+#define VIDEO_BMP 0            // One frame_XXXX.bmp file per frame
+#define VIDEO_FFMPEG 1         // Raw frames piped into an ffmpeg subprocess
+#define VIDEO_Y4M 2            // YUV4MPEG2 stream to a file or stdout
+#define VIDEO_FPS 30           // Default video frame rate
+
+/* Trajectory file format v2 (rocket_trails.bin, see trail_io.c) */
+#define TRAIL_MAGIC "NBTRAIL"  // 8 bytes including the terminating NUL
+#define TRAIL_VERSION 2        // Current trajectory file version
+#define TRAIL_ALIGN 64         // Byte alignment of every column in the file
+
+/* Checkpoints (config.txt: checkpoint_interval, checkpoint_file; see checkpoint.c) */
+#define CHECKPOINT_MAGIC "NBCKPT"  // 8 bytes including the terminating NUL
+#define CHECKPOINT_VERSION 2       // Current checkpoint layout
+#define CHECKPOINT_FILE "checkpoint.bin" // Default checkpoint file
+
+/* Rocket events (config.txt: escape_radius, collision_radius, region, events_file;
+ * see events.c) */
+#define EVENT_ESCAPE 0             // Left the escape_radius circle around the origin
+#define EVENT_COLLISION 1          // Came within collision_radius of a body
+#define EVENT_REGION 2             // Entered a region= rectangle
+#define EVENT_KINDS 3
+#define EVENT_MAX_REGIONS 8        // region= rectangles per run
+#define EVENTS_FILE "events.csv"   // Default event log
+#define EVENT_GRID_MIN 16          // Bodies from which collisions are culled on a grid
+#define LIVE_GATHER_FRACTION 8     // Force kernels see only live rockets once 1/8 are inactive
+
+/* Bodies and rockets input files (text or binary; see input.c) */
+#define INPUT_MAGIC "NBINPUT"      // 8 bytes including the terminating NUL
+#define INPUT_VERSION 1            // Current binary input layout
+#define INPUT_BODY_FIELDS 5        // x y vx vy mass
+#define INPUT_ROCKET_FIELDS 4      // x y vx vy
+
+/* Command line (see main.c) */
+#define PATH_LEN 256               // Longest input or output path
+#define MODE_PROMPT 0              // Ask N/L on a terminal, simulate otherwise
+#define MODE_SIMULATE 1            // --mode simulate
+#define MODE_REPLAY 2              // --mode replay
+
+/* Headers of final_rockets.txt and rocket_stats.csv (single, batch and distributed runs) */
+#define ROCKET_DATA_HEADER "# Rocket_ID   Final_X   Final_Y   Final_VX   Final_VY   Trail_Length\n"
+#define TRAJECTORY_STATS_HEADER "RocketID,TrailLength,FinalDistance,MaxDistance,AverageSpeed\n"
+
+/* Distributed runs (bin/nbody_mpi, built by make mpi; see distributed.c) */
+#define DISTRIBUTED_ALIGN 16       // Rocket shares are multiples of this (whole SIMD vectors)
+#define DISTRIBUTED_CHUNK (1 << 26) // Doubles per MPI_Bcast() of the ephemeris
+
+/* Batch mode (nbody --batch <manifest>, see batch.c) */
+#define BATCH_STATS_FILE "batch_stats.csv"   // Summary rows of every scenario
+#define EPHEMERIS_MAX_BYTES (256L << 20)     // Largest in-memory body ephemeris
+
+/* Body ephemeris files (config.txt: ephemeris_file, ephemeris_stride; see ephemeris.c) */
+#define EPHEMERIS_MAGIC "NBEPHEM"  // 8 bytes including the terminating NUL
+#define EPHEMERIS_VERSION 1        // Current ephemeris file layout
+#define EPHEMERIS_DATA_OFFSET 128  // Records start after the header, 64-byte aligned
+
+/* Phase timers (make PROFILE=0 compiles them out; config.txt: timing_file; see profile.c) */
+#define PROFILE_BODY_FORCES 0      // Body accelerations (direct or Barnes-Hut)
+#define PROFILE_ROCKET_FORCES 1    // Rocket accelerations
+#define PROFILE_INTEGRATE 2        // Kicks, drifts, ephemeris lookups, rocket events
+#define PROFILE_TRAILS 3           // Trail recording and spooling
+#define PROFILE_RENDER 4           // Frame rendering (or snapshots for the pipeline)
+#define PROFILE_BMP 5              // BMP and video frame writes
+#define PROFILE_PHASES 6
 
 /* ============================================================================
  * DATA STRUCTURES
@@ -53,15 +177,532 @@ typedef struct {
     double *trail_y;  // Array to store Y positions
     int trail_length; // Current length of trail
     int trail_capacity; // Maximum capacity of trail arrays
+    int trail_flushed;  // Leading trail points already written by the trail sink
+    int trail_dropped;  // Points slid out of the in-memory window
+    int trail_skipped;  // Sampled positions not stored (trail_stride, trail_tolerance)
+    int trail_tip;      // 1 if the last trail point is the provisional current position
+    double trail_anchor_x, trail_anchor_y; // Last fixed point before the tip
+    double trail_dir_x, trail_dir_y;       // Direction of the segment leaving the anchor
+    double dropped_path;     // Path length covered by the dropped points
+    double dropped_max_dist; // Max distance from origin over the dropped points
 } Rocket;
 
+/**
+ * Structure-of-arrays particle storage used by the physics kernels
+ * Each field is a separate contiguous, SOA_ALIGNMENT-aligned column so
+ * the force loops only stream the data they actually touch
+ */
+typedef struct {
+    double *x, *y;          // Positions
+    double *vx, *vy;        // Velocities
+    double *ax, *ay;        // Accelerations
+    double *mass;           // Masses (zero for rockets)
+    unsigned char *active;  // 1 if particle is integrated (always 1 for bodies)
+    int n;                  // Number of particles in use
+    int capacity;           // Allocated slots per column
+} ParticleSoA;
+
+/**
+ * Rectangle watched for rockets entering it (config.txt: region=)
+ */
+typedef struct {
+    double x0, y0;          // Lower corner
+    double x1, y1;          // Upper corner
+    int stop;               // 1 = rockets entering are deactivated
+} EventRegion;
+
+/**
+ * One detected rocket event
+ */
+typedef struct {
+    int64_t step;           // Step after which it was detected (counted from 1)
+    double time;
+    int rocket;
+    int kind;               // EVENT_ESCAPE, EVENT_COLLISION or EVENT_REGION
+    int detail;             // Body (collision) or region index, -1 otherwise
+    double x, y;            // Rocket position
+    double distance;        // From the origin (escape) or the body (collision)
+} RocketEvent;
+
+/**
+ * Asynchronous event writer
+ * The simulation thread queues each step's events; a writer thread
+ * formats them into the events CSV (and the console), so detection never
+ * waits on stdio.
+ */
+typedef struct EventLog {
+    FILE *out;              // Events CSV (NULL = console only)
+    int console;            // 1 = one console line per event
+    RocketEvent *queue;     // Events not yet taken by the writer
+    int n_queued;
+    int capacity;
+    int busy;               // Writer is formatting a batch
+    int stopping;           // Writer exits once the queue is empty
+    int rocket_offset;      // Added to rocket numbers (distributed shards)
+    long long written;      // Events written so far
+    pthread_mutex_t lock;
+    pthread_cond_t ready;   // Signalled when events are queued or on stop
+    pthread_cond_t idle;    // Signalled when the writer has caught up
+    pthread_t thread;
+} EventLog;
+
+/**
+ * Event detection state and the dense list of live rockets
+ * The live list is rebuilt from the active flags after sim_state_pack()
+ * and filtered in place by every detection pass, so the per-step loops
+ * over rockets visit only live ones.
+ */
+typedef struct {
+    int *live;              // Indices of the active rockets, ascending
+    int n_live;
+    int live_capacity;
+    int live_valid;         // 0 = rebuild before the next step
+    ParticleSoA dense;      // Live rocket positions gathered for the force kernels
+    uint8_t *inside;        // Per rocket: bit k set while inside region k
+    int inside_capacity;
+    RocketEvent *pending;   // Events of the current step
+    int n_pending;
+    int pending_capacity;
+    int *grid_start;        // Collision grid: bucket starts (grid_mask + 2)
+    int *grid_body;         // Body indices grouped by bucket
+    int grid_mask;          // Buckets - 1 (power of two)
+    int grid_capacity;      // Allocated buckets + 2
+    int grid_bodies;        // Allocated grid_body slots
+    int64_t steps;          // Detection passes so far
+    int64_t counts[EVENT_KINDS]; // Events so far by kind
+    EventLog *log;          // Asynchronous writer (NULL = events only counted)
+} RocketEvents;
+
+/**
+ * Barnes-Hut quadtree cell
+ * Covers a contiguous range of the Morton-sorted body order
+ */
+typedef struct {
+    double com_x, com_y;   // Centre of mass
+    double mass;           // Total mass in the cell
+    double size;           // Cell side length
+    int first;             // First position in QuadTree.order
+    int count;             // Number of bodies in the cell
+    int child[4];          // Child node indices (-1 if empty)
+    int is_leaf;           // 1 if bodies are summed directly
+} QuadNode;
+
+/**
+ * Barnes-Hut quadtree over the bodies (storage reused between builds)
+ */
+typedef struct {
+    QuadNode *nodes;       // Node array, root at index 0
+    int n_nodes;
+    int node_capacity;
+    int *order;            // Body indices in Morton order
+    int *rank;             // Position of each body in `order`
+    int index_capacity;
+} QuadTree;
+
+/**
+ * Trajectory file header (v2), 64 bytes at offset 0
+ */
+typedef struct {
+    char magic[8];          // TRAIL_MAGIC
+    uint32_t version;       // TRAIL_VERSION
+    uint32_t elem_size;     // Bytes per coordinate: 8 (float64) or 4 (float32)
+    uint64_t n_rockets;     // Entries in the index
+    uint64_t index_offset;  // Byte offset of TrailIndexEntry[n_rockets]
+    uint64_t data_offset;   // Byte offset of the first column
+    uint64_t reserved[3];   // Zero
+} TrailFileHeader;
+
+/**
+ * Checkpoint file header
+ * Counters of the driving loop (step, frame, output file offsets) are
+ * filled in by the caller, simulation fields by checkpoint_save().
+ * Followed by SimConfig, Body[n_bodies], then per rocket the Rocket
+ * record and its trail window, block time-step levels and the
+ * incremental trail layer when present.
+ */
+typedef struct {
+    char magic[8];          // CHECKPOINT_MAGIC
+    uint32_t version;       // CHECKPOINT_VERSION
+    uint32_t config_size;   // sizeof(SimConfig), sizeof(Body), sizeof(Rocket):
+    uint32_t body_size;     // the file is only read back by a build with the
+    uint32_t rocket_size;   // same layout
+    int64_t step;           // Next step to run
+    int64_t frame_num;      // Next frame number
+    double time;            // Simulated time
+    double initial_energy;  // Body energy at step 0 (for the drift report)
+    int32_t n_bodies;
+    int32_t n_rockets;
+    int32_t forces_valid;   // KDK accelerations match the positions
+    int32_t has_levels;     // Block time-step levels follow the rockets
+    int64_t force_evals;    // Block time-step force evaluations so far
+    int64_t spool_offset;   // Trail spool bytes covered (-1 = no trail sink)
+    int64_t spool_points;   // Points in those bytes
+    int64_t log_offset;     // frames.log bytes (-1 = no log)
+    int64_t video_offset;   // Y4M file bytes (-1 = no resumable video file)
+    int64_t video_frames;   // Video frames written
+    int64_t canvas_offset;  // File offset of the trail layer (0 = none)
+    int64_t events_offset;  // Events CSV bytes (-1 = no events file)
+    int64_t event_steps;    // Detection passes so far
+    int64_t event_counts[EVENT_KINDS]; // Events so far by kind
+} CheckpointHeader;
+
+/**
+ * Per-rocket index entry: where the rocket's x and y columns start
+ */
+typedef struct {
+    uint64_t x_offset;      // Byte offset of x[length], TRAIL_ALIGN-aligned
+    uint64_t y_offset;      // Byte offset of y[length], TRAIL_ALIGN-aligned
+    uint64_t length;        // Points in the trail
+} TrailIndexEntry;
+
+/**
+ * Read-only memory-mapped trajectory file
+ */
+typedef struct {
+    const unsigned char *base;      // Start of the mapping
+    size_t size;                    // Mapped bytes
+    const TrailFileHeader *header;
+    const TrailIndexEntry *index;
+} TrailFile;
+
+/**
+ * Running statistics of one trail (see trail_stats.c)
+ * Points are added in chunks; a chunk continues the path of the last
+ */
+typedef struct {
+    long points;            // Points added so far
+    double path_length;     // Sum of the segment lengths
+    double min_d2, max_d2;  // Squared distance from the origin, smallest and largest
+    double min_x, max_x;    // Bounding box
+    double min_y, max_y;
+    double first_x, first_y; // First point added
+    double last_x, last_y;   // Last point added
+} TrailStats;
+
+/**
+ * Streaming trail writer
+ * Trail chunks are appended to a spool file during the run and turned
+ * into the final trail file on close, so trails are not capped by the
+ * in-memory window and a crash keeps everything flushed so far.
+ */
+typedef struct TrailSink {
+    FILE *spool;            // Chunk records, appended during the run
+    char path[256];         // Final trail file
+    char spool_path[264];   // path + ".part"
+    int n_rockets;          // Rockets covered by the sink
+    int precision;          // Bits per stored coordinate in the final file (64/32)
+    long long points;       // Points written so far
+} TrailSink;
+
+/**
+ * Body positions over a run (see ephemeris.c)
+ * Rockets are massless, so the bodies follow the same trajectory in
+ * every run that starts from the same bodies with the same step, solver
+ * and integrator. Record k holds the bodies after k * stride steps:
+ * x[n], y[n] with stride 1, x[n], y[n], vx[n], vy[n] (for cubic Hermite
+ * interpolation between records) with a larger stride.
+ */
+typedef struct BodyEphemeris {
+    const double *records;  // n_records records of `record` doubles
+    double *data;           // Owned storage of a built ephemeris (NULL if mapped)
+    void *map;              // Read-only mapping of an ephemeris file
+    size_t map_size;
+    int n_bodies;
+    int steps;              // Steps covered
+    int stride;             // Steps between records (1 = every step, exact)
+    int record;             // Doubles per record
+    long n_records;
+    double dt;              // Step length, for interpolation
+} BodyEphemeris;
+
+/**
+ * A saved run opened for replay (see replay.c)
+ * Trails are read in place from the mapped trajectory file; trail point
+ * k of a rocket is its position after k * trail_stride steps
+ */
+typedef struct {
+    TrailFile trails;
+    BodyEphemeris ephemeris; // Body positions, at least at every frame step
+    Body *bodies;            // Initial bodies (masses and count)
+    int n_bodies;
+    int n_rockets;
+    int steps;               // Steps of the recorded run
+    int frame_interval;      // Steps between frames
+    int n_frames;            // Frames of the recorded run
+    int trail_stride;        // Steps between trail points
+} Replay;
+
+/**
+ * Binary bodies or rockets file header (32 bytes, values follow)
+ * Written by input_write(); load_bodies() and load_rockets() detect it
+ */
+typedef struct {
+    char magic[8];          // INPUT_MAGIC
+    uint32_t version;       // INPUT_VERSION
+    uint32_t fields;        // Doubles per entity (INPUT_BODY_FIELDS or INPUT_ROCKET_FIELDS)
+    uint64_t count;         // Entities
+    uint64_t reserved;      // Zero
+} InputHeader;
+
+/**
+ * Ephemeris file header (128 bytes, records follow at data_offset)
+ * A file is reused only by runs with the same bodies and dynamics
+ */
+typedef struct {
+    char magic[8];          // EPHEMERIS_MAGIC
+    uint32_t version;       // EPHEMERIS_VERSION
+    uint32_t n_bodies;
+    int32_t steps;          // Steps covered
+    int32_t stride;         // Steps between records
+    uint32_t record;        // Doubles per record
+    int32_t integrator;     // Dynamics the trajectory was computed with
+    int32_t solver;
+    uint32_t precision;     // PRECISION_* of the body forces
+    double dt;
+    double g;
+    double theta;
+    uint64_t body_hash;     // FNV-1a hash of the initial bodies
+    uint64_t data_offset;   // Byte offset of record 0
+    uint64_t n_records;
+    uint64_t reserved[5];   // Zero
+} EphemerisHeader;
+
+/**
+ * Per-rocket power-of-two block time-step schedule
+ * Rocket i steps with dt / 2^level[i]; blocks are aligned to their own
+ * length, so every block ends on a global step boundary.
+ */
+typedef struct {
+    unsigned char *level;   // Time-step level per rocket
+    int *order;             // Live rockets of the step, finest level first
+    int *due;               // Scratch for re-sorting the due rockets
+    int count[BLOCK_MAX_LEVEL + 1]; // Rockets of `order` on each level
+    int capacity;           // Allocated entries in level/order/due
+    ParticleSoA due_soa;    // Compacted due rockets for the force kernel
+    ParticleSoA body_pred;  // Bodies predicted to the current tick
+    long long force_evals;  // Rocket force evaluations so far
+} BlockSteps;
+
+/**
+ * Per-phase wall-clock totals of a run
+ * Timers nest: a phase records its own time only, so force evaluations
+ * inside a step are not counted again as integration.
+ */
+typedef struct Profile {
+    double seconds[PROFILE_PHASES];  // Time spent in each phase
+    double offload[PROFILE_PHASES];  // Time spent on frame worker threads
+    double nested;          // Time already recorded by finished timers
+    double start;           // profile_init() time
+    long long interactions; // Pairwise force evaluations (direct-sum count)
+    FILE *csv;              // Per-frame timing rows (NULL = none)
+    double frame_seconds[PROFILE_PHASES]; // Totals at the last CSV row
+    double frame_start;     // Time of the last CSV row
+} Profile;
+
+/*
+ * Scoped timers: PROFILE_BEGIN declares the start variable `t`,
+ * PROFILE_END adds the time since then to `phase`. Both do nothing when
+ * `p` is NULL and compile to nothing without NBODY_PROFILE.
+ */
+#ifdef NBODY_PROFILE
+#define PROFILE_BEGIN(p, t) double t = (p) ? profile_begin(p) : 0.0
+#define PROFILE_END(p, t, phase) do { if (p) profile_end((p), (phase), (t)); } while (0)
+#define PROFILE_COUNT(p, pairs) do { if (p) (p)->interactions += (pairs); } while (0)
+#else
+#define PROFILE_BEGIN(p, t) ((void)(p))
+#define PROFILE_END(p, t, phase) ((void)(p))
+#define PROFILE_COUNT(p, pairs) ((void)(p))
+#endif
+
+/**
+ * Simulation state: heap-backed, growable body and rocket arrays
+ * The Body/Rocket arrays are the AoS view used for I/O and rendering;
+ * body_soa/rocket_soa hold the hot data the physics kernels run on.
+ * Use sim_state_pack() and sim_state_unpack() to sync the two views.
+ */
+typedef struct {
+    Body *bodies;        // Array of gravitating bodies
+    int n_bodies;        // Number of bodies in use
+    int body_capacity;   // Allocated body slots
+    Rocket *rockets;     // Array of rockets
+    int n_rockets;       // Number of rockets in use
+    int rocket_capacity; // Allocated rocket slots
+    ParticleSoA body_soa;   // Physics storage for bodies
+    ParticleSoA rocket_soa; // Physics storage for rockets
+    QuadTree tree;          // Barnes-Hut tree (solver=bh)
+    int forces_valid;       // SoA accelerations match current positions (KDK)
+    BlockSteps blocks;      // Rocket block time-steps (block_steps=1)
+    double time;            // Simulated time
+    struct TrailSink *trail_sink; // Streaming trail writer (NULL = memory only)
+    const struct BodyEphemeris *ephemeris; // Body positions per step (NULL = integrate bodies)
+    int ephemeris_step;     // Steps taken against the ephemeris
+    Profile *profile;       // Phase timers (NULL = not timed)
+    RocketEvents events;    // Escape, collision and region detection
+} SimState;
+
+/**
+ * Rocket force kernel operating on rockets [begin, end)
+ */
+typedef void (*RocketForceKernel)(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                  double g, int begin, int end);
+
+/* Rocket force kernel kinds (see physics_simd.c) */
+#define KERNEL_AUTO   0        // Widest kernel supported by the CPU
+#define KERNEL_SCALAR 1        // Portable scalar reference kernel
+#define KERNEL_AVX2   2        // x86 AVX2 + FMA, 4 rockets per vector
+#define KERNEL_AVX512 3        // x86 AVX-512F, 8 rockets per vector
+#define KERNEL_NEON   4        // ARM NEON, 2 rockets per vector
+
+#define FIXED_BODIES_MAX 8     // Largest body count with specialized kernels
+
 /**
  * Pixel structure for BMP image format
+ * Three bytes in BMP channel order, so a row of pixels is a BMP row
  */
 typedef struct {
     unsigned char b, g, r;  // Blue, Green, Red color channels
 } Pixel;
 
+/**
+ * Where and how large the simulation is drawn
+ * World point (center_x, center_y) maps to the image center. Pixel
+ * (x, y) lives at img[y * stride + x], so a view can draw into part of a
+ * larger image.
+ */
+typedef struct {
+    int width, height;      // Image size in pixels
+    int stride;             // Pixels from one image row to the next (>= width)
+    double scale;           // Pixels per world unit
+    double center_x;        // World coordinates of the image center
+    double center_y;
+} Viewport;
+
+/**
+ * One queued line or circle, in image pixels
+ */
+typedef struct {
+    int x0, y0;             // Line start, or circle center
+    int x1, y1;             // Line end; x1 is the circle radius
+    int kind;               // RASTER_LINE, RASTER_CIRCLE or RASTER_NONE
+    Pixel color;
+} RasterPrim;
+
+/**
+ * Tiled rasterizer: primitives queued in drawing order, binned into
+ * screen tiles and drawn tile-parallel when the queue is flushed
+ */
+typedef struct {
+    Pixel *img;             // Target image
+    Viewport view;          // Image size and stride
+    int threads;            // Drawing threads (1 = one tile, no binning)
+    int tile_size;          // Tile edge in pixels
+    int tiles_x, tiles_y, n_tiles;
+    RasterPrim *prims;      // Queued primitives
+    int n_prims;
+    int capacity;
+    long *counts;           // threads * n_tiles: per-chunk tile counts, then offsets
+    long *tile_start;       // n_tiles + 1: start of each tile's bin
+    int *bins;              // Primitive indices grouped by tile, in drawing order
+    long bin_capacity;
+} Rasterizer;
+
+/**
+ * Persistent trail layer for incremental rendering
+ * Each pixel remembers the frame it was last drawn in; brightness is
+ * looked up from its age when a frame is composited, so fading costs
+ * nothing until the image is built and never stalls on 8-bit rounding.
+ */
+typedef struct {
+    uint32_t *stamp;        // width * height: frame a pixel was last drawn (0 = never)
+    uint32_t frame;         // Current frame, counted from 1
+    int width, height;      // Layer size (the viewport it was created for)
+    unsigned char *rows;    // Per row: 1 if any pixel of the row has been drawn
+    unsigned char fade[TRAIL_FADE_FRAMES]; // Trail brightness by age in frames
+    long *drawn;            // Per rocket: trail points already rasterized (absolute)
+    int n_rockets;
+} TrailCanvas;
+
+/**
+ * Density render buffers (render_mode=density)
+ * Each thread splats into its own fixed-point accumulation buffer, so no
+ * atomics are needed and integer sums make the image independent of the
+ * thread count. The buffers are all zero between frames.
+ */
+typedef struct {
+    uint32_t *acc;          // threads * width * height splat weights (256 = one rocket)
+    int width, height;      // Buffer size (the viewport it was created for)
+    int threads;            // Splat threads, one buffer each
+    Pixel lut[256];         // Colour by log density
+} DensityMap;
+
+/**
+ * Streaming video output (ffmpeg pipe or Y4M file/stdout)
+ */
+typedef struct {
+    FILE *out;              // Encoder pipe or stream file
+    int kind;               // VIDEO_FFMPEG or VIDEO_Y4M
+    int is_pipe;            // 1 if `out` came from popen()
+    int is_file;            // 1 for a Y4M file (can be resumed after a checkpoint)
+    int width, height;      // Frame size
+    unsigned char *planes;  // Y4M: Y, Cb, Cr planes of one frame
+    long frames;            // Frames written
+} VideoSink;
+
+/**
+ * One frame in flight: a private copy of everything render() reads
+ * Trail pointers in `rockets` point into this slot's trail storage
+ */
+typedef struct {
+    int state;              // FRAME_SLOT_FREE, _READY or _BUSY
+    char filename[PATH_LEN]; // Output file for this frame
+    Body *bodies;           // Body snapshot
+    int n_bodies;
+    int body_capacity;
+    Rocket *rockets;        // Rocket snapshot
+    int n_rockets;
+    int rocket_capacity;
+    double *trail_x;        // Trail points of all rockets, back to back
+    double *trail_y;
+    long trail_capacity;    // Allocated points in trail_x/trail_y
+    TrailCanvas layer;      // Incremental trail layer copy (stamp, rows and fade)
+    int use_layer;          // 1 if this frame is composited over `layer`
+    int use_density;        // 1 if this is a density frame of `n_points` positions
+    int n_points;           // Density frames: active rocket positions in trail_x/trail_y
+    DensityMap density;     // Density buffers (allocated by the worker on first use)
+    long long seq;          // Submission order (video frames are written in order)
+    Pixel *img;             // Render target
+} FrameSlot;
+
+/**
+ * Producer/consumer frame pipeline
+ * The simulation thread fills slots in ring order and only waits when
+ * the next slot is still in flight; workers take ready slots oldest
+ * first, render them and write the BMP, or append them to the video
+ * stream in submission order.
+ */
+typedef struct {
+    FrameSlot *slots;       // Ring of preallocated frames
+    int n_slots;
+    int head;               // Next slot to fill
+    int tail;               // Next slot to hand to a worker
+    pthread_mutex_t lock;
+    pthread_cond_t slot_free;   // Signalled when a worker finishes a frame
+    pthread_cond_t slot_ready;  // Signalled when a frame is submitted or on stop
+    pthread_cond_t written;     // Signalled when a video frame has been written
+    VideoSink *video;       // Video stream (NULL = one BMP file per frame)
+    long long next_seq;     // Sequence number of the next submitted frame
+    long long next_write;   // Next frame allowed into the video stream
+    pthread_t *workers;
+    int n_workers;
+    int stopping;           // Workers exit once the ring is drained
+    Viewport view;          // Frame size and projection (contiguous rows)
+    int render_threads;     // Rasterizer threads per frame
+    int failed;             // Frames dropped or not written
+    long long stalls;       // Submits that had to wait for a free slot
+    double render_seconds;  // Worker time rendering (PROFILE=1 builds)
+    double write_seconds;   // Worker time writing frames (PROFILE=1 builds)
+} FramePipeline;
+
 /**
  * Simulation configuration structure
  */
@@ -71,43 +712,157 @@ typedef struct {
     int frames;
     int save_interval;
     double g;
+    int threads;       // 0 = serial step, N > 0 = threaded step with N threads
+    int solver;        // SOLVER_DIRECT or SOLVER_BH
+    double theta;      // Barnes-Hut opening angle
+    int integrator;    // INTEGRATOR_KDK or INTEGRATOR_EULER
+    int precision;     // PRECISION_DOUBLE, PRECISION_MIXED or PRECISION_FLOAT
+    int block_steps;   // 1 = per-rocket block time-steps (KDK only)
+    double eta;        // Block time-step accuracy parameter
+    int trail_precision; // Bits per coordinate in rocket_trails.bin (64 or 32)
+    int trail_stride;    // Steps between trail samples (1 = every step)
+    double trail_tolerance; // Pixels a trail may deviate from the path (0 = keep every sample)
+    int frame_threads;   // Frame render/write threads (0 = synchronous)
+    int frame_buffers;   // Frame snapshots in the pipeline ring
+    int render_mode;     // RENDER_FULL, RENDER_INCREMENTAL or RENDER_DENSITY
+    double trail_decay;  // Incremental trail brightness kept per frame (0..1]
+    int video_output;    // VIDEO_BMP, VIDEO_FFMPEG or VIDEO_Y4M
+    char video_file[64]; // Video output file ("-" = stdout for y4m)
+    int video_fps;       // Video frame rate
+    int width, height;   // Image size in pixels
+    double scale;        // Pixels per unit (0 = VIEW_SCALE scaled to the image size)
+    double center_x;     // World point drawn at the image center
+    double center_y;
+    int render_threads;  // Tiled rasterizer threads per frame (1 = single thread)
+    int checkpoint_interval; // Steps between checkpoints (0 = none)
+    char checkpoint_file[64]; // Checkpoint written atomically and read by --resume
+    int batch_threads;   // Scenarios run at once by --batch (0 = all cores)
+    char ephemeris_file[64]; // Cached body ephemeris ("" = integrate the bodies)
+    int ephemeris_stride;    // Steps between stored body records (1 = exact)
+    char timing_file[64];    // Per-frame phase timings CSV ("" = none)
+    double escape_radius;    // Rockets beyond it are deactivated (0 = never)
+    double collision_radius; // Rockets this close to a body are deactivated (0 = never)
+    int n_regions;           // region= rectangles in use
+    EventRegion regions[EVENT_MAX_REGIONS];
+    char events_file[64];    // Event log CSV ("" = none)
+    int replay_first;        // First frame drawn by --mode replay
+    int replay_last;         // Last frame drawn by --mode replay (-1 = last of the run)
+    int replay_threads;      // Frames drawn at once by --mode replay (0 = all cores)
 } SimConfig;
 
+/**
+ * One body set of a batch: scenarios with the same bodies file and the
+ * same body dynamics (dt, steps, g, solver, theta, integrator, precision) share its
+ * parsed bodies and, without block time-steps, its ephemeris
+ */
+typedef struct {
+    char bodies_file[256];
+    SimConfig config;       // Settings the body trajectory depends on
+    Body *bodies;           // Parsed once, read-only while scenarios run
+    int n_bodies;
+    BodyEphemeris ephemeris;
+    int has_ephemeris;      // 1 if rockets step against the ephemeris
+    int scenarios;          // Scenarios using this set
+} BatchGroup;
+
+/**
+ * One scenario of a batch manifest line
+ */
+typedef struct {
+    char name[64];
+    char bodies_file[256];
+    char rockets_file[256];
+    SimConfig config;       // Base config.txt plus the line's key=value overrides
+    int group;              // Index of its BatchGroup
+    int n_rockets;          // Rockets loaded (-1 = scenario failed)
+    char *summary;          // CSV rows, until written in manifest order
+    size_t summary_size;
+    int done;               // 1 once the summary is ready
+} BatchScenario;
+
 /* ============================================================================
  * FUNCTION DECLARATIONS - bmp_io.c
  * ============================================================================ */
 
 /**
- * Write a 24-bit BMP image file
+ * Size in bytes of a 24-bit BMP file of w x h pixels
+ */
+long bmp_file_size(int w, int h);
+
+/**
+ * Encode an image as a complete BMP file into `out` (bmp_file_size bytes)
  */
-void write_bmp(const char *filename, Pixel *img, int w, int h);
+void bmp_encode(const Pixel *img, int w, int h, unsigned char *out);
+
+/**
+ * Write a 24-bit BMP image file with a single write (0 on success, -1 on error)
+ */
+int write_bmp(const char *filename, const Pixel *img, int w, int h);
 
 /* ============================================================================
  * FUNCTION DECLARATIONS - file_io.c
  * ============================================================================ */
 
 /**
- * Load celestial bodies from file
+ * Load celestial bodies from file, appending to the state
+ */
+int load_bodies(const char *filename, SimState *state);
+
+/**
+ * Load rockets from file, appending to the state
  */
-int load_bodies(const char *filename, Body *bodies, int max_bodies);
+int load_rockets(const char *filename, SimState *state);
 
 /**
- * Load rockets from file
+ * Fill a configuration with the compile-time defaults
  */
-int load_rockets(const char *filename, Rocket *rockets, int max_rockets);
+void sim_config_default(SimConfig *config);
 
 /**
  * Load simulation configuration
  */
 int load_config(const char *filename, SimConfig *config);
 
+/**
+ * Apply one key=value option (0 = known key, -1 = unknown or not a number)
+ */
+int config_set_option(SimConfig *config, const char *key, const char *text);
+
+/**
+ * Turn progress messages (loaders, savers, the configuration report and
+ * rocket escapes) off (1) or on (0); returns the previous setting
+ */
+int file_io_quiet(int quiet);
+
+/**
+ * 1 if only errors and warnings are printed
+ */
+int file_io_is_quiet(void);
+
+/**
+ * Print every loaded body and rocket (1) or only the totals (0);
+ * returns the previous setting
+ */
+int file_io_verbose(int verbose);
+
+/**
+ * Put `name` in directory `dir` ("" = current directory; absolute names
+ * and "-" are kept as they are)
+ */
+void output_path(char *path, size_t size, const char *dir, const char *name);
+
 /**
  * Save final rocket data
  */
 void save_rocket_data(const char *filename, Rocket *rockets, int n);
 
 /**
- * Save rocket trajectories in binary format
+ * Write final rocket data rows, numbered from `first_id`
+ */
+void write_rocket_data(FILE *f, const Rocket *rockets, int n, int first_id);
+
+/**
+ * Save rocket trajectories as a v2 trajectory file (float64 columns)
  */
 void save_rocket_trails_bin(const char *filename, Rocket *rockets, int n);
 
@@ -116,11 +871,49 @@ void save_rocket_trails_bin(const char *filename, Rocket *rockets, int n);
  */
 void save_trajectory_stats(const char *filename, Rocket *rockets, int n, double dt);
 
+/**
+ * Write trajectory statistics rows (prefixed with `scenario` unless NULL),
+ * numbered from `first_id`
+ */
+void write_trajectory_stats(FILE *f, const char *scenario, Rocket *rockets, int n, double dt,
+                            int first_id);
+
 /**
  * Save simulation metadata
  */
 void save_metadata(const char *filename, int n_bodies, int n_rockets, SimConfig *config);
 
+/* ============================================================================
+ * FUNCTION DECLARATIONS - input.c
+ * ============================================================================ */
+
+/**
+ * Parse the decimal number at `p` bitwise as strtod() would
+ * Returns the end of the number, or NULL if there is none
+ */
+const char *input_parse_double(const char *p, double *value);
+
+/**
+ * Read a text or binary bodies/rockets file of `fields` values per line;
+ * `values` is malloc()ed, returns the entity count or -1
+ */
+long input_read(FILE *f, const char *filename, int fields, double **values);
+
+/**
+ * Write `count` entities of `fields` doubles as a binary input file
+ */
+int input_write(const char *filename, const double *values, long count, int fields);
+
+/**
+ * Write bodies as a binary bodies file
+ */
+int input_write_bodies(const char *filename, const Body *bodies, int n);
+
+/**
+ * Write rockets as a binary rockets file
+ */
+int input_write_rockets(const char *filename, const Rocket *rockets, int n);
+
 /* ============================================================================
  * FUNCTION DECLARATIONS - init.c
  * ============================================================================ */
@@ -128,12 +921,92 @@ void save_metadata(const char *filename, int n_bodies, int n_rockets, SimConfig
 /**
  * Initialize bodies with default configuration
  */
-void init_bodies_default(Body *bodies, int *n);
+void init_bodies_default(SimState *state);
 
 /**
  * Initialize rockets with default configuration
  */
-void init_rockets_default(Rocket *rockets, int *n);
+void init_rockets_default(SimState *state);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - state.c
+ * ============================================================================ */
+
+/**
+ * Initialize an empty simulation state
+ */
+void sim_state_init(SimState *state);
+
+/**
+ * Reserve storage for at least `capacity` bodies
+ */
+int sim_state_reserve_bodies(SimState *state, int capacity);
+
+/**
+ * Reserve storage for at least `capacity` rockets
+ */
+int sim_state_reserve_rockets(SimState *state, int capacity);
+
+/**
+ * Append a zeroed body (NULL on allocation failure)
+ */
+Body *sim_state_add_body(SimState *state);
+
+/**
+ * Append a zeroed rocket (NULL on allocation failure)
+ */
+Rocket *sim_state_add_rocket(SimState *state);
+
+/**
+ * Allocate a rocket's in-memory trail window and record its position
+ * Returns 0 on success, -1 on allocation failure
+ */
+int rocket_trail_init(Rocket *rocket);
+
+/**
+ * Free all state memory, including rocket trails
+ */
+void sim_state_free(SimState *state);
+
+/**
+ * Copy the AoS body/rocket arrays into the SoA physics storage
+ */
+int sim_state_pack(SimState *state);
+
+/**
+ * Copy SoA physics storage back into the AoS body/rocket arrays
+ */
+void sim_state_unpack(SimState *state);
+
+/**
+ * Reserve aligned storage for at least `capacity` particles
+ */
+int soa_reserve(ParticleSoA *p, int capacity);
+
+/**
+ * Free all SoA columns
+ */
+void soa_free(ParticleSoA *p);
+
+/**
+ * Load a body array into SoA storage
+ */
+int soa_from_bodies(ParticleSoA *p, const Body *bodies, int n);
+
+/**
+ * Store SoA state back into a body array
+ */
+void soa_to_bodies(const ParticleSoA *p, Body *bodies);
+
+/**
+ * Load a rocket array into SoA storage
+ */
+int soa_from_rockets(ParticleSoA *p, const Rocket *rockets, int n);
+
+/**
+ * Store SoA state back into a rocket array (trails are untouched)
+ */
+void soa_to_rockets(const ParticleSoA *p, Rocket *rockets);
 
 /* ============================================================================
  * FUNCTION DECLARATIONS - physics.c
@@ -161,14 +1034,823 @@ void update_bodies(Body *bodies, int n, double dt, double g);
 void update_rockets(Rocket *rockets, int n_rockets, Body *bodies, 
                    int n_bodies, double dt, double g);
 
-/* ============================================================================
- * FUNCTION DECLARATIONS - render.c
- * ============================================================================ */
+/**
+ * Compute gravitational accelerations between bodies (SoA kernel)
+ */
+void compute_forces_soa(ParticleSoA *bodies, double g);
 
 /**
- * Render the current simulation state
+ * Compute gravitational accelerations on rockets (SoA, dispatched kernel)
  */
-void render(Body *bodies, int n_bodies, Rocket *rockets, int n_rockets, 
-            Pixel *img, double scale);
+void compute_rocket_forces_soa(ParticleSoA *rockets, const ParticleSoA *bodies,
+                               double g);
+
+/**
+ * Integrate bodies one time step (SoA kernel)
+ */
+void update_bodies_soa(ParticleSoA *bodies, double dt, double g);
+
+/**
+ * Integrate active rockets one time step (SoA kernel, no trail recording)
+ */
+void update_rockets_soa(ParticleSoA *rockets, const ParticleSoA *bodies,
+                        double dt, double g);
+
+/**
+ * Append current SoA positions of active rockets to their trails
+ * `live` lists the rockets to visit (NULL = every active rocket). Every
+ * `stride`th step is sampled; with `tolerance` > 0 (world units) a
+ * sample only ends the current segment when the path leaves it by more
+ * than that. A full window drops its oldest half (kept in the dropped_*
+ * totals)
+ */
+void record_rocket_trails(Rocket *rockets, const ParticleSoA *soa, const int *live,
+                          int n_live, int stride, double tolerance);
+
+/**
+ * Deactivate rockets farther than `radius` from the origin (AoS
+ * adapters; sim_step() uses events_detect()); returns how many
+ */
+int check_rocket_escape(ParticleSoA *rockets, double radius);
+
+/**
+ * Kick-drift particles: v += a * dt, x += v * dt (active particles only)
+ */
+void integrate_particles(ParticleSoA *p, double dt, int threads);
+
+/**
+ * Kick particles: v += a * dt (active particles only)
+ */
+void kick_particles(ParticleSoA *p, double dt, int threads);
+
+/**
+ * Drift particles: x += v * dt (active particles only)
+ */
+void drift_particles(ParticleSoA *p, double dt, int threads);
+
+/**
+ * Total energy of the bodies (kinetic + softened potential)
+ * Rockets are massless and do not contribute
+ */
+double compute_energy(const ParticleSoA *bodies, double g);
+
+/**
+ * Body accelerations with the configured solver and thread count
+ * Returns 0, or -1 when the Barnes-Hut tree could not be built and the
+ * forces were summed directly instead
+ */
+int sim_body_forces(SimState *state, const SimConfig *config);
+
+/**
+ * Rocket accelerations with the configured solver and thread count
+ */
+void sim_rocket_forces(SimState *state, const SimConfig *config);
+
+/**
+ * Advance the whole simulation state by one time step
+ * Uses config->integrator; KDK reuses the previous step's accelerations
+ * for its first half-kick, so each step costs one force evaluation.
+ * With state->ephemeris set only the rockets are integrated and the
+ * bodies are read from it, which gives the same rocket trajectories.
+ * Runs on the SoA storage; call sim_state_unpack() before reading
+ * positions from the Body/Rocket arrays
+ */
+void sim_step(SimState *state, const SimConfig *config);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - trail_io.c
+ * ============================================================================ */
+
+/**
+ * Write in-memory trails as a v2 trajectory file
+ * `precision` is 64 or 32 bits per stored coordinate
+ * Returns 0 on success, -1 on I/O failure
+ */
+int write_trail_file(const char *filename, const Rocket *rockets, int n, int precision);
+
+/**
+ * Map a v2 trajectory file read-only
+ * Returns 0 on success, -1 if the file is missing or not a valid v2 file
+ */
+int trail_file_open(TrailFile *file, const char *filename);
+
+/**
+ * Unmap a trajectory file
+ */
+void trail_file_close(TrailFile *file);
+
+/**
+ * Number of rockets in a trajectory file
+ */
+int trail_file_count(const TrailFile *file);
+
+/**
+ * Points in the trail of `rocket` (O(1) through the index)
+ */
+long trail_file_length(const TrailFile *file, int rocket);
+
+/**
+ * Point `j` of the trail of `rocket`, read in place (either precision)
+ */
+void trail_file_point(const TrailFile *file, int rocket, long j, double *x, double *y);
+
+/**
+ * Zero-copy float64 columns of `rocket` (NULL for float32 files)
+ */
+const double *trail_file_x(const TrailFile *file, int rocket);
+const double *trail_file_y(const TrailFile *file, int rocket);
+
+/**
+ * Open a trail sink writing `filename` for `n_rockets` rockets
+ * `precision` (64 or 32) selects the column type of the final file
+ * Returns 0 on success, -1 if the spool file cannot be created
+ */
+int trail_sink_open(TrailSink *sink, const char *filename, int n_rockets, int precision);
+
+/**
+ * Write out every rocket holding at least TRAIL_CHUNK unwritten points
+ * (all unwritten points when `final` is set)
+ */
+void trail_sink_flush(TrailSink *sink, Rocket *rockets, int n, int final);
+
+/**
+ * Reopen the spool of an interrupted run, dropping everything after the
+ * first `offset` bytes (`points` trail points), and keep appending
+ * Returns 0 on success, -1 if the spool is missing or not a spool
+ */
+int trail_sink_resume(TrailSink *sink, const char *filename, int n_rockets, int precision,
+                      long offset, long long points);
+
+/**
+ * Push the spool to disk; returns its size in bytes, or -1 on failure
+ */
+long trail_sink_sync(TrailSink *sink);
+
+/**
+ * Flush the remaining points and produce the final trail file
+ * Returns 0 on success, -1 on I/O failure (the spool is then kept)
+ */
+int trail_sink_close(TrailSink *sink, Rocket *rockets, int n);
+
+/**
+ * Convert a spool file (e.g. left by a crashed run) into a v2 trail file
+ * Returns the number of rockets written, or -1 on failure
+ */
+int trail_spool_convert(const char *spool_path, const char *filename, int precision);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - trail_stats.c
+ * ============================================================================ */
+
+/**
+ * Start empty statistics
+ */
+void trail_stats_init(TrailStats *stats);
+
+/**
+ * Add `n` points; the first one is joined to the last point added
+ */
+void trail_stats_add(TrailStats *stats, const double *x, const double *y, long n);
+
+/**
+ * Add `n` float32 points (stored trail columns), widened to double
+ */
+void trail_stats_add_float(TrailStats *stats, const float *x, const float *y, long n);
+
+/**
+ * Statistics of the trail of `rocket` in a mapped trajectory file
+ */
+void trail_stats_file(const TrailFile *file, int rocket, TrailStats *stats);
+
+/**
+ * Name of the statistics kernel in use ("avx2" or "scalar")
+ */
+const char *trail_stats_kernel(void);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - frame_pipeline.c
+ * ============================================================================ */
+
+/**
+ * Allocate `n_slots` frame buffers and start `n_workers` render threads
+ * Frames go to `video` when given, otherwise to their BMP files
+ * Returns 0 on success, -1 on failure (nothing is left running)
+ */
+int frame_pipeline_start(FramePipeline *pipeline, int n_slots, int n_workers,
+                         const Viewport *view, int render_threads, VideoSink *video);
+
+/**
+ * Snapshot bodies, rockets and trails into the next free slot and queue
+ * it for `filename`; blocks while every slot is in flight
+ * With a trail `canvas` (incremental mode) the layer is copied instead of
+ * the trails and the frame is composited over it
+ * Returns 0 on success, -1 on allocation failure (frame dropped, counted as failed)
+ */
+int frame_pipeline_submit(FramePipeline *pipeline, const char *filename,
+                          const TrailCanvas *canvas, const Body *bodies, int n_bodies,
+                          const Rocket *rockets, int n_rockets);
+
+/**
+ * Snapshot bodies and the positions of active rockets into the next free
+ * slot and queue a density frame for `filename`; blocks like
+ * frame_pipeline_submit()
+ * Returns 0 on success, -1 on allocation failure (frame dropped, counted as failed)
+ */
+int frame_pipeline_submit_density(FramePipeline *pipeline, const char *filename,
+                                  const Body *bodies, int n_bodies,
+                                  const ParticleSoA *rockets);
+
+/**
+ * Wait until every submitted frame has been written
+ */
+void frame_pipeline_drain(FramePipeline *pipeline);
+
+/**
+ * Write every queued frame, stop the workers and free the ring
+ * Returns the number of frames that were dropped or failed to render or write
+ */
+int frame_pipeline_finish(FramePipeline *pipeline);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - video_out.c
+ * ============================================================================ */
+
+/**
+ * Move stdout to a new descriptor for a video stream and point fd 1 at
+ * stderr, so console output cannot corrupt it. Call before printing
+ * anything; returns the stream's descriptor, or -1
+ */
+int video_take_stdout(void);
+
+/**
+ * Open a video sink of w x h frames: kind VIDEO_FFMPEG encodes into
+ * `filename`, VIDEO_Y4M writes a stream to `filename` ("-" = the
+ * descriptor `stdout_fd` from video_take_stdout(); ignored otherwise)
+ * Returns 0 on success, -1 on failure
+ */
+int video_open(VideoSink *video, int kind, const char *filename, int w, int h, int fps,
+               int stdout_fd);
+
+/**
+ * Reopen the Y4M file of an interrupted run, keeping its first `offset`
+ * bytes (`frames` frames), and append from there (0 on success)
+ */
+int video_resume_y4m(VideoSink *video, const char *filename, int w, int h,
+                     long offset, long frames);
+
+/**
+ * Push a Y4M file to disk; returns its size in bytes, or -1 when the
+ * stream cannot be resumed (ffmpeg pipe, stdout) or the sync failed
+ */
+long video_sync(VideoSink *video);
+
+/**
+ * Append one frame (0 on success, -1 on write failure)
+ */
+int video_write_frame(VideoSink *video, const Pixel *img);
+
+/**
+ * Finish the stream and wait for the encoder (0 on success, -1 on failure)
+ */
+int video_close(VideoSink *video);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - timestep.c
+ * ============================================================================ */
+
+/**
+ * Initialize an empty block time-step schedule
+ */
+void block_steps_init(BlockSteps *blocks);
+
+/**
+ * Free all schedule memory
+ */
+void block_steps_free(BlockSteps *blocks);
+
+/**
+ * Put every rocket on the finest level (after forces are primed)
+ * Returns 0 on success, -1 on allocation failure
+ */
+int block_steps_reset(BlockSteps *blocks, int n_rockets);
+
+/**
+ * Time-step level for acceleration a and jerk j:
+ * smallest level with dt / 2^level <= eta * |a| / |j|
+ */
+int rocket_block_level(double ax, double ay, double jx, double jy,
+                       double dt, double eta);
+
+/**
+ * Advance active rockets by one global step of config->dt, each on its
+ * own block step. Bodies must still hold x, v, a at the start of the
+ * step; their positions at intermediate ticks are predicted.
+ * Returns 0 on success, -1 on allocation failure (nothing is moved)
+ */
+int advance_rockets_block(SimState *state, const SimConfig *config);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - physics_simd.c
+ * ============================================================================ */
+
+/**
+ * Scalar reference rocket force kernel
+ */
+void compute_rocket_forces_scalar(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                  double g, int begin, int end);
+
+/**
+ * Float rocket force kernels (scalar): accumulate in float, with the
+ * body-rocket differences taken in double (mixed) or from positions
+ * rounded to float (float)
+ */
+void compute_rocket_forces_scalar_mixed(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                        double g, int begin, int end);
+void compute_rocket_forces_scalar_float(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                        double g, int begin, int end);
+
+/**
+ * Select the rocket force kernel (returns the kind actually selected)
+ */
+int select_rocket_kernel(int kind);
+
+/**
+ * Current rocket force kernel (selected by CPU dispatch on first use, from
+ * any thread, exactly once)
+ */
+RocketForceKernel rocket_force_kernel(void);
+
+/**
+ * Rocket force kernel of the current kind for a PRECISION_* mode
+ */
+RocketForceKernel rocket_force_kernel_for(int precision);
+
+/**
+ * Human-readable name of a PRECISION_* mode
+ */
+const char *precision_name(int precision);
+
+/**
+ * Kind of the current rocket force kernel
+ */
+int rocket_kernel_kind(void);
+
+/**
+ * Human-readable kernel name
+ */
+const char *rocket_kernel_name(int kind);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - physics_fixed.c
+ * ============================================================================ */
+
+/**
+ * Rocket force kernel of a KERNEL_* kind specialized for `n_bodies`
+ * bodies (1 to FIXED_BODIES_MAX), or NULL if there is none
+ */
+RocketForceKernel rocket_force_kernel_fixed(int kind, int n_bodies);
+
+/**
+ * Rocket force kernel for a PRECISION_* mode and body count: specialized
+ * when available, the generic kernel of the current kind otherwise
+ */
+RocketForceKernel rocket_force_kernel_sized(int precision, int n_bodies);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - parallel.c
+ * ============================================================================ */
+
+/**
+ * Body accelerations on `threads` threads (bitwise-identical to serial)
+ */
+void compute_forces_threaded(ParticleSoA *bodies, double g, int threads);
+
+/**
+ * Rocket accelerations on `threads` threads
+ */
+void compute_rocket_forces_threaded(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                    double g, int threads, int precision);
+
+/**
+ * Body accelerations in float arithmetic (PRECISION_MIXED or
+ * PRECISION_FLOAT), gather form on `threads` threads (0 = serial)
+ */
+void compute_forces_float(ParticleSoA *bodies, double g, int threads, int precision);
+
+/**
+ * Default thread count of the OpenMP runtime (1 if built without OpenMP)
+ */
+int max_threads(void);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - bh_tree.c
+ * ============================================================================ */
+
+/**
+ * Initialize an empty quadtree
+ */
+void quadtree_init(QuadTree *tree);
+
+/**
+ * Free quadtree memory
+ */
+void quadtree_free(QuadTree *tree);
+
+/**
+ * Build the quadtree over the current body positions
+ */
+int quadtree_build(QuadTree *tree, const ParticleSoA *bodies);
+
+/**
+ * Recompute the centres of mass of a built tree for moved bodies,
+ * keeping its cells (for bodies that moved a little since the build)
+ */
+void quadtree_refit(QuadTree *tree, const ParticleSoA *bodies);
+
+/**
+ * Tree-walk acceleration at a point (`self` = body index or -1)
+ */
+void quadtree_accel(const QuadTree *tree, const ParticleSoA *bodies,
+                    double px, double py, int self, double theta, double g,
+                    double *out_ax, double *out_ay);
+
+/**
+ * Barnes-Hut body accelerations (builds the tree)
+ */
+int compute_forces_bh(ParticleSoA *bodies, QuadTree *tree, double g,
+                      double theta, int threads);
+
+/**
+ * Barnes-Hut rocket accelerations from a built tree
+ */
+void compute_rocket_forces_bh(ParticleSoA *rockets, const ParticleSoA *bodies,
+                              const QuadTree *tree, double g, double theta,
+                              int threads);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - raster.c
+ * ============================================================================ */
+
+/**
+ * Prepare a rasterizer drawing into `img` with up to `threads` threads
+ * (0 on success, -1 on failure)
+ */
+int raster_begin(Rasterizer *ras, Pixel *img, const Viewport *view, int threads);
+
+/**
+ * Space for `n` more primitives, in drawing order (NULL on failure)
+ */
+RasterPrim *raster_reserve(Rasterizer *ras, int n);
+
+/**
+ * Queue `n` primitives written into the space from raster_reserve()
+ */
+void raster_commit(Rasterizer *ras, int n);
+
+/**
+ * Draw every queued primitive
+ */
+void raster_flush(Rasterizer *ras);
+
+/**
+ * Draw what is still queued and free the rasterizer
+ */
+void raster_end(Rasterizer *ras);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - render.c
+ * ============================================================================ */
+
+/**
+ * Set up a view of `width` x `height` contiguous pixels; scale <= 0 picks
+ * VIEW_SCALE scaled to the image size, so the default field of view is kept
+ */
+void viewport_init(Viewport *view, int width, int height, double scale,
+                   double center_x, double center_y);
+
+/**
+ * Project world coordinates to pixel coordinates
+ */
+int viewport_px(const Viewport *view, double x);
+int viewport_py(const Viewport *view, double y);
+
+/**
+ * Draw a Bresenham line into the view's image (clipped per pixel)
+ */
+void draw_line(Pixel *img, const Viewport *view, int x1, int y1, int x2, int y2,
+               unsigned char r, unsigned char g, unsigned char b);
+
+/**
+ * Draw a filled circle into the view's image
+ */
+void draw_circle(Pixel *img, const Viewport *view, int cx, int cy, int radius,
+                 unsigned char r, unsigned char g, unsigned char b);
+
+/**
+ * Reference grid, one line per world unit (coarser when zoomed out),
+ * brightening pixels to at least `level`
+ */
+void draw_grid(Pixel *img, const Viewport *view, unsigned char level);
+
+/**
+ * Marker radius for the view: `base` pixels at the default image size
+ */
+int viewport_radius(const Viewport *view, int base);
+
+/**
+ * Draw the bodies that are inside the view (star and planet markers)
+ */
+void draw_bodies(const Body *bodies, int n_bodies, Pixel *img, const Viewport *view);
+
+/**
+ * Render the current simulation state; threads > 1 rasterizes tiles in
+ * parallel (same image for any thread count)
+ */
+void render(Body *bodies, int n_bodies, Rocket *rockets, int n_rockets, 
+            Pixel *img, const Viewport *view, int threads);
+
+/**
+ * Allocate an empty trail layer of the view's size for `n_rockets`
+ * rockets whose trails keep `decay` of their brightness per frame
+ * (0 on success, -1 on failure)
+ */
+int trail_canvas_init(TrailCanvas *canvas, const Viewport *view, int n_rockets,
+                      double decay);
+
+/**
+ * Free the trail layer
+ */
+void trail_canvas_free(TrailCanvas *canvas);
+
+/**
+ * Start the next frame and rasterize the trail segments recorded since
+ * the previous update
+ */
+void trail_canvas_update(TrailCanvas *canvas, const Rocket *rockets, int n_rockets,
+                         const Viewport *view);
+
+/**
+ * Grid, faded trail layer, rockets and bodies: one incremental frame
+ */
+void render_composite(const TrailCanvas *canvas, const Body *bodies, int n_bodies,
+                      const Rocket *rockets, int n_rockets, Pixel *img,
+                      const Viewport *view);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - density.c
+ * ============================================================================ */
+
+/**
+ * Allocate zeroed density buffers of the view's size for `threads`
+ * splat threads (0 on success, -1 on failure)
+ */
+int density_init(DensityMap *map, const Viewport *view, int threads);
+
+/**
+ * Free the density buffers
+ */
+void density_free(DensityMap *map);
+
+/**
+ * Density frame: splat the `n` positions (only those with `active` set,
+ * all of them when `active` is NULL), tone-map log density into the
+ * image, then draw the grid and the bodies
+ */
+void render_density(DensityMap *map, const Body *bodies, int n_bodies,
+                    const double *x, const double *y, const unsigned char *active,
+                    int n, Pixel *img, const Viewport *view);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - checkpoint.c
+ * ============================================================================ */
+
+/**
+ * Write a checkpoint of `state` and `config` atomically: the file is
+ * written to `<filename>.tmp`, synced and renamed over `filename`
+ * `header` carries the caller's counters in and is completed in place
+ * Returns 0 on success, -1 on failure (the previous checkpoint is kept)
+ */
+int checkpoint_save(const char *filename, CheckpointHeader *header, const SimState *state,
+                    const SimConfig *config, const TrailCanvas *canvas);
+
+/**
+ * Load a checkpoint into an empty `state` and `config`; the state is
+ * packed and ready for sim_step()
+ * Returns 0 on success, -1 on failure
+ */
+int checkpoint_load(const char *filename, CheckpointHeader *header, SimState *state,
+                    SimConfig *config);
+
+/**
+ * Restore the trail layer saved with the checkpoint into `canvas`,
+ * created for the checkpoint's view and rocket count (0 on success)
+ */
+int checkpoint_load_canvas(const char *filename, const CheckpointHeader *header,
+                           TrailCanvas *canvas);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - ephemeris.c
+ * ============================================================================ */
+
+/**
+ * 1 if rockets stepped against an ephemeris follow the same trajectories
+ * as in a full run with `config` (not with block time-steps)
+ */
+int ephemeris_supported(const SimConfig *config);
+
+/**
+ * Integrate `bodies` for config->steps steps, keeping every `stride`th
+ * step (1 = every step, exact)
+ * Returns 0 on success, -1 on allocation failure or if it would exceed
+ * EPHEMERIS_MAX_BYTES
+ */
+int ephemeris_build(BodyEphemeris *eph, const Body *bodies, int n_bodies,
+                    const SimConfig *config, int stride);
+
+/**
+ * Integrate `bodies` like ephemeris_build() but stream the records into
+ * an ephemeris file (written to `<filename>.tmp` and renamed), so its
+ * size is not limited by memory. Returns 0 on success, -1 on failure
+ */
+int ephemeris_write(const char *filename, const Body *bodies, int n_bodies,
+                    const SimConfig *config, int stride);
+
+/**
+ * Map an ephemeris file read-only if it matches `config` and, unless
+ * NULL, the initial `bodies`. Returns 0 on success, -1 (with the reason
+ * printed) if it is missing or does not match
+ */
+int ephemeris_open(BodyEphemeris *eph, const char *filename, const Body *bodies,
+                   int n_bodies, const SimConfig *config);
+
+/**
+ * Write the body positions after `step` steps into `bodies`
+ * (interpolated between records when stride > 1)
+ */
+void ephemeris_bodies(const BodyEphemeris *eph, int step, ParticleSoA *bodies);
+
+/**
+ * Free or unmap the ephemeris
+ */
+void ephemeris_free(BodyEphemeris *eph);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - profile.c
+ * ============================================================================ */
+
+/**
+ * Seconds on the monotonic clock
+ */
+double profile_clock(void);
+
+/**
+ * Clear all totals and start the run clock
+ */
+void profile_init(Profile *p);
+
+/**
+ * Start a timer (use PROFILE_BEGIN)
+ */
+double profile_begin(const Profile *p);
+
+/**
+ * Stop a timer started by profile_begin() and add its own time, less any
+ * timers that ran inside it, to `phase` (use PROFILE_END)
+ */
+void profile_end(Profile *p, int phase, double started);
+
+/**
+ * Write per-frame timing rows to `filename` (see profile_frame())
+ * Returns 0 on success, -1 if the file cannot be created
+ */
+int profile_open_csv(Profile *p, const char *filename);
+
+/**
+ * Append the phase times since the previous row to the timing CSV
+ */
+void profile_frame(Profile *p, int frame, int step, double time);
+
+/**
+ * Print the phase breakdown of `steps` steps and the interaction rate
+ */
+void profile_report(const Profile *p, long long steps);
+
+/**
+ * Close the timing CSV
+ */
+void profile_close(Profile *p);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - events.c
+ * ============================================================================ */
+
+/**
+ * Name of an event kind ("escape", "collision", "region")
+ */
+const char *event_kind_name(int kind);
+
+/**
+ * Rebuild the live rocket list and region bits from the rocket SoA
+ * (sim_step() does this after sim_state_pack()); 0 on success
+ */
+int events_prepare(SimState *state, const SimConfig *config);
+
+/**
+ * Rockets the force kernels should run on: the rocket SoA, or the live
+ * rockets gathered densely once enough rockets are inactive
+ */
+ParticleSoA *events_force_rockets(SimState *state);
+
+/**
+ * Scatter accelerations computed on events_force_rockets() back
+ */
+void events_scatter_forces(SimState *state, const ParticleSoA *rockets);
+
+/**
+ * Detect escapes, collisions and region entries of the live rockets,
+ * deactivate rockets as configured and queue the events to events.log
+ */
+void events_detect(SimState *state, const SimConfig *config);
+
+/**
+ * Free the event detection state
+ */
+void events_free(RocketEvents *ev);
+
+/**
+ * Start the asynchronous event writer (`filename` "" = console only;
+ * resume_offset >= 0 cuts the file back and appends); 0 on success
+ */
+int event_log_open(EventLog *log, const char *filename, int console, long resume_offset);
+
+/**
+ * Queue events for the writer thread
+ */
+void event_log_submit(EventLog *log, const RocketEvent *events, int n);
+
+/**
+ * Wait for the writer to catch up; returns the events file size or -1
+ */
+long event_log_sync(EventLog *log);
+
+/**
+ * Write queued events, stop the writer and close the file (0 on success)
+ */
+int event_log_close(EventLog *log);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - batch.c
+ * ============================================================================ */
+
+/**
+ * Run every scenario of a manifest, `base` (config.txt) plus per-line
+ * overrides, on a pool of config->batch_threads workers and write the
+ * summary rows to `stats_file` (BATCH_STATS_FILE by default)
+ * Returns 0 if every scenario ran, 1 if some failed, -1 on a bad manifest
+ */
+int batch_run(const char *manifest, const SimConfig *base, const char *stats_file);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - replay.c
+ * ============================================================================ */
+
+/**
+ * Open a saved run: map `trails_file` and take the body positions from
+ * config->ephemeris_file, or integrate the bodies of `bodies_file` alone
+ * Returns 0 on success, -1 (with the reason printed) on failure
+ */
+int replay_open(Replay *replay, const char *trails_file, const char *bodies_file,
+                const SimConfig *config);
+
+/**
+ * Draw frame `frame` of the run into `img` as the simulation drew it
+ * (full redraw); returns 0 on success, -1 on allocation failure
+ */
+int replay_render(const Replay *replay, int frame, Pixel *img, const Viewport *view,
+                  int threads);
+
+/**
+ * Unmap the trails and free the ephemeris
+ */
+void replay_close(Replay *replay);
+
+/**
+ * Render frames replay_first..replay_last of a saved run as BMP files in
+ * `output_dir`, on replay_threads workers; returns the exit status
+ */
+int replay_run(const SimConfig *config, const char *trails_file, const char *bodies_file,
+               const char *output_dir, int quiet);
+
+/* ============================================================================
+ * FUNCTION DECLARATIONS - distributed.c (bin/nbody_mpi only)
+ * ============================================================================ */
+
+/**
+ * Run the simulation with the rockets split across the MPI ranks of
+ * MPI_COMM_WORLD (MPI_Init() already called); every output file goes
+ * to `output_dir`. Returns the process exit status
+ */
+int distributed_run(const SimConfig *config, const char *bodies_file, const char *rockets_file,
+                    const char *output_dir, int quiet);
 
 #endif /* NBODY_H */
\ No newline at end of file
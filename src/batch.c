@@ -0,0 +1,320 @@
+/**
+ * batch.c - Batch (Ensemble) Mode
+ * Run many independent scenarios in one process: nbody --batch <manifest>
+ *
+ * Manifest format, one scenario per line ('#' starts a comment):
+ *
+ *   name  bodies_file  rockets_file  [key=value ...]
+ *
+ * Every scenario starts from config.txt with the line's key=value
+ * overrides applied. No frames, trails or logs are written; each
+ * scenario contributes its trajectory statistics rows (the columns of
+ * rocket_stats.csv, prefixed with the scenario name) to batch_stats.csv,
+ * in manifest order.
+ *
+ * Scenarios run one per worker on a pool of batch_threads threads, each
+ * with a serial step. Bodies files are parsed once. Scenarios that share
+ * a bodies file and the body dynamics (dt, steps, g, solver, theta,
+ * integrator, precision) share one read-only body ephemeris, so the
+ * bodies are integrated once for the whole group and each scenario only
+ * steps its rockets, with the same results as a separate run.
+ */
+
+#include "nbody.h"
+
+/**
+ * 1 if two scenarios give the bodies the same trajectory
+ */
+static int same_body_dynamics(const SimConfig *a, const SimConfig *b) {
+    return a->dt == b->dt && a->steps == b->steps && a->g == b->g &&
+           a->solver == b->solver && a->theta == b->theta &&
+           a->integrator == b->integrator && a->block_steps == b->block_steps &&
+           a->precision == b->precision;
+}
+
+/**
+ * Parse the manifest into scenarios; returns the count or -1
+ */
+static int parse_manifest(const char *manifest, const SimConfig *base, BatchScenario **out) {
+    FILE *f = fopen(manifest, "r");
+    if (!f) {
+        printf("Error: Could not open batch manifest %s\n", manifest);
+        return -1;
+    }
+    
+    BatchScenario *scenarios = NULL;
+    int n = 0, capacity = 0, line_no = 0;
+    char line[1024];
+    
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        
+        char name[64], bodies_file[256], rockets_file[256];
+        int pos = 0;
+        int fields = sscanf(line, "%63s %255s %255s%n", name, bodies_file, rockets_file, &pos);
+        if (fields <= 0) continue;
+        if (fields != 3) {
+            printf("Warning: %s:%d: expected name, bodies file and rockets file\n",
+                   manifest, line_no);
+            continue;
+        }
+        
+        if (n == capacity) {
+            capacity = capacity ? 2 * capacity : INITIAL_CAPACITY;
+            BatchScenario *grown = (BatchScenario *)realloc(scenarios,
+                                                            capacity * sizeof(BatchScenario));
+            if (!grown) {
+                printf("Error: Memory allocation failed (%d scenarios)\n", capacity);
+                free(scenarios);
+                fclose(f);
+                return -1;
+            }
+            scenarios = grown;
+        }
+        
+        BatchScenario *sc = &scenarios[n];
+        memset(sc, 0, sizeof(BatchScenario));
+        snprintf(sc->name, sizeof(sc->name), "%s", name);
+        snprintf(sc->rockets_file, sizeof(sc->rockets_file), "%s", rockets_file);
+        snprintf(sc->bodies_file, sizeof(sc->bodies_file), "%s", bodies_file);
+        sc->config = *base;
+        
+        // key=value overrides
+        char option[128];
+        int used = 0;
+        const char *rest = line + pos;
+        while (sscanf(rest, "%127s%n", option, &used) == 1) {
+            rest += used;
+            char *eq = strchr(option, '=');
+            if (eq) *eq = '\0';
+            if (!eq || config_set_option(&sc->config, option, eq + 1) != 0) {
+                printf("Warning: %s:%d: ignoring option '%s'\n", manifest, line_no, option);
+            }
+        }
+        
+        // Parallelism is across scenarios
+        sc->config.threads = 0;
+        if (sc->config.steps < 1 || !(sc->config.dt > 0.0)) {
+            printf("Warning: %s:%d: scenario %s needs steps >= 1 and dt > 0, skipped\n",
+                   manifest, line_no, name);
+            continue;
+        }
+        n++;
+    }
+    
+    fclose(f);
+    *out = scenarios;
+    return n;
+}
+
+/**
+ * Put every scenario into a body set, parsing each new bodies file once
+ */
+static int assign_groups(BatchScenario *scenarios, int n, BatchGroup **out) {
+    BatchGroup *groups = (BatchGroup *)calloc(n > 0 ? n : 1, sizeof(BatchGroup));
+    if (!groups) {
+        printf("Error: Memory allocation failed (%d body sets)\n", n);
+        return -1;
+    }
+    
+    int n_groups = 0;
+    for (int s = 0; s < n; s++) {
+        int g = 0;
+        while (g < n_groups && !(strcmp(groups[g].bodies_file, scenarios[s].bodies_file) == 0 &&
+                                 same_body_dynamics(&groups[g].config, &scenarios[s].config))) {
+            g++;
+        }
+        
+        if (g == n_groups) {
+            BatchGroup *group = &groups[n_groups++];
+            snprintf(group->bodies_file, sizeof(group->bodies_file), "%s",
+                     scenarios[s].bodies_file);
+            group->config = scenarios[s].config;
+            group->n_bodies = -1;
+            
+            // Reuse the parse of an earlier set with the same file
+            int same_file = 0;
+            while (same_file < g && strcmp(groups[same_file].bodies_file, group->bodies_file)) {
+                same_file++;
+            }
+            const BatchGroup *parsed = (same_file < g) ? &groups[same_file] : NULL;
+            
+            SimState state;
+            sim_state_init(&state);
+            int count = parsed ? parsed->n_bodies : load_bodies(group->bodies_file, &state);
+            if (count >= 0) {
+                const Body *src = parsed ? parsed->bodies : state.bodies;
+                group->bodies = (Body *)malloc((count > 0 ? count : 1) * sizeof(Body));
+                if (group->bodies) {
+                    memcpy(group->bodies, src, count * sizeof(Body));
+                    group->n_bodies = count;
+                }
+            }
+            sim_state_free(&state);
+        }
+        
+        scenarios[s].group = g;
+        groups[g].scenarios++;
+    }
+    
+    *out = groups;
+    return n_groups;
+}
+
+/**
+ * Run one scenario and keep its summary rows
+ */
+static void run_scenario(BatchScenario *sc, const BatchGroup *group) {
+    const SimConfig *config = &sc->config;
+    sc->n_rockets = -1;
+    if (group->n_bodies < 0) {
+        printf("Error: Scenario %s: no bodies from %s\n", sc->name, group->bodies_file);
+        return;
+    }
+    
+    SimState state;
+    sim_state_init(&state);
+    int ok = sim_state_reserve_bodies(&state, group->n_bodies) == 0;
+    if (ok) {
+        memcpy(state.bodies, group->bodies, group->n_bodies * sizeof(Body));
+        state.n_bodies = group->n_bodies;
+        ok = load_rockets(sc->rockets_file, &state) >= 0 && sim_state_pack(&state) == 0;
+    }
+    if (!ok) {
+        printf("Error: Scenario %s: could not load rockets from %s\n",
+               sc->name, sc->rockets_file);
+        sim_state_free(&state);
+        return;
+    }
+    
+    if (group->has_ephemeris) {
+        state.ephemeris = &group->ephemeris;
+    }
+    for (int step = 0; step < config->steps; step++) {
+        sim_step(&state, config);
+    }
+    sim_state_unpack(&state);
+    
+    FILE *mem = open_memstream(&sc->summary, &sc->summary_size);
+    if (mem) {
+        write_trajectory_stats(mem, sc->name, state.rockets, state.n_rockets, config->dt, 0);
+        if (fclose(mem) == 0) sc->n_rockets = state.n_rockets;
+    }
+    if (sc->n_rockets < 0) {
+        printf("Error: Scenario %s: could not store its summary\n", sc->name);
+    }
+    sim_state_free(&state);
+}
+
+/**
+ * Run a batch manifest on a pool of worker threads
+ */
+int batch_run(const char *manifest, const SimConfig *base, const char *stats_file) {
+    double start = profile_clock();
+    
+    BatchScenario *scenarios = NULL;
+    int n = parse_manifest(manifest, base, &scenarios);
+    if (n < 0) return -1;
+    
+    BatchGroup *groups = NULL;
+    int was_quiet = file_io_quiet(1);
+    int n_groups = (n > 0) ? assign_groups(scenarios, n, &groups) : 0;
+    if (n_groups < 0) {
+        file_io_quiet(was_quiet);
+        free(scenarios);
+        return -1;
+    }
+    
+    int workers = (base->batch_threads > 0) ? base->batch_threads : max_threads();
+    
+    // Body sets with several scenarios integrate their bodies once
+    #pragma omp parallel for schedule(dynamic, 1) if(workers > 1) num_threads(OMP_THREADS(workers))
+    for (int g = 0; g < n_groups; g++) {
+        BatchGroup *group = &groups[g];
+        if (group->scenarios > 1 && group->n_bodies >= 0 &&
+            ephemeris_supported(&group->config)) {
+            group->has_ephemeris = (ephemeris_build(&group->ephemeris, group->bodies,
+                                                    group->n_bodies, &group->config, 1) == 0);
+        }
+    }
+    
+    int shared = 0;
+    for (int g = 0; g < n_groups; g++) {
+        if (groups[g].has_ephemeris) shared += groups[g].scenarios;
+    }
+    
+    FILE *out = fopen(stats_file, "w");
+    if (!out) {
+        printf("Error: Could not create %s\n", stats_file);
+    } else {
+        fprintf(out, "Scenario,%s", TRAJECTORY_STATS_HEADER);
+    }
+    
+    printf("Batch: %d scenarios, %d body set(s), %d scenario(s) on a shared ephemeris, "
+           "%d worker(s)\n", n, n_groups, shared, OMP_THREADS(workers));
+    double setup = profile_clock() - start;
+    
+    // One scenario per worker, taken in manifest order; finished
+    // summaries are written as soon as all earlier ones are out
+    int next_write = 0;
+    #pragma omp parallel for schedule(dynamic, 1) if(workers > 1) num_threads(OMP_THREADS(workers))
+    for (int s = 0; s < n; s++) {
+        run_scenario(&scenarios[s], &groups[scenarios[s].group]);
+        
+        #pragma omp critical(batch_output)
+        {
+            scenarios[s].done = 1;
+            while (next_write < n && scenarios[next_write].done) {
+                BatchScenario *sc = &scenarios[next_write++];
+                if (out && sc->summary) fwrite(sc->summary, 1, sc->summary_size, out);
+                free(sc->summary);
+                sc->summary = NULL;
+            }
+        }
+    }
+    
+    if (out && fclose(out) != 0) {
+        printf("Error: Could not write %s\n", stats_file);
+        out = NULL;
+    }
+    file_io_quiet(was_quiet);
+    
+    int failed = 0;
+    long long rockets = 0;
+    double rocket_steps = 0.0;
+    for (int s = 0; s < n; s++) {
+        if (scenarios[s].n_rockets < 0) {
+            failed++;
+        } else {
+            rockets += scenarios[s].n_rockets;
+            rocket_steps += (double)scenarios[s].n_rockets * scenarios[s].config.steps;
+        }
+    }
+    double elapsed = profile_clock() - start;
+    
+    printf("\n====================================\n");
+    printf("Batch Complete\n");
+    printf("====================================\n");
+    printf("Scenarios: %d run, %d failed, %lld rockets\n", n - failed, failed, rockets);
+    printf("Time: %.3f s (setup and ephemerides %.3f s)\n", elapsed, setup);
+    if (elapsed > 0.0) {
+        printf("Throughput: %.1f scenarios/s, %.3e rocket-steps/s\n",
+               (n - failed) / elapsed, rocket_steps / elapsed);
+    }
+    if (out) {
+        printf("Summary: %s\n", stats_file);
+    }
+    printf("\n");
+    
+    for (int g = 0; g < n_groups; g++) {
+        free(groups[g].bodies);
+        ephemeris_free(&groups[g].ephemeris);
+    }
+    free(groups);
+    free(scenarios);
+    
+    if (!out) return -1;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,322 @@
+/**
+ * bh_tree.c - Barnes-Hut Quadtree Gravity Solver
+ * O(N log N) approximate forces for bodies and rockets
+ *
+ * The tree is built over Morton-ordered bodies: sorting by interleaved
+ * coordinate bits makes every cell a contiguous range of the sorted
+ * order, so building is a recursive split of index ranges. Leaves hold
+ * up to BH_LEAF_SIZE bodies and are summed directly.
+ *
+ * A cell of side s at distance d from the evaluation point is replaced
+ * by its centre of mass when s < theta * d. Cells that contain the body
+ * being evaluated are always opened, so a body never feels itself.
+ */
+
+#include "nbody.h"
+
+#define MORTON_BITS 21         // Bits per axis in a Morton key
+#define BH_STACK_SIZE 256      // Traversal stack (>= 3 * MORTON_BITS + 4)
+
+/**
+ * Sort record for Morton ordering
+ */
+typedef struct {
+    unsigned long long key;
+    int index;
+} MortonEntry;
+
+/**
+ * Spread the low 21 bits of v so there is a zero bit between each
+ */
+static unsigned long long spread_bits(unsigned long long v) {
+    v &= 0x1FFFFFULL;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFULL;
+    v = (v | (v << 8))  & 0x00FF00FF00FF00FFULL;
+    v = (v | (v << 4))  & 0x0F0F0F0F0F0F0F0FULL;
+    v = (v | (v << 2))  & 0x3333333333333333ULL;
+    v = (v | (v << 1))  & 0x5555555555555555ULL;
+    return v;
+}
+
+/**
+ * Order by Morton key, ties broken by index so the order is total
+ */
+static int compare_morton(const void *a, const void *b) {
+    const MortonEntry *ea = (const MortonEntry *)a;
+    const MortonEntry *eb = (const MortonEntry *)b;
+    if (ea->key != eb->key) return (ea->key < eb->key) ? -1 : 1;
+    return ea->index - eb->index;
+}
+
+/**
+ * Append a node, growing the node array if needed (-1 on failure)
+ */
+static int new_node(QuadTree *tree) {
+    if (tree->n_nodes == tree->node_capacity) {
+        int capacity = (tree->node_capacity > 0) ? tree->node_capacity * 2 : INITIAL_CAPACITY;
+        QuadNode *p = (QuadNode *)realloc(tree->nodes, capacity * sizeof(QuadNode));
+        if (!p) return -1;
+        tree->nodes = p;
+        tree->node_capacity = capacity;
+    }
+    return tree->n_nodes++;
+}
+
+/**
+ * Recursively build the node covering sorted range [first, first+count)
+ * Returns the node index, or -1 on allocation failure
+ */
+static int build_node(QuadTree *tree, const MortonEntry *entries,
+                      const ParticleSoA *bodies, int first, int count,
+                      int depth, double size) {
+    int id = new_node(tree);
+    if (id < 0) return -1;
+    
+    tree->nodes[id].first = first;
+    tree->nodes[id].count = count;
+    tree->nodes[id].size = size;
+    for (int q = 0; q < 4; q++) tree->nodes[id].child[q] = -1;
+    
+    double mass = 0.0, mx = 0.0, my = 0.0;
+    
+    if (count <= BH_LEAF_SIZE || depth == MORTON_BITS) {
+        // Leaf: accumulate the centre of mass directly
+        for (int k = first; k < first + count; k++) {
+            int b = tree->order[k];
+            mass += bodies->mass[b];
+            mx += bodies->mass[b] * bodies->x[b];
+            my += bodies->mass[b] * bodies->y[b];
+        }
+        tree->nodes[id].is_leaf = 1;
+    } else {
+        // Split the range by the quadrant bits at this depth
+        int shift = 2 * (MORTON_BITS - 1 - depth);
+        int start = first;
+        tree->nodes[id].is_leaf = 0;
+        
+        for (int q = 0; q < 4; q++) {
+            int end = start;
+            while (end < first + count &&
+                   (int)((entries[end].key >> shift) & 3) == q) {
+                end++;
+            }
+            if (end > start) {
+                int child = build_node(tree, entries, bodies, start, end - start,
+                                       depth + 1, size * 0.5);
+                if (child < 0) return -1;
+                
+                QuadNode *c = &tree->nodes[child];
+                tree->nodes[id].child[q] = child;
+                mass += c->mass;
+                mx += c->mass * c->com_x;
+                my += c->mass * c->com_y;
+            }
+            start = end;
+        }
+    }
+    
+    QuadNode *node = &tree->nodes[id];
+    node->mass = mass;
+    node->com_x = (mass > 0.0) ? mx / mass : 0.0;
+    node->com_y = (mass > 0.0) ? my / mass : 0.0;
+    return id;
+}
+
+/**
+ * Initialize an empty tree
+ */
+void quadtree_init(QuadTree *tree) {
+    memset(tree, 0, sizeof(QuadTree));
+}
+
+/**
+ * Free all tree memory
+ */
+void quadtree_free(QuadTree *tree) {
+    free(tree->nodes);
+    free(tree->order);
+    free(tree->rank);
+    quadtree_init(tree);
+}
+
+/**
+ * Build the quadtree over the current body positions
+ * Node and index storage is reused across calls
+ */
+int quadtree_build(QuadTree *tree, const ParticleSoA *bodies) {
+    int n = bodies->n;
+    tree->n_nodes = 0;
+    if (n == 0) return 0;
+    
+    if (n > tree->index_capacity) {
+        int *order = (int *)realloc(tree->order, n * sizeof(int));
+        if (!order) return -1;
+        tree->order = order;
+        int *rank = (int *)realloc(tree->rank, n * sizeof(int));
+        if (!rank) return -1;
+        tree->rank = rank;
+        tree->index_capacity = n;
+    }
+    
+    // Square root cell enclosing every body
+    double min_x = bodies->x[0], max_x = bodies->x[0];
+    double min_y = bodies->y[0], max_y = bodies->y[0];
+    for (int i = 1; i < n; i++) {
+        if (bodies->x[i] < min_x) min_x = bodies->x[i];
+        if (bodies->x[i] > max_x) max_x = bodies->x[i];
+        if (bodies->y[i] < min_y) min_y = bodies->y[i];
+        if (bodies->y[i] > max_y) max_y = bodies->y[i];
+    }
+    double size = (max_x - min_x > max_y - min_y) ? max_x - min_x : max_y - min_y;
+    size = (size > 0.0) ? size * (1.0 + 1e-9) : 1.0;
+    
+    MortonEntry *entries = (MortonEntry *)malloc(n * sizeof(MortonEntry));
+    if (!entries) return -1;
+    
+    double cells = (double)(1 << MORTON_BITS);
+    for (int i = 0; i < n; i++) {
+        double fx = (bodies->x[i] - min_x) / size * cells;
+        double fy = (bodies->y[i] - min_y) / size * cells;
+        unsigned long long ix = (fx < cells) ? (unsigned long long)fx : (1ULL << MORTON_BITS) - 1;
+        unsigned long long iy = (fy < cells) ? (unsigned long long)fy : (1ULL << MORTON_BITS) - 1;
+        entries[i].key = spread_bits(ix) | (spread_bits(iy) << 1);
+        entries[i].index = i;
+    }
+    qsort(entries, n, sizeof(MortonEntry), compare_morton);
+    
+    for (int k = 0; k < n; k++) {
+        tree->order[k] = entries[k].index;
+        tree->rank[entries[k].index] = k;
+    }
+    
+    int root = build_node(tree, entries, bodies, 0, n, 0, size);
+    free(entries);
+    return (root < 0) ? -1 : 0;
+}
+
+/**
+ * Recompute centres of mass bottom-up on the cells of the last build
+ * Children are created after their parent, so a reverse pass visits
+ * every child first
+ */
+void quadtree_refit(QuadTree *tree, const ParticleSoA *bodies) {
+    for (int id = tree->n_nodes - 1; id >= 0; id--) {
+        QuadNode *node = &tree->nodes[id];
+        double mass = 0.0, mx = 0.0, my = 0.0;
+        if (node->is_leaf) {
+            for (int k = node->first; k < node->first + node->count; k++) {
+                int b = tree->order[k];
+                mass += bodies->mass[b];
+                mx += bodies->mass[b] * bodies->x[b];
+                my += bodies->mass[b] * bodies->y[b];
+            }
+        } else {
+            for (int q = 0; q < 4; q++) {
+                if (node->child[q] < 0) continue;
+                const QuadNode *c = &tree->nodes[node->child[q]];
+                mass += c->mass;
+                mx += c->mass * c->com_x;
+                my += c->mass * c->com_y;
+            }
+        }
+        node->mass = mass;
+        node->com_x = (mass > 0.0) ? mx / mass : 0.0;
+        node->com_y = (mass > 0.0) ? my / mass : 0.0;
+    }
+}
+
+/**
+ * Acceleration at (px, py) from the tree
+ * `self` is the body index being evaluated, or -1 for rockets
+ */
+void quadtree_accel(const QuadTree *tree, const ParticleSoA *bodies,
+                    double px, double py, int self, double theta, double g,
+                    double *out_ax, double *out_ay) {
+    double ax = 0.0, ay = 0.0;
+    double theta_sq = theta * theta;
+    int self_rank = (self >= 0) ? tree->rank[self] : -1;
+    
+    int stack[BH_STACK_SIZE];
+    int top = 0;
+    if (tree->n_nodes > 0) stack[top++] = 0;
+    
+    while (top > 0) {
+        const QuadNode *node = &tree->nodes[stack[--top]];
+        int contains_self = (self_rank >= node->first &&
+                             self_rank < node->first + node->count);
+        
+        double dx = node->com_x - px;
+        double dy = node->com_y - py;
+        double d_sq = dx * dx + dy * dy;
+        
+        if (!node->is_leaf &&
+            (contains_self || node->size * node->size >= theta_sq * d_sq)) {
+            // Too close: open the cell
+            for (int q = 0; q < 4; q++) {
+                if (node->child[q] >= 0) stack[top++] = node->child[q];
+            }
+            continue;
+        }
+        
+        if (node->is_leaf) {
+            // Direct sum over the bodies in the leaf
+            for (int k = node->first; k < node->first + node->count; k++) {
+                int b = tree->order[k];
+                if (b == self) continue;
+                
+                double bx = bodies->x[b] - px;
+                double by = bodies->y[b] - py;
+                double dist_sq = bx * bx + by * by + SOFTENING * SOFTENING;
+                double dist = sqrt(dist_sq);
+                double acc = g * bodies->mass[b] / dist_sq;
+                ax += acc * bx / dist;
+                ay += acc * by / dist;
+            }
+        } else {
+            // Far enough: use the cell's centre of mass
+            double dist_sq = d_sq + SOFTENING * SOFTENING;
+            double dist = sqrt(dist_sq);
+            double acc = g * node->mass / dist_sq;
+            ax += acc * dx / dist;
+            ay += acc * dy / dist;
+        }
+    }
+    
+    *out_ax = ax;
+    *out_ay = ay;
+}
+
+/**
+ * Barnes-Hut body accelerations: build the tree, then walk it per body
+ */
+int compute_forces_bh(ParticleSoA *bodies, QuadTree *tree, double g,
+                      double theta, int threads) {
+    if (quadtree_build(tree, bodies) != 0) {
+        printf("Error: Barnes-Hut tree allocation failed\n");
+        return -1;
+    }
+    (void)threads;  // Unused without OpenMP
+    
+    #pragma omp parallel for schedule(dynamic, 64) if(threads > 1) num_threads(OMP_THREADS(threads))
+    for (int i = 0; i < bodies->n; i++) {
+        quadtree_accel(tree, bodies, bodies->x[i], bodies->y[i], i, theta, g,
+                       &bodies->ax[i], &bodies->ay[i]);
+    }
+    return 0;
+}
+
+/**
+ * Barnes-Hut rocket accelerations from an already-built body tree
+ */
+void compute_rocket_forces_bh(ParticleSoA *rockets, const ParticleSoA *bodies,
+                              const QuadTree *tree, double g, double theta,
+                              int threads) {
+    (void)threads;  // Unused without OpenMP
+    
+    #pragma omp parallel for schedule(dynamic, 256) if(threads > 1) num_threads(OMP_THREADS(threads))
+    for (int i = 0; i < rockets->n; i++) {
+        if (!rockets->active[i]) continue;
+        quadtree_accel(tree, bodies, rockets->x[i], rockets->y[i], -1, theta, g,
+                       &rockets->ax[i], &rockets->ay[i]);
+    }
+}
@@ -1,65 +1,101 @@
 /**
  * bmp_io.c - BMP Image File I/O Functions
+ *
+ * The whole file (header and padded, bottom-to-top rows) is encoded into
+ * one buffer and written with a single fwrite(), so a frame costs one
+ * write instead of one stdio call per pixel.
  */
 
 #include "nbody.h"
 
 /**
- * Writes a 24-bit BMP image file
- * 
+ * Store a 32-bit value in little-endian byte order
+ */
+static void put_le32(unsigned char *p, unsigned int v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+/**
+ * Size in bytes of a 24-bit BMP file of w x h pixels
+ */
+long bmp_file_size(int w, int h) {
+    // BMP rows must be padded to multiples of 4 bytes
+    long row_size = ((long)w * 3 + 3) & ~3L;
+    return BMP_HEADER_SIZE + row_size * h;
+}
+
+/**
+ * Encode an image as a complete 24-bit BMP file
+ *
+ * @param img Pixel array (row-major order, top row first)
+ * @param w   Image width
+ * @param h   Image height
+ * @param out Output buffer of bmp_file_size(w, h) bytes
+ */
+void bmp_encode(const Pixel *img, int w, int h, unsigned char *out) {
+    long row_size = ((long)w * 3 + 3) & ~3L;
+    long img_size = row_size * h;
+    
+    // Construct 54-byte BMP header
+    memset(out, 0, BMP_HEADER_SIZE);
+    out[0] = 'B';
+    out[1] = 'M';
+    put_le32(out + 2, (unsigned int)(BMP_HEADER_SIZE + img_size));
+    put_le32(out + 10, BMP_HEADER_SIZE);
+    put_le32(out + 14, 40);
+    put_le32(out + 18, (unsigned int)w);
+    put_le32(out + 22, (unsigned int)h);
+    out[26] = 1;
+    out[28] = 24;
+    put_le32(out + 34, (unsigned int)img_size);
+    
+    // BMP format stores pixels bottom-to-top; Pixel is already B, G, R
+    long pixel_bytes = (long)w * 3;
+    unsigned char *row = out + BMP_HEADER_SIZE;
+    for (int y = h - 1; y >= 0; y--) {
+        memcpy(row, &img[(long)y * w], pixel_bytes);
+        memset(row + pixel_bytes, 0, row_size - pixel_bytes);
+        row += row_size;
+    }
+}
+
+/**
+ * Writes a 24-bit BMP image file with a single write
+ *
  * @param filename Output filename
  * @param img      Pixel array (row-major order)
  * @param w        Image width
  * @param h        Image height
+ * @return 0 on success, -1 on error
  */
-void write_bmp(const char *filename, Pixel *img, int w, int h) {
+int write_bmp(const char *filename, const Pixel *img, int w, int h) {
+    long size = bmp_file_size(w, h);
+    unsigned char *buffer = (unsigned char *)malloc(size);
+    if (!buffer) {
+        printf("Error: Memory allocation failed (%ld byte image)\n", size);
+        return -1;
+    }
+    bmp_encode(img, w, h, buffer);
+    
     FILE *f = fopen(filename, "wb");
     if (!f) {
         printf("Error: Could not open file %s\n", filename);
-        return;
+        free(buffer);
+        return -1;
     }
     
-    // BMP rows must be padded to multiples of 4 bytes
-    int row_size = (w * 3 + 3) & ~3;
-    int img_size = row_size * h;
-    int file_size = 54 + img_size;
-    
-    // Construct 54-byte BMP header
-    unsigned char header[54] = {
-        'B','M',
-        file_size & 0xFF, (file_size >> 8) & 0xFF, 
-        (file_size >> 16) & 0xFF, (file_size >> 24) & 0xFF,
-        0,0,0,0,
-        54,0,0,0,
-        40,0,0,0,
-        w & 0xFF, (w >> 8) & 0xFF, (w >> 16) & 0xFF, (w >> 24) & 0xFF,
-        h & 0xFF, (h >> 8) & 0xFF, (h >> 16) & 0xFF, (h >> 24) & 0xFF,
-        1,0,
-        24,0,
-        0,0,0,0,
-        img_size & 0xFF, (img_size >> 8) & 0xFF, 
-        (img_size >> 16) & 0xFF, (img_size >> 24) & 0xFF,
-        0,0,0,0,
-        0,0,0,0,
-        0,0,0,0,
-        0,0,0,0
-    };
-    
-    fwrite(header, 1, 54, f);
+    // The buffer is already complete; skip the stdio copy
+    setvbuf(f, NULL, _IONBF, 0);
+    size_t written = fwrite(buffer, 1, size, f);
+    int closed = fclose(f);
+    free(buffer);
     
-    // BMP format stores pixels bottom-to-top
-    unsigned char padding[3] = {0, 0, 0};
-    int pad_size = row_size - w * 3;
-    
-    for (int y = h - 1; y >= 0; y--) {
-        for (int x = 0; x < w; x++) {
-            Pixel *p = &img[y * w + x];
-            fwrite(p, 3, 1, f);
-        }
-        if (pad_size > 0) {
-            fwrite(padding, 1, pad_size, f);
-        }
+    if (written != (size_t)size || closed != 0) {
+        printf("Error: Failed writing %s\n", filename);
+        return -1;
     }
-    
-    fclose(f);
-}
\ No newline at end of file
+    return 0;
+}
@@ -0,0 +1,239 @@
+/**
+ * checkpoint.c - Checkpoint and Restart
+ * Save the complete simulation state so a preempted run can resume
+ *
+ * File layout (native byte order, read back by the same build):
+ *
+ *   CheckpointHeader    step, frame, counts and output file offsets
+ *   SimConfig           the run's configuration
+ *   Body[n_bodies]
+ *   per rocket          Rocket record (pointers cleared), then the
+ *                       trail window: x[trail_length], y[trail_length]
+ *   levels[n_rockets]   block time-step levels (has_levels)
+ *   trail layer         frame, width, height, stamp[w*h], rows[h],
+ *                       drawn[n_rockets] (incremental mode, canvas_offset)
+ *
+ * Positions, velocities and the accelerations carried between KDK steps
+ * are stored exactly, so a resumed run continues bit for bit where the
+ * checkpoint was taken. Files that the run appends to (trail spool,
+ * frames.log, the events CSV, a Y4M video) are referenced by their size at the
+ * checkpoint; on resume they are cut back to it, so work done after the
+ * checkpoint is redone rather than duplicated.
+ *
+ * A checkpoint is written to <file>.tmp, synced and renamed over the
+ * previous one: a crash while writing leaves the older checkpoint intact.
+ */
+
+#include "nbody.h"
+#include <unistd.h>
+
+/**
+ * Write `count` elements; returns 1 on success
+ */
+static int put(FILE *f, const void *data, size_t size, size_t count) {
+    return count == 0 || fwrite(data, size, count, f) == count;
+}
+
+/**
+ * Read `count` elements; returns 1 on success
+ */
+static int get(FILE *f, void *data, size_t size, size_t count) {
+    return count == 0 || fread(data, size, count, f) == count;
+}
+
+/**
+ * Write the checkpoint file, replacing the previous one atomically
+ * The AoS view of `state` must be current (sim_state_unpack)
+ */
+int checkpoint_save(const char *filename, CheckpointHeader *header, const SimState *state,
+                    const SimConfig *config, const TrailCanvas *canvas) {
+    memset(header->magic, 0, sizeof(header->magic));
+    memcpy(header->magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header->version = CHECKPOINT_VERSION;
+    header->config_size = sizeof(SimConfig);
+    header->body_size = sizeof(Body);
+    header->rocket_size = sizeof(Rocket);
+    header->time = state->time;
+    header->n_bodies = state->n_bodies;
+    header->n_rockets = state->n_rockets;
+    header->forces_valid = state->forces_valid;
+    header->has_levels = config->block_steps && state->n_rockets > 0 &&
+                         state->blocks.capacity >= state->n_rockets;
+    header->force_evals = state->blocks.force_evals;
+    header->canvas_offset = 0;
+    header->event_steps = state->events.steps;
+    memcpy(header->event_counts, state->events.counts, sizeof(header->event_counts));
+    
+    // Everything the spool holds so far must be on disk before the
+    // checkpoint that refers to it
+    header->spool_offset = -1;
+    header->spool_points = 0;
+    if (state->trail_sink) {
+        long offset = trail_sink_sync(state->trail_sink);
+        if (offset < 0) {
+            printf("Error: Could not sync the trail spool for a checkpoint\n");
+            return -1;
+        }
+        header->spool_offset = offset;
+        header->spool_points = state->trail_sink->points;
+    }
+    
+    char tmp[PATH_LEN + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", filename);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        printf("Error: Could not create %s\n", tmp);
+        return -1;
+    }
+    
+    int ok = put(f, header, sizeof(CheckpointHeader), 1) &&
+             put(f, config, sizeof(SimConfig), 1) &&
+             put(f, state->bodies, sizeof(Body), state->n_bodies);
+    
+    for (int i = 0; i < state->n_rockets && ok; i++) {
+        const Rocket *r = &state->rockets[i];
+        Rocket record = *r;
+        record.trail_x = NULL;
+        record.trail_y = NULL;
+        ok = put(f, &record, sizeof(Rocket), 1) &&
+             put(f, r->trail_x, sizeof(double), r->trail_length) &&
+             put(f, r->trail_y, sizeof(double), r->trail_length);
+    }
+    if (ok && header->has_levels) {
+        ok = put(f, state->blocks.level, 1, state->n_rockets);
+    }
+    
+    if (ok && canvas) {
+        long pixels = (long)canvas->width * canvas->height;
+        header->canvas_offset = ftell(f);
+        ok = put(f, &canvas->frame, sizeof(uint32_t), 1) &&
+             put(f, &canvas->width, sizeof(int), 1) &&
+             put(f, &canvas->height, sizeof(int), 1) &&
+             put(f, canvas->stamp, sizeof(uint32_t), pixels) &&
+             put(f, canvas->rows, 1, canvas->height) &&
+             put(f, canvas->drawn, sizeof(long), canvas->n_rockets);
+    }
+    
+    // Header again, now with the trail layer offset
+    ok = ok && fseek(f, 0, SEEK_SET) == 0 && put(f, header, sizeof(CheckpointHeader), 1);
+    ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    if (fclose(f) != 0) ok = 0;
+    
+    if (!ok || rename(tmp, filename) != 0) {
+        printf("Error: Could not write checkpoint %s\n", filename);
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Read the checkpoint into an empty state and pack it for the physics loop
+ */
+int checkpoint_load(const char *filename, CheckpointHeader *header, SimState *state,
+                    SimConfig *config) {
+    FILE *f = fopen(filename, "rb");
+    if (!f) {
+        printf("Error: Could not open checkpoint %s\n", filename);
+        return -1;
+    }
+    
+    if (!get(f, header, sizeof(CheckpointHeader), 1) ||
+        memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 ||
+        header->version != CHECKPOINT_VERSION ||
+        header->config_size != sizeof(SimConfig) || header->body_size != sizeof(Body) ||
+        header->rocket_size != sizeof(Rocket) ||
+        header->n_bodies < 0 || header->n_rockets < 0) {
+        printf("Error: %s is not a checkpoint written by this build\n", filename);
+        fclose(f);
+        return -1;
+    }
+    
+    int n_bodies = header->n_bodies, n_rockets = header->n_rockets;
+    int ok = get(f, config, sizeof(SimConfig), 1) &&
+             sim_state_reserve_bodies(state, n_bodies) == 0 &&
+             sim_state_reserve_rockets(state, n_rockets) == 0 &&
+             get(f, state->bodies, sizeof(Body), n_bodies);
+    if (ok) state->n_bodies = n_bodies;
+    
+    for (int i = 0; i < n_rockets && ok; i++) {
+        Rocket *r = &state->rockets[i];
+        ok = get(f, r, sizeof(Rocket), 1);
+        if (!ok) break;
+        
+        // Counted only once its trail pointers are valid, for sim_state_free()
+        int capacity = r->trail_capacity;
+        r->trail_x = NULL;
+        r->trail_y = NULL;
+        state->n_rockets = i + 1;
+        if (r->trail_length < 0 || r->trail_length > capacity) {
+            ok = 0;
+            break;
+        }
+        if (capacity > 0) {
+            r->trail_x = (double *)malloc(capacity * sizeof(double));
+            r->trail_y = (double *)malloc(capacity * sizeof(double));
+            ok = r->trail_x && r->trail_y &&
+                 get(f, r->trail_x, sizeof(double), r->trail_length) &&
+                 get(f, r->trail_y, sizeof(double), r->trail_length);
+        }
+    }
+    
+    // SoA columns, then the step state the physics loop carries over
+    ok = ok && sim_state_pack(state) == 0;
+    if (ok) {
+        state->forces_valid = header->forces_valid;
+        state->time = header->time;
+        state->blocks.force_evals = header->force_evals;
+        state->events.steps = header->event_steps;
+        memcpy(state->events.counts, header->event_counts, sizeof(state->events.counts));
+    }
+    if (ok && header->has_levels) {
+        ok = block_steps_reset(&state->blocks, n_rockets) == 0 &&
+             get(f, state->blocks.level, 1, n_rockets);
+    }
+    fclose(f);
+    
+    if (!ok) {
+        printf("Error: Checkpoint %s is truncated or damaged\n", filename);
+        sim_state_free(state);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Read the trail layer section into a canvas of matching size
+ */
+int checkpoint_load_canvas(const char *filename, const CheckpointHeader *header,
+                           TrailCanvas *canvas) {
+    if (header->canvas_offset <= 0) {
+        printf("Error: Checkpoint %s has no trail layer\n", filename);
+        return -1;
+    }
+    FILE *f = fopen(filename, "rb");
+    if (!f) {
+        printf("Error: Could not open checkpoint %s\n", filename);
+        return -1;
+    }
+    
+    uint32_t frame = 0;
+    int width = 0, height = 0;
+    int ok = fseek(f, (long)header->canvas_offset, SEEK_SET) == 0 &&
+             get(f, &frame, sizeof(uint32_t), 1) &&
+             get(f, &width, sizeof(int), 1) &&
+             get(f, &height, sizeof(int), 1) &&
+             width == canvas->width && height == canvas->height &&
+             canvas->n_rockets == header->n_rockets &&
+             get(f, canvas->stamp, sizeof(uint32_t), (size_t)width * height) &&
+             get(f, canvas->rows, 1, height) &&
+             get(f, canvas->drawn, sizeof(long), canvas->n_rockets);
+    fclose(f);
+    
+    if (!ok) {
+        printf("Error: Trail layer in %s does not match the view\n", filename);
+        return -1;
+    }
+    canvas->frame = frame;
+    return 0;
+}
@@ -0,0 +1,166 @@
+/**
+ * density.c - Density (Heatmap) Rendering
+ * Render very large rocket counts as a density map instead of markers
+ *
+ * With a million rockets, markers and trails are neither readable nor
+ * affordable. render_mode=density splats every active rocket into an
+ * accumulation buffer with bilinear (cloud-in-cell) weights and maps log
+ * density through a colour table, so the cost per frame is one splat
+ * per rocket plus one pass over the pixels, whatever the trail length.
+ *
+ * Each thread splats a contiguous block of rockets into its own buffer;
+ * nothing is shared, so no atomics are needed. The tone-mapping pass sums
+ * the buffers into the first one and clears them for the next frame.
+ * Weights are fixed point (DENSITY_SUBPIXEL steps per axis, 256 per
+ * rocket), so the sums, and the image, do not depend on the thread count.
+ */
+
+#include "nbody.h"
+
+#define DENSITY_LUT_FLOOR 48   // Colour index of the faintest non-empty pixel
+
+/**
+ * Colour map stops, dark purple to pale yellow (inferno-like)
+ */
+static const unsigned char density_stops[5][3] = {
+    {20, 11, 52}, {120, 28, 109}, {188, 55, 84}, {237, 105, 37}, {252, 255, 164}
+};
+
+/**
+ * Allocate the buffers and build the colour table
+ */
+int density_init(DensityMap *map, const Viewport *view, int threads) {
+    memset(map, 0, sizeof(DensityMap));
+    map->width = view->width;
+    map->height = view->height;
+    map->threads = OMP_THREADS(threads);
+    map->acc = (uint32_t *)calloc((size_t)map->threads * map->width * map->height,
+                                  sizeof(uint32_t));
+    if (!map->acc) {
+        printf("Error: Memory allocation failed (density buffers)\n");
+        return -1;
+    }
+    
+    // Linear interpolation between the stops
+    for (int k = 0; k < 256; k++) {
+        double t = k * 4.0 / 255.0;
+        int s = (t < 4.0) ? (int)t : 3;
+        double f = t - s;
+        const unsigned char *a = density_stops[s];
+        const unsigned char *b = density_stops[s + 1];
+        map->lut[k].r = (unsigned char)(a[0] + f * (b[0] - a[0]) + 0.5);
+        map->lut[k].g = (unsigned char)(a[1] + f * (b[1] - a[1]) + 0.5);
+        map->lut[k].b = (unsigned char)(a[2] + f * (b[2] - a[2]) + 0.5);
+    }
+    return 0;
+}
+
+/**
+ * Free the buffers
+ */
+void density_free(DensityMap *map) {
+    free(map->acc);
+    map->acc = NULL;
+}
+
+/**
+ * Splat positions [first, last) into one buffer
+ * Pixel i covers [i, i + 1) after projection, so its centre is i + 0.5
+ */
+static void splat(uint32_t *acc, const Viewport *view, const double *x, const double *y,
+                  const unsigned char *active, long first, long last) {
+    const int w = view->width, h = view->height;
+    const double cx = view->center_x, cy = view->center_y, scale = view->scale;
+    const double ox = w / 2 - 0.5, oy = h / 2 - 0.5;
+    const uint32_t S = DENSITY_SUBPIXEL;
+    
+    for (long i = first; i < last; i++) {
+        if (active && !active[i]) continue;
+        
+        double sx = (x[i] - cx) * scale + ox;
+        double sy = (y[i] - cy) * scale + oy;
+        // Also rejects NaN
+        if (!(sx > -1.0 && sx < w && sy > -1.0 && sy < h)) continue;
+        
+        double fx = floor(sx), fy = floor(sy);
+        int i0 = (int)fx, j0 = (int)fy;
+        uint32_t wx = (uint32_t)((sx - fx) * S);
+        uint32_t wy = (uint32_t)((sy - fy) * S);
+        uint32_t w00 = (S - wx) * (S - wy), w10 = wx * (S - wy);
+        uint32_t w01 = (S - wx) * wy, w11 = wx * wy;
+        
+        if (i0 >= 0 && i0 + 1 < w && j0 >= 0 && j0 + 1 < h) {
+            uint32_t *p = &acc[(long)j0 * w + i0];
+            p[0] += w00;
+            p[1] += w10;
+            p[w] += w01;
+            p[w + 1] += w11;
+            continue;
+        }
+        
+        // Image edge: drop the corners that fall outside
+        int in_x0 = (i0 >= 0), in_x1 = (i0 + 1 < w);
+        int in_y0 = (j0 >= 0), in_y1 = (j0 + 1 < h);
+        long row0 = (long)j0 * w, row1 = row0 + w;
+        if (in_y0 && in_x0) acc[row0 + i0] += w00;
+        if (in_y0 && in_x1) acc[row0 + i0 + 1] += w10;
+        if (in_y1 && in_x0) acc[row1 + i0] += w01;
+        if (in_y1 && in_x1) acc[row1 + i0 + 1] += w11;
+    }
+}
+
+/**
+ * Density frame: splat, sum, tone-map, then grid and bodies
+ */
+void render_density(DensityMap *map, const Body *bodies, int n_bodies,
+                    const double *x, const double *y, const unsigned char *active,
+                    int n, Pixel *img, const Viewport *view) {
+    const int w = map->width, h = map->height, threads = map->threads;
+    const long n_px = (long)w * h;
+    
+    // One contiguous block of rockets per thread, each into its own buffer
+    long block = ((long)n + threads - 1) / threads;
+    #pragma omp parallel for schedule(static, 1) if(threads > 1) num_threads(threads)
+    for (int t = 0; t < threads; t++) {
+        long first = t * block;
+        long last = (first + block < n) ? first + block : n;
+        if (first < last) splat(map->acc + t * n_px, view, x, y, active, first, last);
+    }
+    
+    // Sum the per-thread buffers into the first, clearing them as we go
+    uint32_t peak = 0;
+    #pragma omp parallel for reduction(max:peak) if(threads > 1) num_threads(threads)
+    for (int j = 0; j < h; j++) {
+        uint32_t *row = &map->acc[(long)j * w];
+        for (int t = 1; t < threads; t++) {
+            uint32_t *other = row + t * n_px;
+            for (int i = 0; i < w; i++) {
+                row[i] += other[i];
+                other[i] = 0;
+            }
+        }
+        for (int i = 0; i < w; i++) {
+            if (row[i] > peak) peak = row[i];
+        }
+    }
+    
+    // log(1 + rockets per pixel), scaled so the densest pixel is white-yellow
+    float gain = (peak > 0) ? (255 - DENSITY_LUT_FLOOR) / log1pf(peak / 256.0f) : 0.0f;
+    #pragma omp parallel for if(threads > 1) num_threads(threads)
+    for (int j = 0; j < h; j++) {
+        uint32_t *row = &map->acc[(long)j * w];
+        Pixel *out = &img[(long)j * view->stride];
+        for (int i = 0; i < w; i++) {
+            if (!row[i]) {
+                out[i].r = out[i].g = out[i].b = 0;
+                continue;
+            }
+            int k = DENSITY_LUT_FLOOR + (int)(log1pf(row[i] / 256.0f) * gain);
+            out[i] = map->lut[(k < 255) ? k : 255];
+            row[i] = 0;
+        }
+    }
+    
+    draw_grid(img, view, GRID_LEVEL);
+    draw_bodies(bodies, n_bodies, img, view);
+}
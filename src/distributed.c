@@ -0,0 +1,519 @@
+/**
+ * distributed.c - Distributed (MPI) Mode
+ * One run split across processes: mpirun -np N ./bin/nbody_mpi [options]
+ *
+ * Rockets are massless, so a rank never needs another rank's rockets:
+ * each rank steps its own contiguous share of the rockets against the
+ * same bodies. The bodies are integrated once, on rank 0, into a body
+ * ephemeris (built in memory, or the ephemeris_file of config.txt) that
+ * every rank receives before the first step, so nothing is exchanged
+ * while the run steps. Where the ephemeris cannot be used (block
+ * time-steps, or too large for memory) every rank integrates the bodies
+ * itself, which gives every rank the same trajectory.
+ *
+ * Shares are whole multiples of DISTRIBUTED_ALIGN rockets, so every
+ * rocket sits in the same SIMD lanes as in a single-process run and the
+ * results match it bitwise (until the live list is compacted, which
+ * happens per rank; see events.c).
+ *
+ * Each rank writes its own shards, with the rank before the extension:
+ *
+ *   rocket_trails.0002.bin    trails of rank 2's rockets (numbered from 0)
+ *   events.0002.csv           its events, with global rocket numbers
+ *
+ * Rank 0 gathers every rank's rows into rocket_stats.csv and
+ * final_rockets.txt, in global rocket order, the same files a
+ * single-process run writes. metadata.txt lists the shards and the
+ * first rocket of each.
+ *
+ * Frames, the frame log and checkpoints are not written.
+ */
+
+#include "nbody.h"
+#include <limits.h>
+#include <mpi.h>
+
+/**
+ * Rockets [first, first + count) of `n` that rank `rank` of `ranks` steps
+ * Blocks of DISTRIBUTED_ALIGN rockets are split as evenly as possible
+ */
+static void share_range(int n, int rank, int ranks, int *first, int *count) {
+    long blocks = (n + DISTRIBUTED_ALIGN - 1) / DISTRIBUTED_ALIGN;
+    long begin = (long)DISTRIBUTED_ALIGN * (blocks * rank / ranks);
+    long end = (long)DISTRIBUTED_ALIGN * (blocks * (rank + 1) / ranks);
+    if (begin > n) begin = n;
+    if (end > n) end = n;
+    *first = (int)begin;
+    *count = (int)(end - begin);
+}
+
+/**
+ * Output path of rank `rank`'s shard of `name`: rocket_trails.bin
+ * becomes rocket_trails.0002.bin
+ */
+static void shard_path(char *path, size_t size, const char *dir, const char *name, int rank) {
+    char shard[PATH_LEN];
+    const char *dot = strrchr(name, '.');
+    const char *slash = strrchr(name, '/');
+    if (!dot || (slash && dot < slash)) dot = name + strlen(name);
+    snprintf(shard, sizeof(shard), "%.*s.%04d%s", (int)(dot - name), name, rank, dot);
+    output_path(path, size, dir, shard);
+}
+
+/**
+ * Every rocket of `filename` as x y vx vy values, or the default rocket
+ * Returns the number of rockets or -1
+ */
+static long read_rockets(const char *filename, double **values) {
+    FILE *f = fopen(filename, "rb");
+    if (f) {
+        long n = input_read(f, filename, INPUT_ROCKET_FIELDS, values);
+        fclose(f);
+        return n;
+    }
+    
+    printf("Warning: Could not open %s, using default rockets\n", filename);
+    SimState scratch;
+    sim_state_init(&scratch);
+    init_rockets_default(&scratch);
+    long n = scratch.n_rockets;
+    *values = (double *)malloc((n > 0 ? n : 1) * INPUT_ROCKET_FIELDS * sizeof(double));
+    for (long i = 0; *values && i < n; i++) {
+        double *v = *values + i * INPUT_ROCKET_FIELDS;
+        v[0] = scratch.rockets[i].x;
+        v[1] = scratch.rockets[i].y;
+        v[2] = scratch.rockets[i].vx;
+        v[3] = scratch.rockets[i].vy;
+    }
+    sim_state_free(&scratch);
+    return *values ? n : -1;
+}
+
+/**
+ * Add rockets [first, first + count) of `values` to the state, as
+ * load_rockets() would
+ */
+static int add_rockets(SimState *state, const double *values, int first, int count) {
+    if (sim_state_reserve_rockets(state, count) != 0) return -1;
+    for (int i = 0; i < count; i++) {
+        const double *v = values + (size_t)(first + i) * INPUT_ROCKET_FIELDS;
+        Rocket *r = sim_state_add_rocket(state);
+        if (!r) return -1;
+        r->x = v[0];
+        r->y = v[1];
+        r->vx = v[2];
+        r->vy = v[3];
+        r->ax = 0.0;
+        r->ay = 0.0;
+        r->active = 1;
+        if (rocket_trail_init(r) != 0) return -1;
+    }
+    return 0;
+}
+
+/**
+ * Broadcast `n` doubles from rank 0, in DISTRIBUTED_CHUNK pieces
+ * (an MPI count is an int)
+ */
+static void bcast_doubles(double *data, size_t n) {
+    for (size_t done = 0; done < n; done += DISTRIBUTED_CHUNK) {
+        size_t chunk = (n - done < DISTRIBUTED_CHUNK) ? n - done : DISTRIBUTED_CHUNK;
+        MPI_Bcast(data + done, (int)chunk, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    }
+}
+
+/**
+ * Map the configured ephemeris file on every rank; rank 0 writes it
+ * first if it is missing or stale. Returns 1 if every rank mapped it
+ */
+static int open_ephemeris_file(BodyEphemeris *eph, const SimConfig *config,
+                               const Body *bodies, int n_bodies, int rank, int quiet) {
+    int ok = 0;
+    if (rank == 0) {
+        ok = (ephemeris_open(eph, config->ephemeris_file, bodies, n_bodies, config) == 0);
+        if (!ok) {
+            if (!quiet) {
+                printf("Writing ephemeris %s (%d steps, stride %d)...\n",
+                       config->ephemeris_file, config->steps, config->ephemeris_stride);
+            }
+            ok = (ephemeris_write(config->ephemeris_file, bodies, n_bodies, config,
+                                  config->ephemeris_stride) == 0 &&
+                  ephemeris_open(eph, config->ephemeris_file, bodies, n_bodies, config) == 0);
+        }
+    }
+    MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (ok && rank > 0) {
+        ok = (ephemeris_open(eph, config->ephemeris_file, bodies, n_bodies, config) == 0);
+    }
+    
+    int everywhere = 0;
+    MPI_Allreduce(&ok, &everywhere, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    if (!everywhere) ephemeris_free(eph);
+    return everywhere;
+}
+
+/**
+ * Integrate the bodies on rank 0 and broadcast the exact (stride 1)
+ * ephemeris. Returns 1 if every rank has it
+ */
+static int share_built_ephemeris(BodyEphemeris *eph, const SimConfig *config,
+                                 const Body *bodies, int n_bodies, int rank) {
+    long long shape[5] = {0, 0, 0, 0, 0};    // built, steps, stride, record, records
+    if (rank == 0 && ephemeris_build(eph, bodies, n_bodies, config, 1) == 0) {
+        shape[0] = 1;
+        shape[1] = eph->steps;
+        shape[2] = eph->stride;
+        shape[3] = eph->record;
+        shape[4] = eph->n_records;
+    }
+    MPI_Bcast(shape, 5, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+    if (!shape[0]) return 0;
+    
+    size_t doubles = (size_t)shape[3] * (size_t)shape[4];
+    int ok = 1;
+    if (rank > 0) {
+        memset(eph, 0, sizeof(BodyEphemeris));
+        eph->data = (double *)malloc((doubles > 0 ? doubles : 1) * sizeof(double));
+        if (!eph->data) {
+            printf("Error: Memory allocation failed (body ephemeris)\n");
+            ok = 0;
+        }
+        eph->records = eph->data;
+        eph->n_bodies = n_bodies;
+        eph->steps = (int)shape[1];
+        eph->stride = (int)shape[2];
+        eph->record = (int)shape[3];
+        eph->n_records = (long)shape[4];
+        eph->dt = config->dt;
+    }
+    
+    int everywhere = 0;
+    MPI_Allreduce(&ok, &everywhere, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    if (!everywhere) {
+        ephemeris_free(eph);
+        return 0;
+    }
+    bcast_doubles(eph->data, doubles);
+    return 1;
+}
+
+/**
+ * Gather every rank's text on rank 0, in rank order
+ * `all` (rank 0 only, free() it) gets the concatenation; returns 0 if
+ * every rank's text arrived
+ */
+static int gather_text(const char *text, size_t size, int ok, int rank, int ranks,
+                       char **all, size_t *all_size) {
+    *all = NULL;
+    *all_size = 0;
+    int part[2] = {0, 0};           // text arrived, its size
+    if (ok && size <= (size_t)INT_MAX) {
+        part[0] = 1;
+        part[1] = (int)size;
+    }
+    
+    int *parts = NULL, *counts = NULL, *displs = NULL;
+    if (rank == 0) {
+        parts = (int *)malloc(2 * ranks * sizeof(int));
+        counts = (int *)malloc(ranks * sizeof(int));
+        displs = (int *)malloc(ranks * sizeof(int));
+    }
+    MPI_Gather(part, 2, MPI_INT, parts, 2, MPI_INT, 0, MPI_COMM_WORLD);
+    
+    // Rank 0 decides whether the text fits one Gatherv, every rank learns it
+    int status = 0;
+    size_t total = 0;
+    if (rank == 0) {
+        if (!parts || !counts || !displs) status = -1;
+        for (int r = 0; status == 0 && r < ranks; r++) {
+            if (!parts[2 * r]) status = -1;
+            counts[r] = parts[2 * r + 1];
+            displs[r] = (int)total;
+            total += (size_t)counts[r];
+            if (total > (size_t)INT_MAX) status = -1;
+        }
+        if (status == 0) {
+            *all = (char *)malloc(total > 0 ? total : 1);
+            if (!*all) status = -1;
+        }
+    }
+    MPI_Bcast(&status, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    
+    if (status == 0) {
+        MPI_Gatherv(text, part[1], MPI_CHAR, *all, counts, displs, MPI_CHAR, 0,
+                    MPI_COMM_WORLD);
+        *all_size = total;
+    } else if (rank == 0) {
+        free(*all);
+        *all = NULL;
+    }
+    free(parts);
+    free(counts);
+    free(displs);
+    return status;
+}
+
+/**
+ * Write gathered rows under `header`
+ */
+static int write_gathered(const char *filename, const char *header, const char *rows,
+                          size_t size) {
+    FILE *f = fopen(filename, "w");
+    if (!f) {
+        printf("Error: Could not create %s\n", filename);
+        return -1;
+    }
+    fprintf(f, "%s", header);
+    int ok = (fwrite(rows, 1, size, f) == size);
+    if (fclose(f) != 0) ok = 0;
+    if (!ok) {
+        printf("Error: Could not write %s\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Gather the final_rockets.txt and rocket_stats.csv rows of every rank
+ * and write both files on rank 0
+ */
+static int write_merged_outputs(const char *final_path, const char *stats_path,
+                                Rocket *rockets, int n, int first, double dt,
+                                int rank, int ranks) {
+    int failed = 0;
+    for (int file = 0; file < 2; file++) {
+        char *rows = NULL, *all = NULL;
+        size_t size = 0, all_size = 0;
+        FILE *mem = open_memstream(&rows, &size);
+        int ok = (mem != NULL);
+        if (mem) {
+            if (file == 0) write_rocket_data(mem, rockets, n, first);
+            else write_trajectory_stats(mem, NULL, rockets, n, dt, first);
+            if (fclose(mem) != 0) ok = 0;
+        }
+        
+        const char *path = (file == 0) ? final_path : stats_path;
+        if (gather_text(rows, size, ok, rank, ranks, &all, &all_size) != 0) {
+            if (rank == 0) printf("Error: Could not gather the rows of %s\n", path);
+            failed = 1;
+        } else if (rank == 0) {
+            const char *header = (file == 0) ? ROCKET_DATA_HEADER : TRAJECTORY_STATS_HEADER;
+            if (write_gathered(path, header, all, all_size) != 0) failed = 1;
+        }
+        free(rows);
+        free(all);
+    }
+    return failed ? -1 : 0;
+}
+
+/**
+ * Append the ranks and their shards to metadata.txt
+ */
+static void save_shard_metadata(const char *filename, const char *trails_file,
+                                const char *events_file, int n_rockets, int ranks) {
+    FILE *f = fopen(filename, "a");
+    if (!f) {
+        printf("Error: Could not write %s\n", filename);
+        return;
+    }
+    fprintf(f, "\n# Distributed run\n");
+    fprintf(f, "Ranks: %d\n", ranks);
+    for (int r = 0; r < ranks; r++) {
+        int first, count;
+        share_range(n_rockets, r, ranks, &first, &count);
+        char trails[PATH_LEN], events[PATH_LEN];
+        shard_path(trails, sizeof(trails), "", trails_file, r);
+        fprintf(f, "Shard %d: rockets %d-%d (%d) -> %s", r, first, first + count - 1,
+                count, trails);
+        if (events_file[0] != '\0') {
+            shard_path(events, sizeof(events), "", events_file, r);
+            fprintf(f, ", %s", events);
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+}
+
+/**
+ * Run the simulation with the rockets split across the ranks
+ */
+int distributed_run(const SimConfig *config, const char *bodies_file, const char *rockets_file,
+                    const char *output_dir, int quiet) {
+    int rank = 0, ranks = 1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+    
+    SimConfig run = *config;
+    if (run.checkpoint_interval > 0) {
+        if (rank == 0) printf("Warning: Distributed runs do not write checkpoints\n");
+        run.checkpoint_interval = 0;
+    }
+    
+    char metadata_path[PATH_LEN], final_path[PATH_LEN], stats_path[PATH_LEN];
+    char trails_path[PATH_LEN], events_path[PATH_LEN];
+    output_path(metadata_path, sizeof(metadata_path), output_dir, "metadata.txt");
+    output_path(final_path, sizeof(final_path), output_dir, "final_rockets.txt");
+    output_path(stats_path, sizeof(stats_path), output_dir, "rocket_stats.csv");
+    shard_path(trails_path, sizeof(trails_path), output_dir, "rocket_trails.bin", rank);
+    shard_path(events_path, sizeof(events_path), output_dir, run.events_file, rank);
+    
+    // Every rank reads the inputs and keeps its own share of the rockets
+    SimState state;
+    sim_state_init(&state);
+    if (load_bodies(bodies_file, &state) < 0) {
+        init_bodies_default(&state);
+    }
+    double *values = NULL;
+    long n_total = read_rockets(rockets_file, &values);
+    int first = 0, n_rockets = 0;
+    int ok = (n_total >= 0 && n_total <= INT_MAX);
+    if (ok) {
+        share_range((int)n_total, rank, ranks, &first, &n_rockets);
+        ok = (add_rockets(&state, values, first, n_rockets) == 0 &&
+              sim_state_pack(&state) == 0);
+        if (!ok) printf("Error: Rank %d: memory allocation failed\n", rank);
+    }
+    free(values);
+    
+    int everywhere = 0;
+    MPI_Allreduce(&ok, &everywhere, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    if (!everywhere) {
+        sim_state_free(&state);
+        return 1;
+    }
+    int n_bodies = state.n_bodies;
+    double initial_energy = compute_energy(&state.body_soa, run.g);
+    
+    // Bodies: integrated once and shared, unless they cannot be
+    BodyEphemeris ephemeris;
+    memset(&ephemeris, 0, sizeof(ephemeris));
+    int shared = 0;
+    if (ephemeris_supported(&run)) {
+        if (run.ephemeris_file[0] != '\0') {
+            shared = open_ephemeris_file(&ephemeris, &run, state.bodies, n_bodies,
+                                         rank, quiet);
+        }
+        if (!shared) {
+            shared = share_built_ephemeris(&ephemeris, &run, state.bodies, n_bodies, rank);
+        }
+    }
+    if (shared) {
+        state.ephemeris = &ephemeris;
+        state.ephemeris_step = 0;
+    } else if (rank == 0 && !quiet) {
+        printf("Bodies integrated on every rank (no shared ephemeris)\n");
+    }
+    
+    if (rank == 0 && !quiet) {
+        int most = 0, fewest = INT_MAX;
+        for (int r = 0; r < ranks; r++) {
+            int r_first, r_count;
+            share_range((int)n_total, r, ranks, &r_first, &r_count);
+            if (r_count > most) most = r_count;
+            if (r_count < fewest) fewest = r_count;
+        }
+        printf("\n====================================\n");
+        printf("Distributed Simulation Parameters\n");
+        printf("====================================\n");
+        printf("Ranks: %d\n", ranks);
+        printf("Bodies: %d%s\n", n_bodies, shared ? " (shared ephemeris)" : "");
+        printf("Rockets: %ld, %d-%d per rank in blocks of %d\n", n_total, fewest, most,
+               DISTRIBUTED_ALIGN);
+        printf("Steps: %d\n", run.steps);
+        printf("Time step: %.4f\n", run.dt);
+        printf("Rocket kernel: %s\n", rocket_kernel_name(rocket_kernel_kind()));
+        if (run.threads > 0) {
+            printf("Threads per rank: %d\n", run.threads);
+        }
+        printf("Events: escape radius %.1f, collision radius %.1f, %d region(s)\n",
+               run.escape_radius, run.collision_radius, run.n_regions);
+        printf("====================================\n\n");
+    }
+    
+    // Per-rank shards: trails and events
+    TrailSink trail_sink;
+    if (trail_sink_open(&trail_sink, trails_path, n_rockets, run.trail_precision) == 0) {
+        state.trail_sink = &trail_sink;
+    }
+    EventLog event_log;
+    int events_open = (event_log_open(&event_log, run.events_file[0] ? events_path : NULL,
+                                      !quiet, -1) == 0);
+    if (events_open) event_log.rocket_offset = first;
+    state.events.log = events_open ? &event_log : NULL;
+    
+    if (rank == 0) save_metadata(metadata_path, n_bodies, (int)n_total, &run);
+    if (rank == 0 && !quiet) printf("Starting simulation...\n");
+    
+    // No communication until the last step
+    MPI_Barrier(MPI_COMM_WORLD);
+    double started = MPI_Wtime();
+    for (int step = 0; step < run.steps; step++) {
+        sim_step(&state, &run);
+    }
+    double seconds = MPI_Wtime() - started;
+    sim_state_unpack(&state);
+    
+    double final_energy = compute_energy(&state.body_soa, run.g);
+    ephemeris_free(&ephemeris);
+    state.ephemeris = NULL;
+    state.events.log = NULL;
+    if (events_open) event_log_close(&event_log);
+    
+    int status = 0;
+    if (state.trail_sink) {
+        if (trail_sink_close(state.trail_sink, state.rockets, n_rockets) != 0) status = 1;
+        state.trail_sink = NULL;
+    } else {
+        save_rocket_trails_bin(trails_path, state.rockets, n_rockets);
+    }
+    if (write_merged_outputs(final_path, stats_path, state.rockets, n_rockets, first,
+                             run.dt, rank, ranks) != 0) {
+        status = 1;
+    }
+    
+    // Totals over the ranks
+    long long local[EVENT_KINDS + 1], total[EVENT_KINDS + 1];
+    for (int k = 0; k < EVENT_KINDS; k++) local[k] = (long long)state.events.counts[k];
+    local[EVENT_KINDS] = state.events.n_live;
+    MPI_Reduce(local, total, EVENT_KINDS + 1, MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    double slowest = 0.0, fastest = 0.0;
+    MPI_Reduce(&seconds, &slowest, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&seconds, &fastest, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, &status, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    
+    if (rank == 0) {
+        save_shard_metadata(metadata_path, "rocket_trails.bin", run.events_file,
+                            (int)n_total, ranks);
+        
+        printf("\n====================================\n");
+        printf("Distributed Simulation Complete!\n");
+        printf("====================================\n");
+        if (shared) {
+            printf("Energy: bodies read from the shared ephemeris, drift not measured\n");
+        } else {
+            printf("Energy: %.6e -> %.6e (relative drift %.3e)\n", initial_energy,
+                   final_energy, (initial_energy != 0.0) ?
+                   fabs((final_energy - initial_energy) / initial_energy) : 0.0);
+        }
+        printf("Events: %lld escapes, %lld collisions, %lld region entries (%lld rockets still active)\n",
+               total[EVENT_ESCAPE], total[EVENT_COLLISION], total[EVENT_REGION],
+               total[EVENT_KINDS]);
+        printf("Ranks: %d, stepping took %.3f s on the slowest, %.3f s on the fastest\n",
+               ranks, slowest, fastest);
+        if (!quiet) {
+            printf("\nOutput files generated:\n");
+            printf("  - %s (final positions and velocities)\n", final_path);
+            printf("  - %s (statistical analysis)\n", stats_path);
+            shard_path(trails_path, sizeof(trails_path), output_dir, "rocket_trails.bin", 0);
+            printf("  - %s ... one per rank (binary trajectory data)\n", trails_path);
+            if (events_open && run.events_file[0] != '\0') {
+                shard_path(events_path, sizeof(events_path), output_dir, run.events_file, 0);
+                printf("  - %s ... one per rank (rocket events)\n", events_path);
+            }
+            printf("  - %s (simulation parameters and shards)\n", metadata_path);
+        }
+    }
+    
+    sim_state_free(&state);
+    return status;
+}
@@ -0,0 +1,308 @@
+/**
+ * ephemeris.c - Body Ephemeris
+ * Precomputed body trajectories for rocket-only runs
+ *
+ * Rockets are massless test particles: they never act on the bodies, so
+ * the body trajectory is the same in every run that starts from the same
+ * bodies with the same dt, g, solver, integrator and precision. An
+ * ephemeris records the body positions once; runs that point
+ * state->ephemeris at it integrate only their rockets (see sim_step()).
+ *
+ * With stride 1 every step is stored and the rocket forces are evaluated
+ * at exactly the positions a full run computes, so the rocket
+ * trajectories are bitwise identical. A stride of N stores every Nth step
+ * with the body velocities and interpolates in between (cubic Hermite,
+ * error O((N dt)^4)), for a file N/2 times smaller.
+ *
+ * Block time-steps predict the bodies to intermediate times from their
+ * velocities and accelerations, which the ephemeris does not keep; such
+ * runs integrate their own bodies.
+ *
+ * File layout (native byte order, like the checkpoint):
+ *
+ *   EphemerisHeader     128 bytes: dynamics, body hash, record layout
+ *   record[n_records]   x[n], y[n] (stride 1) or x[n], y[n], vx[n], vy[n]
+ *
+ * ephemeris_file= keeps the ephemeris between runs: a run maps a file
+ * that matches its bodies and settings and writes a new one otherwise.
+ * Records are read through a read-only mmap(), so the kernel streams them
+ * in as the run advances.
+ */
+
+#include "nbody.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Rockets stepped against an ephemeris match a full run with `config`
+ */
+int ephemeris_supported(const SimConfig *config) {
+    return !(config->block_steps && config->integrator == INTEGRATOR_KDK);
+}
+
+/**
+ * Records needed to cover `steps` steps (the last one may lie beyond)
+ */
+static long record_count(int steps, int stride) {
+    return (steps + stride - 1) / stride + 1;
+}
+
+/**
+ * Doubles per record: positions, plus velocities for interpolation
+ */
+static int record_size(int n_bodies, int stride) {
+    return (stride > 1 ? 4 : 2) * n_bodies;
+}
+
+/**
+ * FNV-1a hash of the initial body positions, velocities and masses
+ */
+static uint64_t hash_bodies(const Body *bodies, int n_bodies) {
+    uint64_t h = 1469598103934665603ULL;
+    for (int i = 0; i < n_bodies; i++) {
+        double fields[5] = {bodies[i].x, bodies[i].y, bodies[i].vx, bodies[i].vy,
+                            bodies[i].mass};
+        const unsigned char *bytes = (const unsigned char *)fields;
+        for (size_t k = 0; k < sizeof(fields); k++) {
+            h = (h ^ bytes[k]) * 1099511628211ULL;
+        }
+    }
+    return h;
+}
+
+/**
+ * Integrate the bodies and hand every `stride`th state to `out` (memory)
+ * or `f` (file); returns 0 on success
+ */
+static int record_trajectory(const Body *bodies, int n_bodies, const SimConfig *config,
+                             int stride, double *out, FILE *f) {
+    SimState state;
+    sim_state_init(&state);
+    if (sim_state_reserve_bodies(&state, n_bodies) != 0) return -1;
+    memcpy(state.bodies, bodies, n_bodies * sizeof(Body));
+    state.n_bodies = n_bodies;
+    if (sim_state_pack(&state) != 0) {
+        sim_state_free(&state);
+        return -1;
+    }
+    
+    const ParticleSoA *b = &state.body_soa;
+    const double *columns[4] = {b->x, b->y, b->vx, b->vy};
+    int n_columns = (stride > 1) ? 4 : 2;
+    long n_records = record_count(config->steps, stride);
+    int ok = 1;
+    
+    for (long k = 0; k < n_records && ok; k++) {
+        if (k > 0) {
+            for (int s = 0; s < stride; s++) sim_step(&state, config);
+        }
+        for (int c = 0; c < n_columns && ok; c++) {
+            if (out) {
+                memcpy(out, columns[c], n_bodies * sizeof(double));
+                out += n_bodies;
+            } else {
+                ok = fwrite(columns[c], sizeof(double), n_bodies, f) == (size_t)n_bodies;
+            }
+        }
+    }
+    
+    sim_state_free(&state);
+    return ok ? 0 : -1;
+}
+
+/**
+ * Build an ephemeris in memory
+ */
+int ephemeris_build(BodyEphemeris *eph, const Body *bodies, int n_bodies,
+                    const SimConfig *config, int stride) {
+    memset(eph, 0, sizeof(BodyEphemeris));
+    if (config->steps < 0 || stride < 1) return -1;
+    
+    long n_records = record_count(config->steps, stride);
+    int record = record_size(n_bodies, stride);
+    size_t doubles = (size_t)n_records * record;
+    if (doubles * sizeof(double) > (size_t)EPHEMERIS_MAX_BYTES) {
+        return -1;
+    }
+    
+    eph->data = (double *)malloc((doubles > 0 ? doubles : 1) * sizeof(double));
+    if (!eph->data || record_trajectory(bodies, n_bodies, config, stride, eph->data, NULL) != 0) {
+        printf("Error: Memory allocation failed (body ephemeris)\n");
+        ephemeris_free(eph);
+        return -1;
+    }
+    eph->records = eph->data;
+    eph->n_bodies = n_bodies;
+    eph->steps = config->steps;
+    eph->stride = stride;
+    eph->record = record;
+    eph->n_records = n_records;
+    eph->dt = config->dt;
+    return 0;
+}
+
+/**
+ * Stream an ephemeris into a file, replacing it atomically
+ */
+int ephemeris_write(const char *filename, const Body *bodies, int n_bodies,
+                    const SimConfig *config, int stride) {
+    if (config->steps < 0 || stride < 1) return -1;
+    
+    EphemerisHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, EPHEMERIS_MAGIC, sizeof(EPHEMERIS_MAGIC));
+    header.version = EPHEMERIS_VERSION;
+    header.n_bodies = (uint32_t)n_bodies;
+    header.steps = config->steps;
+    header.stride = stride;
+    header.record = (uint32_t)record_size(n_bodies, stride);
+    header.integrator = config->integrator;
+    header.solver = config->solver;
+    header.precision = (uint32_t)config->precision;
+    header.dt = config->dt;
+    header.g = config->g;
+    header.theta = config->theta;
+    header.body_hash = hash_bodies(bodies, n_bodies);
+    header.data_offset = EPHEMERIS_DATA_OFFSET;
+    header.n_records = (uint64_t)record_count(config->steps, stride);
+    
+    char tmp[PATH_LEN + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", filename);
+    FILE *f = fopen(tmp, "wb");
+    if (!f) {
+        printf("Error: Could not create %s\n", tmp);
+        return -1;
+    }
+    
+    unsigned char pad[EPHEMERIS_DATA_OFFSET - sizeof(EphemerisHeader)];
+    memset(pad, 0, sizeof(pad));
+    int ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+             fwrite(pad, 1, sizeof(pad), f) == sizeof(pad) &&
+             record_trajectory(bodies, n_bodies, config, stride, NULL, f) == 0;
+    if (fclose(f) != 0) ok = 0;
+    
+    if (!ok || rename(tmp, filename) != 0) {
+        printf("Error: Could not write ephemeris %s\n", filename);
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Why a file cannot serve this run, or NULL if it can
+ */
+static const char *header_mismatch(const EphemerisHeader *h, size_t size,
+                                   const Body *bodies, int n_bodies,
+                                   const SimConfig *config) {
+    if (memcmp(h->magic, EPHEMERIS_MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != EPHEMERIS_VERSION) {
+        return "not an ephemeris file of this version";
+    }
+    if (h->n_bodies != (uint32_t)n_bodies) return "different number of bodies";
+    if (bodies && h->body_hash != hash_bodies(bodies, n_bodies)) return "different bodies";
+    if (h->dt != config->dt || h->g != config->g || h->integrator != config->integrator ||
+        h->solver != config->solver || h->precision != (uint32_t)config->precision ||
+        (config->solver == SOLVER_BH && h->theta != config->theta)) {
+        return "different dt, g, integrator, solver or precision";
+    }
+    if (h->stride != config->ephemeris_stride) return "different ephemeris_stride";
+    if (h->steps < config->steps) return "covers fewer steps";
+    if (h->record != (uint32_t)record_size(n_bodies, h->stride) ||
+        h->data_offset != EPHEMERIS_DATA_OFFSET ||
+        h->n_records != (uint64_t)record_count(h->steps, h->stride) ||
+        h->n_records * h->record * sizeof(double) > size - h->data_offset) {
+        return "truncated or damaged";
+    }
+    return NULL;
+}
+
+/**
+ * Map a matching ephemeris file
+ */
+int ephemeris_open(BodyEphemeris *eph, const char *filename, const Body *bodies,
+                   int n_bodies, const SimConfig *config) {
+    memset(eph, 0, sizeof(BodyEphemeris));
+    
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        if (!file_io_is_quiet()) printf("Ephemeris %s: not found\n", filename);
+        return -1;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < EPHEMERIS_DATA_OFFSET) {
+        printf("Ephemeris %s: not an ephemeris file\n", filename);
+        close(fd);
+        return -1;
+    }
+    
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping stays valid
+    if (base == MAP_FAILED) {
+        printf("Error: Could not map %s\n", filename);
+        return -1;
+    }
+    
+    const EphemerisHeader *h = (const EphemerisHeader *)base;
+    const char *reason = header_mismatch(h, (size_t)st.st_size, bodies, n_bodies, config);
+    if (reason) {
+        if (!file_io_is_quiet()) printf("Ephemeris %s: %s\n", filename, reason);
+        munmap(base, (size_t)st.st_size);
+        return -1;
+    }
+    
+    // Records are read front to back
+    posix_madvise(base, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+    
+    eph->map = base;
+    eph->map_size = (size_t)st.st_size;
+    eph->records = (const double *)((const unsigned char *)base + h->data_offset);
+    eph->n_bodies = n_bodies;
+    eph->steps = h->steps;
+    eph->stride = h->stride;
+    eph->record = (int)h->record;
+    eph->n_records = (long)h->n_records;
+    eph->dt = h->dt;
+    return 0;
+}
+
+/**
+ * Body positions after `step` steps, into the SoA x/y columns
+ */
+void ephemeris_bodies(const BodyEphemeris *eph, int step, ParticleSoA *bodies) {
+    int n = eph->n_bodies;
+    const double *r0 = eph->records + (size_t)(step / eph->stride) * eph->record;
+    int within = step % eph->stride;
+    
+    if (within == 0) {
+        memcpy(bodies->x, r0, n * sizeof(double));
+        memcpy(bodies->y, r0 + n, n * sizeof(double));
+        return;
+    }
+    
+    // Cubic Hermite between the records around `step`
+    const double *r1 = r0 + eph->record;
+    double s = (double)within / eph->stride;
+    double h = eph->stride * eph->dt;
+    double h00 = (2.0 * s - 3.0) * s * s + 1.0;
+    double h10 = ((s - 2.0) * s + 1.0) * s * h;
+    double h01 = (3.0 - 2.0 * s) * s * s;
+    double h11 = (s - 1.0) * s * s * h;
+    for (int i = 0; i < n; i++) {
+        bodies->x[i] = h00 * r0[i] + h10 * r0[2 * n + i] + h01 * r1[i] + h11 * r1[2 * n + i];
+        bodies->y[i] = h00 * r0[n + i] + h10 * r0[3 * n + i] +
+                       h01 * r1[n + i] + h11 * r1[3 * n + i];
+    }
+}
+
+/**
+ * Free the records or unmap the file
+ */
+void ephemeris_free(BodyEphemeris *eph) {
+    free(eph->data);
+    if (eph->map) munmap(eph->map, eph->map_size);
+    memset(eph, 0, sizeof(BodyEphemeris));
+}
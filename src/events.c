@@ -0,0 +1,508 @@
+/**
+ * events.c - Rocket Events
+ * Escape, collision and region detection, and the live rocket list
+ *
+ * After every step each live rocket is tested, in this order, for
+ *
+ *   escape     distance from the origin above escape_radius
+ *   collision  distance to a body below collision_radius (the lowest
+ *              numbered body within reach is reported)
+ *   region     entering one of the region= rectangles (a rocket that
+ *              starts inside a region has not entered it)
+ *
+ * Escapes and collisions deactivate the rocket, as do regions marked
+ * "stop". With EVENT_GRID_MIN bodies or more, collisions are culled on a
+ * hashed grid of collision_radius cells, so a rocket only looks at the
+ * bodies in the 3x3 cells around it.
+ *
+ * The detection pass filters the dense list of live rockets in place.
+ * Trail recording and detection loop over that list only, and once
+ * 1/LIVE_GATHER_FRACTION of the rockets are inactive the force kernels
+ * run on the live positions gathered into a dense copy, so rockets that
+ * have left the run cost nothing per step. A rocket that moves from a
+ * vector lane of the force kernel to its scalar remainder (or back) by
+ * the compaction can change in the last bits, as with a different
+ * kernel; runs stay deterministic and independent of the thread count.
+ *
+ * Events are queued to an EventLog, whose writer thread formats them
+ * into the events CSV (Step,Time,Rocket,Event,Detail,X,Y,Distance) and
+ * the console, off the simulation thread.
+ */
+
+#include "nbody.h"
+#include <unistd.h>
+
+static const char *kind_names[EVENT_KINDS] = {"escape", "collision", "region"};
+
+/**
+ * Name of an event kind, as written to the events CSV
+ */
+const char *event_kind_name(int kind) {
+    return (kind >= 0 && kind < EVENT_KINDS) ? kind_names[kind] : "unknown";
+}
+
+/**
+ * Grow an int array to hold at least `needed` elements
+ */
+static int reserve_ints(int **data, int *capacity, int needed) {
+    if (needed <= *capacity) return 0;
+    int *grown = (int *)realloc(*data, (size_t)needed * sizeof(int));
+    if (!grown) return -1;
+    *data = grown;
+    *capacity = needed;
+    return 0;
+}
+
+/* ============================================================================
+ * LIVE ROCKETS
+ * ============================================================================ */
+
+/**
+ * Region bits of a position
+ */
+static uint8_t region_bits(const SimConfig *config, double x, double y) {
+    uint8_t bits = 0;
+    for (int k = 0; k < config->n_regions; k++) {
+        const EventRegion *r = &config->regions[k];
+        if (x >= r->x0 && x <= r->x1 && y >= r->y0 && y <= r->y1) bits |= (uint8_t)(1u << k);
+    }
+    return bits;
+}
+
+/**
+ * Rebuild the live list and the region bits from the rocket SoA
+ * Called before a step whenever sim_state_pack() has reloaded the rockets
+ */
+int events_prepare(SimState *state, const SimConfig *config) {
+    RocketEvents *ev = &state->events;
+    const ParticleSoA *r = &state->rocket_soa;
+    
+    if (reserve_ints(&ev->live, &ev->live_capacity, r->n) != 0) {
+        printf("Error: Memory allocation failed (%d live rockets)\n", r->n);
+        return -1;
+    }
+    if (r->n > ev->inside_capacity) {
+        uint8_t *grown = (uint8_t *)realloc(ev->inside, (size_t)r->n);
+        if (!grown) {
+            printf("Error: Memory allocation failed (%d live rockets)\n", r->n);
+            return -1;
+        }
+        ev->inside = grown;
+        ev->inside_capacity = r->n;
+    }
+    
+    ev->n_live = 0;
+    for (int i = 0; i < r->n; i++) {
+        ev->inside[i] = 0;
+        if (!r->active[i]) continue;
+        
+        ev->live[ev->n_live++] = i;
+        ev->inside[i] = region_bits(config, r->x[i], r->y[i]);
+    }
+    ev->live_valid = 1;
+    return 0;
+}
+
+/**
+ * Rockets for the force kernels: the rocket SoA itself, or the live
+ * rockets' positions gathered into events.dense once enough are inactive
+ */
+ParticleSoA *events_force_rockets(SimState *state) {
+    RocketEvents *ev = &state->events;
+    ParticleSoA *r = &state->rocket_soa;
+    int inactive = r->n - ev->n_live;
+    if (!ev->live_valid || inactive == 0 || (long)inactive * LIVE_GATHER_FRACTION < r->n ||
+        soa_reserve(&ev->dense, ev->n_live) != 0) {
+        return r;
+    }
+    
+    ParticleSoA *d = &ev->dense;
+    for (int k = 0; k < ev->n_live; k++) {
+        int i = ev->live[k];
+        d->x[k] = r->x[i];
+        d->y[k] = r->y[i];
+        d->active[k] = 1;
+    }
+    d->n = ev->n_live;
+    return d;
+}
+
+/**
+ * Copy accelerations computed on events_force_rockets() back to the
+ * rocket SoA (nothing to do when the kernels ran on it directly)
+ */
+void events_scatter_forces(SimState *state, const ParticleSoA *rockets) {
+    RocketEvents *ev = &state->events;
+    ParticleSoA *r = &state->rocket_soa;
+    if (rockets == r) return;
+    
+    for (int k = 0; k < ev->n_live; k++) {
+        int i = ev->live[k];
+        r->ax[i] = rockets->ax[k];
+        r->ay[i] = rockets->ay[k];
+    }
+}
+
+/* ============================================================================
+ * DETECTION
+ * ============================================================================ */
+
+/**
+ * Grid cell of a coordinate, clamped so far-away points stay in range
+ */
+static long long grid_cell(double v, double cell) {
+    double c = floor(v / cell);
+    if (c > 1e15) c = 1e15;
+    if (c < -1e15) c = -1e15;
+    return (long long)c;
+}
+
+/**
+ * Bucket of grid cell (cx, cy)
+ */
+static int grid_bucket(long long cx, long long cy, int mask) {
+    uint64_t h = (uint64_t)cx * 0x9E3779B97F4A7C15ULL ^ (uint64_t)cy * 0xC2B2AE3D27D4EB4FULL;
+    return (int)((h ^ (h >> 29)) & (uint64_t)mask);
+}
+
+/**
+ * Sort the bodies into hashed collision_radius cells (counting sort)
+ */
+static int grid_build(RocketEvents *ev, const ParticleSoA *b, double cell) {
+    int buckets = 1;
+    while (buckets < 2 * b->n) buckets <<= 1;
+    if (reserve_ints(&ev->grid_start, &ev->grid_capacity, buckets + 2) != 0 ||
+        reserve_ints(&ev->grid_body, &ev->grid_bodies, b->n) != 0) {
+        return -1;
+    }
+    ev->grid_mask = buckets - 1;
+    
+    int *start = ev->grid_start;
+    memset(start, 0, (size_t)(buckets + 2) * sizeof(int));
+    for (int j = 0; j < b->n; j++) {
+        start[grid_bucket(grid_cell(b->x[j], cell), grid_cell(b->y[j], cell), ev->grid_mask) + 2]++;
+    }
+    for (int k = 2; k < buckets + 2; k++) start[k] += start[k - 1];
+    for (int j = 0; j < b->n; j++) {
+        int k = grid_bucket(grid_cell(b->x[j], cell), grid_cell(b->y[j], cell), ev->grid_mask);
+        ev->grid_body[start[k + 1]++] = j;
+    }
+    return 0;
+}
+
+/**
+ * Lowest numbered body within `radius` of (x, y), or -1
+ * `grid` selects the culled search over the cells around the rocket
+ */
+static int find_collision(const RocketEvents *ev, const ParticleSoA *b, int grid,
+                          double radius, double x, double y, double *distance) {
+    double r2 = radius * radius;
+    int hit = -1;
+    double hit_d2 = 0.0;
+    
+    if (!grid) {
+        for (int j = 0; j < b->n; j++) {
+            double dx = b->x[j] - x, dy = b->y[j] - y;
+            double d2 = dx * dx + dy * dy;
+            if (d2 < r2) {
+                hit = j;
+                hit_d2 = d2;
+                break;
+            }
+        }
+    } else {
+        long long cx = grid_cell(x, radius), cy = grid_cell(y, radius);
+        for (int oy = -1; oy <= 1; oy++) {
+            for (int ox = -1; ox <= 1; ox++) {
+                int k = grid_bucket(cx + ox, cy + oy, ev->grid_mask);
+                for (int s = ev->grid_start[k]; s < ev->grid_start[k + 1]; s++) {
+                    int j = ev->grid_body[s];
+                    if (hit >= 0 && j >= hit) continue;
+                    double dx = b->x[j] - x, dy = b->y[j] - y;
+                    double d2 = dx * dx + dy * dy;
+                    if (d2 < r2) {
+                        hit = j;
+                        hit_d2 = d2;
+                    }
+                }
+            }
+        }
+    }
+    
+    if (hit >= 0) *distance = sqrt(hit_d2);
+    return hit;
+}
+
+/**
+ * Queue one event of this step
+ */
+static void add_event(RocketEvents *ev, const SimState *state, int rocket, int kind,
+                      int detail, double x, double y, double distance) {
+    if (ev->n_pending == ev->pending_capacity) {
+        int capacity = ev->pending_capacity ? 2 * ev->pending_capacity : INITIAL_CAPACITY;
+        RocketEvent *grown = (RocketEvent *)realloc(ev->pending,
+                                                    (size_t)capacity * sizeof(RocketEvent));
+        if (!grown) return;  // Counted, but not logged
+        ev->pending = grown;
+        ev->pending_capacity = capacity;
+    }
+    
+    RocketEvent *e = &ev->pending[ev->n_pending++];
+    e->step = ev->steps;
+    e->time = state->time;
+    e->rocket = rocket;
+    e->kind = kind;
+    e->detail = detail;
+    e->x = x;
+    e->y = y;
+    e->distance = distance;
+}
+
+/**
+ * Test every live rocket for escape, collision and region entry, drop
+ * deactivated rockets from the live list and queue the step's events
+ */
+void events_detect(SimState *state, const SimConfig *config) {
+    RocketEvents *ev = &state->events;
+    ParticleSoA *r = &state->rocket_soa;
+    const ParticleSoA *b = &state->body_soa;
+    if (!ev->live_valid && events_prepare(state, config) != 0) return;
+    
+    ev->steps++;
+    ev->n_pending = 0;
+    
+    // Escape: compare squares first, then decide exactly as sqrt() does
+    double escape = config->escape_radius;
+    double escape_near = 0.999999 * escape * escape;
+    double collide = config->collision_radius;
+    int grid = collide > 0.0 && b->n >= EVENT_GRID_MIN && grid_build(ev, b, collide) == 0;
+    
+    int kept = 0;
+    for (int k = 0; k < ev->n_live; k++) {
+        int i = ev->live[k];
+        double x = r->x[i], y = r->y[i];
+        int stop = 0;
+        
+        double d2 = x * x + y * y;
+        if (escape > 0.0 && d2 > escape_near && sqrt(d2) > escape) {
+            add_event(ev, state, i, EVENT_ESCAPE, -1, x, y, sqrt(d2));
+            ev->counts[EVENT_ESCAPE]++;
+            stop = 1;
+        }
+        
+        double distance = 0.0;
+        int body = (!stop && collide > 0.0) ?
+                   find_collision(ev, b, grid, collide, x, y, &distance) : -1;
+        if (body >= 0) {
+            add_event(ev, state, i, EVENT_COLLISION, body, x, y, distance);
+            ev->counts[EVENT_COLLISION]++;
+            stop = 1;
+        }
+        
+        if (!stop && config->n_regions > 0) {
+            uint8_t now = region_bits(config, x, y);
+            uint8_t entered = now & (uint8_t)~ev->inside[i];
+            ev->inside[i] = now;
+            for (int g = 0; g < config->n_regions && entered; g++) {
+                if (!(entered & (1u << g))) continue;
+                
+                add_event(ev, state, i, EVENT_REGION, g, x, y, 0.0);
+                ev->counts[EVENT_REGION]++;
+                if (config->regions[g].stop) stop = 1;
+            }
+        }
+        
+        if (stop) {
+            r->active[i] = 0;
+        } else {
+            ev->live[kept++] = i;
+        }
+    }
+    ev->n_live = kept;
+    
+    if (ev->log && ev->n_pending > 0) event_log_submit(ev->log, ev->pending, ev->n_pending);
+}
+
+/**
+ * Free the live list, gathered copy, region bits and grid
+ */
+void events_free(RocketEvents *ev) {
+    free(ev->live);
+    soa_free(&ev->dense);
+    free(ev->inside);
+    free(ev->pending);
+    free(ev->grid_start);
+    free(ev->grid_body);
+    memset(ev, 0, sizeof(RocketEvents));
+}
+
+/* ============================================================================
+ * ASYNCHRONOUS EVENT LOG
+ * ============================================================================ */
+
+/**
+ * Format one event on the console as rocket `rocket`
+ */
+static void print_event(const RocketEvent *e, int rocket) {
+    switch (e->kind) {
+        case EVENT_ESCAPE:
+            printf("Rocket %d left simulation area (distance: %.2f)\n", rocket, e->distance);
+            break;
+        case EVENT_COLLISION:
+            printf("Rocket %d hit body %d (distance: %.3f)\n", rocket, e->detail, e->distance);
+            break;
+        default:
+            printf("Rocket %d entered region %d at (%.2f, %.2f)\n", rocket, e->detail,
+                   e->x, e->y);
+            break;
+    }
+}
+
+/**
+ * Writer thread: take the whole queue, format it outside the lock
+ */
+static void *event_writer(void *arg) {
+    EventLog *log = (EventLog *)arg;
+    RocketEvent *batch = NULL;
+    int batch_capacity = 0;
+    
+    pthread_mutex_lock(&log->lock);
+    for (;;) {
+        while (log->n_queued == 0 && !log->stopping) {
+            pthread_cond_wait(&log->ready, &log->lock);
+        }
+        if (log->n_queued == 0) break;
+        
+        // Swap buffers: the simulation keeps queueing into the old batch
+        RocketEvent *events = log->queue;
+        int events_capacity = log->capacity;
+        int n = log->n_queued;
+        log->queue = batch;
+        log->capacity = batch_capacity;
+        log->n_queued = 0;
+        batch = events;
+        batch_capacity = events_capacity;
+        log->busy = 1;
+        pthread_mutex_unlock(&log->lock);
+        
+        for (int k = 0; k < n; k++) {
+            const RocketEvent *e = &batch[k];
+            int rocket = log->rocket_offset + e->rocket;
+            if (log->out) {
+                fprintf(log->out, "%lld,%.6f,%d,%s,%d,%.6f,%.6f,%.6f\n", (long long)e->step,
+                        e->time, rocket, event_kind_name(e->kind), e->detail,
+                        e->x, e->y, e->distance);
+            }
+            if (log->console) print_event(e, rocket);
+        }
+        
+        pthread_mutex_lock(&log->lock);
+        log->written += n;
+        log->busy = 0;
+        if (log->n_queued == 0) pthread_cond_broadcast(&log->idle);
+    }
+    pthread_mutex_unlock(&log->lock);
+    free(batch);
+    return NULL;
+}
+
+/**
+ * Start the writer; `filename` NULL or "" logs to the console only
+ * A resumed run (resume_offset >= 0) cuts the file back to its size at
+ * the checkpoint and appends
+ */
+int event_log_open(EventLog *log, const char *filename, int console, long resume_offset) {
+    memset(log, 0, sizeof(EventLog));
+    log->console = console;
+    
+    if (filename && filename[0] != '\0') {
+        if (resume_offset >= 0) {
+            if (truncate(filename, (off_t)resume_offset) != 0) {
+                printf("Warning: %s of the interrupted run not found\n", filename);
+            }
+            log->out = fopen(filename, "a");
+        } else {
+            log->out = fopen(filename, "w");
+            if (log->out) fprintf(log->out, "Step,Time,Rocket,Event,Detail,X,Y,Distance\n");
+        }
+        if (!log->out) {
+            printf("Error: Could not create %s\n", filename);
+            return -1;
+        }
+    }
+    
+    pthread_mutex_init(&log->lock, NULL);
+    pthread_cond_init(&log->ready, NULL);
+    pthread_cond_init(&log->idle, NULL);
+    if (pthread_create(&log->thread, NULL, event_writer, log) != 0) {
+        printf("Error: Could not start the event writer\n");
+        pthread_mutex_destroy(&log->lock);
+        pthread_cond_destroy(&log->ready);
+        pthread_cond_destroy(&log->idle);
+        if (log->out) fclose(log->out);
+        log->out = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Queue events for the writer (copied; never waits for the file)
+ */
+void event_log_submit(EventLog *log, const RocketEvent *events, int n) {
+    pthread_mutex_lock(&log->lock);
+    if (log->n_queued + n > log->capacity) {
+        int capacity = log->capacity ? log->capacity : INITIAL_CAPACITY;
+        while (capacity < log->n_queued + n) capacity *= 2;
+        RocketEvent *grown = (RocketEvent *)realloc(log->queue,
+                                                    (size_t)capacity * sizeof(RocketEvent));
+        if (!grown) {
+            pthread_mutex_unlock(&log->lock);
+            printf("Error: Memory allocation failed (%d events not logged)\n", n);
+            return;
+        }
+        log->queue = grown;
+        log->capacity = capacity;
+    }
+    memcpy(log->queue + log->n_queued, events, (size_t)n * sizeof(RocketEvent));
+    log->n_queued += n;
+    pthread_cond_signal(&log->ready);
+    pthread_mutex_unlock(&log->lock);
+}
+
+/**
+ * Wait until every queued event is written; returns the file size
+ * (for a checkpoint) or -1 without a file
+ */
+long event_log_sync(EventLog *log) {
+    pthread_mutex_lock(&log->lock);
+    while (log->n_queued > 0 || log->busy) {
+        pthread_cond_wait(&log->idle, &log->lock);
+    }
+    pthread_mutex_unlock(&log->lock);
+    fflush(stdout);
+    return (log->out && fflush(log->out) == 0) ? ftell(log->out) : -1;
+}
+
+/**
+ * Write the remaining events, stop the writer and close the file
+ * Returns 0, or -1 if the file could not be written
+ */
+int event_log_close(EventLog *log) {
+    pthread_mutex_lock(&log->lock);
+    log->stopping = 1;
+    pthread_cond_signal(&log->ready);
+    pthread_mutex_unlock(&log->lock);
+    pthread_join(log->thread, NULL);
+    
+    pthread_mutex_destroy(&log->lock);
+    pthread_cond_destroy(&log->ready);
+    pthread_cond_destroy(&log->idle);
+    free(log->queue);
+    log->queue = NULL;
+    
+    int status = 0;
+    if (log->out && fclose(log->out) != 0) status = -1;
+    log->out = NULL;
+    return status;
+}
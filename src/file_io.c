@@ -5,95 +5,374 @@
 
 #include "nbody.h"
 
+static int quiet_loaders = 0;   // file_io_quiet(): only errors and warnings
+static int verbose_loaders = 0; // file_io_verbose(): every loaded entity
+
+/**
+ * Turn progress messages off or on, returning the previous setting
+ * Batch runs load thousands of rocket files from several threads;
+ * nbody --quiet keeps scheduler logs to errors and the final summary
+ */
+int file_io_quiet(int quiet) {
+    int previous = quiet_loaders;
+    quiet_loaders = quiet;
+    return previous;
+}
+
+/**
+ * 1 if progress messages are off
+ */
+int file_io_is_quiet(void) {
+    return quiet_loaders;
+}
+
+/**
+ * Turn the per-body and per-rocket load messages on or off, returning
+ * the previous setting (nbody --verbose)
+ */
+int file_io_verbose(int verbose) {
+    int previous = verbose_loaders;
+    verbose_loaders = verbose;
+    return previous;
+}
+
+/**
+ * Build an output path: `dir`/`name`, or `name` alone when there is no
+ * directory, the name is absolute or it is "-" (stdout)
+ */
+void output_path(char *path, size_t size, const char *dir, const char *name) {
+    if (!dir || dir[0] == '\0' || name[0] == '/' || strcmp(name, "-") == 0) {
+        snprintf(path, size, "%s", name);
+    } else {
+        size_t len = strlen(dir);
+        snprintf(path, size, "%s%s%s", dir, (dir[len - 1] == '/') ? "" : "/", name);
+    }
+}
+
 /**
  * Load Body Parameters from a File (Exercise 1.1)
+ * Text ("x y vx vy mass" per line) or binary (see input.c); storage is
+ * sized from the file, so there is no upper limit on bodies
  */
-int load_bodies(const char *filename, Body *bodies, int max_bodies) {
-    FILE *f = fopen(filename, "r");
+int load_bodies(const char *filename, SimState *state) {
+    FILE *f = fopen(filename, "rb");
     if (!f) {
         printf("Warning: Could not open %s, using default bodies\n", filename);
         return -1;
     }
     
-    int count = 0;
-    char line[256];
+    if (!quiet_loaders) printf("Loading bodies from %s...\n", filename);
     
-    printf("Loading bodies from %s...\n", filename);
+    double *values = NULL;
+    long n = input_read(f, filename, INPUT_BODY_FIELDS, &values);
+    fclose(f);
+    if (n < 0 || sim_state_reserve_bodies(state, state->n_bodies + (int)n) != 0) {
+        free(values);
+        return -1;
+    }
     
-    while (fgets(line, sizeof(line), f) && count < max_bodies) {
-        if (line[0] == '#' || line[0] == '\n') continue;
+    int count = 0;
+    for (; count < n; count++) {
+        const double *v = values + (size_t)count * INPUT_BODY_FIELDS;
+        Body *b = sim_state_add_body(state);
+        if (!b) break;
+        
+        b->x = v[0];
+        b->y = v[1];
+        b->vx = v[2];
+        b->vy = v[3];
+        b->mass = v[4];
+        b->ax = 0.0;
+        b->ay = 0.0;
         
-        double x, y, vx, vy, mass;
-        if (sscanf(line, "%lf %lf %lf %lf %lf", &x, &y, &vx, &vy, &mass) == 5) {
-            bodies[count].x = x;
-            bodies[count].y = y;
-            bodies[count].vx = vx;
-            bodies[count].vy = vy;
-            bodies[count].mass = mass;
-            bodies[count].ax = 0.0;
-            bodies[count].ay = 0.0;
-            
+        if (verbose_loaders && !quiet_loaders) {
             printf("  Body %d: pos(%.2f, %.2f) vel(%.2f, %.2f) mass=%.2f\n",
-                   count, x, y, vx, vy, mass);
-            count++;
+                   count, b->x, b->y, b->vx, b->vy, b->mass);
         }
     }
     
-    fclose(f);
-    printf("Loaded %d bodies\n\n", count);
+    free(values);
+    if (!quiet_loaders) printf("Loaded %d bodies\n\n", count);
     return count;
 }
 
 /**
  * Initialize Rockets from a File (Exercise 1.2)
+ * Text ("x y vx vy" per line) or binary (see input.c); storage is sized
+ * from the file, so there is no upper limit on rockets
  */
-int load_rockets(const char *filename, Rocket *rockets, int max_rockets) {
-    FILE *f = fopen(filename, "r");
+int load_rockets(const char *filename, SimState *state) {
+    FILE *f = fopen(filename, "rb");
     if (!f) {
         printf("Warning: Could not open %s, using default rockets\n", filename);
         return -1;
     }
     
-    int count = 0;
-    char line[256];
+    if (!quiet_loaders) printf("Loading rockets from %s...\n", filename);
     
-    printf("Loading rockets from %s...\n", filename);
+    double *values = NULL;
+    long n = input_read(f, filename, INPUT_ROCKET_FIELDS, &values);
+    fclose(f);
+    if (n < 0 || sim_state_reserve_rockets(state, state->n_rockets + (int)n) != 0) {
+        free(values);
+        return -1;
+    }
     
-    while (fgets(line, sizeof(line), f) && count < max_rockets) {
-        if (line[0] == '#' || line[0] == '\n') continue;
+    int count = 0;
+    for (; count < n; count++) {
+        const double *v = values + (size_t)count * INPUT_ROCKET_FIELDS;
+        Rocket *r = sim_state_add_rocket(state);
+        if (!r) break;
+        
+        r->x = v[0];
+        r->y = v[1];
+        r->vx = v[2];
+        r->vy = v[3];
+        r->ax = 0.0;
+        r->ay = 0.0;
+        r->active = 1;
+        
+        rocket_trail_init(r);
         
-        double x, y, vx, vy;
-        if (sscanf(line, "%lf %lf %lf %lf", &x, &y, &vx, &vy) == 4) {
-            rockets[count].x = x;
-            rockets[count].y = y;
-            rockets[count].vx = vx;
-            rockets[count].vy = vy;
-            rockets[count].ax = 0.0;
-            rockets[count].ay = 0.0;
-            rockets[count].active = 1;
-            
-            rockets[count].trail_capacity = STEPS;
-            rockets[count].trail_x = (double *)malloc(STEPS * sizeof(double));
-            rockets[count].trail_y = (double *)malloc(STEPS * sizeof(double));
-            rockets[count].trail_length = 0;
-            
-            rockets[count].trail_x[0] = x;
-            rockets[count].trail_y[0] = y;
-            rockets[count].trail_length = 1;
-            
+        if (verbose_loaders && !quiet_loaders) {
             printf("  Rocket %d: pos(%.2f, %.2f) vel(%.4f, %.4f)\n",
-                   count, x, y, vx, vy);
-            count++;
+                   count, r->x, r->y, r->vx, r->vy);
         }
     }
     
-    fclose(f);
-    printf("Loaded %d rockets\n\n", count);
+    free(values);
+    if (!quiet_loaders) printf("Loaded %d rockets\n\n", count);
     return count;
 }
 
+/**
+ * Fill a configuration with the compile-time defaults
+ */
+void sim_config_default(SimConfig *config) {
+    memset(config, 0, sizeof(SimConfig));
+    config->dt = DT;
+    config->steps = STEPS;
+    config->frames = FRAMES;
+    config->save_interval = STEPS / FRAMES;
+    config->g = G;
+    config->threads = 0;
+    config->solver = SOLVER_DIRECT;
+    config->theta = THETA;
+    config->integrator = INTEGRATOR_KDK;
+    config->precision = PRECISION_DOUBLE;
+    config->block_steps = 0;
+    config->eta = BLOCK_ETA;
+    config->trail_precision = 64;
+    config->trail_stride = 1;
+    config->trail_tolerance = 0.0;
+    config->frame_threads = FRAME_THREADS;
+    config->frame_buffers = FRAME_BUFFERS;
+    config->render_mode = RENDER_FULL;
+    config->trail_decay = TRAIL_DECAY;
+    config->video_output = VIDEO_BMP;
+    config->video_file[0] = '\0';
+    config->video_fps = VIDEO_FPS;
+    config->width = WIDTH;
+    config->height = HEIGHT;
+    config->scale = 0.0;
+    config->center_x = 0.0;
+    config->center_y = 0.0;
+    config->render_threads = 1;
+    config->checkpoint_interval = 0;
+    config->batch_threads = 0;
+    snprintf(config->checkpoint_file, sizeof(config->checkpoint_file), "%s", CHECKPOINT_FILE);
+    config->ephemeris_file[0] = '\0';
+    config->ephemeris_stride = 1;
+    config->timing_file[0] = '\0';
+    config->escape_radius = ESCAPE_RADIUS;
+    config->collision_radius = 0.0;
+    config->n_regions = 0;
+    snprintf(config->events_file, sizeof(config->events_file), "%s", EVENTS_FILE);
+    config->replay_first = 0;
+    config->replay_last = -1;
+    config->replay_threads = 0;
+}
+
+/**
+ * Parse a region= value "x0,y0,x1,y1[,stop]" and add it to the config
+ * An empty value removes all regions
+ */
+static void config_add_region(SimConfig *config, const char *text) {
+    if (text[0] == '\0') {
+        config->n_regions = 0;
+        return;
+    }
+    
+    EventRegion r;
+    char flag[16] = "";
+    int fields = sscanf(text, " %lf , %lf , %lf , %lf , %15s", &r.x0, &r.y0, &r.x1, &r.y1, flag);
+    if (fields < 4 || (fields == 5 && strcmp(flag, "stop") != 0)) {
+        printf("Warning: region must be x0,y0,x1,y1[,stop], ignoring '%s'\n", text);
+        return;
+    }
+    if (config->n_regions == EVENT_MAX_REGIONS) {
+        printf("Warning: At most %d regions, ignoring '%s'\n", EVENT_MAX_REGIONS, text);
+        return;
+    }
+    
+    // Corners may be given in either order
+    if (r.x0 > r.x1) { double t = r.x0; r.x0 = r.x1; r.x1 = t; }
+    if (r.y0 > r.y1) { double t = r.y0; r.y0 = r.y1; r.y1 = t; }
+    r.stop = (fields == 5);
+    config->regions[config->n_regions++] = r;
+}
+
+/**
+ * Apply one key=value configuration option
+ * Values are numbers except for named options such as solver=direct|bh,
+ * integrator=kdk|euler, precision=double|mixed|float,
+ * render_mode=full|incremental|density,
+ * video_output=bmp|ffmpeg|y4m, region=x0,y0,x1,y1[,stop] (repeatable)
+ * and the video_file, checkpoint_file, ephemeris_file, timing_file and
+ * events_file names.
+ * Returns 0 for a known key (a bad value warns and keeps the old one),
+ * -1 for an unknown key or a number that does not parse
+ */
+int config_set_option(SimConfig *config, const char *key, const char *text) {
+    // Named options
+    if (strcmp(key, "solver") == 0) {
+        if (strcmp(text, "bh") == 0) config->solver = SOLVER_BH;
+        else if (strcmp(text, "direct") == 0) config->solver = SOLVER_DIRECT;
+        else printf("Warning: Unknown solver '%s', keeping default\n", text);
+        return 0;
+    }
+    if (strcmp(key, "integrator") == 0) {
+        if (strcmp(text, "kdk") == 0) config->integrator = INTEGRATOR_KDK;
+        else if (strcmp(text, "euler") == 0) config->integrator = INTEGRATOR_EULER;
+        else printf("Warning: Unknown integrator '%s', keeping default\n", text);
+        return 0;
+    }
+    if (strcmp(key, "precision") == 0) {
+        if (strcmp(text, "double") == 0) config->precision = PRECISION_DOUBLE;
+        else if (strcmp(text, "mixed") == 0) config->precision = PRECISION_MIXED;
+        else if (strcmp(text, "float") == 0) config->precision = PRECISION_FLOAT;
+        else printf("Warning: Unknown precision '%s', keeping default\n", text);
+        return 0;
+    }
+    if (strcmp(key, "render_mode") == 0) {
+        if (strcmp(text, "incremental") == 0) config->render_mode = RENDER_INCREMENTAL;
+        else if (strcmp(text, "full") == 0) config->render_mode = RENDER_FULL;
+        else if (strcmp(text, "density") == 0) config->render_mode = RENDER_DENSITY;
+        else printf("Warning: Unknown render_mode '%s', keeping default\n", text);
+        return 0;
+    }
+    if (strcmp(key, "video_output") == 0) {
+        if (strcmp(text, "bmp") == 0) config->video_output = VIDEO_BMP;
+        else if (strcmp(text, "ffmpeg") == 0) config->video_output = VIDEO_FFMPEG;
+        else if (strcmp(text, "y4m") == 0) config->video_output = VIDEO_Y4M;
+        else printf("Warning: Unknown video_output '%s', keeping default\n", text);
+        return 0;
+    }
+    if (strcmp(key, "video_file") == 0) {
+        snprintf(config->video_file, sizeof(config->video_file), "%s", text);
+        return 0;
+    }
+    if (strcmp(key, "checkpoint_file") == 0) {
+        snprintf(config->checkpoint_file, sizeof(config->checkpoint_file), "%s", text);
+        return 0;
+    }
+    if (strcmp(key, "ephemeris_file") == 0) {
+        snprintf(config->ephemeris_file, sizeof(config->ephemeris_file), "%s", text);
+        return 0;
+    }
+    if (strcmp(key, "timing_file") == 0) {
+        snprintf(config->timing_file, sizeof(config->timing_file), "%s", text);
+        return 0;
+    }
+    if (strcmp(key, "events_file") == 0) {
+        snprintf(config->events_file, sizeof(config->events_file), "%s", text);
+        return 0;
+    }
+    if (strcmp(key, "region") == 0) {
+        config_add_region(config, text);
+        return 0;
+    }
+    
+    // Numeric options
+    char *end;
+    double value = strtod(text, &end);
+    if (end == text) return -1;
+    
+    if (strcmp(key, "dt") == 0) config->dt = value;
+    else if (strcmp(key, "steps") == 0) config->steps = (int)value;
+    else if (strcmp(key, "frames") == 0) config->frames = (int)value;
+    else if (strcmp(key, "save_interval") == 0) config->save_interval = (int)value;
+    else if (strcmp(key, "g") == 0) config->g = value;
+    else if (strcmp(key, "threads") == 0) config->threads = (int)value;
+    else if (strcmp(key, "theta") == 0) config->theta = value;
+    else if (strcmp(key, "block_steps") == 0) config->block_steps = (int)value;
+    else if (strcmp(key, "eta") == 0) config->eta = value;
+    else if (strcmp(key, "frame_threads") == 0) config->frame_threads = (int)value;
+    else if (strcmp(key, "frame_buffers") == 0) config->frame_buffers = (int)value;
+    else if (strcmp(key, "video_fps") == 0) config->video_fps = (int)value;
+    else if (strcmp(key, "scale") == 0) config->scale = value;
+    else if (strcmp(key, "center_x") == 0) config->center_x = value;
+    else if (strcmp(key, "center_y") == 0) config->center_y = value;
+    else if (strcmp(key, "render_threads") == 0) config->render_threads = (int)value;
+    else if (strcmp(key, "checkpoint_interval") == 0) {
+        if ((int)value >= 0) config->checkpoint_interval = (int)value;
+        else printf("Warning: checkpoint_interval must be >= 0, keeping default\n");
+    }
+    else if (strcmp(key, "width") == 0 || strcmp(key, "height") == 0) {
+        if ((int)value >= 1 && (int)value <= MAX_IMAGE_SIZE) {
+            if (key[0] == 'w') config->width = (int)value;
+            else config->height = (int)value;
+        } else {
+            printf("Warning: %s must be 1..%d pixels, keeping default\n",
+                   key, MAX_IMAGE_SIZE);
+        }
+    }
+    else if (strcmp(key, "trail_decay") == 0) {
+        if (value > 0.0 && value <= 1.0) config->trail_decay = value;
+        else printf("Warning: trail_decay must be in (0, 1], keeping default\n");
+    }
+    else if (strcmp(key, "trail_precision") == 0) {
+        if ((int)value == 32 || (int)value == 64) config->trail_precision = (int)value;
+        else printf("Warning: trail_precision must be 64 or 32, keeping default\n");
+    }
+    else if (strcmp(key, "trail_stride") == 0) {
+        if ((int)value >= 1) config->trail_stride = (int)value;
+        else printf("Warning: trail_stride must be >= 1, keeping default\n");
+    }
+    else if (strcmp(key, "trail_tolerance") == 0) {
+        if (value >= 0.0) config->trail_tolerance = value;
+        else printf("Warning: trail_tolerance must be >= 0 pixels, keeping default\n");
+    }
+    else if (strcmp(key, "batch_threads") == 0) config->batch_threads = (int)value;
+    else if (strcmp(key, "replay_threads") == 0) config->replay_threads = (int)value;
+    else if (strcmp(key, "replay_first") == 0 || strcmp(key, "replay_last") == 0) {
+        int minimum = (key[7] == 'f') ? 0 : -1;
+        if ((int)value >= minimum) {
+            if (key[7] == 'f') config->replay_first = (int)value;
+            else config->replay_last = (int)value;
+        } else {
+            printf("Warning: %s must be >= %d, keeping default\n", key, minimum);
+        }
+    }
+    else if (strcmp(key, "ephemeris_stride") == 0) {
+        if ((int)value >= 1) config->ephemeris_stride = (int)value;
+        else printf("Warning: ephemeris_stride must be >= 1, keeping default\n");
+    }
+    else if (strcmp(key, "escape_radius") == 0 || strcmp(key, "collision_radius") == 0) {
+        if (value >= 0.0) {
+            if (key[0] == 'e') config->escape_radius = value;
+            else config->collision_radius = value;
+        } else {
+            printf("Warning: %s must be >= 0, keeping default\n", key);
+        }
+    }
+    else return -1;
+    return 0;
+}
+
 /**
  * Load Simulation Configuration (Exercise 4.3)
+ * One key=value option per line, see config_set_option()
  */
 int load_config(const char *filename, SimConfig *config) {
     FILE *f = fopen(filename, "r");
@@ -103,115 +382,118 @@ int load_config(const char *filename, SimConfig *config) {
     }
     
     char line[256];
-    printf("Loading configuration from %s...\n", filename);
+    if (!quiet_loaders) printf("Loading configuration from %s...\n", filename);
     
     while (fgets(line, sizeof(line), f)) {
         if (line[0] == '#' || line[0] == '\n') continue;
         
         char key[64];
-        double value;
-        if (sscanf(line, "%[^=]=%lf", key, &value) == 2) {
-            if (strcmp(key, "dt") == 0) config->dt = value;
-            else if (strcmp(key, "steps") == 0) config->steps = (int)value;
-            else if (strcmp(key, "frames") == 0) config->frames = (int)value;
-            else if (strcmp(key, "save_interval") == 0) config->save_interval = (int)value;
-            else if (strcmp(key, "g") == 0) config->g = value;
-        }
+        char text[64];
+        if (sscanf(line, "%63[^=]=%63s", key, text) != 2) continue;
+        config_set_option(config, key, text);
     }
     
     fclose(f);
+    if (quiet_loaders) return 0;
     printf("Configuration loaded:\n");
-    printf("  dt=%.4f, steps=%d, frames=%d, save_interval=%d, g=%.2f\n\n",
+    printf("  dt=%.4f, steps=%d, frames=%d, save_interval=%d, g=%.2f, threads=%d\n",
            config->dt, config->steps, config->frames, 
-           config->save_interval, config->g);
+           config->save_interval, config->g, config->threads);
+    printf("  solver=%s, theta=%.2f, integrator=%s, block_steps=%d, eta=%.3f\n\n",
+           (config->solver == SOLVER_BH) ? "bh" : "direct", config->theta,
+           (config->integrator == INTEGRATOR_EULER) ? "euler" : "kdk",
+           config->block_steps, config->eta);
     return 0;
 }
 
 /**
- * Save Final Rocket Positions (Exercise 2.1)
+ * Write one final-state row per rocket, numbered from `first_id`
  */
-void save_rocket_data(const char *filename, Rocket *rockets, int n) {
-    FILE *f = fopen(filename, "w");
-    if (!f) {
-        printf("Error: Could not create %s\n", filename);
-        return;
-    }
-    
-    fprintf(f, "# Rocket_ID   Final_X   Final_Y   Final_VX   Final_VY   Trail_Length\n");
-    
+void write_rocket_data(FILE *f, const Rocket *rockets, int n, int first_id) {
     for (int i = 0; i < n; i++) {
         fprintf(f, "%d   %.6f   %.6f   %.6f   %.6f   %d\n",
-                i, rockets[i].x, rockets[i].y, 
+                first_id + i, rockets[i].x, rockets[i].y, 
                 rockets[i].vx, rockets[i].vy,
                 rockets[i].trail_length);
     }
-    
-    fclose(f);
-    printf("Saved final rocket data to %s\n", filename);
 }
 
 /**
- * Save Rocket Trajectories in Binary Format (Exercise 2.2)
+ * Save Final Rocket Positions (Exercise 2.1)
  */
-void save_rocket_trails_bin(const char *filename, Rocket *rockets, int n) {
-    FILE *f = fopen(filename, "wb");
+void save_rocket_data(const char *filename, Rocket *rockets, int n) {
+    FILE *f = fopen(filename, "w");
     if (!f) {
         printf("Error: Could not create %s\n", filename);
         return;
     }
     
-    fwrite(&n, sizeof(int), 1, f);
-    
-    for (int i = 0; i < n; i++) {
-        fwrite(&rockets[i].trail_length, sizeof(int), 1, f);
-        fwrite(rockets[i].trail_x, sizeof(double), rockets[i].trail_length, f);
-        fwrite(rockets[i].trail_y, sizeof(double), rockets[i].trail_length, f);
-    }
+    fprintf(f, "%s", ROCKET_DATA_HEADER);
+    write_rocket_data(f, rockets, n, 0);
     
     fclose(f);
-    printf("Saved rocket trails in binary format to %s\n", filename);
+    if (!quiet_loaders) printf("Saved final rocket data to %s\n", filename);
 }
 
 /**
- * Save Trajectory Summary Statistics (Exercise 3.1)
+ * Save Rocket Trajectories in Binary Format (Exercise 2.2)
+ * Writes the indexed v2 trajectory format (see trail_io.c)
  */
-void save_trajectory_stats(const char *filename, Rocket *rockets, int n, double dt) {
-    FILE *f = fopen(filename, "w");
-    if (!f) {
-        printf("Error: Could not create %s\n", filename);
+void save_rocket_trails_bin(const char *filename, Rocket *rockets, int n) {
+    if (write_trail_file(filename, rockets, n, 64) != 0) {
+        printf("Error: Could not write %s\n", filename);
         return;
     }
-    
-    fprintf(f, "RocketID,TrailLength,FinalDistance,MaxDistance,AverageSpeed\n");
-    
+    if (!quiet_loaders) printf("Saved rocket trails in binary format to %s\n", filename);
+}
+
+/**
+ * Write one CSV summary row per rocket, numbered from `first_id`
+ * With a scenario name (batch mode) each row starts with it
+ */
+void write_trajectory_stats(FILE *f, const char *scenario, Rocket *rockets, int n, double dt,
+                            int first_id) {
     for (int i = 0; i < n; i++) {
         double final_dist = sqrt(rockets[i].x * rockets[i].x + 
                                 rockets[i].y * rockets[i].y);
         
-        double max_dist = 0.0;
-        double total_distance = 0.0;
+        // Samples of the whole run, including those decimation did not keep
+        int trail_length = rockets[i].trail_dropped + rockets[i].trail_length +
+                           rockets[i].trail_skipped;
         
-        for (int j = 0; j < rockets[i].trail_length; j++) {
-            double dist = sqrt(rockets[i].trail_x[j] * rockets[i].trail_x[j] +
-                             rockets[i].trail_y[j] * rockets[i].trail_y[j]);
-            if (dist > max_dist) max_dist = dist;
-            
-            if (j > 0) {
-                double dx = rockets[i].trail_x[j] - rockets[i].trail_x[j-1];
-                double dy = rockets[i].trail_y[j] - rockets[i].trail_y[j-1];
-                total_distance += sqrt(dx * dx + dy * dy);
-            }
-        }
+        // Continue from the points that slid out of the in-memory window
+        TrailStats stats;
+        trail_stats_init(&stats);
+        stats.path_length = rockets[i].dropped_path;
+        trail_stats_add(&stats, rockets[i].trail_x, rockets[i].trail_y, rockets[i].trail_length);
+        double total_distance = stats.path_length;
+        double max_dist = sqrt(stats.max_d2);
+        if (rockets[i].dropped_max_dist > max_dist) max_dist = rockets[i].dropped_max_dist;
         
-        double sim_time = rockets[i].trail_length * dt;
+        double sim_time = trail_length * dt;
         double avg_speed = (sim_time > 0) ? total_distance / sim_time : 0.0;
         
+        if (scenario) fprintf(f, "%s,", scenario);
         fprintf(f, "%d,%d,%.3f,%.3f,%.6f\n",
-                i, rockets[i].trail_length, final_dist, max_dist, avg_speed);
+                first_id + i, trail_length, final_dist, max_dist, avg_speed);
+    }
+}
+
+/**
+ * Save Trajectory Summary Statistics (Exercise 3.1)
+ */
+void save_trajectory_stats(const char *filename, Rocket *rockets, int n, double dt) {
+    FILE *f = fopen(filename, "w");
+    if (!f) {
+        printf("Error: Could not create %s\n", filename);
+        return;
     }
     
+    fprintf(f, "%s", TRAJECTORY_STATS_HEADER);
+    write_trajectory_stats(f, NULL, rockets, n, dt, 0);
+    
     fclose(f);
-    printf("Saved trajectory statistics to %s\n", filename);
+    if (!quiet_loaders) printf("Saved trajectory statistics to %s\n", filename);
 }
 
 /**
@@ -228,8 +510,15 @@ void save_metadata(const char *filename, int n_bodies, int n_rockets,
     time_t now = time(NULL);
     fprintf(f, "# Simulation Metadata\n");
     fprintf(f, "# Generated: %s\n", ctime(&now));
-    fprintf(f, "Width=%d\n", WIDTH);
-    fprintf(f, "Height=%d\n", HEIGHT);
+    // Effective scale, also when it is derived from the image size
+    Viewport view;
+    viewport_init(&view, config->width, config->height, config->scale,
+                  config->center_x, config->center_y);
+    fprintf(f, "Width=%d\n", view.width);
+    fprintf(f, "Height=%d\n", view.height);
+    fprintf(f, "Scale=%.6f\n", view.scale);
+    fprintf(f, "Center_X=%.6f\n", view.center_x);
+    fprintf(f, "Center_Y=%.6f\n", view.center_y);
     fprintf(f, "Steps=%d\n", config->steps);
     fprintf(f, "DT=%.6f\n", config->dt);
     fprintf(f, "G=%.6f\n", config->g);
@@ -238,7 +527,39 @@ void save_metadata(const char *filename, int n_bodies, int n_rockets,
     fprintf(f, "Frames=%d\n", config->frames);
     fprintf(f, "Save_Interval=%d\n", config->save_interval);
     fprintf(f, "Softening=%.6f\n", SOFTENING);
+    fprintf(f, "Threads=%d\n", config->threads);
+    fprintf(f, "Solver=%s\n", (config->solver == SOLVER_BH) ? "bh" : "direct");
+    fprintf(f, "Theta=%.6f\n", config->theta);
+    fprintf(f, "Integrator=%s\n", (config->integrator == INTEGRATOR_EULER) ? "euler" : "kdk");
+    fprintf(f, "Precision=%s\n", precision_name(config->precision));
+    fprintf(f, "Block_Steps=%d\n", config->block_steps);
+    fprintf(f, "Eta=%.6f\n", config->eta);
+    fprintf(f, "Trail_Precision=%d\n", config->trail_precision);
+    fprintf(f, "Trail_Stride=%d\n", config->trail_stride);
+    fprintf(f, "Trail_Tolerance=%.6f\n", config->trail_tolerance);
+    fprintf(f, "Frame_Threads=%d\n", config->frame_threads);
+    fprintf(f, "Render_Threads=%d\n", config->render_threads);
+    fprintf(f, "Frame_Buffers=%d\n", config->frame_buffers);
+    fprintf(f, "Render_Mode=%s\n",
+            (config->render_mode == RENDER_INCREMENTAL) ? "incremental" :
+            (config->render_mode == RENDER_DENSITY) ? "density" : "full");
+    fprintf(f, "Trail_Decay=%.6f\n", config->trail_decay);
+    fprintf(f, "Video_Output=%s\n", (config->video_output == VIDEO_FFMPEG) ? "ffmpeg" :
+            (config->video_output == VIDEO_Y4M) ? "y4m" : "bmp");
+    fprintf(f, "Video_FPS=%d\n", config->video_fps);
+    fprintf(f, "Checkpoint_Interval=%d\n", config->checkpoint_interval);
+    fprintf(f, "Ephemeris_File=%s\n", config->ephemeris_file);
+    fprintf(f, "Ephemeris_Stride=%d\n", config->ephemeris_stride);
+    fprintf(f, "Timing_File=%s\n", config->timing_file);
+    fprintf(f, "Escape_Radius=%.6f\n", config->escape_radius);
+    fprintf(f, "Collision_Radius=%.6f\n", config->collision_radius);
+    for (int k = 0; k < config->n_regions; k++) {
+        const EventRegion *r = &config->regions[k];
+        fprintf(f, "Region=%.6f,%.6f,%.6f,%.6f%s\n", r->x0, r->y0, r->x1, r->y1,
+                r->stop ? ",stop" : "");
+    }
+    fprintf(f, "Events_File=%s\n", config->events_file);
     
     fclose(f);
-    printf("Saved simulation metadata to %s\n", filename);
+    if (!quiet_loaders) printf("Saved simulation metadata to %s\n", filename);
 }
\ No newline at end of file
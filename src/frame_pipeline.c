@@ -0,0 +1,395 @@
+/**
+ * frame_pipeline.c - Asynchronous Frame Output
+ * Render and write frames on worker threads while the simulation steps
+ *
+ * The simulation thread is the only producer. At a frame it copies the
+ * bodies, rockets and trail points that render() reads into the next
+ * slot of a preallocated ring and carries on stepping. Worker threads
+ * take ready slots oldest first, render them and write the BMP. Slot
+ * memory only grows, so after the first few frames a snapshot is a set
+ * of memcpy()s with no allocation.
+ *
+ * Backpressure: slots are filled strictly in ring order, and the
+ * producer waits when the next slot is still queued or being written.
+ * At most n_slots frames are in memory at once, however slow the disk.
+ *
+ * With a video stream, rendering stays parallel but frames are appended
+ * strictly in submission order: a worker holding a rendered frame waits
+ * until every earlier frame has been written.
+ *
+ * Each frame is rendered from its own snapshot, so the images are
+ * identical to rendering synchronously at the same step. In incremental
+ * render mode the trail layer is already up to date when the frame is
+ * submitted; the slot copies the layer instead of the trails and the
+ * worker fades it and composites bodies and rockets over it. Density
+ * frames copy only the bodies and the positions of active rockets, so a
+ * snapshot of a million rockets is two columns, not a million trails.
+ */
+
+#include "nbody.h"
+
+/**
+ * Free one slot's buffers
+ */
+static void slot_free(FrameSlot *slot) {
+    free(slot->bodies);
+    free(slot->rockets);
+    free(slot->trail_x);
+    free(slot->trail_y);
+    free(slot->layer.stamp);
+    free(slot->layer.rows);
+    density_free(&slot->density);
+    free(slot->img);
+    memset(slot, 0, sizeof(FrameSlot));
+}
+
+/**
+ * Grow a slot to hold the given snapshot (0 on success, -1 on failure)
+ */
+static int slot_reserve(FrameSlot *slot, int n_bodies, int n_rockets, long points) {
+    if (n_bodies > slot->body_capacity) {
+        Body *p = (Body *)realloc(slot->bodies, n_bodies * sizeof(Body));
+        if (!p) return -1;
+        slot->bodies = p;
+        slot->body_capacity = n_bodies;
+    }
+    if (n_rockets > slot->rocket_capacity) {
+        Rocket *p = (Rocket *)realloc(slot->rockets, n_rockets * sizeof(Rocket));
+        if (!p) return -1;
+        slot->rockets = p;
+        slot->rocket_capacity = n_rockets;
+    }
+    if (points > slot->trail_capacity) {
+        double *x = (double *)realloc(slot->trail_x, points * sizeof(double));
+        if (!x) return -1;
+        slot->trail_x = x;
+        double *y = (double *)realloc(slot->trail_y, points * sizeof(double));
+        if (!y) return -1;
+        slot->trail_y = y;
+        slot->trail_capacity = points;
+    }
+    return 0;
+}
+
+/**
+ * Worker thread: render and write ready slots until stopped and drained
+ */
+static void *frame_worker(void *arg) {
+    FramePipeline *pipeline = (FramePipeline *)arg;
+    
+    pthread_mutex_lock(&pipeline->lock);
+    while (1) {
+        FrameSlot *slot = &pipeline->slots[pipeline->tail];
+        if (slot->state != FRAME_SLOT_READY) {
+            if (pipeline->stopping) break;
+            pthread_cond_wait(&pipeline->slot_ready, &pipeline->lock);
+            continue;
+        }
+        
+        slot->state = FRAME_SLOT_BUSY;
+        pipeline->tail = (pipeline->tail + 1) % pipeline->n_slots;
+        pthread_mutex_unlock(&pipeline->lock);
+
+#ifdef NBODY_PROFILE
+        double started = profile_clock();
+#endif
+
+        // A frame that cannot be rendered is written black and counted as failed
+        int render_failed = 0;
+        if (slot->use_density) {
+            if (!slot->density.acc &&
+                density_init(&slot->density, &pipeline->view, pipeline->render_threads) != 0) {
+                memset(slot->img, 0, (size_t)pipeline->view.width * pipeline->view.height *
+                                     sizeof(Pixel));
+                render_failed = 1;
+            } else {
+                render_density(&slot->density, slot->bodies, slot->n_bodies,
+                               slot->trail_x, slot->trail_y, NULL, slot->n_points,
+                               slot->img, &pipeline->view);
+            }
+        } else if (slot->use_layer) {
+            render_composite(&slot->layer, slot->bodies, slot->n_bodies,
+                             slot->rockets, slot->n_rockets, slot->img, &pipeline->view);
+        } else {
+            render(slot->bodies, slot->n_bodies, slot->rockets, slot->n_rockets,
+                   slot->img, &pipeline->view, pipeline->render_threads);
+        }
+#ifdef NBODY_PROFILE
+        double rendered = profile_clock();
+#endif
+        int status;
+        if (pipeline->video) {
+            pthread_mutex_lock(&pipeline->lock);
+            while (pipeline->next_write != slot->seq) {
+                pthread_cond_wait(&pipeline->written, &pipeline->lock);
+            }
+            pthread_mutex_unlock(&pipeline->lock);
+            
+            status = video_write_frame(pipeline->video, slot->img);
+            
+            pthread_mutex_lock(&pipeline->lock);
+            pipeline->next_write++;
+            pthread_cond_broadcast(&pipeline->written);
+        } else {
+            status = write_bmp(slot->filename, slot->img,
+                               pipeline->view.width, pipeline->view.height);
+            pthread_mutex_lock(&pipeline->lock);
+        }
+
+#ifdef NBODY_PROFILE
+        pipeline->render_seconds += rendered - started;
+        pipeline->write_seconds += profile_clock() - rendered;
+#endif
+        if (status != 0 || render_failed) pipeline->failed++;
+        slot->state = FRAME_SLOT_FREE;
+        pthread_cond_broadcast(&pipeline->slot_free);
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    return NULL;
+}
+
+/**
+ * Allocate the ring and start the workers
+ */
+int frame_pipeline_start(FramePipeline *pipeline, int n_slots, int n_workers,
+                         const Viewport *view, int render_threads, VideoSink *video) {
+    memset(pipeline, 0, sizeof(FramePipeline));
+    if (n_slots < 1) n_slots = 1;
+    if (n_workers < 1) n_workers = 1;
+    
+    pipeline->slots = (FrameSlot *)calloc(n_slots, sizeof(FrameSlot));
+    pipeline->workers = (pthread_t *)calloc(n_workers, sizeof(pthread_t));
+    if (!pipeline->slots || !pipeline->workers) {
+        printf("Error: Memory allocation failed (frame pipeline)\n");
+        free(pipeline->slots);
+        free(pipeline->workers);
+        return -1;
+    }
+    pipeline->n_slots = n_slots;
+    pipeline->video = video;
+    pipeline->render_threads = render_threads;
+    
+    // Slot images are written as they are, so their rows are contiguous
+    pipeline->view = *view;
+    pipeline->view.stride = view->width;
+    size_t pixels = (size_t)view->width * view->height;
+    
+    for (int s = 0; s < n_slots; s++) {
+        pipeline->slots[s].img = (Pixel *)malloc(pixels * sizeof(Pixel));
+        if (!pipeline->slots[s].img) {
+            printf("Error: Memory allocation failed (frame pipeline)\n");
+            for (int k = 0; k < n_slots; k++) slot_free(&pipeline->slots[k]);
+            free(pipeline->slots);
+            free(pipeline->workers);
+            return -1;
+        }
+    }
+    
+    pthread_mutex_init(&pipeline->lock, NULL);
+    pthread_cond_init(&pipeline->slot_free, NULL);
+    pthread_cond_init(&pipeline->slot_ready, NULL);
+    pthread_cond_init(&pipeline->written, NULL);
+    
+    for (int t = 0; t < n_workers; t++) {
+        if (pthread_create(&pipeline->workers[t], NULL, frame_worker, pipeline) != 0) {
+            printf("Warning: Started %d of %d frame threads\n", t, n_workers);
+            break;
+        }
+        pipeline->n_workers++;
+    }
+    if (pipeline->n_workers == 0) {
+        printf("Error: Could not start frame threads\n");
+        frame_pipeline_finish(pipeline);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Wait until the next slot in ring order is free and return it
+ */
+static FrameSlot *slot_acquire(FramePipeline *pipeline) {
+    pthread_mutex_lock(&pipeline->lock);
+    FrameSlot *slot = &pipeline->slots[pipeline->head];
+    if (slot->state != FRAME_SLOT_FREE) {
+        pipeline->stalls++;
+        while (slot->state != FRAME_SLOT_FREE) {
+            pthread_cond_wait(&pipeline->slot_free, &pipeline->lock);
+        }
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+    return slot;
+}
+
+/**
+ * Hand a filled slot to the workers
+ */
+static void slot_queue(FramePipeline *pipeline, FrameSlot *slot) {
+    pthread_mutex_lock(&pipeline->lock);
+    slot->seq = pipeline->next_seq++;
+    slot->state = FRAME_SLOT_READY;
+    pipeline->head = (pipeline->head + 1) % pipeline->n_slots;
+    pthread_cond_signal(&pipeline->slot_ready);
+    pthread_mutex_unlock(&pipeline->lock);
+}
+
+/**
+ * Give up on a frame that could not be snapshotted; it counts as failed
+ * like a frame that could not be written
+ */
+static int slot_drop(FramePipeline *pipeline, const char *filename) {
+    printf("Error: Memory allocation failed, dropping frame %s\n", filename);
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->failed++;
+    pthread_mutex_unlock(&pipeline->lock);
+    return -1;
+}
+
+/**
+ * Snapshot the frame into the next slot, waiting if it is still in flight
+ */
+int frame_pipeline_submit(FramePipeline *pipeline, const char *filename,
+                          const TrailCanvas *canvas, const Body *bodies, int n_bodies,
+                          const Rocket *rockets, int n_rockets) {
+    FrameSlot *slot = slot_acquire(pipeline);
+    
+    // The slot is ours until it is marked ready; copy without the lock
+    // Composited frames never read the trails, so none are copied
+    long points = 0;
+    for (int i = 0; i < n_rockets && !canvas; i++) {
+        points += rockets[i].trail_length;
+    }
+    if (canvas && !slot->layer.stamp) {
+        slot->layer.stamp = (uint32_t *)malloc((size_t)canvas->width * canvas->height *
+                                               sizeof(uint32_t));
+        slot->layer.rows = (unsigned char *)malloc(canvas->height);
+    }
+    if (slot_reserve(slot, n_bodies, n_rockets, points) != 0 ||
+        (canvas && (!slot->layer.stamp || !slot->layer.rows))) {
+        return slot_drop(pipeline, filename);
+    }
+    
+    slot->use_layer = (canvas != NULL);
+    slot->use_density = 0;
+    if (canvas) {
+        // Untouched rows are never read, so only drawn rows are copied
+        long w = canvas->width;
+        for (int y = 0; y < canvas->height; y++) {
+            if (!canvas->rows[y]) continue;
+            memcpy(&slot->layer.stamp[y * w], &canvas->stamp[y * w], w * sizeof(uint32_t));
+        }
+        slot->layer.frame = canvas->frame;
+        slot->layer.width = canvas->width;
+        slot->layer.height = canvas->height;
+        memcpy(slot->layer.rows, canvas->rows, canvas->height);
+        memcpy(slot->layer.fade, canvas->fade, sizeof(canvas->fade));
+    }
+    
+    snprintf(slot->filename, sizeof(slot->filename), "%s", filename);
+    memcpy(slot->bodies, bodies, n_bodies * sizeof(Body));
+    slot->n_bodies = n_bodies;
+    
+    long offset = 0;
+    for (int i = 0; i < n_rockets; i++) {
+        Rocket *r = &slot->rockets[i];
+        *r = rockets[i];
+        if (canvas) {
+            // Trail length is kept: it decides whether the marker is drawn
+            r->trail_x = NULL;
+            r->trail_y = NULL;
+            r->trail_capacity = 0;
+            continue;
+        }
+        r->trail_x = slot->trail_x + offset;
+        r->trail_y = slot->trail_y + offset;
+        r->trail_capacity = r->trail_length;
+        memcpy(r->trail_x, rockets[i].trail_x, r->trail_length * sizeof(double));
+        memcpy(r->trail_y, rockets[i].trail_y, r->trail_length * sizeof(double));
+        offset += r->trail_length;
+    }
+    slot->n_rockets = n_rockets;
+    
+    slot_queue(pipeline, slot);
+    return 0;
+}
+
+/**
+ * Snapshot bodies and active rocket positions for a density frame
+ */
+int frame_pipeline_submit_density(FramePipeline *pipeline, const char *filename,
+                                  const Body *bodies, int n_bodies,
+                                  const ParticleSoA *rockets) {
+    FrameSlot *slot = slot_acquire(pipeline);
+    
+    long points = 0;
+    for (int i = 0; i < rockets->n; i++) {
+        points += rockets->active[i];
+    }
+    if (slot_reserve(slot, n_bodies, 0, points) != 0) {
+        return slot_drop(pipeline, filename);
+    }
+    
+    snprintf(slot->filename, sizeof(slot->filename), "%s", filename);
+    memcpy(slot->bodies, bodies, n_bodies * sizeof(Body));
+    slot->n_bodies = n_bodies;
+    slot->n_rockets = 0;
+    slot->use_layer = 0;
+    slot->use_density = 1;
+    
+    // Trail storage holds the positions; inactive rockets are left out
+    int n = 0;
+    for (int i = 0; i < rockets->n; i++) {
+        if (!rockets->active[i]) continue;
+        slot->trail_x[n] = rockets->x[i];
+        slot->trail_y[n] = rockets->y[i];
+        n++;
+    }
+    slot->n_points = n;
+    
+    slot_queue(pipeline, slot);
+    return 0;
+}
+
+/**
+ * Block until every slot is free again, i.e. all frames are written
+ */
+void frame_pipeline_drain(FramePipeline *pipeline) {
+    pthread_mutex_lock(&pipeline->lock);
+    for (int s = 0; s < pipeline->n_slots; s++) {
+        while (pipeline->slots[s].state != FRAME_SLOT_FREE) {
+            pthread_cond_wait(&pipeline->slot_free, &pipeline->lock);
+        }
+    }
+    pthread_mutex_unlock(&pipeline->lock);
+}
+
+/**
+ * Drain the ring, join the workers and free everything
+ */
+int frame_pipeline_finish(FramePipeline *pipeline) {
+    pthread_mutex_lock(&pipeline->lock);
+    pipeline->stopping = 1;
+    pthread_cond_broadcast(&pipeline->slot_ready);
+    pthread_mutex_unlock(&pipeline->lock);
+    
+    for (int t = 0; t < pipeline->n_workers; t++) {
+        pthread_join(pipeline->workers[t], NULL);
+    }
+    
+    int failed = pipeline->failed;
+    for (int s = 0; s < pipeline->n_slots; s++) {
+        slot_free(&pipeline->slots[s]);
+    }
+    free(pipeline->slots);
+    free(pipeline->workers);
+    
+    pthread_mutex_destroy(&pipeline->lock);
+    pthread_cond_destroy(&pipeline->slot_free);
+    pthread_cond_destroy(&pipeline->slot_ready);
+    pthread_cond_destroy(&pipeline->written);
+    pipeline->slots = NULL;
+    pipeline->workers = NULL;
+    pipeline->n_slots = 0;
+    pipeline->n_workers = 0;
+    return failed;
+}
@@ -9,7 +9,13 @@
  * Initialize celestial bodies with default configuration
  * Creates a central massive star with orbiting planets
  */
-void init_bodies_default(Body *bodies, int *n) {
+void init_bodies_default(SimState *state) {
+    int count = 5;
+    if (sim_state_reserve_bodies(state, count) != 0) return;
+    
+    state->n_bodies = count;
+    Body *bodies = state->bodies;
+    
     // Central massive body (star)
     bodies[0].x = 0.0;
     bodies[0].y = 0.0;
@@ -20,7 +26,6 @@ void init_bodies_default(Body *bodies, int *n) {
     bodies[0].ay = 0.0;
     
     // Create orbiting bodies (planets)
-    int count = 5;
     for (int i = 1; i < count; i++) {
         double angle = 2.0 * M_PI * i / (count - 1);
         double radius = 2.0 + i * 0.5;
@@ -37,15 +42,19 @@ void init_bodies_default(Body *bodies, int *n) {
         bodies[i].ay = 0.0;
     }
     
-    *n = count;
-    printf("Initialized %d default bodies\n", count);
+    if (!file_io_is_quiet()) printf("Initialized %d default bodies\n", count);
 }
 
 /**
  * Initialize rockets with default elliptical orbit configuration
  * Creates a rocket in a stable elliptical orbit around the central mass
  */
-void init_rockets_default(Rocket *rockets, int *n) {
+void init_rockets_default(SimState *state) {
+    if (sim_state_reserve_rockets(state, 1) != 0) return;
+    
+    state->n_rockets = 1;
+    Rocket *rockets = state->rockets;
+    
     // Elliptical orbit parameters
     double semi_major = 5.0;        // Semi-major axis
     double eccentricity = 0.6;      // Eccentricity (0 = circle, <1 = ellipse)
@@ -69,19 +78,11 @@ void init_rockets_default(Rocket *rockets, int *n) {
     rockets[0].ay = 0.0;
     rockets[0].active = 1;
     
-    // Allocate trail memory
-    rockets[0].trail_capacity = STEPS;
-    rockets[0].trail_x = (double *)malloc(STEPS * sizeof(double));
-    rockets[0].trail_y = (double *)malloc(STEPS * sizeof(double));
-    rockets[0].trail_length = 0;
-    
-    // Store initial position
-    rockets[0].trail_x[0] = rockets[0].x;
-    rockets[0].trail_y[0] = rockets[0].y;
-    rockets[0].trail_length = 1;
+    // Allocate trail memory and store initial position
+    rocket_trail_init(&rockets[0]);
     
-    *n = 1;
-    printf("Initialized %d default rocket(s) in elliptical orbit\n", *n);
+    if (file_io_is_quiet()) return;
+    printf("Initialized %d default rocket(s) in elliptical orbit\n", state->n_rockets);
     printf("  Semi-major axis: %.2f, Eccentricity: %.2f\n", semi_major, eccentricity);
     printf("  Perihelion: %.2f, Aphelion: %.2f\n", 
            r, semi_major * (1.0 + eccentricity));
@@ -0,0 +1,313 @@
+/**
+ * input.c - Bulk Input Parsing
+ * Reads bodies and rockets files as whole blocks of numbers
+ *
+ * A text file is read with a single fread() and parsed in memory: one
+ * entity per line, `fields` numbers separated by blanks, lines that start
+ * with '#' or are empty skipped, incomplete lines ignored and anything
+ * after the last field ignored (the rules of the old fgets and sscanf
+ * loop). Numbers go through input_parse_double(), which converts the
+ * common case exactly without strtod() and hands the rest to strtod(),
+ * so every value is bitwise what sscanf("%lf") gave.
+ *
+ * A binary file (written by input_write(), e.g. through
+ * tools/convert_input) holds the same numbers as doubles in native byte
+ * order, like the checkpoint:
+ *
+ *   InputHeader         32 bytes: magic, version, fields, count
+ *   values[count]       x y vx vy [mass] per entity
+ *
+ * and is read with one fread() straight into the value array. The format
+ * is detected from the magic, so --bodies and --rockets take either.
+ */
+
+#include "nbody.h"
+#include <limits.h>
+#include <sys/stat.h>
+
+#define FAST_DIGITS 19            // Significant digits that fit in a uint64_t
+#define FAST_MANTISSA (1ULL << 53)  // Largest mantissa a double holds exactly
+#define FAST_EXP10 22             // Largest power of ten a double holds exactly
+#define INPUT_BLOCK (64 << 10)    // First block when the file size is unknown
+
+/* Exact powers of ten for the fast path */
+static const double exact_pow10[FAST_EXP10 + 1] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/**
+ * 1 for the blanks that separate numbers on a line
+ */
+static int is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/**
+ * 1 for a character a number may not be followed by
+ */
+static int is_number_tail(char c) {
+    return !(is_blank(c) || c == '\n' || c == '\0');
+}
+
+/**
+ * Parse the decimal number at `p` into `value`
+ * Returns the end of the number, or NULL if there is none
+ */
+const char *input_parse_double(const char *p, double *value) {
+    const char *s = p;
+    int negative = (*s == '-');
+    if (*s == '+' || *s == '-') s++;
+    
+    // Mantissa digits, dropping leading zeros; exp10 scales the mantissa
+    uint64_t mantissa = 0;
+    int digits = 0, exp10 = 0, seen = 0, exact = 1;
+    for (; *s >= '0' && *s <= '9'; s++, seen = 1) {
+        if (digits < FAST_DIGITS) {
+            mantissa = mantissa * 10 + (uint64_t)(*s - '0');
+            if (mantissa) digits++;
+        } else {
+            exact = 0;
+        }
+    }
+    if (*s == '.') {
+        for (s++; *s >= '0' && *s <= '9'; s++, seen = 1) {
+            if (digits < FAST_DIGITS) {
+                mantissa = mantissa * 10 + (uint64_t)(*s - '0');
+                if (mantissa) digits++;
+                exp10--;
+            } else {
+                exact = 0;
+            }
+        }
+    }
+    
+    // An exponent needs at least one digit ("1e" is 1 followed by 'e')
+    if (seen && (*s == 'e' || *s == 'E')) {
+        const char *e = s + 1;
+        int exp_negative = (*e == '-');
+        if (*e == '+' || *e == '-') e++;
+        if (*e >= '0' && *e <= '9') {
+            int exponent = 0;
+            for (; *e >= '0' && *e <= '9'; e++) {
+                if (exponent < 10000) exponent = exponent * 10 + (*e - '0');
+            }
+            exp10 += exp_negative ? -exponent : exponent;
+            s = e;
+        }
+    }
+    
+    // One correctly rounded operation on exact operands: the same double
+    // strtod() returns. Everything else (long mantissas, large exponents,
+    // inf, nan, hex) is left to strtod().
+    if (seen && exact && !is_number_tail(*s) && mantissa <= FAST_MANTISSA &&
+        exp10 >= -FAST_EXP10 && exp10 <= FAST_EXP10) {
+        double v = (double)mantissa;
+        v = (exp10 < 0) ? v / exact_pow10[-exp10] : v * exact_pow10[exp10];
+        *value = negative ? -v : v;
+        return s;
+    }
+    
+    char *end = NULL;
+    *value = strtod(p, &end);
+    return (end == p) ? NULL : end;
+}
+
+/**
+ * Read `head` (`used` bytes already read from `f`) and the rest of `f`
+ * into a NUL-terminated buffer; nothing is read twice, so pipes work
+ * A regular file takes one fread(); pipes are read in growing blocks
+ */
+static char *read_block(FILE *f, const char *filename, const void *head, size_t used,
+                        size_t *length) {
+    struct stat st;
+    long start = ftell(f);
+    size_t capacity = INPUT_BLOCK;
+    int regular = fstat(fileno(f), &st) == 0 && S_ISREG(st.st_mode) && start >= 0 &&
+                  st.st_size >= start;
+    if (regular) capacity = used + (size_t)(st.st_size - start) + 1;
+    
+    char *text = NULL;
+    for (int first = 1;; first = 0) {
+        char *grown = (char *)realloc(text, capacity);
+        if (!grown) {
+            printf("Error: Memory allocation failed (%zu bytes for %s)\n", capacity, filename);
+            free(text);
+            return NULL;
+        }
+        text = grown;
+        if (first) memcpy(text, head, used);
+        size_t want = capacity - 1 - used;
+        size_t got = fread(text + used, 1, want, f);
+        used += got;
+        if (regular || got < want) break;
+        capacity *= 2;
+    }
+    if (ferror(f)) {
+        printf("Error: Could not read %s\n", filename);
+        free(text);
+        return NULL;
+    }
+    
+    text[used] = '\0';
+    *length = used;
+    return text;
+}
+
+/**
+ * Parse text lines of `fields` numbers into `values` (room for `max`
+ * entities); returns the number of entities
+ */
+static long parse_text(const char *text, int fields, double *values, long max) {
+    long count = 0;
+    const char *line = text;
+    
+    while (*line && count < max) {
+        const char *next = strchr(line, '\n');
+        next = next ? next + 1 : line + strlen(line);
+        
+        if (line[0] != '#' && line[0] != '\n') {
+            double *v = values + count * fields;
+            const char *p = line;
+            int k = 0;
+            for (; k < fields; k++) {
+                while (is_blank(*p)) p++;
+                if (*p == '\n') break;
+                p = input_parse_double(p, &v[k]);
+                if (!p || p > next) break;
+            }
+            if (k == fields) count++;
+        }
+        line = next;
+    }
+    return count;
+}
+
+/**
+ * Read every entity of a bodies or rockets file, text or binary
+ * `values` gets `fields` doubles per entity (free() it); returns the
+ * number of entities or -1
+ */
+long input_read(FILE *f, const char *filename, int fields, double **values) {
+    *values = NULL;
+
+    InputHeader header;
+    size_t got = fread(&header, 1, sizeof(header), f);
+    if (got == sizeof(header) && memcmp(header.magic, INPUT_MAGIC, sizeof(header.magic)) == 0) {
+        if (header.version != INPUT_VERSION || header.fields != (uint32_t)fields ||
+            header.count > (uint64_t)INT_MAX) {
+            printf("Error: %s: needs a version %d input file of %d values per entry\n",
+                   filename, INPUT_VERSION, fields);
+            return -1;
+        }
+        
+        size_t n = (size_t)header.count * fields;
+        double *data = (double *)malloc((n > 0 ? n : 1) * sizeof(double));
+        if (!data) {
+            printf("Error: Memory allocation failed (%zu values for %s)\n", n, filename);
+            return -1;
+        }
+        if (fread(data, sizeof(double), n, f) != n) {
+            printf("Error: %s is truncated\n", filename);
+            free(data);
+            return -1;
+        }
+        *values = data;
+        return (long)header.count;
+    }
+    
+    // Text: the probed bytes start the buffer (no rewind: f may be a
+    // pipe); size the array from the line count, then parse in place
+    size_t length = 0;
+    char *text = read_block(f, filename, &header, got, &length);
+    if (!text) return -1;
+    
+    long lines = 1;
+    for (const char *c = memchr(text, '\n', length); c;
+         c = memchr(c + 1, '\n', length - (size_t)(c + 1 - text))) {
+        lines++;
+    }
+    if (lines > INT_MAX) lines = INT_MAX;
+    
+    double *data = (double *)malloc((size_t)lines * fields * sizeof(double));
+    if (!data) {
+        printf("Error: Memory allocation failed (%ld lines of %s)\n", lines, filename);
+        free(text);
+        return -1;
+    }
+    long count = parse_text(text, fields, data, lines);
+    free(text);
+    
+    *values = data;
+    return count;
+}
+
+/**
+ * Write `count` entities of `fields` doubles as a binary input file
+ */
+int input_write(const char *filename, const double *values, long count, int fields) {
+    InputHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INPUT_MAGIC, sizeof(INPUT_MAGIC));
+    header.version = INPUT_VERSION;
+    header.fields = (uint32_t)fields;
+    header.count = (uint64_t)count;
+    
+    FILE *f = fopen(filename, "wb");
+    if (!f) {
+        printf("Error: Could not create %s\n", filename);
+        return -1;
+    }
+    size_t n = (size_t)count * fields;
+    int ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+             fwrite(values, sizeof(double), n, f) == n;
+    if (fclose(f) != 0) ok = 0;
+    if (!ok) {
+        printf("Error: Could not write %s\n", filename);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Write bodies as a binary input file (x y vx vy mass)
+ */
+int input_write_bodies(const char *filename, const Body *bodies, int n) {
+    double *values = (double *)malloc((n > 0 ? n : 1) * INPUT_BODY_FIELDS * sizeof(double));
+    if (!values) {
+        printf("Error: Memory allocation failed (%d bodies)\n", n);
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        double *v = values + (size_t)i * INPUT_BODY_FIELDS;
+        v[0] = bodies[i].x;
+        v[1] = bodies[i].y;
+        v[2] = bodies[i].vx;
+        v[3] = bodies[i].vy;
+        v[4] = bodies[i].mass;
+    }
+    int result = input_write(filename, values, n, INPUT_BODY_FIELDS);
+    free(values);
+    return result;
+}
+
+/**
+ * Write rockets as a binary input file (x y vx vy)
+ */
+int input_write_rockets(const char *filename, const Rocket *rockets, int n) {
+    double *values = (double *)malloc((n > 0 ? n : 1) * INPUT_ROCKET_FIELDS * sizeof(double));
+    if (!values) {
+        printf("Error: Memory allocation failed (%d rockets)\n", n);
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        double *v = values + (size_t)i * INPUT_ROCKET_FIELDS;
+        v[0] = rockets[i].x;
+        v[1] = rockets[i].y;
+        v[2] = rockets[i].vx;
+        v[3] = rockets[i].vy;
+    }
+    int result = input_write(filename, values, n, INPUT_ROCKET_FIELDS);
+    free(values);
+    return result;
+}
@@ -1,104 +1,572 @@
 /**
  * main.c - Main Program Entry Point
  * N-Body Simulation with Rocket Trajectories
+ *
+ * Usage: ./bin/nbody [options]
+ *   --config <file>     configuration (default config.txt)
+ *   --bodies <file>     initial bodies (default bodies.txt)
+ *   --rockets <file>    initial rockets (default rockets.txt)
+ *   --output <dir>      directory for every output file (default: current)
+ *   --mode <simulate|replay>  skip the N/L prompt
+ *   --trails <file>     trails replayed by --mode replay (default
+ *                       rocket_trails.bin in the output directory)
+ *   --no-frames         simulate without rendering frames or video
+ *   --quiet             print only errors, warnings and the final summary
+ *   --verbose           also list every body and rocket as it is loaded
+ *   --resume            continue an interrupted run from its checkpoint
+ *   --batch <manifest>  run every scenario of a manifest (see batch.c)
+ *
+ * Without --mode the N/L prompt is shown only when stdin is a terminal;
+ * a job without a tty simulates. Replay (L) draws the frames of a saved
+ * run from its trails without simulating (see replay.c).
+ *
+ * Built with -DUSE_MPI (make mpi) this is bin/nbody_mpi: the same
+ * options, with the run split across the ranks by distributed.c
+ * (mpirun -np 4 ./bin/nbody_mpi). Only rank 0 reports progress.
  */
 
 #include "nbody.h"
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-int main() {
-    Body bodies[MAX_BODIES];
-    Rocket rockets[MAX_ROCKETS];
-    Pixel *img = (Pixel *)malloc(WIDTH * HEIGHT * sizeof(Pixel));
+#ifdef USE_MPI
+#include <mpi.h>
+
+/**
+ * Shut MPI down on every exit path
+ */
+static void finalize_mpi(void) {
+    int finalized = 0;
+    MPI_Finalized(&finalized);
+    if (!finalized) MPI_Finalize();
+}
+#endif
+
+/**
+ * Print the command line options
+ */
+static void usage(const char *program) {
+    printf("Usage: %s [options]\n", program);
+    printf("  --config <file>           configuration (default config.txt)\n");
+    printf("  --bodies <file>           initial bodies (default bodies.txt)\n");
+    printf("  --rockets <file>          initial rockets (default rockets.txt)\n");
+    printf("  --output <dir>            directory for every output file\n");
+    printf("  --mode <simulate|replay>  skip the N/L prompt\n");
+    printf("  --trails <file>           trails to replay (default rocket_trails.bin)\n");
+    printf("  --no-frames               do not render frames or video\n");
+    printf("  --quiet                   only errors, warnings and the final summary\n");
+    printf("  --verbose                 list every loaded body and rocket\n");
+    printf("  --resume                  continue from the checkpoint\n");
+    printf("  --batch <manifest>        run every scenario of a manifest\n");
+}
+
+/**
+ * Take stdout for the video when the config streams Y4M to "-"
+ * Returns the stream's descriptor, or -1
+ */
+static int take_video_stdout(const SimConfig *config) {
+    if (config->video_output != VIDEO_Y4M || strcmp(config->video_file, "-") != 0) {
+        return -1;
+    }
+    return video_take_stdout();
+}
+
+int main(int argc, char *argv[]) {
+#ifdef USE_MPI
+    MPI_Init(&argc, &argv);
+    atexit(finalize_mpi);
+    int rank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
+    int resume = 0;
+    const char *batch_manifest = NULL;
+    const char *config_file = "config.txt";
+    const char *bodies_file = "bodies.txt";
+    const char *rockets_file = "rockets.txt";
+    const char *output_dir = "";
+    const char *replay_trails = NULL;
+    int mode = MODE_PROMPT;
+    int draw_frames = 1;
+    int quiet = 0;
+    int verbose = 0;
     
-    if (!img) {
-        printf("Error: Memory allocation failed\n");
+    for (int a = 1; a < argc; a++) {
+        const char *arg = argv[a];
+        const char *value = (a + 1 < argc) ? argv[a + 1] : NULL;
+        if (strcmp(arg, "--resume") == 0) {
+            resume = 1;
+        } else if (strcmp(arg, "--no-frames") == 0) {
+            draw_frames = 0;
+        } else if (strcmp(arg, "--quiet") == 0) {
+            quiet = 1;
+        } else if (strcmp(arg, "--verbose") == 0) {
+            verbose = 1;
+        } else if (strcmp(arg, "--help") == 0) {
+            usage(argv[0]);
+            return 0;
+        } else if (value && strcmp(arg, "--batch") == 0) {
+            batch_manifest = argv[++a];
+        } else if (value && strcmp(arg, "--config") == 0) {
+            config_file = argv[++a];
+        } else if (value && strcmp(arg, "--bodies") == 0) {
+            bodies_file = argv[++a];
+        } else if (value && strcmp(arg, "--rockets") == 0) {
+            rockets_file = argv[++a];
+        } else if (value && strcmp(arg, "--output") == 0) {
+            output_dir = argv[++a];
+        } else if (value && strcmp(arg, "--trails") == 0) {
+            replay_trails = argv[++a];
+        } else if (value && strcmp(arg, "--mode") == 0 &&
+                   (strcmp(value, "simulate") == 0 || strcmp(value, "replay") == 0)) {
+            mode = (value[0] == 's') ? MODE_SIMULATE : MODE_REPLAY;
+            a++;
+        } else {
+            printf("Error: Unknown or incomplete option '%s'\n", arg);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (resume && batch_manifest) {
+        printf("Error: --resume and --batch cannot be combined\n");
+        return 1;
+    }
+#ifdef USE_MPI
+    if (resume || batch_manifest) {
+        if (rank == 0) printf("Error: --resume and --batch are not available with MPI\n");
+        return 1;
+    }
+    if (rank > 0) quiet = 1;
+#endif
+
+    // Every output file goes to the output directory
+    if (output_dir[0] != '\0' && mkdir(output_dir, 0777) != 0 && errno != EEXIST) {
+        printf("Error: Could not create output directory %s\n", output_dir);
         return 1;
     }
+    char log_path[PATH_LEN], metadata_path[PATH_LEN], final_path[PATH_LEN];
+    char trails_path[PATH_LEN], stats_path[PATH_LEN], checkpoint_path[PATH_LEN];
+    output_path(log_path, sizeof(log_path), output_dir, "frames.log");
+    output_path(metadata_path, sizeof(metadata_path), output_dir, "metadata.txt");
+    output_path(final_path, sizeof(final_path), output_dir, "final_rockets.txt");
+    output_path(trails_path, sizeof(trails_path), output_dir, "rocket_trails.bin");
+    output_path(stats_path, sizeof(stats_path), output_dir, "rocket_stats.csv");
+    
+    SimState state;
+    sim_state_init(&state);
     
     // Load configuration
-    SimConfig config = {DT, STEPS, FRAMES, STEPS/FRAMES, G};
-    load_config("config.txt", &config);
+    file_io_quiet(quiet);
+    file_io_verbose(verbose);
+    SimConfig config;
+    sim_config_default(&config);
+    load_config(config_file, &config);
+    output_path(checkpoint_path, sizeof(checkpoint_path), output_dir, config.checkpoint_file);
     
-    // User interaction (Exercise 4.1)
-    printf("\n====================================\n");
-    printf("N-Body Rocket Simulation\n");
-    printf("====================================\n");
-    printf("Choose mode:\n");
-    printf("  [N] Run new simulation\n");
-    printf("  [L] Load and plot saved data\n");
-    printf("Choice (N/L): ");
+    // A Y4M stream on stdout takes it before anything else is printed
+    // (a resumed run checks again with the config of its checkpoint)
+    int video_fd = -1;
+#ifndef USE_MPI
+    if (draw_frames && !batch_manifest && mode != MODE_REPLAY) {
+        video_fd = take_video_stdout(&config);
+    }
+#endif
+
+#ifdef USE_MPI
+    // Distributed run: no prompt and no frames, rockets split across ranks
+    sim_state_free(&state);
+    return distributed_run(&config, bodies_file, rockets_file, output_dir, quiet);
+#endif
+
+    // Batch mode: no prompt, no frames, one summary file for all scenarios
+    if (batch_manifest) {
+        char batch_path[PATH_LEN];
+        output_path(batch_path, sizeof(batch_path), output_dir, BATCH_STATS_FILE);
+        return (batch_run(batch_manifest, &config, batch_path) == 0) ? 0 : 1;
+    }
     
-    char choice;
-    scanf(" %c", &choice);
-    printf("\n");
+    // Resume: state, configuration and progress all come from the checkpoint
+    CheckpointHeader resumed;
+    memset(&resumed, 0, sizeof(resumed));
+    if (resume) {
+        if (checkpoint_load(checkpoint_path, &resumed, &state, &config) != 0) {
+            return 1;
+        }
+        if (draw_frames && video_fd < 0) video_fd = take_video_stdout(&config);
+        if (!quiet) {
+            printf("Resuming from %s: step %lld, frame %lld, t=%.4f\n", checkpoint_path,
+                   (long long)resumed.step, (long long)resumed.frame_num, resumed.time);
+        }
+    }
     
-    if (choice == 'L' || choice == 'l') {
-        printf("Loading mode not yet fully implemented.\n");
-        printf("Use plot_trails tool to visualize saved data.\n");
-        printf("Falling back to new simulation...\n\n");
+    // Image size and projection are configurable
+    Viewport view;
+    viewport_init(&view, config.width, config.height, config.scale,
+                  config.center_x, config.center_y);
+    Pixel *img = NULL;
+    if (draw_frames) {
+        img = (Pixel *)malloc((size_t)view.width * view.height * sizeof(Pixel));
+        if (!img) {
+            printf("Error: Memory allocation failed\n");
+            return 1;
+        }
     }
     
-    // Load or initialize bodies
-    int n_bodies = load_bodies("bodies.txt", bodies, MAX_BODIES);
-    if (n_bodies < 0) {
-        init_bodies_default(bodies, &n_bodies);
+    // User interaction (Exercise 4.1), only on a terminal; a resumed run
+    // is always a simulation
+    if (!resume) {
+        if (mode == MODE_PROMPT && isatty(STDIN_FILENO)) {
+            printf("\n====================================\n");
+            printf("N-Body Rocket Simulation\n");
+            printf("====================================\n");
+            printf("Choose mode:\n");
+            printf("  [N] Run new simulation\n");
+            printf("  [L] Load and plot saved data\n");
+            printf("Choice (N/L): ");
+            
+            char choice = 'N';
+            if (scanf(" %c", &choice) != 1) choice = 'N';
+            printf("\n");
+            mode = (choice == 'L' || choice == 'l') ? MODE_REPLAY : MODE_SIMULATE;
+        }
+        
+        // Replay: frames drawn from the saved trails, nothing simulated
+        if (mode == MODE_REPLAY) {
+            free(img);
+            sim_state_free(&state);
+            return replay_run(&config, replay_trails ? replay_trails : trails_path,
+                              bodies_file, output_dir, quiet);
+        }
+        
+        // Load or initialize bodies
+        if (load_bodies(bodies_file, &state) < 0) {
+            init_bodies_default(&state);
+        }
+        
+        // Load or initialize rockets
+        if (load_rockets(rockets_file, &state) < 0) {
+            init_rockets_default(&state);
+        }
+        
+        // Move hot particle data into the SoA storage used by the physics loop
+        if (sim_state_pack(&state) != 0) {
+            printf("Error: Memory allocation failed\n");
+            free(img);
+            sim_state_free(&state);
+            return 1;
+        }
     }
     
-    // Load or initialize rockets
-    int n_rockets = load_rockets("rockets.txt", rockets, MAX_ROCKETS);
-    if (n_rockets < 0) {
-        init_rockets_default(rockets, &n_rockets);
+    int n_bodies = state.n_bodies;
+    int n_rockets = state.n_rockets;
+    Body *bodies = state.bodies;
+    Rocket *rockets = state.rockets;
+    
+    double initial_energy = resume ? resumed.initial_energy :
+                            compute_energy(&state.body_soa, config.g);
+    
+    // Stream trails to disk in chunks instead of keeping the whole run
+    TrailSink trail_sink;
+    if (resume && resumed.spool_offset >= 0) {
+        if (trail_sink_resume(&trail_sink, trails_path, n_rockets,
+                              config.trail_precision, (long)resumed.spool_offset,
+                              resumed.spool_points) != 0) {
+            printf("Error: Cannot resume without the trail spool of the interrupted run\n");
+            free(img);
+            sim_state_free(&state);
+            return 1;
+        }
+        state.trail_sink = &trail_sink;
+    } else if (!resume && trail_sink_open(&trail_sink, trails_path, n_rockets,
+                                          config.trail_precision) == 0) {
+        state.trail_sink = &trail_sink;
+    }
+    
+    // Cached body ephemeris: map a matching file or write one first; the
+    // bodies are then read from it and only the rockets are integrated
+    BodyEphemeris ephemeris;
+    memset(&ephemeris, 0, sizeof(ephemeris));
+    if (config.ephemeris_file[0] != '\0') {
+        if (!ephemeris_supported(&config)) {
+            printf("Warning: Block time-steps need the bodies integrated, ignoring %s\n",
+                   config.ephemeris_file);
+        } else if (ephemeris_open(&ephemeris, config.ephemeris_file,
+                                  resume ? NULL : bodies, n_bodies, &config) == 0) {
+            state.ephemeris = &ephemeris;
+        } else if (resume) {
+            printf("Error: Cannot resume without the ephemeris of the interrupted run\n");
+            free(img);
+            sim_state_free(&state);
+            return 1;
+        } else {
+            if (!quiet) {
+                printf("Writing ephemeris %s (%d steps, stride %d)...\n",
+                       config.ephemeris_file, config.steps, config.ephemeris_stride);
+            }
+            if (ephemeris_write(config.ephemeris_file, bodies, n_bodies, &config,
+                                config.ephemeris_stride) == 0 &&
+                ephemeris_open(&ephemeris, config.ephemeris_file, bodies, n_bodies,
+                               &config) == 0) {
+                state.ephemeris = &ephemeris;
+            } else {
+                printf("Warning: Integrating the bodies without an ephemeris\n");
+            }
+        }
+        state.ephemeris_step = resume ? (int)resumed.step : 0;
     }
     
-    double scale = 50.0;
     int frame_interval = config.steps / config.frames;
     if (config.save_interval > 0) {
         frame_interval = config.save_interval;
     }
     
-    printf("\n====================================\n");
-    printf("Simulation Parameters\n");
-    printf("====================================\n");
-    printf("Bodies: %d\n", n_bodies);
-    printf("Rockets: %d\n", n_rockets);
-    printf("Steps: %d\n", config.steps);
-    printf("Time step: %.4f\n", config.dt);
-    printf("Frames: %d\n", config.frames);
-    printf("Save interval: %d steps\n", frame_interval);
-    printf("====================================\n\n");
+    // Stream frames into one video instead of BMP files
+    VideoSink video;
+    int video_frames = 0;
+    const char *video_file = config.video_file;
+    char video_path[PATH_LEN], resumed_video[PATH_LEN + 16];
+    if (draw_frames && config.video_output != VIDEO_BMP) {
+        if (video_file[0] == '\0') {
+            video_file = (config.video_output == VIDEO_Y4M) ? "simulation.y4m" : "simulation.mp4";
+        }
+        output_path(video_path, sizeof(video_path), output_dir, video_file);
+        video_file = video_path;
+        if (resume && config.video_output == VIDEO_FFMPEG) {
+            // An encoded video cannot be appended to: the rest goes to
+            // <name>_<frame>.<ext>, to be concatenated with the first part
+            const char *dot = strrchr(video_file, '.');
+            int stem = dot ? (int)(dot - video_file) : (int)strlen(video_file);
+            snprintf(resumed_video, sizeof(resumed_video), "%.*s_%04lld%s", stem, video_file,
+                     (long long)resumed.frame_num, dot ? dot : "");
+            video_file = resumed_video;
+        }
+        if (resume && config.video_output == VIDEO_Y4M && resumed.video_offset >= 0) {
+            video_frames = (video_resume_y4m(&video, video_file, view.width, view.height,
+                                             (long)resumed.video_offset,
+                                             (long)resumed.video_frames) == 0);
+        } else {
+            video_frames = (video_open(&video, config.video_output, video_file,
+                                       view.width, view.height, config.video_fps,
+                                       video_fd) == 0);
+        }
+        if (!video_frames) {
+            printf("Warning: Falling back to BMP frame files\n");
+        }
+    }
     
-    // Open frame log file (Exercise 2.3)
-    FILE *log = fopen("frames.log", "w");
-    if (log) {
-        time_t now = time(NULL);
-        fprintf(log, "# Frame Generation Log\n");
-        fprintf(log, "# Started: %s\n", ctime(&now));
+    if (!quiet) {
+        printf("\n====================================\n");
+        printf("Simulation Parameters\n");
+        printf("====================================\n");
+        printf("Bodies: %d\n", n_bodies);
+        printf("Rockets: %d\n", n_rockets);
+        printf("Steps: %d\n", config.steps);
+        printf("Time step: %.4f\n", config.dt);
+        printf("Frames: %d%s\n", config.frames, draw_frames ? "" : " (logged, not drawn)");
+        printf("Save interval: %d steps\n", frame_interval);
+        printf("Solver: %s\n", (config.solver == SOLVER_BH) ? "Barnes-Hut" : "direct");
+        printf("Integrator: %s\n", (config.integrator == INTEGRATOR_EULER) ?
+               "semi-implicit Euler" : "KDK leapfrog");
+        if (config.block_steps && config.integrator != INTEGRATOR_EULER) {
+            printf("Rocket block time-steps: dt/1 .. dt/%d, eta=%.3f\n",
+                   1 << BLOCK_MAX_LEVEL, config.eta);
+        }
+        printf("Rocket kernel: %s%s", rocket_kernel_name(rocket_kernel_kind()),
+               (config.precision == PRECISION_MIXED) ? ", mixed precision (float forces)" :
+               (config.precision == PRECISION_FLOAT) ? ", single precision" : "");
+        if (config.solver != SOLVER_BH && config.precision == PRECISION_DOUBLE &&
+            rocket_force_kernel_fixed(rocket_kernel_kind(), state.n_bodies)) {
+            printf(", specialized for %d bodies", state.n_bodies);
+        }
+        printf("\n");
+        if (state.ephemeris) {
+            if (ephemeris.stride > 1) {
+                printf("Ephemeris: %s, bodies every %d steps, interpolated\n",
+                       config.ephemeris_file, ephemeris.stride);
+            } else {
+                printf("Ephemeris: %s, bodies every step\n", config.ephemeris_file);
+            }
+        }
+        if (config.threads > 0) {
+            printf("Threads: %d (of %d available)\n", config.threads, max_threads());
+        } else {
+            printf("Threads: serial\n");
+        }
+        printf("Image: %dx%d, scale %.2f px/unit, center (%.2f, %.2f)\n",
+               view.width, view.height, view.scale, view.center_x, view.center_y);
+        if (config.render_threads > 1) {
+            printf("Rasterizer: %d threads, %dx%d tiles\n",
+                   config.render_threads, RASTER_TILE, RASTER_TILE);
+        }
+        if (config.trail_stride > 1 || config.trail_tolerance > 0.0) {
+            printf("Trails: sampled every %d step(s), tolerance %.2f px\n",
+                   config.trail_stride, config.trail_tolerance);
+        }
+        if (config.render_mode == RENDER_INCREMENTAL) {
+            printf("Render: incremental, trail decay %.3f per frame\n", config.trail_decay);
+        } else if (config.render_mode == RENDER_DENSITY) {
+            printf("Render: density heatmap of active rockets\n");
+        } else {
+            printf("Render: full redraw\n");
+        }
+        if (output_dir[0] != '\0') {
+            printf("Output directory: %s\n", output_dir);
+        }
+        if (!draw_frames) {
+            printf("Frame output: off (--no-frames)\n");
+        } else if (config.frame_threads > 0) {
+            printf("Frame output: %d thread(s), %d buffers\n",
+                   config.frame_threads, config.frame_buffers);
+        } else {
+            printf("Frame output: synchronous\n");
+        }
+        if (video_frames) {
+            printf("Video: %s -> %s at %d fps\n",
+                   (config.video_output == VIDEO_Y4M) ? "Y4M stream" : "ffmpeg",
+                   strcmp(video_file, "-") == 0 ? "stdout" : video_file, config.video_fps);
+        }
+        printf("Events: escape radius %.1f, collision radius %.1f, %d region(s)\n",
+               config.escape_radius, config.collision_radius, config.n_regions);
+        if (config.checkpoint_interval > 0) {
+            printf("Checkpoints: every %d steps -> %s\n",
+                   config.checkpoint_interval, checkpoint_path);
+        }
+        printf("====================================\n\n");
+    }
+    
+    // Open frame log file (Exercise 2.3); a resumed run drops the lines
+    // written after the checkpoint and carries on
+    FILE *log = NULL;
+    if (resume && resumed.log_offset >= 0) {
+        if (truncate(log_path, (off_t)resumed.log_offset) != 0) {
+            printf("Warning: %s of the interrupted run not found\n", log_path);
+        }
+        log = fopen(log_path, "a");
+    } else {
+        log = fopen(log_path, "w");
+        if (log) {
+            time_t now = time(NULL);
+            fprintf(log, "# Frame Generation Log\n");
+            fprintf(log, "# Started: %s\n", ctime(&now));
+        }
+    }
+    
+    // Rocket events are written to their CSV by a background thread; a
+    // resumed run drops the events after the checkpoint
+    char events_path[PATH_LEN];
+    output_path(events_path, sizeof(events_path), output_dir, config.events_file);
+    EventLog event_log;
+    int events_open = (event_log_open(&event_log, config.events_file[0] ? events_path : NULL,
+                                      !quiet,
+                                      resume ? (long)resumed.events_offset : -1) == 0);
+    state.events.log = events_open ? &event_log : NULL;
+    
+    // Persistent trail layer for incremental rendering
+    TrailCanvas canvas;
+    int incremental = 0;
+    if (draw_frames && config.render_mode == RENDER_INCREMENTAL) {
+        incremental = (trail_canvas_init(&canvas, &view, n_rockets, config.trail_decay) == 0);
+        if (!incremental) {
+            printf("Warning: Falling back to full frame rendering\n");
+        } else if (resume && checkpoint_load_canvas(checkpoint_path, &resumed,
+                                                    &canvas) != 0) {
+            printf("Warning: Trail layer restarts empty\n");
+        }
+    }
+    
+    // Render and write frames off the simulation thread
+    FramePipeline pipeline;
+    int async_frames = 0;
+    if (draw_frames && config.frame_threads > 0) {
+        async_frames = (frame_pipeline_start(&pipeline, config.frame_buffers,
+                                             config.frame_threads, &view, config.render_threads,
+                                             video_frames ? &video : NULL) == 0);
+        if (!async_frames) {
+            printf("Warning: Falling back to synchronous frame output\n");
+        }
+    }
+    
+    // Density buffers for frames rendered on this thread
+    DensityMap density_map;
+    int density = draw_frames && (config.render_mode == RENDER_DENSITY);
+    if (density && !async_frames &&
+        density_init(&density_map, &view, config.render_threads) != 0) {
+        printf("Warning: Falling back to full frame rendering\n");
+        density = 0;
     }
     
     // Save metadata (Exercise 4.2)
-    save_metadata("metadata.txt", n_bodies, n_rockets, &config);
+    save_metadata(metadata_path, n_bodies, n_rockets, &config);
+    
+    // Phase timers, with optional per-frame rows
+    Profile profile;
+    profile_init(&profile);
+    state.profile = &profile;
+    char timing_path[PATH_LEN];
+    if (config.timing_file[0] != '\0') {
+        output_path(timing_path, sizeof(timing_path), output_dir, config.timing_file);
+        profile_open_csv(&profile, timing_path);
+    }
     
-    printf("Starting simulation...\n");
+    if (!quiet) printf("Starting simulation...\n");
     
     // Main simulation loop
-    for (int step = 0; step < config.steps; step++) {
-        // Update physics for one time step
-        update_bodies(bodies, n_bodies, config.dt, config.g);
-        update_rockets(rockets, n_rockets, bodies, n_bodies, config.dt, config.g);
-        
-        // Generate output frame at intervals
-        if (step % frame_interval == 0) {
-            char filename[50];
-            int frame_num = step / frame_interval;
-            sprintf(filename, "frame_%04d.bmp", frame_num);
+    // Frames are spaced by simulated time (frame_interval * dt): frame k
+    // shows t = k * frame_time, independent of how the steps are split
+    double frame_time = frame_interval * config.dt;
+    double end_time = config.steps * config.dt;
+    int frame_num = (int)resumed.frame_num;
+    
+    for (int step = (int)resumed.step; step < config.steps; step++) {
+        // Generate output frame when simulated time reaches the next frame
+        double next_frame = frame_num * frame_time;
+        if (state.time >= next_frame - 1e-9 * frame_time && next_frame < end_time) {
+            sim_state_unpack(&state);
             
-            // Render and save frame
-            render(bodies, n_bodies, rockets, n_rockets, img, scale);
-            write_bmp(filename, img, WIDTH, HEIGHT);
+            char name[32], filename[PATH_LEN];
+            snprintf(name, sizeof(name), "frame_%04d.bmp", frame_num);
+            output_path(filename, sizeof(filename), output_dir, name);
+            
+            // Incremental mode: bring the trail layer up to date first
+            PROFILE_BEGIN(state.profile, render_started);
+            const TrailCanvas *layer = NULL;
+            if (incremental) {
+                trail_canvas_update(&canvas, rockets, n_rockets, &view);
+                layer = &canvas;
+            }
+            
+            // Render and save frame (queued when the pipeline is running)
+            if (!draw_frames) {
+                // --no-frames: the frame is only logged
+            } else if (density && async_frames) {
+                frame_pipeline_submit_density(&pipeline, filename, bodies, n_bodies,
+                                              &state.rocket_soa);
+            } else if (async_frames) {
+                frame_pipeline_submit(&pipeline, filename, layer, bodies, n_bodies,
+                                      rockets, n_rockets);
+            } else {
+                if (density) {
+                    render_density(&density_map, bodies, n_bodies, state.rocket_soa.x,
+                                   state.rocket_soa.y, state.rocket_soa.active,
+                                   state.rocket_soa.n, img, &view);
+                } else if (layer) {
+                    render_composite(layer, bodies, n_bodies, rockets, n_rockets, img, &view);
+                } else {
+                    render(bodies, n_bodies, rockets, n_rockets, img, &view, config.render_threads);
+                }
+                PROFILE_BEGIN(state.profile, write_started);
+                if (video_frames) {
+                    video_write_frame(&video, img);
+                } else {
+                    write_bmp(filename, img, view.width, view.height);
+                }
+                PROFILE_END(state.profile, write_started, PROFILE_BMP);
+            }
+            PROFILE_END(state.profile, render_started, PROFILE_RENDER);
             
             // Log frame information
             if (log) {
-                fprintf(log, "Frame %d: Step %d", frame_num, step);
+                fprintf(log, "Frame %d: Step %d, t=%.4f", frame_num, step, state.time);
                 for (int i = 0; i < n_rockets; i++) {
                     if (rockets[i].active || rockets[i].trail_length > 0) {
                         fprintf(log, ", Rocket%d_Pos (%.2f, %.2f)", 
@@ -107,44 +575,176 @@ int main() {
                 }
                 fprintf(log, "\n");
             }
+            profile_frame(&profile, frame_num, step, state.time);
+            
+            if (quiet) {
+                // No progress lines
+            } else if (!draw_frames) {
+                printf("Step %5d/%d - Logged frame %d\n", step, config.steps, frame_num);
+            } else if (video_frames) {
+                printf("Step %5d/%d - %s video frame %d\n", step, config.steps,
+                       async_frames ? "Queued" : "Wrote", frame_num);
+            } else {
+                printf("Step %5d/%d - %s %s\n", step, config.steps,
+                       async_frames ? "Queued" : "Generated", filename);
+            }
+            frame_num++;
+        }
+        
+        // Update physics for one time step
+        sim_step(&state, &config);
+        
+        // Periodic checkpoint; queued frames are written first so the
+        // checkpoint never refers to output that is not on disk
+        if (config.checkpoint_interval > 0 && (step + 1) % config.checkpoint_interval == 0 &&
+            step + 1 < config.steps) {
+            sim_state_unpack(&state);
+            if (async_frames) frame_pipeline_drain(&pipeline);
             
-            printf("Step %5d/%d - Generated %s\n", step, config.steps, filename);
+            CheckpointHeader checkpoint;
+            memset(&checkpoint, 0, sizeof(checkpoint));
+            checkpoint.step = step + 1;
+            checkpoint.frame_num = frame_num;
+            checkpoint.initial_energy = initial_energy;
+            checkpoint.log_offset = (log && fflush(log) == 0) ? ftell(log) : -1;
+            checkpoint.video_offset = video_frames ? video_sync(&video) : -1;
+            checkpoint.video_frames = video_frames ? video.frames : 0;
+            checkpoint.events_offset = events_open ? event_log_sync(&event_log) : -1;
+            if (checkpoint_save(checkpoint_path, &checkpoint, &state, &config,
+                                incremental ? &canvas : NULL) == 0 && !quiet) {
+                printf("Step %5d/%d - Checkpoint saved to %s\n",
+                       step + 1, config.steps, checkpoint_path);
+            }
         }
     }
     
+    sim_state_unpack(&state);
+    
+    // Wait for queued frames to reach the disk
+    long long frame_stalls = 0;
+    int frame_failures = 0;
+    if (async_frames) {
+        frame_stalls = pipeline.stalls;
+        frame_failures = frame_pipeline_finish(&pipeline);
+        profile.offload[PROFILE_RENDER] = pipeline.render_seconds;
+        profile.offload[PROFILE_BMP] = pipeline.write_seconds;
+    }
+    if (incremental) {
+        trail_canvas_free(&canvas);
+    }
+    if (density && !async_frames) {
+        density_free(&density_map);
+    }
+    int video_status = 0;
+    long video_written = 0;
+    if (video_frames) {
+        video_written = video.frames;
+        video_status = video_close(&video);
+    }
+    
+    // Energy drift over the run (bodies only; rockets are massless); the
+    // ephemeris holds no body velocities to measure it from
+    double final_energy = compute_energy(&state.body_soa, config.g);
+    double drift = (initial_energy != 0.0) ?
+                   fabs((final_energy - initial_energy) / initial_energy) : 0.0;
+    int bodies_from_ephemeris = (state.ephemeris != NULL);
+    ephemeris_free(&ephemeris);
+    state.ephemeris = NULL;
+    
+    // Remaining events reach the CSV before the summary
+    state.events.log = NULL;
+    if (events_open) event_log_close(&event_log);
+    
     // Close log file
     if (log) {
         fclose(log);
-        printf("\nFrame log saved to frames.log\n");
+        if (!quiet) printf("\nFrame log saved to %s\n", log_path);
     }
     
     printf("\n====================================\n");
     printf("Simulation Complete!\n");
-    printf("====================================\n\n");
+    printf("====================================\n");
+    if (bodies_from_ephemeris) {
+        printf("Energy: bodies read from %s, drift not measured\n", config.ephemeris_file);
+    } else {
+        printf("Energy: %.6e -> %.6e (relative drift %.3e)\n",
+               initial_energy, final_energy, drift);
+    }
+    if (video_frames) {
+        printf("Video: %ld frames -> %s%s\n", video_written,
+               strcmp(video_file, "-") == 0 ? "stdout" : video_file,
+               (video_status != 0) ? " (encoder reported an error)" : "");
+    }
+    if (async_frames) {
+        printf("Frames: %d written, %d failed, simulation waited on %lld\n",
+               frame_num - frame_failures, frame_failures, frame_stalls);
+    }
+    if (config.block_steps) {
+        printf("Rocket force evaluations: %lld (%lld with a global step)\n",
+               state.blocks.force_evals, (long long)config.steps * n_rockets);
+    }
+    printf("Events: %lld escapes, %lld collisions, %lld region entries (%d rockets still active)\n",
+           (long long)state.events.counts[EVENT_ESCAPE],
+           (long long)state.events.counts[EVENT_COLLISION],
+           (long long)state.events.counts[EVENT_REGION], state.events.n_live);
+    if (config.trail_stride > 1 || config.trail_tolerance > 0.0) {
+        long long kept = 0, sampled = 0;
+        for (int i = 0; i < n_rockets; i++) {
+            kept += rockets[i].trail_dropped + rockets[i].trail_length;
+            sampled += rockets[i].trail_dropped + rockets[i].trail_length +
+                       rockets[i].trail_skipped;
+        }
+        printf("Trail points: %lld kept of %lld sampled (%.1fx fewer)\n", kept, sampled,
+               (kept > 0) ? (double)sampled / kept : 0.0);
+    }
+    profile_report(&profile, config.steps - resumed.step);
+    profile_close(&profile);
+    state.profile = NULL;
+    printf("\n");
     
     // Save output files
-    save_rocket_data("final_rockets.txt", rockets, n_rockets);
-    save_rocket_trails_bin("rocket_trails.bin", rockets, n_rockets);
-    save_trajectory_stats("rocket_stats.csv", rockets, n_rockets, config.dt);
+    save_rocket_data(final_path, rockets, n_rockets);
+    if (state.trail_sink) {
+        if (trail_sink_close(state.trail_sink, rockets, n_rockets) == 0 && !quiet) {
+            printf("Saved rocket trails in binary format to %s (%lld points)\n",
+                   trail_sink.path, trail_sink.points);
+        }
+        state.trail_sink = NULL;
+    } else {
+        save_rocket_trails_bin(trails_path, rockets, n_rockets);
+    }
+    save_trajectory_stats(stats_path, rockets, n_rockets, config.dt);
     
-    printf("\nOutput files generated:\n");
-    printf("  - frame_XXXX.bmp (visualization frames)\n");
-    printf("  - final_rockets.txt (final positions and velocities)\n");
-    printf("  - rocket_trails.bin (binary trajectory data)\n");
-    printf("  - rocket_stats.csv (statistical analysis)\n");
-    printf("  - frames.log (frame generation log)\n");
-    printf("  - metadata.txt (simulation parameters)\n");
-    
-    // Clean up
+    // The run is complete; its checkpoint must not be resumed again
+    if (config.checkpoint_interval > 0 || resume) {
+        remove(checkpoint_path);
+    }
+    
+    // Clean up; frames that were dropped or not written fail the run
     free(img);
-    for (int i = 0; i < n_rockets; i++) {
-        free(rockets[i].trail_x);
-        free(rockets[i].trail_y);
+    sim_state_free(&state);
+    int status = (frame_failures > 0) ? 1 : 0;
+    if (quiet) return status;
+    
+    printf("\nOutput files generated:\n");
+    if (video_frames) {
+        printf("  - %s (video)\n", strcmp(video_file, "-") == 0 ? "stdout" : video_file);
+    } else if (draw_frames) {
+        printf("  - %s%sframe_XXXX.bmp (visualization frames)\n", output_dir,
+               (output_dir[0] && output_dir[strlen(output_dir) - 1] != '/') ? "/" : "");
+    }
+    printf("  - %s (final positions and velocities)\n", final_path);
+    printf("  - %s (binary trajectory data)\n", trails_path);
+    printf("  - %s (statistical analysis)\n", stats_path);
+    printf("  - %s (frame generation log)\n", log_path);
+    if (events_open && config.events_file[0] != '\0') {
+        printf("  - %s (rocket events)\n", events_path);
     }
+    printf("  - %s (simulation parameters)\n", metadata_path);
     
     printf("\n====================================\n");
     printf("All done! Check output files.\n");
     printf("====================================\n\n");
     
-    return 0;
+    return status;
 }
\ No newline at end of file
@@ -0,0 +1,127 @@
+/**
+ * parallel.c - Threaded Simulation Step
+ * OpenMP-parallel versions of the body and rocket updates
+ *
+ * Results are bitwise-identical for any thread count. Every particle's
+ * acceleration is summed by exactly one thread in a fixed order, so the
+ * partitioning never changes the floating-point result:
+ *
+ * - Bodies use a gather formulation: body i sums over all j != i in
+ *   ascending j. Since -(a * b) == (-a) * b exactly, this reproduces the
+ *   serial Newton's-third-law loop bit for bit, without the scatter
+ *   writes to bodies[j] that would need per-thread accumulators.
+ * - Rockets are independent test particles and are split into fixed
+ *   chunks, each handed to the dispatched SIMD kernel.
+ * - precision=mixed|float runs the bodies through the float rocket
+ *   kernel (gather form) for every thread count, serial included, so it
+ *   is deterministic too.
+ *
+ * Integration and trail recording are per-particle loops in physics.c
+ * that use the same thread count.
+ */
+
+#include "nbody.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Gather-form body forces for bodies [begin, end)
+ */
+static void body_forces_gather(ParticleSoA *bodies, double g, int begin, int end) {
+    int n = bodies->n;
+    const double *x = bodies->x;
+    const double *y = bodies->y;
+    const double *mass = bodies->mass;
+    
+    for (int i = begin; i < end; i++) {
+        double ax = 0.0;
+        double ay = 0.0;
+        
+        for (int j = 0; j < n; j++) {
+            if (j == i) continue;
+            
+            // Vector from body i to body j
+            double dx = x[j] - x[i];
+            double dy = y[j] - y[i];
+            
+            double dist_sq = dx * dx + dy * dy + SOFTENING * SOFTENING;
+            double dist = sqrt(dist_sq);
+            double force = g / dist_sq;
+            
+            // Same expression order as compute_forces_soa()
+            double fx = force * dx / dist;
+            double fy = force * dy / dist;
+            
+            ax += fx * mass[j];
+            ay += fy * mass[j];
+        }
+        
+        bodies->ax[i] = ax;
+        bodies->ay[i] = ay;
+    }
+}
+
+/**
+ * Compute body accelerations across threads
+ */
+void compute_forces_threaded(ParticleSoA *bodies, double g, int threads) {
+    int n = bodies->n;
+    int n_chunks = (n + BODY_CHUNK - 1) / BODY_CHUNK;
+    (void)threads;  // Unused without OpenMP
+    
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+    for (int c = 0; c < n_chunks; c++) {
+        int begin = c * BODY_CHUNK;
+        int end = (begin + BODY_CHUNK < n) ? begin + BODY_CHUNK : n;
+        body_forces_gather(bodies, g, begin, end);
+    }
+}
+
+/**
+ * Compute body accelerations in float across threads (serial for 0 or 1)
+ * The bodies are their own test particles in the float rocket kernel;
+ * with softening the self term is exactly zero
+ */
+void compute_forces_float(ParticleSoA *bodies, double g, int threads, int precision) {
+    RocketForceKernel kernel = rocket_force_kernel_for(precision);
+    int n = bodies->n;
+    int n_chunks = (n + BODY_CHUNK - 1) / BODY_CHUNK;
+    
+    #pragma omp parallel for schedule(dynamic, 1) if(threads > 1) num_threads(OMP_THREADS(threads))
+    for (int c = 0; c < n_chunks; c++) {
+        int begin = c * BODY_CHUNK;
+        int end = (begin + BODY_CHUNK < n) ? begin + BODY_CHUNK : n;
+        kernel(bodies, bodies, g, begin, end);
+    }
+}
+
+/**
+ * Compute rocket accelerations across threads
+ */
+void compute_rocket_forces_threaded(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                    double g, int threads, int precision) {
+    RocketForceKernel kernel = rocket_force_kernel_sized(precision, bodies->n);
+    int n = rockets->n;
+    int n_chunks = (n + ROCKET_CHUNK - 1) / ROCKET_CHUNK;
+    (void)threads;  // Unused without OpenMP
+    
+    #pragma omp parallel for schedule(static) num_threads(threads)
+    for (int c = 0; c < n_chunks; c++) {
+        int begin = c * ROCKET_CHUNK;
+        int end = (begin + ROCKET_CHUNK < n) ? begin + ROCKET_CHUNK : n;
+        kernel(rockets, bodies, g, begin, end);
+    }
+}
+
+/**
+ * Number of threads the runtime would use by default (1 without OpenMP)
+ */
+int max_threads(void) {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
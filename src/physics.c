@@ -1,29 +1,43 @@
 /**
  * physics.c - Physics Simulation Functions
  * Implements gravitational force calculations and numerical integration
+ *
+ * The kernels run on structure-of-arrays storage (ParticleSoA). The
+ * Body/Rocket entry points are thin adapters kept for the AoS view.
  */
 
 #include "nbody.h"
 
+/* ============================================================================
+ * SOA KERNELS
+ * ============================================================================ */
+
 /**
  * Compute gravitational forces between all bodies using Newton's law
  * F = G * m1 * m2 / r^2
  * 
  * Uses softening parameter to prevent numerical singularities
  */
-void compute_forces(Body *bodies, int n, double g) {
+void compute_forces_soa(ParticleSoA *bodies, double g) {
+    int n = bodies->n;
+    const double *x = bodies->x;
+    const double *y = bodies->y;
+    const double *mass = bodies->mass;
+    double *ax = bodies->ax;
+    double *ay = bodies->ay;
+    
     // Reset accelerations
     for (int i = 0; i < n; i++) {
-        bodies[i].ax = 0.0;
-        bodies[i].ay = 0.0;
+        ax[i] = 0.0;
+        ay[i] = 0.0;
     }
     
     // Compute pairwise forces (Newton's third law)
     for (int i = 0; i < n; i++) {
         for (int j = i + 1; j < n; j++) {
             // Vector from body i to body j
-            double dx = bodies[j].x - bodies[i].x;
-            double dy = bodies[j].y - bodies[i].y;
+            double dx = x[j] - x[i];
+            double dy = y[j] - y[i];
             
             // Distance squared with softening
             double dist_sq = dx * dx + dy * dy + SOFTENING * SOFTENING;
@@ -37,10 +51,10 @@ void compute_forces(Body *bodies, int n, double g) {
             double fy = force * dy / dist;
             
             // Apply forces (Newton's third law: equal and opposite)
-            bodies[i].ax += fx * bodies[j].mass;
-            bodies[i].ay += fy * bodies[j].mass;
-            bodies[j].ax -= fx * bodies[i].mass;
-            bodies[j].ay -= fy * bodies[i].mass;
+            ax[i] += fx * mass[j];
+            ay[i] += fy * mass[j];
+            ax[j] -= fx * mass[i];
+            ay[j] -= fy * mass[i];
         }
     }
 }
@@ -48,92 +62,569 @@ void compute_forces(Body *bodies, int n, double g) {
 /**
  * Compute gravitational acceleration on rockets from all bodies
  * Rockets don't exert forces, only experience them (test particles)
+ * 
+ * Runs the SIMD kernel chosen by CPU dispatch (see physics_simd.c),
+ * specialized for the body count when it is small (physics_fixed.c)
  */
-void compute_rocket_forces(Rocket *rockets, int n_rockets, 
-                          Body *bodies, int n_bodies, double g) {
-    for (int i = 0; i < n_rockets; i++) {
-        if (!rockets[i].active) continue;
-        
-        // Reset acceleration
-        rockets[i].ax = 0.0;
-        rockets[i].ay = 0.0;
-        
-        // Sum gravitational acceleration from all bodies
-        for (int j = 0; j < n_bodies; j++) {
-            double dx = bodies[j].x - rockets[i].x;
-            double dy = bodies[j].y - rockets[i].y;
-            
-            double dist_sq = dx * dx + dy * dy + SOFTENING * SOFTENING;
-            double dist = sqrt(dist_sq);
-            
-            // Acceleration = G * M / r^2
-            double acc = g * bodies[j].mass / dist_sq;
-            
-            rockets[i].ax += acc * dx / dist;
-            rockets[i].ay += acc * dy / dist;
-        }
-    }
+void compute_rocket_forces_soa(ParticleSoA *rockets, const ParticleSoA *bodies,
+                               double g) {
+    rocket_force_kernel_sized(PRECISION_DOUBLE, bodies->n)(rockets, bodies, g, 0, rockets->n);
 }
 
 /**
- * Update body positions and velocities using leapfrog integration
- * This symplectic integrator conserves energy better than Euler method
+ * Update body positions and velocities using semi-implicit Euler
+ * First-order but symplectic, so energy errors stay bounded; sim_step()
+ * uses the second-order KDK leapfrog unless integrator=euler
  * 
  * Steps:
  * 1. Compute accelerations from forces
  * 2. Update velocities: v(t+dt) = v(t) + a(t) * dt
  * 3. Update positions: x(t+dt) = x(t) + v(t+dt) * dt
  */
-void update_bodies(Body *bodies, int n, double dt, double g) {
+void update_bodies_soa(ParticleSoA *bodies, double dt, double g) {
     // Compute accelerations
-    compute_forces(bodies, n, g);
+    compute_forces_soa(bodies, g);
     
     // Integrate equations of motion
-    for (int i = 0; i < n; i++) {
+    for (int i = 0; i < bodies->n; i++) {
         // Update velocity
-        bodies[i].vx += bodies[i].ax * dt;
-        bodies[i].vy += bodies[i].ay * dt;
+        bodies->vx[i] += bodies->ax[i] * dt;
+        bodies->vy[i] += bodies->ay[i] * dt;
         
         // Update position
-        bodies[i].x += bodies[i].vx * dt;
-        bodies[i].y += bodies[i].vy * dt;
+        bodies->x[i] += bodies->vx[i] * dt;
+        bodies->y[i] += bodies->vy[i] * dt;
     }
 }
 
 /**
  * Update rocket positions and velocities
- * Same integration scheme as bodies, with trajectory recording
+ * Same integration scheme as bodies; trails are recorded separately
  */
-void update_rockets(Rocket *rockets, int n_rockets, Body *bodies, 
-                   int n_bodies, double dt, double g) {
+void update_rockets_soa(ParticleSoA *rockets, const ParticleSoA *bodies,
+                        double dt, double g) {
     // Compute accelerations
-    compute_rocket_forces(rockets, n_rockets, bodies, n_bodies, g);
+    compute_rocket_forces_soa(rockets, bodies, g);
     
     // Integrate equations of motion
-    for (int i = 0; i < n_rockets; i++) {
-        if (!rockets[i].active) continue;
+    for (int i = 0; i < rockets->n; i++) {
+        if (!rockets->active[i]) continue;
         
         // Update velocity
-        rockets[i].vx += rockets[i].ax * dt;
-        rockets[i].vy += rockets[i].ay * dt;
+        rockets->vx[i] += rockets->ax[i] * dt;
+        rockets->vy[i] += rockets->ay[i] * dt;
         
         // Update position
-        rockets[i].x += rockets[i].vx * dt;
-        rockets[i].y += rockets[i].vy * dt;
+        rockets->x[i] += rockets->vx[i] * dt;
+        rockets->y[i] += rockets->vy[i] * dt;
+    }
+}
+
+/**
+ * Drop the oldest half of a full trail window
+ * Path length and max distance of the dropped points are kept so the
+ * trajectory statistics still cover the whole run
+ */
+static void slide_trail_window(Rocket *r) {
+    int drop = r->trail_length / 2;
+    
+    // Up to and including the first point kept, for the last segment
+    TrailStats stats;
+    trail_stats_init(&stats);
+    stats.path_length = r->dropped_path;
+    trail_stats_add(&stats, r->trail_x, r->trail_y, drop + 1);
+    r->dropped_path = stats.path_length;
+    if (sqrt(stats.max_d2) > r->dropped_max_dist) r->dropped_max_dist = sqrt(stats.max_d2);
+    
+    memmove(r->trail_x, r->trail_x + drop, (r->trail_length - drop) * sizeof(double));
+    memmove(r->trail_y, r->trail_y + drop, (r->trail_length - drop) * sizeof(double));
+    r->trail_length -= drop;
+    r->trail_dropped += drop;
+    r->trail_flushed = (r->trail_flushed > drop) ? r->trail_flushed - drop : 0;
+}
+
+/**
+ * Offer one sampled position to a rocket's trail
+ *
+ * With a tolerance the trail ends in a provisional tip that follows the
+ * rocket. The segment from the anchor (the last fixed point) is a strip
+ * of half-width `tolerance` along the direction of its first sample, as
+ * in Reumann-Witkam line simplification: while a sample stays inside the
+ * strip and keeps moving forward, it replaces the tip. A sample that
+ * leaves the strip or turns back fixes the tip and starts a new segment.
+ */
+static void record_trail_point(Rocket *r, double x, double y, int stride, double tolerance) {
+    long sample = (long)r->trail_dropped + r->trail_length + r->trail_skipped;
+    if (stride > 1 && sample % stride != 0) {
+        r->trail_skipped++;
+        return;
+    }
+    
+    if (tolerance > 0.0 && r->trail_tip) {
+        int tip = r->trail_length - 1;
+        double dx = r->trail_dir_x, dy = r->trail_dir_y;
+        double cross = dx * (y - r->trail_anchor_y) - dy * (x - r->trail_anchor_x);
+        double along = dx * (x - r->trail_x[tip]) + dy * (y - r->trail_y[tip]);
+        if (along >= 0.0 && cross * cross <= tolerance * tolerance * (dx * dx + dy * dy)) {
+            r->trail_x[tip] = x;
+            r->trail_y[tip] = y;
+            r->trail_skipped++;
+            return;
+        }
+    }
+    
+    if (r->trail_length == r->trail_capacity) slide_trail_window(r);
+    if (tolerance > 0.0 && r->trail_length > 0) {
+        r->trail_anchor_x = r->trail_x[r->trail_length - 1];
+        r->trail_anchor_y = r->trail_y[r->trail_length - 1];
+        r->trail_dir_x = x - r->trail_anchor_x;
+        r->trail_dir_y = y - r->trail_anchor_y;
+        r->trail_tip = 1;
+    } else {
+        r->trail_tip = 0;
+    }
+    
+    r->trail_x[r->trail_length] = x;
+    r->trail_y[r->trail_length] = y;
+    r->trail_length++;
+}
+
+/**
+ * Store current positions of active rockets in their trails
+ * Trail arrays are cold AoS data, touched once per rocket per step
+ */
+void record_rocket_trails(Rocket *rockets, const ParticleSoA *soa, const int *live,
+                          int n_live, int stride, double tolerance) {
+    int n = live ? n_live : soa->n;
+    for (int k = 0; k < n; k++) {
+        int i = live ? live[k] : k;
+        if (!soa->active[i]) continue;
         
-        // Store position in trail for visualization
-        if (rockets[i].trail_length < rockets[i].trail_capacity) {
-            rockets[i].trail_x[rockets[i].trail_length] = rockets[i].x;
-            rockets[i].trail_y[rockets[i].trail_length] = rockets[i].y;
-            rockets[i].trail_length++;
+        Rocket *r = &rockets[i];
+        if (r->trail_capacity < 2) continue;
+        record_trail_point(r, soa->x[i], soa->y[i], stride, tolerance);
+    }
+}
+
+/**
+ * trail_tolerance converted from pixels of the configured view to world units
+ */
+static double trail_tolerance_units(const SimConfig *config) {
+    if (config->trail_tolerance <= 0.0) return 0.0;
+    
+    Viewport view;
+    viewport_init(&view, config->width, config->height, config->scale, 0.0, 0.0);
+    return config->trail_tolerance / view.scale;
+}
+
+/**
+ * Deactivate rockets that go too far from the origin
+ */
+int check_rocket_escape(ParticleSoA *rockets, double radius) {
+    int escaped = 0;
+    for (int i = 0; i < rockets->n; i++) {
+        if (!rockets->active[i]) continue;
+        
+        double dist = sqrt(rockets->x[i] * rockets->x[i] + 
+                          rockets->y[i] * rockets->y[i]);
+        if (dist > radius) {
+            rockets->active[i] = 0;
+            escaped++;
         }
+    }
+    return escaped;
+}
+
+/**
+ * Kick-drift update for active particles [begin, end)
+ */
+static void integrate_range(ParticleSoA *p, double dt, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        if (!p->active[i]) continue;
+        
+        p->vx[i] += p->ax[i] * dt;
+        p->vy[i] += p->ay[i] * dt;
+        p->x[i] += p->vx[i] * dt;
+        p->y[i] += p->vy[i] * dt;
+    }
+}
+
+/**
+ * Velocity update for active particles [begin, end)
+ */
+static void kick_range(ParticleSoA *p, double dt, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        if (!p->active[i]) continue;
+        
+        p->vx[i] += p->ax[i] * dt;
+        p->vy[i] += p->ay[i] * dt;
+    }
+}
+
+/**
+ * Position update for active particles [begin, end)
+ */
+static void drift_range(ParticleSoA *p, double dt, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        if (!p->active[i]) continue;
         
-        // Deactivate rocket if it goes too far
-        double dist = sqrt(rockets[i].x * rockets[i].x + 
-                          rockets[i].y * rockets[i].y);
-        if (dist > 50.0) {
-            rockets[i].active = 0;
-            printf("Rocket %d left simulation area (distance: %.2f)\n", i, dist);
+        p->x[i] += p->vx[i] * dt;
+        p->y[i] += p->vy[i] * dt;
+    }
+}
+
+/*
+ * The serial versions call the range functions directly: entering the
+ * OpenMP runtime, even for a region that if(threads > 1) would disable,
+ * costs more than updating a handful of particles, and small batch
+ * scenarios take several of these updates per step.
+ */
+
+/**
+ * Kick-drift update for active particles on `threads` threads
+ * v(t+dt) = v(t) + a(t) * dt, then x(t+dt) = x(t) + v(t+dt) * dt
+ */
+void integrate_particles(ParticleSoA *p, double dt, int threads) {
+    if (threads <= 1) {
+        integrate_range(p, dt, 0, p->n);
+        return;
+    }
+    
+    #pragma omp parallel for schedule(static) num_threads(threads)
+    for (int c = 0; c < p->n; c += ROCKET_CHUNK) {
+        integrate_range(p, dt, c, (c + ROCKET_CHUNK < p->n) ? c + ROCKET_CHUNK : p->n);
+    }
+}
+
+/**
+ * Half of a KDK step for active particles: v += a * dt
+ */
+void kick_particles(ParticleSoA *p, double dt, int threads) {
+    if (threads <= 1) {
+        kick_range(p, dt, 0, p->n);
+        return;
+    }
+    
+    #pragma omp parallel for schedule(static) num_threads(threads)
+    for (int c = 0; c < p->n; c += ROCKET_CHUNK) {
+        kick_range(p, dt, c, (c + ROCKET_CHUNK < p->n) ? c + ROCKET_CHUNK : p->n);
+    }
+}
+
+/**
+ * Position update for active particles: x += v * dt
+ */
+void drift_particles(ParticleSoA *p, double dt, int threads) {
+    if (threads <= 1) {
+        drift_range(p, dt, 0, p->n);
+        return;
+    }
+    
+    #pragma omp parallel for schedule(static) num_threads(threads)
+    for (int c = 0; c < p->n; c += ROCKET_CHUNK) {
+        drift_range(p, dt, c, (c + ROCKET_CHUNK < p->n) ? c + ROCKET_CHUNK : p->n);
+    }
+}
+
+/**
+ * Total energy of the body system
+ * E = sum 1/2 m v^2 - sum_{i<j} G m_i m_j / sqrt(r^2 + eps^2)
+ * 
+ * The Plummer potential matches the softened force law used by the
+ * kernels, so this is the quantity the dynamics actually conserve.
+ */
+double compute_energy(const ParticleSoA *bodies, double g) {
+    double kinetic = 0.0;
+    double potential = 0.0;
+    
+    for (int i = 0; i < bodies->n; i++) {
+        kinetic += 0.5 * bodies->mass[i] * (bodies->vx[i] * bodies->vx[i] +
+                                            bodies->vy[i] * bodies->vy[i]);
+        
+        for (int j = i + 1; j < bodies->n; j++) {
+            double dx = bodies->x[j] - bodies->x[i];
+            double dy = bodies->y[j] - bodies->y[i];
+            double dist = sqrt(dx * dx + dy * dy + SOFTENING * SOFTENING);
+            potential -= g * bodies->mass[i] * bodies->mass[j] / dist;
+        }
+    }
+    return kinetic + potential;
+}
+
+/**
+ * Direct-sum body accelerations: serial pairwise loop, or gather form
+ * when threaded or in float
+ */
+static void direct_body_forces(ParticleSoA *b, const SimConfig *config) {
+    if (config->precision != PRECISION_DOUBLE) {
+        compute_forces_float(b, config->g, config->threads, config->precision);
+    } else if (config->threads > 0) {
+        compute_forces_threaded(b, config->g, config->threads);
+    } else {
+        compute_forces_soa(b, config->g);
+    }
+}
+
+/**
+ * Compute body accelerations with the configured solver
+ * direct: see direct_body_forces()
+ * bh:     Barnes-Hut tree (rebuilt from current positions, always double)
+ * A tree that cannot be allocated falls back to the direct sum for this
+ * step; returns -1 then (state->tree is not valid), else 0
+ */
+int sim_body_forces(SimState *state, const SimConfig *config) {
+    ParticleSoA *b = &state->body_soa;
+    PROFILE_BEGIN(state->profile, started);
+    
+    int status = 0;
+    if (config->solver != SOLVER_BH) {
+        direct_body_forces(b, config);
+    } else if (compute_forces_bh(b, &state->tree, config->g, config->theta,
+                                 config->threads) != 0) {
+        printf("Warning: Summing body forces directly for this step\n");
+        direct_body_forces(b, config);
+        status = -1;
+    }
+    
+    PROFILE_COUNT(state->profile, (long long)b->n * (b->n - 1));
+    PROFILE_END(state->profile, started, PROFILE_BODY_FORCES);
+    return status;
+}
+
+/**
+ * Compute rocket accelerations with the configured solver
+ * With solver=bh the rockets walk a tree built on the current bodies
+ */
+void sim_rocket_forces(SimState *state, const SimConfig *config) {
+    ParticleSoA *r = events_force_rockets(state);
+    ParticleSoA *b = &state->body_soa;
+    PROFILE_BEGIN(state->profile, started);
+    
+    int tree = (config->solver == SOLVER_BH);
+    if (tree && quadtree_build(&state->tree, b) != 0) {
+        printf("Error: Barnes-Hut tree allocation failed, summing rocket forces directly\n");
+        tree = 0;
+    }
+    if (tree) {
+        compute_rocket_forces_bh(r, b, &state->tree, config->g,
+                                 config->theta, config->threads);
+    } else if (config->threads > 0) {
+        compute_rocket_forces_threaded(r, b, config->g, config->threads, config->precision);
+    } else {
+        rocket_force_kernel_sized(config->precision, b->n)(r, b, config->g, 0, r->n);
+    }
+    events_scatter_forces(state, r);
+    
+    PROFILE_COUNT(state->profile, (long long)r->n * b->n);
+    PROFILE_END(state->profile, started, PROFILE_ROCKET_FORCES);
+}
+
+/**
+ * Body and rocket accelerations at the current (synchronised) positions
+ * With solver=bh the rockets reuse the tree just built for the bodies
+ */
+static void kdk_forces(SimState *state, const SimConfig *config) {
+    int tree = (sim_body_forces(state, config) == 0 && config->solver == SOLVER_BH);
+    
+    if (tree) {
+        PROFILE_BEGIN(state->profile, started);
+        ParticleSoA *r = events_force_rockets(state);
+        compute_rocket_forces_bh(r, &state->body_soa, &state->tree,
+                                 config->g, config->theta, config->threads);
+        events_scatter_forces(state, r);
+        PROFILE_COUNT(state->profile, (long long)r->n * state->body_soa.n);
+        PROFILE_END(state->profile, started, PROFILE_ROCKET_FORCES);
+    } else {
+        sim_rocket_forces(state, config);
+    }
+}
+
+/**
+ * Kick-drift-kick leapfrog step
+ * v += a(t) dt/2;  x += v dt;  a(t+dt);  v += a(t+dt) dt/2
+ * 
+ * a(t+dt) is kept for the next step's first half-kick, so forces are
+ * evaluated once per step. The very first step (or the first after
+ * sim_state_pack()) computes a(t) itself.
+ * 
+ * With block_steps=1 rockets take their own power-of-two sub-steps
+ * (see timestep.c) and only rockets that are due are evaluated.
+ */
+static void sim_step_kdk(SimState *state, const SimConfig *config) {
+    ParticleSoA *b = &state->body_soa;
+    ParticleSoA *r = &state->rocket_soa;
+    double half_dt = 0.5 * config->dt;
+    
+    if (!state->forces_valid) {
+        kdk_forces(state, config);
+        if (config->block_steps) block_steps_reset(&state->blocks, r->n);
+        state->forces_valid = 1;
+    }
+    
+    // Rockets sub-cycle against bodies predicted from the step start; if
+    // the schedule cannot be allocated (nothing has moved yet) the step
+    // is a plain KDK step for the rockets as well
+    if (config->block_steps) {
+        if (advance_rockets_block(state, config) == 0) {
+            kick_particles(b, half_dt, config->threads);
+            drift_particles(b, config->dt, config->threads);
+            sim_body_forces(state, config);
+            kick_particles(b, half_dt, config->threads);
+            return;
+        }
+        printf("Warning: Stepping the rockets with the global step\n");
+    }
+    
+    kick_particles(b, half_dt, config->threads);
+    kick_particles(r, half_dt, config->threads);
+    drift_particles(b, config->dt, config->threads);
+    drift_particles(r, config->dt, config->threads);
+    
+    kdk_forces(state, config);
+    
+    kick_particles(b, half_dt, config->threads);
+    kick_particles(r, half_dt, config->threads);
+}
+
+/**
+ * Semi-implicit Euler step
+ * Bodies are integrated first so rockets see the updated field
+ */
+static void sim_step_euler(SimState *state, const SimConfig *config) {
+    sim_body_forces(state, config);
+    integrate_particles(&state->body_soa, config->dt, config->threads);
+    
+    sim_rocket_forces(state, config);
+    integrate_particles(&state->rocket_soa, config->dt, config->threads);
+    
+    // Accelerations now lag the positions by a step
+    state->forces_valid = 0;
+}
+
+/**
+ * Rocket-only step against the body ephemeris
+ * The rockets take exactly the operations of sim_step_kdk() or
+ * sim_step_euler(), with the bodies read from the ephemeris where those
+ * would have integrated them, so the rocket trajectories are unchanged
+ */
+static void sim_step_rockets(SimState *state, const SimConfig *config) {
+    ParticleSoA *b = &state->body_soa;
+    ParticleSoA *r = &state->rocket_soa;
+    int step = state->ephemeris_step;
+    
+    if (config->integrator == INTEGRATOR_EULER) {
+        ephemeris_bodies(state->ephemeris, step + 1, b);
+        sim_rocket_forces(state, config);
+        integrate_particles(r, config->dt, config->threads);
+        state->forces_valid = 0;
+    } else {
+        double half_dt = 0.5 * config->dt;
+        if (!state->forces_valid) {
+            ephemeris_bodies(state->ephemeris, step, b);
+            sim_rocket_forces(state, config);
+            state->forces_valid = 1;
         }
+        kick_particles(r, half_dt, config->threads);
+        drift_particles(r, config->dt, config->threads);
+        ephemeris_bodies(state->ephemeris, step + 1, b);
+        sim_rocket_forces(state, config);
+        kick_particles(r, half_dt, config->threads);
+    }
+    state->ephemeris_step++;
+}
+
+/**
+ * Advance the simulation state by one time step
+ * Everything but the forces and trails is timed as integration
+ */
+void sim_step(SimState *state, const SimConfig *config) {
+    PROFILE_BEGIN(state->profile, step_started);
+    if (!state->events.live_valid) events_prepare(state, config);
+    
+    if (state->ephemeris) {
+        sim_step_rockets(state, config);
+    } else if (config->integrator == INTEGRATOR_EULER) {
+        sim_step_euler(state, config);
+    } else {
+        sim_step_kdk(state, config);
+    }
+    
+    state->time += config->dt;
+    
+    PROFILE_BEGIN(state->profile, trails_started);
+    const RocketEvents *ev = &state->events;
+    record_rocket_trails(state->rockets, &state->rocket_soa, ev->live_valid ? ev->live : NULL,
+                         ev->n_live, config->trail_stride, trail_tolerance_units(config));
+    if (state->trail_sink) {
+        trail_sink_flush(state->trail_sink, state->rockets, state->n_rockets, 0);
+    }
+    PROFILE_END(state->profile, trails_started, PROFILE_TRAILS);
+    
+    events_detect(state, config);
+    PROFILE_END(state->profile, step_started, PROFILE_INTEGRATE);
+}
+
+/* ============================================================================
+ * AOS ADAPTERS
+ * ============================================================================ */
+
+/**
+ * Compute gravitational forces between bodies (AoS view)
+ */
+void compute_forces(Body *bodies, int n, double g) {
+    ParticleSoA soa = {0};
+    if (soa_from_bodies(&soa, bodies, n) != 0) return;
+    
+    compute_forces_soa(&soa, g);
+    
+    soa_to_bodies(&soa, bodies);
+    soa_free(&soa);
+}
+
+/**
+ * Compute gravitational acceleration on rockets (AoS view)
+ */
+void compute_rocket_forces(Rocket *rockets, int n_rockets, 
+                          Body *bodies, int n_bodies, double g) {
+    ParticleSoA rsoa = {0};
+    ParticleSoA bsoa = {0};
+    if (soa_from_rockets(&rsoa, rockets, n_rockets) == 0 &&
+        soa_from_bodies(&bsoa, bodies, n_bodies) == 0) {
+        compute_rocket_forces_soa(&rsoa, &bsoa, g);
+        soa_to_rockets(&rsoa, rockets);
+    }
+    soa_free(&rsoa);
+    soa_free(&bsoa);
+}
+
+/**
+ * Update body positions and velocities (AoS view)
+ */
+void update_bodies(Body *bodies, int n, double dt, double g) {
+    ParticleSoA soa = {0};
+    if (soa_from_bodies(&soa, bodies, n) != 0) return;
+    
+    update_bodies_soa(&soa, dt, g);
+    
+    soa_to_bodies(&soa, bodies);
+    soa_free(&soa);
+}
+
+/**
+ * Update rocket positions and velocities (AoS view)
+ * Records trails and applies the escape check like sim_step()
+ */
+void update_rockets(Rocket *rockets, int n_rockets, Body *bodies, 
+                   int n_bodies, double dt, double g) {
+    ParticleSoA rsoa = {0};
+    ParticleSoA bsoa = {0};
+    if (soa_from_rockets(&rsoa, rockets, n_rockets) == 0 &&
+        soa_from_bodies(&bsoa, bodies, n_bodies) == 0) {
+        update_rockets_soa(&rsoa, &bsoa, dt, g);
+        record_rocket_trails(rockets, &rsoa, NULL, 0, 1, 0.0);
+        check_rocket_escape(&rsoa, ESCAPE_RADIUS);
+        soa_to_rockets(&rsoa, rockets);
     }
-}
\ No newline at end of file
+    soa_free(&rsoa);
+    soa_free(&bsoa);
+}
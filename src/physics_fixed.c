@@ -0,0 +1,310 @@
+/**
+ * physics_fixed.c - Body-Count Specialized Rocket Kernels
+ * Rocket force kernels compiled for 1 to FIXED_BODIES_MAX bodies
+ *
+ * Production setups have a handful of massive bodies and many rockets.
+ * With the body count a compile-time constant the body loop unrolls
+ * completely and the body positions and G*M values are loaded once per
+ * call, held in registers (broadcast vectors for the SIMD kernels) while
+ * the rockets stream past.
+ *
+ * Each kernel body is written once as an always-inline function of `n`;
+ * FIXED_KERNELS() instantiates it for every constant and builds the
+ * table rocket_force_kernel_sized() picks from. The arithmetic matches
+ * the generic kernels of physics_simd.c operation for operation, so the
+ * results are bitwise identical. Body counts above FIXED_BODIES_MAX and
+ * the float precision modes use the generic kernels.
+ */
+
+#include "nbody.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON_KERNEL 1
+#endif
+
+#define FIXED_INLINE static inline __attribute__((always_inline))
+
+/*
+ * One wrapper per body count and the table indexed by count - 1
+ */
+#define FIXED_KERNEL(name, attr, n) \
+    attr static void name##_##n(ParticleSoA *rockets, const ParticleSoA *bodies, \
+                                double g, int begin, int end) { \
+        name(rockets, bodies, g, begin, end, n); \
+    }
+
+#define FIXED_KERNELS(name, attr) \
+    FIXED_KERNEL(name, attr, 1) FIXED_KERNEL(name, attr, 2) \
+    FIXED_KERNEL(name, attr, 3) FIXED_KERNEL(name, attr, 4) \
+    FIXED_KERNEL(name, attr, 5) FIXED_KERNEL(name, attr, 6) \
+    FIXED_KERNEL(name, attr, 7) FIXED_KERNEL(name, attr, 8) \
+    static const RocketForceKernel name##_table[FIXED_BODIES_MAX] = { \
+        name##_1, name##_2, name##_3, name##_4, \
+        name##_5, name##_6, name##_7, name##_8 \
+    };
+
+/* ============================================================================
+ * SCALAR KERNEL
+ * ============================================================================ */
+
+/**
+ * Scalar kernel for `n` bodies; also the remainder lanes of the vector ones
+ */
+FIXED_INLINE void fixed_scalar(ParticleSoA *rockets, const ParticleSoA *bodies,
+                               double g, int begin, int end, int n) {
+    double bx[FIXED_BODIES_MAX], by[FIXED_BODIES_MAX], gm[FIXED_BODIES_MAX];
+    #pragma GCC unroll 8
+    for (int j = 0; j < n; j++) {
+        bx[j] = bodies->x[j];
+        by[j] = bodies->y[j];
+        gm[j] = g * bodies->mass[j];
+    }
+    
+    for (int i = begin; i < end; i++) {
+        if (!rockets->active[i]) continue;
+        
+        double rx = rockets->x[i];
+        double ry = rockets->y[i];
+        double ax = 0.0;
+        double ay = 0.0;
+        
+        #pragma GCC unroll 8
+        for (int j = 0; j < n; j++) {
+            double dx = bx[j] - rx;
+            double dy = by[j] - ry;
+            double dist_sq = dx * dx + dy * dy + SOFTENING * SOFTENING;
+            double dist = sqrt(dist_sq);
+            double acc = gm[j] / dist_sq;
+            ax += acc * dx / dist;
+            ay += acc * dy / dist;
+        }
+        
+        rockets->ax[i] = ax;
+        rockets->ay[i] = ay;
+    }
+}
+
+FIXED_KERNELS(fixed_scalar, )
+
+/* ============================================================================
+ * X86 KERNELS (AVX2 / AVX-512)
+ * ============================================================================ */
+
+#ifdef HAVE_X86_KERNELS
+
+/**
+ * AVX2 + FMA kernel for `n` bodies: 4 rockets per vector
+ */
+__attribute__((target("avx2,fma")))
+FIXED_INLINE void fixed_avx2(ParticleSoA *rockets, const ParticleSoA *bodies,
+                             double g, int begin, int end, int n) {
+    const __m256d eps2 = _mm256_set1_pd(SOFTENING * SOFTENING);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d three_halves = _mm256_set1_pd(1.5);
+    const __m256i zero = _mm256_setzero_si256();
+    
+    __m256d bx[FIXED_BODIES_MAX], by[FIXED_BODIES_MAX], gm[FIXED_BODIES_MAX];
+    #pragma GCC unroll 8
+    for (int j = 0; j < n; j++) {
+        bx[j] = _mm256_set1_pd(bodies->x[j]);
+        by[j] = _mm256_set1_pd(bodies->y[j]);
+        gm[j] = _mm256_set1_pd(g * bodies->mass[j]);
+    }
+    
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        int flags;
+        memcpy(&flags, &rockets->active[i], sizeof(flags));
+        __m256i act = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(flags));
+        __m256i mask = _mm256_cmpgt_epi64(act, zero);
+        if (_mm256_testz_si256(mask, mask)) continue;
+        
+        __m256d rx = _mm256_loadu_pd(&rockets->x[i]);
+        __m256d ry = _mm256_loadu_pd(&rockets->y[i]);
+        __m256d ax = _mm256_setzero_pd();
+        __m256d ay = _mm256_setzero_pd();
+        
+        #pragma GCC unroll 8
+        for (int j = 0; j < n; j++) {
+            __m256d dx = _mm256_sub_pd(bx[j], rx);
+            __m256d dy = _mm256_sub_pd(by[j], ry);
+            __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, eps2));
+            
+            __m256d inv = _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(r2)));
+            __m256d hr2 = _mm256_mul_pd(half, r2);
+            inv = _mm256_mul_pd(inv, _mm256_fnmadd_pd(hr2, _mm256_mul_pd(inv, inv), three_halves));
+            inv = _mm256_mul_pd(inv, _mm256_fnmadd_pd(hr2, _mm256_mul_pd(inv, inv), three_halves));
+            
+            __m256d inv3 = _mm256_mul_pd(inv, _mm256_mul_pd(inv, inv));
+            __m256d s = _mm256_mul_pd(gm[j], inv3);
+            ax = _mm256_fmadd_pd(s, dx, ax);
+            ay = _mm256_fmadd_pd(s, dy, ay);
+        }
+        
+        _mm256_maskstore_pd(&rockets->ax[i], mask, ax);
+        _mm256_maskstore_pd(&rockets->ay[i], mask, ay);
+    }
+    
+    fixed_scalar(rockets, bodies, g, i, end, n);
+}
+
+/**
+ * AVX-512F kernel for `n` bodies: 8 rockets per vector
+ */
+__attribute__((target("avx512f")))
+FIXED_INLINE void fixed_avx512(ParticleSoA *rockets, const ParticleSoA *bodies,
+                               double g, int begin, int end, int n) {
+    const __m512d eps2 = _mm512_set1_pd(SOFTENING * SOFTENING);
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d three_halves = _mm512_set1_pd(1.5);
+    
+    __m512d bx[FIXED_BODIES_MAX], by[FIXED_BODIES_MAX], gm[FIXED_BODIES_MAX];
+    #pragma GCC unroll 8
+    for (int j = 0; j < n; j++) {
+        bx[j] = _mm512_set1_pd(bodies->x[j]);
+        by[j] = _mm512_set1_pd(bodies->y[j]);
+        gm[j] = _mm512_set1_pd(g * bodies->mass[j]);
+    }
+    
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m128i flags = _mm_loadl_epi64((const __m128i *)&rockets->active[i]);
+        __m512i act = _mm512_cvtepu8_epi64(flags);
+        __mmask8 mask = _mm512_test_epi64_mask(act, act);
+        if (mask == 0) continue;
+        
+        __m512d rx = _mm512_loadu_pd(&rockets->x[i]);
+        __m512d ry = _mm512_loadu_pd(&rockets->y[i]);
+        __m512d ax = _mm512_setzero_pd();
+        __m512d ay = _mm512_setzero_pd();
+        
+        #pragma GCC unroll 8
+        for (int j = 0; j < n; j++) {
+            __m512d dx = _mm512_sub_pd(bx[j], rx);
+            __m512d dy = _mm512_sub_pd(by[j], ry);
+            __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, eps2));
+            
+            __m512d inv = _mm512_rsqrt14_pd(r2);
+            __m512d hr2 = _mm512_mul_pd(half, r2);
+            inv = _mm512_mul_pd(inv, _mm512_fnmadd_pd(hr2, _mm512_mul_pd(inv, inv), three_halves));
+            inv = _mm512_mul_pd(inv, _mm512_fnmadd_pd(hr2, _mm512_mul_pd(inv, inv), three_halves));
+            
+            __m512d inv3 = _mm512_mul_pd(inv, _mm512_mul_pd(inv, inv));
+            __m512d s = _mm512_mul_pd(gm[j], inv3);
+            ax = _mm512_fmadd_pd(s, dx, ax);
+            ay = _mm512_fmadd_pd(s, dy, ay);
+        }
+        
+        _mm512_mask_storeu_pd(&rockets->ax[i], mask, ax);
+        _mm512_mask_storeu_pd(&rockets->ay[i], mask, ay);
+    }
+    
+    fixed_scalar(rockets, bodies, g, i, end, n);
+}
+
+FIXED_KERNELS(fixed_avx2, __attribute__((target("avx2,fma"))))
+FIXED_KERNELS(fixed_avx512, __attribute__((target("avx512f"))))
+
+#endif /* HAVE_X86_KERNELS */
+
+/* ============================================================================
+ * ARM KERNEL (NEON)
+ * ============================================================================ */
+
+#ifdef HAVE_NEON_KERNEL
+
+/**
+ * NEON kernel for `n` bodies: 2 rockets per vector
+ */
+FIXED_INLINE void fixed_neon(ParticleSoA *rockets, const ParticleSoA *bodies,
+                             double g, int begin, int end, int n) {
+    const float64x2_t eps2 = vdupq_n_f64(SOFTENING * SOFTENING);
+    
+    float64x2_t bx[FIXED_BODIES_MAX], by[FIXED_BODIES_MAX], gm[FIXED_BODIES_MAX];
+    #pragma GCC unroll 8
+    for (int j = 0; j < n; j++) {
+        bx[j] = vdupq_n_f64(bodies->x[j]);
+        by[j] = vdupq_n_f64(bodies->y[j]);
+        gm[j] = vdupq_n_f64(g * bodies->mass[j]);
+    }
+    
+    int i = begin;
+    for (; i + 2 <= end; i += 2) {
+        uint64_t lanes[2] = {rockets->active[i] ? ~0ULL : 0, rockets->active[i + 1] ? ~0ULL : 0};
+        if (!lanes[0] && !lanes[1]) continue;
+        uint64x2_t mask = vld1q_u64(lanes);
+        
+        float64x2_t rx = vld1q_f64(&rockets->x[i]);
+        float64x2_t ry = vld1q_f64(&rockets->y[i]);
+        float64x2_t ax = vdupq_n_f64(0.0);
+        float64x2_t ay = vdupq_n_f64(0.0);
+        
+        #pragma GCC unroll 8
+        for (int j = 0; j < n; j++) {
+            float64x2_t dx = vsubq_f64(bx[j], rx);
+            float64x2_t dy = vsubq_f64(by[j], ry);
+            float64x2_t r2 = vfmaq_f64(vfmaq_f64(eps2, dy, dy), dx, dx);
+            
+            float64x2_t inv = vrsqrteq_f64(r2);
+            inv = vmulq_f64(inv, vrsqrtsq_f64(vmulq_f64(r2, inv), inv));
+            inv = vmulq_f64(inv, vrsqrtsq_f64(vmulq_f64(r2, inv), inv));
+            inv = vmulq_f64(inv, vrsqrtsq_f64(vmulq_f64(r2, inv), inv));
+            
+            float64x2_t inv3 = vmulq_f64(inv, vmulq_f64(inv, inv));
+            float64x2_t s = vmulq_f64(gm[j], inv3);
+            ax = vfmaq_f64(ax, s, dx);
+            ay = vfmaq_f64(ay, s, dy);
+        }
+        
+        vst1q_f64(&rockets->ax[i], vbslq_f64(mask, ax, vld1q_f64(&rockets->ax[i])));
+        vst1q_f64(&rockets->ay[i], vbslq_f64(mask, ay, vld1q_f64(&rockets->ay[i])));
+    }
+    
+    fixed_scalar(rockets, bodies, g, i, end, n);
+}
+
+FIXED_KERNELS(fixed_neon, )
+
+#endif /* HAVE_NEON_KERNEL */
+
+/* ============================================================================
+ * DISPATCH
+ * ============================================================================ */
+
+/**
+ * Specialized kernel of a given kind for `n_bodies`, or NULL if none
+ */
+RocketForceKernel rocket_force_kernel_fixed(int kind, int n_bodies) {
+    if (n_bodies < 1 || n_bodies > FIXED_BODIES_MAX) return NULL;
+    
+    switch (kind) {
+        case KERNEL_SCALAR: return fixed_scalar_table[n_bodies - 1];
+#ifdef HAVE_X86_KERNELS
+        case KERNEL_AVX2:   return fixed_avx2_table[n_bodies - 1];
+        case KERNEL_AVX512: return fixed_avx512_table[n_bodies - 1];
+#endif
+#ifdef HAVE_NEON_KERNEL
+        case KERNEL_NEON:   return fixed_neon_table[n_bodies - 1];
+#endif
+        default:            return NULL;
+    }
+}
+
+/**
+ * Rocket force kernel for a precision mode and body count: the
+ * specialized kernel of the current kind when there is one, otherwise
+ * the generic kernel
+ */
+RocketForceKernel rocket_force_kernel_sized(int precision, int n_bodies) {
+    if (precision == PRECISION_DOUBLE) {
+        RocketForceKernel fixed = rocket_force_kernel_fixed(rocket_kernel_kind(), n_bodies);
+        if (fixed) return fixed;
+    }
+    return rocket_force_kernel_for(precision);
+}
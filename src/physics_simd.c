@@ -0,0 +1,709 @@
+/**
+ * physics_simd.c - Vectorized Rocket Force Kernels
+ * SIMD versions of the rocket acceleration loop with runtime CPU dispatch
+ *
+ * Each kernel processes a group of rockets per vector (4 with AVX2,
+ * 8 with AVX-512, 2 with NEON) and loops over bodies with broadcast
+ * body data. The per-rocket `active` branch is replaced by a lane mask
+ * so inactive rockets are left untouched by the stores.
+ *
+ * 1/sqrt(r^2) comes from the hardware reciprocal-sqrt estimate refined
+ * by Newton-Raphson steps: y' = y * (1.5 - 0.5 * r2 * y * y)
+ *
+ * precision=mixed|float selects float versions of every kernel, with
+ * twice the lanes per vector (see rocket_force_kernel_for()).
+ */
+
+#include "nbody.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#endif
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define HAVE_NEON_KERNEL 1
+#endif
+
+/* ============================================================================
+ * SCALAR KERNEL
+ * ============================================================================ */
+
+/**
+ * Reference scalar kernel for rockets [begin, end)
+ * Also used for the remainder lanes of the vector kernels
+ */
+void compute_rocket_forces_scalar(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                  double g, int begin, int end) {
+    int n_bodies = bodies->n;
+    const double *bx = bodies->x;
+    const double *by = bodies->y;
+    const double *bm = bodies->mass;
+    
+    for (int i = begin; i < end; i++) {
+        if (!rockets->active[i]) continue;
+        
+        double rx = rockets->x[i];
+        double ry = rockets->y[i];
+        double ax = 0.0;
+        double ay = 0.0;
+        
+        // Sum gravitational acceleration from all bodies
+        for (int j = 0; j < n_bodies; j++) {
+            double dx = bx[j] - rx;
+            double dy = by[j] - ry;
+            
+            double dist_sq = dx * dx + dy * dy + SOFTENING * SOFTENING;
+            double dist = sqrt(dist_sq);
+            
+            // Acceleration = G * M / r^2
+            double acc = g * bm[j] / dist_sq;
+            
+            ax += acc * dx / dist;
+            ay += acc * dy / dist;
+        }
+        
+        rockets->ax[i] = ax;
+        rockets->ay[i] = ay;
+    }
+}
+
+/* ============================================================================
+ * X86 KERNELS (AVX2 / AVX-512)
+ * ============================================================================ */
+
+#ifdef HAVE_X86_KERNELS
+
+/**
+ * AVX2 + FMA kernel: 4 rockets per vector
+ * The float rsqrt estimate (~12 bits) is refined twice in double (~46 bits)
+ */
+__attribute__((target("avx2,fma")))
+static void rocket_forces_avx2(ParticleSoA *rockets, const ParticleSoA *bodies,
+                               double g, int begin, int end) {
+    const __m256d eps2 = _mm256_set1_pd(SOFTENING * SOFTENING);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d three_halves = _mm256_set1_pd(1.5);
+    const __m256i zero = _mm256_setzero_si256();
+    
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        // Lane mask from the active flags (all-ones where active)
+        int flags;
+        memcpy(&flags, &rockets->active[i], sizeof(flags));
+        __m256i act = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(flags));
+        __m256i mask = _mm256_cmpgt_epi64(act, zero);
+        if (_mm256_testz_si256(mask, mask)) continue;
+        
+        __m256d rx = _mm256_loadu_pd(&rockets->x[i]);
+        __m256d ry = _mm256_loadu_pd(&rockets->y[i]);
+        __m256d ax = _mm256_setzero_pd();
+        __m256d ay = _mm256_setzero_pd();
+        
+        for (int j = 0; j < bodies->n; j++) {
+            __m256d dx = _mm256_sub_pd(_mm256_set1_pd(bodies->x[j]), rx);
+            __m256d dy = _mm256_sub_pd(_mm256_set1_pd(bodies->y[j]), ry);
+            __m256d r2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, eps2));
+            
+            __m256d inv = _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(r2)));
+            __m256d hr2 = _mm256_mul_pd(half, r2);
+            inv = _mm256_mul_pd(inv, _mm256_fnmadd_pd(hr2, _mm256_mul_pd(inv, inv), three_halves));
+            inv = _mm256_mul_pd(inv, _mm256_fnmadd_pd(hr2, _mm256_mul_pd(inv, inv), three_halves));
+            
+            // a = G * M / r^3 * d
+            __m256d inv3 = _mm256_mul_pd(inv, _mm256_mul_pd(inv, inv));
+            __m256d s = _mm256_mul_pd(_mm256_set1_pd(g * bodies->mass[j]), inv3);
+            ax = _mm256_fmadd_pd(s, dx, ax);
+            ay = _mm256_fmadd_pd(s, dy, ay);
+        }
+        
+        _mm256_maskstore_pd(&rockets->ax[i], mask, ax);
+        _mm256_maskstore_pd(&rockets->ay[i], mask, ay);
+    }
+    
+    compute_rocket_forces_scalar(rockets, bodies, g, i, end);
+}
+
+/**
+ * AVX-512F kernel: 8 rockets per vector
+ * rsqrt14 (~14 bits) refined twice reaches full double precision
+ */
+__attribute__((target("avx512f")))
+static void rocket_forces_avx512(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                 double g, int begin, int end) {
+    const __m512d eps2 = _mm512_set1_pd(SOFTENING * SOFTENING);
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d three_halves = _mm512_set1_pd(1.5);
+    
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        // Lane mask from the active flags
+        __m128i flags = _mm_loadl_epi64((const __m128i *)&rockets->active[i]);
+        __m512i act = _mm512_cvtepu8_epi64(flags);
+        __mmask8 mask = _mm512_test_epi64_mask(act, act);
+        if (mask == 0) continue;
+        
+        __m512d rx = _mm512_loadu_pd(&rockets->x[i]);
+        __m512d ry = _mm512_loadu_pd(&rockets->y[i]);
+        __m512d ax = _mm512_setzero_pd();
+        __m512d ay = _mm512_setzero_pd();
+        
+        for (int j = 0; j < bodies->n; j++) {
+            __m512d dx = _mm512_sub_pd(_mm512_set1_pd(bodies->x[j]), rx);
+            __m512d dy = _mm512_sub_pd(_mm512_set1_pd(bodies->y[j]), ry);
+            __m512d r2 = _mm512_fmadd_pd(dx, dx, _mm512_fmadd_pd(dy, dy, eps2));
+            
+            __m512d inv = _mm512_rsqrt14_pd(r2);
+            __m512d hr2 = _mm512_mul_pd(half, r2);
+            inv = _mm512_mul_pd(inv, _mm512_fnmadd_pd(hr2, _mm512_mul_pd(inv, inv), three_halves));
+            inv = _mm512_mul_pd(inv, _mm512_fnmadd_pd(hr2, _mm512_mul_pd(inv, inv), three_halves));
+            
+            __m512d inv3 = _mm512_mul_pd(inv, _mm512_mul_pd(inv, inv));
+            __m512d s = _mm512_mul_pd(_mm512_set1_pd(g * bodies->mass[j]), inv3);
+            ax = _mm512_fmadd_pd(s, dx, ax);
+            ay = _mm512_fmadd_pd(s, dy, ay);
+        }
+        
+        _mm512_mask_storeu_pd(&rockets->ax[i], mask, ax);
+        _mm512_mask_storeu_pd(&rockets->ay[i], mask, ay);
+    }
+    
+    compute_rocket_forces_scalar(rockets, bodies, g, i, end);
+}
+
+#endif /* HAVE_X86_KERNELS */
+
+/* ============================================================================
+ * ARM KERNEL (NEON)
+ * ============================================================================ */
+
+#ifdef HAVE_NEON_KERNEL
+
+/**
+ * NEON kernel: 2 rockets per vector
+ * vrsqrte (~8 bits) refined three times with vrsqrts
+ */
+static void rocket_forces_neon(ParticleSoA *rockets, const ParticleSoA *bodies,
+                               double g, int begin, int end) {
+    const float64x2_t eps2 = vdupq_n_f64(SOFTENING * SOFTENING);
+    
+    int i = begin;
+    for (; i + 2 <= end; i += 2) {
+        uint64_t lanes[2] = {rockets->active[i] ? ~0ULL : 0, rockets->active[i + 1] ? ~0ULL : 0};
+        if (!lanes[0] && !lanes[1]) continue;
+        uint64x2_t mask = vld1q_u64(lanes);
+        
+        float64x2_t rx = vld1q_f64(&rockets->x[i]);
+        float64x2_t ry = vld1q_f64(&rockets->y[i]);
+        float64x2_t ax = vdupq_n_f64(0.0);
+        float64x2_t ay = vdupq_n_f64(0.0);
+        
+        for (int j = 0; j < bodies->n; j++) {
+            float64x2_t dx = vsubq_f64(vdupq_n_f64(bodies->x[j]), rx);
+            float64x2_t dy = vsubq_f64(vdupq_n_f64(bodies->y[j]), ry);
+            float64x2_t r2 = vfmaq_f64(vfmaq_f64(eps2, dy, dy), dx, dx);
+            
+            float64x2_t inv = vrsqrteq_f64(r2);
+            inv = vmulq_f64(inv, vrsqrtsq_f64(vmulq_f64(r2, inv), inv));
+            inv = vmulq_f64(inv, vrsqrtsq_f64(vmulq_f64(r2, inv), inv));
+            inv = vmulq_f64(inv, vrsqrtsq_f64(vmulq_f64(r2, inv), inv));
+            
+            float64x2_t inv3 = vmulq_f64(inv, vmulq_f64(inv, inv));
+            float64x2_t s = vmulq_f64(vdupq_n_f64(g * bodies->mass[j]), inv3);
+            ax = vfmaq_f64(ax, s, dx);
+            ay = vfmaq_f64(ay, s, dy);
+        }
+        
+        // Blend so inactive lanes keep their previous acceleration
+        vst1q_f64(&rockets->ax[i], vbslq_f64(mask, ax, vld1q_f64(&rockets->ax[i])));
+        vst1q_f64(&rockets->ay[i], vbslq_f64(mask, ay, vld1q_f64(&rockets->ay[i])));
+    }
+    
+    compute_rocket_forces_scalar(rockets, bodies, g, i, end);
+}
+
+#endif /* HAVE_NEON_KERNEL */
+
+/* ============================================================================
+ * FLOAT KERNELS (precision=mixed|float)
+ * ============================================================================ */
+
+/*
+ * Same loop in float: twice the rockets per vector and one Newton step
+ * instead of two. Positions stay double in the SoA columns. With
+ * precision=mixed the body-rocket differences are taken in double and
+ * only then rounded, so the accuracy does not depend on the distance
+ * from the origin; precision=float rounds the positions themselves.
+ */
+
+/**
+ * Scalar float kernel for rockets [begin, end)
+ */
+static void rocket_forces_float_scalar(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                       double g, int begin, int end, int relative) {
+    const float eps2 = (float)(SOFTENING * SOFTENING);
+    const double *bx = bodies->x;
+    const double *by = bodies->y;
+    const double *bm = bodies->mass;
+    
+    for (int i = begin; i < end; i++) {
+        if (!rockets->active[i]) continue;
+        
+        double rx = rockets->x[i];
+        double ry = rockets->y[i];
+        float ax = 0.0f;
+        float ay = 0.0f;
+        
+        for (int j = 0; j < bodies->n; j++) {
+            float dx = relative ? (float)(bx[j] - rx) : (float)bx[j] - (float)rx;
+            float dy = relative ? (float)(by[j] - ry) : (float)by[j] - (float)ry;
+            float r2 = dx * dx + dy * dy + eps2;
+            float inv = 1.0f / sqrtf(r2);
+            float s = (float)(g * bm[j]) * inv * inv * inv;
+            ax += s * dx;
+            ay += s * dy;
+        }
+        
+        rockets->ax[i] = ax;
+        rockets->ay[i] = ay;
+    }
+}
+
+/**
+ * Scalar mixed-precision kernel (differences in double)
+ */
+void compute_rocket_forces_scalar_mixed(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                        double g, int begin, int end) {
+    rocket_forces_float_scalar(rockets, bodies, g, begin, end, 1);
+}
+
+/**
+ * Scalar single-precision kernel
+ */
+void compute_rocket_forces_scalar_float(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                        double g, int begin, int end) {
+    rocket_forces_float_scalar(rockets, bodies, g, begin, end, 0);
+}
+
+#ifdef HAVE_X86_KERNELS
+
+/**
+ * Two vectors of four doubles rounded into one vector of eight floats
+ */
+__attribute__((target("avx2,fma")))
+static __m256 narrow_avx2(__m256d lo, __m256d hi) {
+    return _mm256_set_m128(_mm256_cvtpd_ps(hi), _mm256_cvtpd_ps(lo));
+}
+
+/**
+ * AVX2 + FMA float kernel: 8 rockets per vector
+ * rsqrt (~12 bits) refined once (~23 bits)
+ */
+__attribute__((target("avx2,fma")))
+static void rocket_forces_float_avx2(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                     double g, int begin, int end, int relative) {
+    const __m256 eps2 = _mm256_set1_ps((float)(SOFTENING * SOFTENING));
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 three_halves = _mm256_set1_ps(1.5f);
+    const __m256i zero = _mm256_setzero_si256();
+    
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        long long flags;
+        memcpy(&flags, &rockets->active[i], sizeof(flags));
+        __m256i act = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(flags));
+        __m256i mask = _mm256_cmpgt_epi32(act, zero);
+        if (_mm256_testz_si256(mask, mask)) continue;
+        
+        __m256d rx_lo = _mm256_loadu_pd(&rockets->x[i]);
+        __m256d rx_hi = _mm256_loadu_pd(&rockets->x[i + 4]);
+        __m256d ry_lo = _mm256_loadu_pd(&rockets->y[i]);
+        __m256d ry_hi = _mm256_loadu_pd(&rockets->y[i + 4]);
+        __m256 rx = narrow_avx2(rx_lo, rx_hi);
+        __m256 ry = narrow_avx2(ry_lo, ry_hi);
+        __m256 ax = _mm256_setzero_ps();
+        __m256 ay = _mm256_setzero_ps();
+        
+        for (int j = 0; j < bodies->n; j++) {
+            __m256 dx, dy;
+            if (relative) {
+                __m256d bx = _mm256_set1_pd(bodies->x[j]);
+                __m256d by = _mm256_set1_pd(bodies->y[j]);
+                dx = narrow_avx2(_mm256_sub_pd(bx, rx_lo), _mm256_sub_pd(bx, rx_hi));
+                dy = narrow_avx2(_mm256_sub_pd(by, ry_lo), _mm256_sub_pd(by, ry_hi));
+            } else {
+                dx = _mm256_sub_ps(_mm256_set1_ps((float)bodies->x[j]), rx);
+                dy = _mm256_sub_ps(_mm256_set1_ps((float)bodies->y[j]), ry);
+            }
+            __m256 r2 = _mm256_fmadd_ps(dx, dx, _mm256_fmadd_ps(dy, dy, eps2));
+            
+            __m256 inv = _mm256_rsqrt_ps(r2);
+            __m256 hr2 = _mm256_mul_ps(half, r2);
+            inv = _mm256_mul_ps(inv, _mm256_fnmadd_ps(hr2, _mm256_mul_ps(inv, inv), three_halves));
+            
+            __m256 inv3 = _mm256_mul_ps(inv, _mm256_mul_ps(inv, inv));
+            __m256 s = _mm256_mul_ps(_mm256_set1_ps((float)(g * bodies->mass[j])), inv3);
+            ax = _mm256_fmadd_ps(s, dx, ax);
+            ay = _mm256_fmadd_ps(s, dy, ay);
+        }
+        
+        // Widen into the double columns, four lanes at a time
+        __m256i mask_lo = _mm256_cvtepi32_epi64(_mm256_castsi256_si128(mask));
+        __m256i mask_hi = _mm256_cvtepi32_epi64(_mm256_extracti128_si256(mask, 1));
+        _mm256_maskstore_pd(&rockets->ax[i], mask_lo, _mm256_cvtps_pd(_mm256_castps256_ps128(ax)));
+        _mm256_maskstore_pd(&rockets->ax[i + 4], mask_hi,
+                            _mm256_cvtps_pd(_mm256_extractf128_ps(ax, 1)));
+        _mm256_maskstore_pd(&rockets->ay[i], mask_lo, _mm256_cvtps_pd(_mm256_castps256_ps128(ay)));
+        _mm256_maskstore_pd(&rockets->ay[i + 4], mask_hi,
+                            _mm256_cvtps_pd(_mm256_extractf128_ps(ay, 1)));
+    }
+    
+    rocket_forces_float_scalar(rockets, bodies, g, i, end, relative);
+}
+
+/**
+ * Widen the low (half 0) or high (half 1) eight floats to doubles
+ */
+__attribute__((target("avx512f")))
+static __m512d widen_half_avx512(__m512 v, int half) {
+    __m256 part = half ? _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1)) :
+                         _mm512_castps512_ps256(v);
+    return _mm512_cvtps_pd(part);
+}
+
+/**
+ * Two vectors of eight doubles rounded into one vector of sixteen floats
+ */
+__attribute__((target("avx512f")))
+static __m512 narrow_avx512(__m512d lo, __m512d hi) {
+    __m256 low = _mm512_cvtpd_ps(lo);
+    __m256 high = _mm512_cvtpd_ps(hi);
+    return _mm512_castpd_ps(_mm512_insertf64x4(_mm512_castps_pd(_mm512_castps256_ps512(low)),
+                                               _mm256_castps_pd(high), 1));
+}
+
+/**
+ * AVX-512F float kernel: 16 rockets per vector
+ * rsqrt14 refined once reaches full float precision
+ */
+__attribute__((target("avx512f")))
+static void rocket_forces_float_avx512(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                       double g, int begin, int end, int relative) {
+    const __m512 eps2 = _mm512_set1_ps((float)(SOFTENING * SOFTENING));
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 three_halves = _mm512_set1_ps(1.5f);
+    
+    int i = begin;
+    for (; i + 16 <= end; i += 16) {
+        __m128i flags = _mm_loadu_si128((const __m128i *)&rockets->active[i]);
+        __m512i act = _mm512_cvtepu8_epi32(flags);
+        __mmask16 mask = _mm512_test_epi32_mask(act, act);
+        if (mask == 0) continue;
+        
+        __m512d rx_lo = _mm512_loadu_pd(&rockets->x[i]);
+        __m512d rx_hi = _mm512_loadu_pd(&rockets->x[i + 8]);
+        __m512d ry_lo = _mm512_loadu_pd(&rockets->y[i]);
+        __m512d ry_hi = _mm512_loadu_pd(&rockets->y[i + 8]);
+        __m512 rx = narrow_avx512(rx_lo, rx_hi);
+        __m512 ry = narrow_avx512(ry_lo, ry_hi);
+        __m512 ax = _mm512_setzero_ps();
+        __m512 ay = _mm512_setzero_ps();
+        
+        for (int j = 0; j < bodies->n; j++) {
+            __m512 dx, dy;
+            if (relative) {
+                __m512d bx = _mm512_set1_pd(bodies->x[j]);
+                __m512d by = _mm512_set1_pd(bodies->y[j]);
+                dx = narrow_avx512(_mm512_sub_pd(bx, rx_lo), _mm512_sub_pd(bx, rx_hi));
+                dy = narrow_avx512(_mm512_sub_pd(by, ry_lo), _mm512_sub_pd(by, ry_hi));
+            } else {
+                dx = _mm512_sub_ps(_mm512_set1_ps((float)bodies->x[j]), rx);
+                dy = _mm512_sub_ps(_mm512_set1_ps((float)bodies->y[j]), ry);
+            }
+            __m512 r2 = _mm512_fmadd_ps(dx, dx, _mm512_fmadd_ps(dy, dy, eps2));
+            
+            __m512 inv = _mm512_rsqrt14_ps(r2);
+            __m512 hr2 = _mm512_mul_ps(half, r2);
+            inv = _mm512_mul_ps(inv, _mm512_fnmadd_ps(hr2, _mm512_mul_ps(inv, inv), three_halves));
+            
+            __m512 inv3 = _mm512_mul_ps(inv, _mm512_mul_ps(inv, inv));
+            __m512 s = _mm512_mul_ps(_mm512_set1_ps((float)(g * bodies->mass[j])), inv3);
+            ax = _mm512_fmadd_ps(s, dx, ax);
+            ay = _mm512_fmadd_ps(s, dy, ay);
+        }
+        
+        __mmask8 mask_lo = (__mmask8)(mask & 0xFF);
+        __mmask8 mask_hi = (__mmask8)(mask >> 8);
+        _mm512_mask_storeu_pd(&rockets->ax[i], mask_lo, widen_half_avx512(ax, 0));
+        _mm512_mask_storeu_pd(&rockets->ax[i + 8], mask_hi, widen_half_avx512(ax, 1));
+        _mm512_mask_storeu_pd(&rockets->ay[i], mask_lo, widen_half_avx512(ay, 0));
+        _mm512_mask_storeu_pd(&rockets->ay[i + 8], mask_hi, widen_half_avx512(ay, 1));
+    }
+    
+    rocket_forces_float_scalar(rockets, bodies, g, i, end, relative);
+}
+
+/**
+ * AVX2 mixed-precision kernel
+ */
+static void rocket_forces_mixed_avx2(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                     double g, int begin, int end) {
+    rocket_forces_float_avx2(rockets, bodies, g, begin, end, 1);
+}
+
+/**
+ * AVX2 single-precision kernel
+ */
+static void rocket_forces_single_avx2(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                      double g, int begin, int end) {
+    rocket_forces_float_avx2(rockets, bodies, g, begin, end, 0);
+}
+
+/**
+ * AVX-512 mixed-precision kernel
+ */
+static void rocket_forces_mixed_avx512(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                       double g, int begin, int end) {
+    rocket_forces_float_avx512(rockets, bodies, g, begin, end, 1);
+}
+
+/**
+ * AVX-512 single-precision kernel
+ */
+static void rocket_forces_single_avx512(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                        double g, int begin, int end) {
+    rocket_forces_float_avx512(rockets, bodies, g, begin, end, 0);
+}
+
+#endif /* HAVE_X86_KERNELS */
+
+#ifdef HAVE_NEON_KERNEL
+
+/**
+ * NEON float kernel: 4 rockets per vector
+ * vrsqrte (~8 bits) refined twice with vrsqrts
+ */
+static void rocket_forces_float_neon(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                     double g, int begin, int end, int relative) {
+    const float32x4_t eps2 = vdupq_n_f32((float)(SOFTENING * SOFTENING));
+    
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        uint64_t lanes[4];
+        int any = 0;
+        for (int l = 0; l < 4; l++) {
+            lanes[l] = rockets->active[i + l] ? ~0ULL : 0;
+            any |= rockets->active[i + l];
+        }
+        if (!any) continue;
+        
+        float64x2_t rx_lo = vld1q_f64(&rockets->x[i]);
+        float64x2_t rx_hi = vld1q_f64(&rockets->x[i + 2]);
+        float64x2_t ry_lo = vld1q_f64(&rockets->y[i]);
+        float64x2_t ry_hi = vld1q_f64(&rockets->y[i + 2]);
+        float32x4_t rx = vcvt_high_f32_f64(vcvt_f32_f64(rx_lo), rx_hi);
+        float32x4_t ry = vcvt_high_f32_f64(vcvt_f32_f64(ry_lo), ry_hi);
+        float32x4_t ax = vdupq_n_f32(0.0f);
+        float32x4_t ay = vdupq_n_f32(0.0f);
+        
+        for (int j = 0; j < bodies->n; j++) {
+            float32x4_t dx, dy;
+            if (relative) {
+                float64x2_t bx = vdupq_n_f64(bodies->x[j]);
+                float64x2_t by = vdupq_n_f64(bodies->y[j]);
+                dx = vcvt_high_f32_f64(vcvt_f32_f64(vsubq_f64(bx, rx_lo)), vsubq_f64(bx, rx_hi));
+                dy = vcvt_high_f32_f64(vcvt_f32_f64(vsubq_f64(by, ry_lo)), vsubq_f64(by, ry_hi));
+            } else {
+                dx = vsubq_f32(vdupq_n_f32((float)bodies->x[j]), rx);
+                dy = vsubq_f32(vdupq_n_f32((float)bodies->y[j]), ry);
+            }
+            float32x4_t r2 = vfmaq_f32(vfmaq_f32(eps2, dy, dy), dx, dx);
+            
+            float32x4_t inv = vrsqrteq_f32(r2);
+            inv = vmulq_f32(inv, vrsqrtsq_f32(vmulq_f32(r2, inv), inv));
+            inv = vmulq_f32(inv, vrsqrtsq_f32(vmulq_f32(r2, inv), inv));
+            
+            float32x4_t inv3 = vmulq_f32(inv, vmulq_f32(inv, inv));
+            float32x4_t s = vmulq_f32(vdupq_n_f32((float)(g * bodies->mass[j])), inv3);
+            ax = vfmaq_f32(ax, s, dx);
+            ay = vfmaq_f32(ay, s, dy);
+        }
+        
+        // Widen and blend so inactive lanes keep their previous acceleration
+        uint64x2_t mask_lo = vld1q_u64(&lanes[0]);
+        uint64x2_t mask_hi = vld1q_u64(&lanes[2]);
+        vst1q_f64(&rockets->ax[i], vbslq_f64(mask_lo, vcvt_f64_f32(vget_low_f32(ax)),
+                                             vld1q_f64(&rockets->ax[i])));
+        vst1q_f64(&rockets->ax[i + 2], vbslq_f64(mask_hi, vcvt_high_f64_f32(ax),
+                                                 vld1q_f64(&rockets->ax[i + 2])));
+        vst1q_f64(&rockets->ay[i], vbslq_f64(mask_lo, vcvt_f64_f32(vget_low_f32(ay)),
+                                             vld1q_f64(&rockets->ay[i])));
+        vst1q_f64(&rockets->ay[i + 2], vbslq_f64(mask_hi, vcvt_high_f64_f32(ay),
+                                                 vld1q_f64(&rockets->ay[i + 2])));
+    }
+    
+    rocket_forces_float_scalar(rockets, bodies, g, i, end, relative);
+}
+
+/**
+ * NEON mixed-precision kernel
+ */
+static void rocket_forces_mixed_neon(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                     double g, int begin, int end) {
+    rocket_forces_float_neon(rockets, bodies, g, begin, end, 1);
+}
+
+/**
+ * NEON single-precision kernel
+ */
+static void rocket_forces_single_neon(ParticleSoA *rockets, const ParticleSoA *bodies,
+                                      double g, int begin, int end) {
+    rocket_forces_float_neon(rockets, bodies, g, begin, end, 0);
+}
+
+#endif /* HAVE_NEON_KERNEL */
+
+/* ============================================================================
+ * RUNTIME DISPATCH
+ * ============================================================================ */
+
+static RocketForceKernel active_kernel = NULL;
+static int active_kind = KERNEL_SCALAR;
+static pthread_once_t default_kernel_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Check whether a kernel can run on this CPU
+ */
+static int kernel_supported(int kind) {
+    switch (kind) {
+        case KERNEL_SCALAR:
+            return 1;
+#ifdef HAVE_X86_KERNELS
+        case KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case KERNEL_AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+#ifdef HAVE_NEON_KERNEL
+        case KERNEL_NEON:
+            return 1;
+#endif
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Install a kernel: KERNEL_AUTO picks the widest kernel the CPU supports,
+ * an unsupported request falls back to the scalar kernel
+ */
+static int install_kernel(int kind) {
+    if (kind == KERNEL_AUTO) {
+        if (kernel_supported(KERNEL_AVX512)) kind = KERNEL_AVX512;
+        else if (kernel_supported(KERNEL_AVX2)) kind = KERNEL_AVX2;
+        else if (kernel_supported(KERNEL_NEON)) kind = KERNEL_NEON;
+        else kind = KERNEL_SCALAR;
+    } else if (!kernel_supported(kind)) {
+        kind = KERNEL_SCALAR;
+    }
+    
+    switch (kind) {
+#ifdef HAVE_X86_KERNELS
+        case KERNEL_AVX2:   active_kernel = rocket_forces_avx2; break;
+        case KERNEL_AVX512: active_kernel = rocket_forces_avx512; break;
+#endif
+#ifdef HAVE_NEON_KERNEL
+        case KERNEL_NEON:   active_kernel = rocket_forces_neon; break;
+#endif
+        default:            active_kernel = compute_rocket_forces_scalar; break;
+    }
+    
+    active_kind = kind;
+    return kind;
+}
+
+/**
+ * Install the widest supported kernel; runs once, under pthread_once()
+ */
+static void install_default_kernel(void) {
+    install_kernel(KERNEL_AUTO);
+}
+
+/**
+ * Select the rocket force kernel
+ * KERNEL_AUTO picks the widest kernel the CPU supports; an unsupported
+ * request falls back to the scalar kernel. Returns the kernel selected.
+ * Call it before threads step, not while they do.
+ */
+int select_rocket_kernel(int kind) {
+    // The default is installed first, so it can never replace this choice
+    pthread_once(&default_kernel_once, install_default_kernel);
+    return install_kernel(kind);
+}
+
+/**
+ * Get the current rocket force kernel
+ * The first call from any thread selects the default exactly once; batch
+ * workers and OpenMP threads may all get here first
+ */
+RocketForceKernel rocket_force_kernel(void) {
+    pthread_once(&default_kernel_once, install_default_kernel);
+    return active_kernel;
+}
+
+/**
+ * Kernel of the current kind for a precision mode
+ */
+RocketForceKernel rocket_force_kernel_for(int precision) {
+    if (precision != PRECISION_MIXED && precision != PRECISION_FLOAT) {
+        return rocket_force_kernel();
+    }
+    int mixed = (precision == PRECISION_MIXED);
+    
+    switch (rocket_kernel_kind()) {
+#ifdef HAVE_X86_KERNELS
+        case KERNEL_AVX2:   return mixed ? rocket_forces_mixed_avx2 : rocket_forces_single_avx2;
+        case KERNEL_AVX512: return mixed ? rocket_forces_mixed_avx512 : rocket_forces_single_avx512;
+#endif
+#ifdef HAVE_NEON_KERNEL
+        case KERNEL_NEON:   return mixed ? rocket_forces_mixed_neon : rocket_forces_single_neon;
+#endif
+        default:
+            return mixed ? compute_rocket_forces_scalar_mixed : compute_rocket_forces_scalar_float;
+    }
+}
+
+/**
+ * Human-readable name of a precision mode
+ */
+const char *precision_name(int precision) {
+    switch (precision) {
+        case PRECISION_DOUBLE: return "double";
+        case PRECISION_MIXED:  return "mixed";
+        case PRECISION_FLOAT:  return "float";
+        default:               return "unknown";
+    }
+}
+
+/**
+ * Human-readable name of a kernel kind
+ */
+const char *rocket_kernel_name(int kind) {
+    switch (kind) {
+        case KERNEL_AUTO:   return "auto";
+        case KERNEL_SCALAR: return "scalar";
+        case KERNEL_AVX2:   return "avx2";
+        case KERNEL_AVX512: return "avx512";
+        case KERNEL_NEON:   return "neon";
+        default:            return "unknown";
+    }
+}
+
+/**
+ * Kind of the kernel currently in use
+ */
+int rocket_kernel_kind(void) {
+    rocket_force_kernel();
+    return active_kind;
+}
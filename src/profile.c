@@ -0,0 +1,145 @@
+/**
+ * profile.c - Phase Timers
+ * Where a run spends its wall-clock time
+ *
+ * The hot paths are wrapped in PROFILE_BEGIN/PROFILE_END pairs (see
+ * nbody.h) that add to state->profile when it is set. A timer records
+ * only its own time: profile_begin() notes the clock minus the time
+ * already recorded, so a timer around a whole step leaves out the force
+ * evaluations timed inside it and the phase totals add up to the run.
+ *
+ * Builds with PROFILE=0 compile the timers out entirely; a NULL profile
+ * (batch scenarios, ephemeris recording) costs one branch per timer.
+ *
+ * Frames rendered by the pipeline are timed on their worker threads and
+ * reported apart from the simulation thread's phases.
+ */
+
+#include "nbody.h"
+
+#ifdef NBODY_PROFILE
+static const char *phase_names[PROFILE_PHASES] = {
+    "Body forces", "Rocket forces", "Integration", "Trails", "Render", "Frame writes"
+};
+#endif
+
+/**
+ * Seconds on the monotonic clock
+ */
+double profile_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Clear all totals and start the run clock
+ */
+void profile_init(Profile *p) {
+    memset(p, 0, sizeof(Profile));
+    p->start = profile_clock();
+    p->frame_start = p->start;
+}
+
+/**
+ * Start a timer: the clock less the time nested timers have recorded
+ */
+double profile_begin(const Profile *p) {
+    return profile_clock() - p->nested;
+}
+
+/**
+ * Stop a timer and add its own time to `phase`
+ */
+void profile_end(Profile *p, int phase, double started) {
+    double own = profile_clock() - p->nested - started;
+    p->seconds[phase] += own;
+    p->nested += own;
+}
+
+/**
+ * Create the per-frame timing CSV
+ */
+int profile_open_csv(Profile *p, const char *filename) {
+#ifndef NBODY_PROFILE
+    printf("Warning: Timers are compiled out (make PROFILE=1), not writing %s\n", filename);
+    (void)p;
+    return -1;
+#else
+    p->csv = fopen(filename, "w");
+    if (!p->csv) {
+        printf("Error: Could not create %s\n", filename);
+        return -1;
+    }
+    fprintf(p->csv, "Frame,Step,Time,BodyForces,RocketForces,Integration,Trails,"
+                    "Render,FrameWrites,Other,Wall\n");
+    return 0;
+#endif
+}
+
+/**
+ * Append one row: seconds per phase since the previous row
+ */
+void profile_frame(Profile *p, int frame, int step, double time) {
+    if (!p->csv) return;
+    
+    double now = profile_clock();
+    double wall = now - p->frame_start;
+    double timed = 0.0;
+    
+    fprintf(p->csv, "%d,%d,%.6f", frame, step, time);
+    for (int k = 0; k < PROFILE_PHASES; k++) {
+        double s = p->seconds[k] - p->frame_seconds[k];
+        fprintf(p->csv, ",%.6f", s);
+        timed += s;
+        p->frame_seconds[k] = p->seconds[k];
+    }
+    fprintf(p->csv, ",%.6f,%.6f\n", wall - timed, wall);
+    p->frame_start = now;
+}
+
+/**
+ * Print the phase table, the untimed remainder and the interaction rate
+ */
+void profile_report(const Profile *p, long long steps) {
+#ifndef NBODY_PROFILE
+    (void)p;
+    (void)steps;
+    printf("Timing: timers compiled out (build with make PROFILE=1)\n");
+#else
+    double wall = profile_clock() - p->start;
+    double timed = 0.0;
+    for (int k = 0; k < PROFILE_PHASES; k++) timed += p->seconds[k];
+    double other = wall - timed;
+    if (other < 0.0) other = 0.0;
+    
+    printf("Timing: %.3f s for %lld steps\n", wall, steps);
+    printf("  %-14s %10s %7s %11s\n", "Phase", "Seconds", "Share", "us/step");
+    for (int k = 0; k <= PROFILE_PHASES; k++) {
+        const char *name = (k < PROFILE_PHASES) ? phase_names[k] : "Other";
+        double s = (k < PROFILE_PHASES) ? p->seconds[k] : other;
+        printf("  %-14s %10.3f %6.1f%% %11.2f\n", name, s,
+               (wall > 0.0) ? 100.0 * s / wall : 0.0,
+               (steps > 0) ? 1e6 * s / steps : 0.0);
+    }
+    if (p->offload[PROFILE_RENDER] > 0.0 || p->offload[PROFILE_BMP] > 0.0) {
+        printf("  Frame workers: %.3f s rendering, %.3f s writing (off the step thread)\n",
+               p->offload[PROFILE_RENDER], p->offload[PROFILE_BMP]);
+    }
+    
+    double force_seconds = p->seconds[PROFILE_BODY_FORCES] + p->seconds[PROFILE_ROCKET_FORCES];
+    if (p->interactions > 0 && force_seconds > 0.0) {
+        printf("  Interactions: %.3e (direct-sum count), %.3e/s in the force phases, "
+               "%.3e/s overall\n", (double)p->interactions,
+               p->interactions / force_seconds, p->interactions / wall);
+    }
+#endif
+}
+
+/**
+ * Close the timing CSV
+ */
+void profile_close(Profile *p) {
+    if (p->csv) fclose(p->csv);
+    p->csv = NULL;
+}
@@ -0,0 +1,441 @@
+/**
+ * raster.c - Tiled Rasterizer
+ * Draw batches of lines and circles, clipped once per primitive, on
+ * screen tiles in parallel
+ *
+ * Primitives are queued in drawing order. On a flush they are binned
+ * into RASTER_TILE x RASTER_TILE tiles (each tile keeps them in order),
+ * then tiles are drawn in parallel. Tiles do not overlap, so no pixel is
+ * written by two threads, and within a tile later primitives still
+ * overwrite earlier ones: the image is identical to drawing everything
+ * in order on one thread. With one thread the whole image is one tile
+ * and binning is skipped.
+ *
+ * A line is clipped against its tile with Cohen-Sutherland, then drawn
+ * by starting Bresenham at the first pixel inside the tile. The pixel
+ * after k steps has a closed form: the major axis moves k pixels and the
+ * minor axis floor((2 * d_minor * k + d_major - 1) / (2 * d_major)),
+ * which reproduces draw_line() exactly. The inner loop has no bounds
+ * checks, and pixels outside the tile are never visited.
+ */
+
+#include "nbody.h"
+
+/* Cohen-Sutherland outcodes */
+#define OUT_LEFT 1
+#define OUT_RIGHT 2
+#define OUT_TOP 4
+#define OUT_BOTTOM 8
+
+/**
+ * Pixel rectangle [x0, x1) x [y0, y1)
+ */
+typedef struct {
+    int x0, y0, x1, y1;
+} TileRect;
+
+/**
+ * Outcode of a point against a closed rectangle
+ */
+static int outcode(double x, double y, double xmin, double ymin, double xmax, double ymax) {
+    int code = 0;
+    if (x < xmin) code |= OUT_LEFT;
+    else if (x > xmax) code |= OUT_RIGHT;
+    if (y < ymin) code |= OUT_TOP;
+    else if (y > ymax) code |= OUT_BOTTOM;
+    return code;
+}
+
+/**
+ * Cohen-Sutherland: clip a segment to a closed rectangle in place
+ * Returns 0 if no part of the segment is inside
+ */
+static int clip_segment(double *ax, double *ay, double *bx, double *by,
+                        double xmin, double ymin, double xmax, double ymax) {
+    int code_a = outcode(*ax, *ay, xmin, ymin, xmax, ymax);
+    int code_b = outcode(*bx, *by, xmin, ymin, xmax, ymax);
+    
+    while (1) {
+        if (!(code_a | code_b)) return 1;
+        if (code_a & code_b) return 0;
+        
+        int code = code_a ? code_a : code_b;
+        double x, y;
+        if (code & OUT_BOTTOM) {
+            x = *ax + (*bx - *ax) * (ymax - *ay) / (*by - *ay);
+            y = ymax;
+        } else if (code & OUT_TOP) {
+            x = *ax + (*bx - *ax) * (ymin - *ay) / (*by - *ay);
+            y = ymin;
+        } else if (code & OUT_RIGHT) {
+            y = *ay + (*by - *ay) * (xmax - *ax) / (*bx - *ax);
+            x = xmax;
+        } else {
+            y = *ay + (*by - *ay) * (xmin - *ax) / (*bx - *ax);
+            x = xmin;
+        }
+        
+        if (code == code_a) {
+            *ax = x;
+            *ay = y;
+            code_a = outcode(x, y, xmin, ymin, xmax, ymax);
+        } else {
+            *bx = x;
+            *by = y;
+            code_b = outcode(x, y, xmin, ymin, xmax, ymax);
+        }
+    }
+}
+
+/**
+ * Bresenham pixel after k steps (closed form, see the file comment)
+ */
+static void line_pixel(const RasterPrim *p, int dx, int dy, long k, int *x, int *y) {
+    int sx = (p->x0 < p->x1) ? 1 : -1;
+    int sy = (p->y0 < p->y1) ? 1 : -1;
+    if (dx == 0 && dy == 0) {
+        *x = p->x0;
+        *y = p->y0;
+    } else if (dx >= dy) {
+        long m = (long)((2LL * dy * k + dx - 1) / (2LL * dx));
+        *x = p->x0 + sx * (int)k;
+        *y = p->y0 + sy * (int)m;
+    } else {
+        long m = (long)((2LL * dx * k + dy - 1) / (2LL * dy));
+        *x = p->x0 + sx * (int)m;
+        *y = p->y0 + sy * (int)k;
+    }
+}
+
+/**
+ * 1 if the Bresenham pixel after k steps is inside the rectangle
+ */
+static int line_pixel_inside(const RasterPrim *p, int dx, int dy, long k, const TileRect *rect) {
+    int x, y;
+    line_pixel(p, dx, dy, k, &x, &y);
+    return x >= rect->x0 && x < rect->x1 && y >= rect->y0 && y < rect->y1;
+}
+
+/**
+ * Draw the part of a line that falls inside the rectangle
+ */
+static void raster_line(Pixel *img, long stride, const TileRect *rect, const RasterPrim *p) {
+    int dx = abs(p->x1 - p->x0);
+    int dy = abs(p->y1 - p->y0);
+    int sx = (p->x0 < p->x1) ? 1 : -1;
+    int sy = (p->y0 < p->y1) ? 1 : -1;
+    long n = (dx > dy) ? dx : dy;
+
+    int x = p->x0, y = p->y0;
+    int err = dx - dy;
+    long k0 = 0, k1 = n;
+
+    // Common case: both ends inside, so the whole line is drawn unchecked
+    if (x < rect->x0 || x >= rect->x1 || y < rect->y0 || y >= rect->y1 ||
+        p->x1 < rect->x0 || p->x1 >= rect->x1 || p->y1 < rect->y0 || p->y1 >= rect->y1) {
+        // Bresenham pixels are within half a pixel of the true line, so a
+        // one-pixel margin keeps every pixel that belongs to the rectangle
+        double ax = p->x0, ay = p->y0, bx = p->x1, by = p->y1;
+        if (!clip_segment(&ax, &ay, &bx, &by, rect->x0 - 1.0, rect->y0 - 1.0,
+                          (double)rect->x1, (double)rect->y1)) {
+            return;
+        }
+
+        // Clipped ends to step numbers along the major axis
+        double ka = (dx >= dy) ? fabs(ax - p->x0) : fabs(ay - p->y0);
+        double kb = (dx >= dy) ? fabs(bx - p->x0) : fabs(by - p->y0);
+        k0 = (long)floor((ka < kb) ? ka : kb);
+        k1 = (long)ceil((ka < kb) ? kb : ka);
+        if (k0 < 0) k0 = 0;
+        if (k1 > n) k1 = n;
+
+        // Both coordinates are monotonic in k, so the inside steps are one run
+        while (k0 <= k1 && !line_pixel_inside(p, dx, dy, k0, rect)) k0++;
+        while (k1 >= k0 && !line_pixel_inside(p, dx, dy, k1, rect)) k1--;
+        if (k0 > k1) return;
+
+        // Resume Bresenham at step k0: err = dx * (1 + y steps) - dy * (1 + x steps)
+        line_pixel(p, dx, dy, k0, &x, &y);
+        long x_steps = abs(x - p->x0);
+        long y_steps = abs(y - p->y0);
+        err = (int)((long long)dx * (1 + y_steps) - (long long)dy * (1 + x_steps));
+    }
+
+    for (long k = k0; ; k++) {
+        Pixel *px = &img[y * stride + x];
+        *px = p->color;
+        if (k == k1) break;
+        
+        int e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+}
+
+/**
+ * Draw the part of a filled circle that falls inside the rectangle
+ */
+static void raster_circle(Pixel *img, long stride, const TileRect *rect, const RasterPrim *p) {
+    int cx = p->x0, cy = p->y0, radius = p->x1;
+    int dy0 = (rect->y0 - cy > -radius) ? rect->y0 - cy : -radius;
+    int dy1 = (rect->y1 - 1 - cy < radius) ? rect->y1 - 1 - cy : radius;
+    int dx0 = (rect->x0 - cx > -radius) ? rect->x0 - cx : -radius;
+    int dx1 = (rect->x1 - 1 - cx < radius) ? rect->x1 - 1 - cx : radius;
+    
+    for (int dy = dy0; dy <= dy1; dy++) {
+        long row = (cy + dy) * stride + cx;
+        for (int dx = dx0; dx <= dx1; dx++) {
+            if (dx * dx + dy * dy <= radius * radius) {
+                img[row + dx] = p->color;
+            }
+        }
+    }
+}
+
+/**
+ * Draw one primitive clipped to the rectangle
+ */
+static void raster_prim(Pixel *img, long stride, const TileRect *rect, const RasterPrim *p) {
+    if (p->kind == RASTER_LINE) {
+        raster_line(img, stride, rect, p);
+    } else if (p->kind == RASTER_CIRCLE) {
+        raster_circle(img, stride, rect, p);
+    }
+}
+
+/**
+ * Pixel bounding box of a primitive clamped to the image
+ * Returns 0 if it is entirely outside
+ */
+static int prim_bounds(const RasterPrim *p, const Viewport *view, TileRect *box) {
+    if (p->kind == RASTER_LINE) {
+        box->x0 = (p->x0 < p->x1) ? p->x0 : p->x1;
+        box->x1 = (p->x0 < p->x1) ? p->x1 : p->x0;
+        box->y0 = (p->y0 < p->y1) ? p->y0 : p->y1;
+        box->y1 = (p->y0 < p->y1) ? p->y1 : p->y0;
+    } else if (p->kind == RASTER_CIRCLE) {
+        box->x0 = p->x0 - p->x1;
+        box->x1 = p->x0 + p->x1;
+        box->y0 = p->y0 - p->x1;
+        box->y1 = p->y0 + p->x1;
+    } else {
+        return 0;
+    }
+    if (box->x1 < 0 || box->y1 < 0 || box->x0 >= view->width || box->y0 >= view->height) {
+        return 0;
+    }
+    if (box->x0 < 0) box->x0 = 0;
+    if (box->y0 < 0) box->y0 = 0;
+    if (box->x1 >= view->width) box->x1 = view->width - 1;
+    if (box->y1 >= view->height) box->y1 = view->height - 1;
+    return 1;
+}
+
+/**
+ * Columns of tiles in tile row `ty` that a primitive may touch
+ * Long lines only get the tiles near the line, not their whole bounding
+ * box; the one-pixel margin matches raster_line()
+ */
+static void prim_tile_span(const Rasterizer *ras, const RasterPrim *p, const TileRect *box,
+                           int ty, int *tx0, int *tx1) {
+    int xa = box->x0, xb = box->x1;
+    if (p->kind == RASTER_LINE && p->y0 != p->y1) {
+        double ya = (double)ty * ras->tile_size - 1.0;
+        double yb = (double)(ty + 1) * ras->tile_size;
+        double slope = (double)(p->x1 - p->x0) / (p->y1 - p->y0);
+        double xa_f = p->x0 + (ya - p->y0) * slope;
+        double xb_f = p->x0 + (yb - p->y0) * slope;
+        if (xa_f > xb_f) {
+            double t = xa_f;
+            xa_f = xb_f;
+            xb_f = t;
+        }
+        if (xa_f - 1.0 > xa) xa = (int)floor(xa_f - 1.0);
+        if (xb_f + 1.0 < xb) xb = (int)ceil(xb_f + 1.0);
+    }
+    *tx0 = xa / ras->tile_size;
+    *tx1 = xb / ras->tile_size;
+}
+
+/**
+ * Prepare a rasterizer for one image
+ */
+int raster_begin(Rasterizer *ras, Pixel *img, const Viewport *view, int threads) {
+    memset(ras, 0, sizeof(Rasterizer));
+    ras->img = img;
+    ras->view = *view;
+    ras->threads = (threads > 1) ? threads : 1;
+    
+    // One thread: the whole image is a single tile
+    ras->tile_size = (ras->threads > 1) ? RASTER_TILE :
+                     ((view->width > view->height) ? view->width : view->height);
+    ras->tiles_x = (view->width + ras->tile_size - 1) / ras->tile_size;
+    ras->tiles_y = (view->height + ras->tile_size - 1) / ras->tile_size;
+    ras->n_tiles = ras->tiles_x * ras->tiles_y;
+    
+    ras->capacity = RASTER_BATCH;
+    ras->prims = (RasterPrim *)malloc(ras->capacity * sizeof(RasterPrim));
+    if (ras->threads > 1) {
+        ras->counts = (long *)malloc((size_t)ras->threads * ras->n_tiles * sizeof(long));
+        ras->tile_start = (long *)malloc((ras->n_tiles + 1) * sizeof(long));
+    }
+    if (!ras->prims || (ras->threads > 1 && (!ras->counts || !ras->tile_start))) {
+        printf("Error: Memory allocation failed (rasterizer)\n");
+        raster_end(ras);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Bin the queued primitives into tiles (0 on success, -1 on failure)
+ */
+static int raster_bin(Rasterizer *ras) {
+    int n_chunks = ras->threads;
+    int n_tiles = ras->n_tiles;
+    int chunk = (ras->n_prims + n_chunks - 1) / n_chunks;
+    memset(ras->counts, 0, (size_t)n_chunks * n_tiles * sizeof(long));
+    
+    // Pass 1: per chunk, how many primitives land in each tile
+    #pragma omp parallel for schedule(static, 1) num_threads(ras->threads)
+    for (int c = 0; c < n_chunks; c++) {
+        long *counts = &ras->counts[(long)c * n_tiles];
+        int end = (c + 1) * chunk < ras->n_prims ? (c + 1) * chunk : ras->n_prims;
+        for (int i = c * chunk; i < end; i++) {
+            TileRect box;
+            if (!prim_bounds(&ras->prims[i], &ras->view, &box)) continue;
+            for (int ty = box.y0 / ras->tile_size; ty <= box.y1 / ras->tile_size; ty++) {
+                int tx0, tx1;
+                prim_tile_span(ras, &ras->prims[i], &box, ty, &tx0, &tx1);
+                for (int tx = tx0; tx <= tx1; tx++) {
+                    counts[ty * ras->tiles_x + tx]++;
+                }
+            }
+        }
+    }
+    
+    // Tile-major prefix sum; chunks in order keep primitives in order
+    long total = 0;
+    for (int t = 0; t < n_tiles; t++) {
+        ras->tile_start[t] = total;
+        for (int c = 0; c < n_chunks; c++) {
+            long count = ras->counts[(long)c * n_tiles + t];
+            ras->counts[(long)c * n_tiles + t] = total;
+            total += count;
+        }
+    }
+    ras->tile_start[n_tiles] = total;
+    
+    if (total > ras->bin_capacity) {
+        int *bins = (int *)realloc(ras->bins, total * sizeof(int));
+        if (!bins) return -1;
+        ras->bins = bins;
+        ras->bin_capacity = total;
+    }
+    
+    // Pass 2: write primitive indices at each chunk's offsets
+    #pragma omp parallel for schedule(static, 1) num_threads(ras->threads)
+    for (int c = 0; c < n_chunks; c++) {
+        long *next = &ras->counts[(long)c * n_tiles];
+        int end = (c + 1) * chunk < ras->n_prims ? (c + 1) * chunk : ras->n_prims;
+        for (int i = c * chunk; i < end; i++) {
+            TileRect box;
+            if (!prim_bounds(&ras->prims[i], &ras->view, &box)) continue;
+            for (int ty = box.y0 / ras->tile_size; ty <= box.y1 / ras->tile_size; ty++) {
+                int tx0, tx1;
+                prim_tile_span(ras, &ras->prims[i], &box, ty, &tx0, &tx1);
+                for (int tx = tx0; tx <= tx1; tx++) {
+                    ras->bins[next[ty * ras->tiles_x + tx]++] = i;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Draw every queued primitive and empty the queue
+ */
+void raster_flush(Rasterizer *ras) {
+    if (ras->n_prims == 0) return;
+    long stride = ras->view.stride;
+    
+    if (ras->threads == 1) {
+        TileRect rect = {0, 0, ras->view.width, ras->view.height};
+        for (int i = 0; i < ras->n_prims; i++) {
+            raster_prim(ras->img, stride, &rect, &ras->prims[i]);
+        }
+        ras->n_prims = 0;
+        return;
+    }
+    
+    if (raster_bin(ras) != 0) {
+        // Out of memory for the bins: draw in order on this thread instead
+        printf("Warning: Rasterizer bins allocation failed, drawing serially\n");
+        TileRect rect = {0, 0, ras->view.width, ras->view.height};
+        for (int i = 0; i < ras->n_prims; i++) {
+            raster_prim(ras->img, stride, &rect, &ras->prims[i]);
+        }
+        ras->n_prims = 0;
+        return;
+    }
+    
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(ras->threads)
+    for (int t = 0; t < ras->n_tiles; t++) {
+        TileRect rect;
+        rect.x0 = (t % ras->tiles_x) * ras->tile_size;
+        rect.y0 = (t / ras->tiles_x) * ras->tile_size;
+        rect.x1 = (rect.x0 + ras->tile_size < ras->view.width) ?
+                  rect.x0 + ras->tile_size : ras->view.width;
+        rect.y1 = (rect.y0 + ras->tile_size < ras->view.height) ?
+                  rect.y0 + ras->tile_size : ras->view.height;
+        for (long b = ras->tile_start[t]; b < ras->tile_start[t + 1]; b++) {
+            raster_prim(ras->img, stride, &rect, &ras->prims[ras->bins[b]]);
+        }
+    }
+    ras->n_prims = 0;
+}
+
+/**
+ * Space for `n` more primitives, flushing queued ones if they do not fit
+ */
+RasterPrim *raster_reserve(Rasterizer *ras, int n) {
+    if (ras->n_prims + n > ras->capacity) {
+        raster_flush(ras);
+    }
+    if (n > ras->capacity) {
+        RasterPrim *prims = (RasterPrim *)realloc(ras->prims, (size_t)n * sizeof(RasterPrim));
+        if (!prims) {
+            printf("Error: Memory allocation failed (rasterizer)\n");
+            return NULL;
+        }
+        ras->prims = prims;
+        ras->capacity = n;
+    }
+    return &ras->prims[ras->n_prims];
+}
+
+/**
+ * Add `n` primitives written into the space from raster_reserve()
+ */
+void raster_commit(Rasterizer *ras, int n) {
+    ras->n_prims += n;
+}
+
+/**
+ * Draw what is still queued and free the rasterizer
+ */
+void raster_end(Rasterizer *ras) {
+    if (ras->prims) raster_flush(ras);
+    free(ras->prims);
+    free(ras->counts);
+    free(ras->tile_start);
+    free(ras->bins);
+    memset(ras, 0, sizeof(Rasterizer));
+}
@@ -1,28 +1,101 @@
 /**
  * render.c - Rendering Functions
  * Converts simulation state to visual representation
+ *
+ * Two modes:
+ * - Full (render): every frame redraws every trail from its first point,
+ *   with brightness graded along the trail.
+ * - Incremental (trail_canvas_update + render_composite): trails live in
+ *   a persistent layer that stores, per pixel, the frame it was last drawn
+ *   in. Each frame draws only the segments recorded since the previous
+ *   frame, so the cost no longer grows with trail length. Compositing
+ *   turns a pixel's age into brightness through a fade table, so older
+ *   parts dim without a separate decay pass over the layer.
+ *
+ * Image size, scale and center come from a Viewport at run time, and
+ * pixels are addressed through its stride. Trail segments that start and
+ * end in the same pixel are skipped unless they are the last one; the
+ * next segment repaints that pixel anyway, so the image is unchanged,
+ * and small images (thumbnails) skip most of the drawing.
  */
 
 #include "nbody.h"
 
+#define GRID_MIN_PIXELS 8      // Grid lines are at least this far apart
+
+/**
+ * Set up a view of contiguous rows
+ */
+void viewport_init(Viewport *view, int width, int height, double scale,
+                   double center_x, double center_y) {
+    view->width = width;
+    view->height = height;
+    view->stride = width;
+    if (scale <= 0.0) {
+        // Same field of view as VIEW_SCALE at the default size
+        int side = (width < height) ? width : height;
+        int base = (WIDTH < HEIGHT) ? WIDTH : HEIGHT;
+        scale = VIEW_SCALE * side / base;
+    }
+    view->scale = scale;
+    view->center_x = center_x;
+    view->center_y = center_y;
+}
+
+/**
+ * World coordinate to pixel index along one axis
+ */
+static int project(double v, double center, double scale, int half) {
+    return (int)((v - center) * scale + half);
+}
+
+/**
+ * World x to pixel column
+ */
+int viewport_px(const Viewport *view, double x) {
+    return project(x, view->center_x, view->scale, view->width / 2);
+}
+
+/**
+ * World y to pixel row
+ */
+int viewport_py(const Viewport *view, double y) {
+    return project(y, view->center_y, view->scale, view->height / 2);
+}
+
+/**
+ * Marker radius scaled with the image, never below one pixel
+ */
+int viewport_radius(const Viewport *view, int base) {
+    int side = (view->width < view->height) ? view->width : view->height;
+    int ref = (WIDTH < HEIGHT) ? WIDTH : HEIGHT;
+    int radius = (int)((double)base * side / ref + 0.5);
+    return (radius < 1) ? 1 : radius;
+}
+
 /**
  * Draw a line using Bresenham's line algorithm
- * Used for rendering rocket trajectories
+ * Used for rendering rocket trajectories (also by plot_trails)
  */
-static void draw_line(Pixel *img, int x1, int y1, int x2, int y2,
-                     unsigned char r, unsigned char g, unsigned char b) {
+void draw_line(Pixel *img, const Viewport *view, int x1, int y1, int x2, int y2,
+               unsigned char r, unsigned char g, unsigned char b) {
     int dx = abs(x2 - x1);
     int dy = abs(y2 - y1);
     int sx = (x1 < x2) ? 1 : -1;
     int sy = (y1 < y2) ? 1 : -1;
     int err = dx - dy;
     
+    // Locals: pixel stores may alias *view, which would force reloads
+    const int w = view->width, h = view->height;
+    const long stride = view->stride;
+    
     int x = x1, y = y1;
     while (1) {
-        if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) {
-            img[y * WIDTH + x].r = r;
-            img[y * WIDTH + x].g = g;
-            img[y * WIDTH + x].b = b;
+        if (x >= 0 && x < w && y >= 0 && y < h) {
+            Pixel *p = &img[y * stride + x];
+            p->r = r;
+            p->g = g;
+            p->b = b;
         }
         
         if (x == x2 && y == y2) break;
@@ -41,25 +114,226 @@ static void draw_line(Pixel *img, int x1, int y1, int x2, int y2,
 
 /**
  * Draw a filled circle
- * Used for rendering celestial bodies and rockets
+ * Used for rendering celestial bodies and rockets (also by plot_trails)
  */
-static void draw_circle(Pixel *img, int cx, int cy, int radius,
-                       unsigned char r, unsigned char g, unsigned char b) {
+void draw_circle(Pixel *img, const Viewport *view, int cx, int cy, int radius,
+                 unsigned char r, unsigned char g, unsigned char b) {
+    const int w = view->width, h = view->height;
+    const long stride = view->stride;
     for (int dy = -radius; dy <= radius; dy++) {
         for (int dx = -radius; dx <= radius; dx++) {
             if (dx * dx + dy * dy <= radius * radius) {
                 int x = cx + dx;
                 int y = cy + dy;
-                if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) {
-                    img[y * WIDTH + x].r = r;
-                    img[y * WIDTH + x].g = g;
-                    img[y * WIDTH + x].b = b;
+                if (x >= 0 && x < w && y >= 0 && y < h) {
+                    Pixel *p = &img[y * stride + x];
+                    p->r = r;
+                    p->g = g;
+                    p->b = b;
                 }
             }
         }
     }
 }
 
+/**
+ * Brighten a pixel to at least the grid level
+ */
+static void grid_pixel(Pixel *p, unsigned char level) {
+    if (p->r < level) p->r = level;
+    if (p->g < level) p->g = level;
+    if (p->b < level) p->b = level;
+}
+
+/**
+ * Draw the reference grid: a line per world unit through the origin,
+ * every 10 units (100, ...) when lines would be too close together
+ */
+void draw_grid(Pixel *img, const Viewport *view, unsigned char level) {
+    double unit = 1.0;
+    while (unit * view->scale < GRID_MIN_PIXELS) unit *= 10.0;
+    
+    double half_w = 0.5 * view->width / view->scale;
+    long k0 = (long)floor((view->center_x - half_w) / unit) - 1;
+    long k1 = (long)ceil((view->center_x + half_w) / unit) + 1;
+    for (long k = k0; k <= k1; k++) {
+        int i = viewport_px(view, k * unit);
+        if (i < 0 || i >= view->width) continue;
+        for (int j = 0; j < view->height; j++) {
+            grid_pixel(&img[(long)j * view->stride + i], level);
+        }
+    }
+    
+    double half_h = 0.5 * view->height / view->scale;
+    k0 = (long)floor((view->center_y - half_h) / unit) - 1;
+    k1 = (long)ceil((view->center_y + half_h) / unit) + 1;
+    for (long k = k0; k <= k1; k++) {
+        int j = viewport_py(view, k * unit);
+        if (j < 0 || j >= view->height) continue;
+        Pixel *row = &img[(long)j * view->stride];
+        for (int i = 0; i < view->width; i++) {
+            grid_pixel(&row[i], level);
+        }
+    }
+}
+
+/**
+ * Clear the view's pixels to black (rows only, never the stride padding)
+ */
+static void clear_view(Pixel *img, const Viewport *view) {
+    if (view->stride == view->width) {
+        memset(img, 0, (size_t)view->width * view->height * sizeof(Pixel));
+        return;
+    }
+    for (int y = 0; y < view->height; y++) {
+        memset(&img[(long)y * view->stride], 0, view->width * sizeof(Pixel));
+    }
+}
+
+/**
+ * Draw celestial bodies (planets and stars)
+ */
+void draw_bodies(const Body *bodies, int n_bodies, Pixel *img, const Viewport *view) {
+    for (int i = 0; i < n_bodies; i++) {
+        int px = viewport_px(view, bodies[i].x);
+        int py = viewport_py(view, bodies[i].y);
+        
+        if (px >= 0 && px < view->width && py >= 0 && py < view->height) {
+            // Central body is larger
+            int radius = viewport_radius(view, (i == 0) ? 8 : 4);
+            
+            if (i == 0) {
+                // Central star: yellow
+                draw_circle(img, view, px, py, radius, 255, 255, 100);
+            } else {
+                // Orbiting bodies: blue shades
+                unsigned char r = 100 + i * 30;
+                draw_circle(img, view, px, py, radius, r, 150, 255);
+            }
+        }
+    }
+}
+
+/**
+ * Draw the current position of a rocket with a trail
+ */
+static void draw_rocket(const Rocket *rocket, Pixel *img, const Viewport *view) {
+    if (rocket->trail_length > 0) {
+        int px = viewport_px(view, rocket->x);
+        int py = viewport_py(view, rocket->y);
+        
+        if (px >= 0 && px < view->width && py >= 0 && py < view->height) {
+            // Draw rocket as bright red circle
+            draw_circle(img, view, px, py, viewport_radius(view, 4), 255, 50, 50);
+        }
+    }
+}
+
+/**
+ * Queue a rocket's trail segments and its marker
+ * Always fills trail_prim_count() entries; skipped ones are RASTER_NONE
+ */
+static void trail_prims(const Rocket *rocket, const Viewport *view, RasterPrim *out) {
+    const double cx = view->center_x, cy = view->center_y, scale = view->scale;
+    const int half_w = view->width / 2, half_h = view->height / 2;
+    int last = rocket->trail_length - 2;
+    
+    if (last >= 0) {
+        const double *tx = rocket->trail_x;
+        const double *ty = rocket->trail_y;
+        int px1 = project(tx[0], cx, scale, half_w);
+        int py1 = project(ty[0], cy, scale, half_h);
+        for (int t = 0; t <= last; t++) {
+            RasterPrim *p = &out[t];
+            int px2 = project(tx[t + 1], cx, scale, half_w);
+            int py2 = project(ty[t + 1], cy, scale, half_h);
+            if (px2 == px1 && py2 == py1 && t < last) {
+                p->kind = RASTER_NONE;
+                continue;
+            }
+            
+            // Color gradient: older parts dimmer, newer parts brighter
+            int brightness = 100 + (155 * t) / 
+                (rocket->trail_length > 0 ? rocket->trail_length : 1);
+            
+            p->kind = RASTER_LINE;
+            p->x0 = px1;
+            p->y0 = py1;
+            p->x1 = px2;
+            p->y1 = py2;
+            p->color.r = brightness;
+            p->color.g = brightness / 2;
+            p->color.b = brightness / 2;
+            px1 = px2;
+            py1 = py2;
+        }
+        out += last + 1;
+    }
+    
+    // Current position as a bright red circle
+    out->kind = RASTER_NONE;
+    if (rocket->trail_length > 0) {
+        int px = viewport_px(view, rocket->x);
+        int py = viewport_py(view, rocket->y);
+        if (px >= 0 && px < view->width && py >= 0 && py < view->height) {
+            out->kind = RASTER_CIRCLE;
+            out->x0 = px;
+            out->y0 = py;
+            out->x1 = viewport_radius(view, 4);
+            out->color.r = 255;
+            out->color.g = 50;
+            out->color.b = 50;
+        }
+    }
+}
+
+/**
+ * Primitives queued per rocket: one per trail segment plus the marker
+ */
+static int trail_prim_count(const Rocket *rocket) {
+    return (rocket->trail_length > 1 ? rocket->trail_length - 1 : 0) + 1;
+}
+
+/**
+ * Draw every rocket trail followed by its marker, on the calling thread
+ */
+static void draw_trails(const Rocket *rockets, int n_rockets, Pixel *img,
+                        const Viewport *view) {
+    const double cx = view->center_x, cy = view->center_y, scale = view->scale;
+    const int half_w = view->width / 2, half_h = view->height / 2;
+    
+    for (int i = 0; i < n_rockets; i++) {
+        int last = rockets[i].trail_length - 2;
+        if (last < 0) {
+            draw_rocket(&rockets[i], img, view);
+            continue;
+        }
+        
+        // Draw trail as connected line segments
+        const double *tx = rockets[i].trail_x;
+        const double *ty = rockets[i].trail_y;
+        int px1 = project(tx[0], cx, scale, half_w);
+        int py1 = project(ty[0], cy, scale, half_h);
+        for (int t = 0; t <= last; t++) {
+            int px2 = project(tx[t + 1], cx, scale, half_w);
+            int py2 = project(ty[t + 1], cy, scale, half_h);
+            if (px2 == px1 && py2 == py1 && t < last) continue;
+            
+            // Color gradient: older parts dimmer, newer parts brighter
+            int brightness = 100 + (155 * t) / 
+                (rockets[i].trail_length > 0 ? rockets[i].trail_length : 1);
+            
+            draw_line(img, view, px1, py1, px2, py2, 
+                     brightness, brightness / 2, brightness / 2);
+            px1 = px2;
+            py1 = py2;
+        }
+        
+        // Draw current rocket position
+        draw_rocket(&rockets[i], img, view);
+    }
+}
+
 /**
  * Render the current simulation state to an image
  * 
@@ -68,74 +342,248 @@ static void draw_circle(Pixel *img, int cx, int cy, int radius,
  * 2. Rocket trajectories (complete history)
  * 3. Celestial bodies
  * 4. Current rocket positions
+ *
+ * With more than one thread, trails, markers and bodies go through the
+ * tiled rasterizer in this order. Rockets are queued in batches of about
+ * RASTER_BATCH segments, projected in parallel, then drawn tile-parallel.
+ * On one thread queueing buys nothing, so everything is drawn directly;
+ * the image is the same either way.
  */
 void render(Body *bodies, int n_bodies, Rocket *rockets, int n_rockets, 
-            Pixel *img, double scale) {
+            Pixel *img, const Viewport *view, int threads) {
     // Clear image to black
-    memset(img, 0, WIDTH * HEIGHT * sizeof(Pixel));
+    clear_view(img, view);
     
     // Draw reference grid
-    for (int i = 0; i < WIDTH; i += 50) {
-        for (int j = 0; j < HEIGHT; j++) {
-            img[j * WIDTH + i].r = 20;
-            img[j * WIDTH + i].g = 20;
-            img[j * WIDTH + i].b = 20;
-        }
+    draw_grid(img, view, GRID_LEVEL);
+    
+    if (threads <= 1) {
+        draw_trails(rockets, n_rockets, img, view);
+        draw_bodies(bodies, n_bodies, img, view);
+        return;
     }
-    for (int j = 0; j < HEIGHT; j += 50) {
-        for (int i = 0; i < WIDTH; i++) {
-            img[j * WIDTH + i].r = 20;
-            img[j * WIDTH + i].g = 20;
-            img[j * WIDTH + i].b = 20;
+    
+    Rasterizer ras;
+    if (raster_begin(&ras, img, view, threads) != 0) return;
+    
+    // Draw complete rocket trajectories with their current positions
+    int i = 0;
+    while (i < n_rockets) {
+        // Batch rockets up to RASTER_BATCH primitives (a long trail alone)
+        int end = i;
+        long total = 0;
+        while (end < n_rockets &&
+               (end == i || total + trail_prim_count(&rockets[end]) <= RASTER_BATCH)) {
+            total += trail_prim_count(&rockets[end]);
+            end++;
+        }
+        
+        RasterPrim *out = raster_reserve(&ras, (int)total);
+        if (!out) break;
+        
+        // Each rocket's primitives start at a fixed offset in the batch
+        long offset = 0;
+        if (end - i == 1) {
+            trail_prims(&rockets[i], view, out);
+        } else {
+            int *start = (int *)malloc((end - i) * sizeof(int));
+            if (!start) break;
+            for (int k = i; k < end; k++) {
+                start[k - i] = (int)offset;
+                offset += trail_prim_count(&rockets[k]);
+            }
+            #pragma omp parallel for schedule(dynamic, 16) if(threads > 1) num_threads(OMP_THREADS(threads))
+            for (int k = i; k < end; k++) {
+                trail_prims(&rockets[k], view, out + start[k - i]);
+            }
+            free(start);
         }
+        raster_commit(&ras, (int)total);
+        i = end;
     }
     
-    // Draw complete rocket trajectories
-    for (int i = 0; i < n_rockets; i++) {
-        // Draw trail as connected line segments
-        for (int t = 0; t < rockets[i].trail_length - 1; t++) {
-            int px1 = (int)(rockets[i].trail_x[t] * scale + WIDTH / 2);
-            int py1 = (int)(rockets[i].trail_y[t] * scale + HEIGHT / 2);
-            int px2 = (int)(rockets[i].trail_x[t + 1] * scale + WIDTH / 2);
-            int py2 = (int)(rockets[i].trail_y[t + 1] * scale + HEIGHT / 2);
+    // Draw celestial bodies (planets and stars)
+    RasterPrim *out = raster_reserve(&ras, n_bodies);
+    if (out) {
+        for (int b = 0; b < n_bodies; b++) {
+            RasterPrim *p = &out[b];
+            int px = viewport_px(view, bodies[b].x);
+            int py = viewport_py(view, bodies[b].y);
             
-            // Color gradient: older parts dimmer, newer parts brighter
-            int brightness = 100 + (155 * t) / 
-                (rockets[i].trail_length > 0 ? rockets[i].trail_length : 1);
+            p->kind = RASTER_NONE;
+            if (px < 0 || px >= view->width || py < 0 || py >= view->height) continue;
             
-            draw_line(img, px1, py1, px2, py2, 
-                     brightness, brightness / 2, brightness / 2);
+            // Central body is larger: yellow star; orbiting bodies: blue shades
+            p->kind = RASTER_CIRCLE;
+            p->x0 = px;
+            p->y0 = py;
+            p->x1 = viewport_radius(view, (b == 0) ? 8 : 4);
+            p->color.r = (b == 0) ? 255 : (unsigned char)(100 + b * 30);
+            p->color.g = (b == 0) ? 255 : 150;
+            p->color.b = (b == 0) ? 100 : 255;
+        }
+        raster_commit(&ras, n_bodies);
+    }
+    raster_end(&ras);
+}
+
+/* ============================================================================
+ * INCREMENTAL TRAIL LAYER
+ * ============================================================================ */
+
+/**
+ * Allocate an empty trail layer and build its fade table
+ */
+int trail_canvas_init(TrailCanvas *canvas, const Viewport *view, int n_rockets,
+                      double decay) {
+    memset(canvas, 0, sizeof(TrailCanvas));
+    canvas->width = view->width;
+    canvas->height = view->height;
+    canvas->stamp = (uint32_t *)calloc((size_t)view->width * view->height, sizeof(uint32_t));
+    canvas->rows = (unsigned char *)calloc(view->height, 1);
+    canvas->drawn = (long *)calloc(n_rockets > 0 ? n_rockets : 1, sizeof(long));
+    if (!canvas->stamp || !canvas->rows || !canvas->drawn) {
+        printf("Error: Memory allocation failed (trail layer)\n");
+        trail_canvas_free(canvas);
+        return -1;
+    }
+    canvas->n_rockets = n_rockets;
+    
+    // Newest segments at full brightness, then `decay` per frame of age
+    double level = 255.0;
+    for (int age = 0; age < TRAIL_FADE_FRAMES; age++) {
+        canvas->fade[age] = (unsigned char)(level + 0.5);
+        level *= decay;
+    }
+    return 0;
+}
+
+/**
+ * Free the trail layer
+ */
+void trail_canvas_free(TrailCanvas *canvas) {
+    free(canvas->stamp);
+    free(canvas->rows);
+    free(canvas->drawn);
+    memset(canvas, 0, sizeof(TrailCanvas));
+}
+
+/**
+ * Bresenham line into the trail layer, stamped with the current frame
+ */
+static void canvas_line(TrailCanvas *canvas, int x1, int y1, int x2, int y2) {
+    int dx = abs(x2 - x1);
+    int dy = abs(y2 - y1);
+    int sx = (x1 < x2) ? 1 : -1;
+    int sy = (y1 < y2) ? 1 : -1;
+    int err = dx - dy;
+    
+    // Locals: the rows[] stores may alias *canvas
+    const int w = canvas->width, h = canvas->height;
+    uint32_t *stamp = canvas->stamp;
+    unsigned char *rows = canvas->rows;
+    const uint32_t frame = canvas->frame;
+    
+    int x = x1, y = y1;
+    while (1) {
+        if (x >= 0 && x < w && y >= 0 && y < h) {
+            stamp[(long)y * w + x] = frame;
+            rows[y] = 1;
         }
         
-        // Draw current rocket position
-        if (rockets[i].trail_length > 0) {
-            int px = (int)(rockets[i].x * scale + WIDTH / 2);
-            int py = (int)(rockets[i].y * scale + HEIGHT / 2);
-            
-            if (px >= 0 && px < WIDTH && py >= 0 && py < HEIGHT) {
-                // Draw rocket as bright red circle
-                draw_circle(img, px, py, 4, 255, 50, 50);
+        if (x == x2 && y == y2) break;
+        
+        int e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+}
+
+/**
+ * Start a frame and draw the segments recorded since the last update
+ *
+ * Trail points are counted from the start of the run (trail_dropped +
+ * window index), so segments are found even after the in-memory window
+ * has slid. Points that slid out before they were drawn are skipped.
+ */
+void trail_canvas_update(TrailCanvas *canvas, const Rocket *rockets, int n_rockets,
+                         const Viewport *view) {
+    canvas->frame++;
+    
+    if (n_rockets > canvas->n_rockets) n_rockets = canvas->n_rockets;
+    for (int i = 0; i < n_rockets; i++) {
+        const Rocket *r = &rockets[i];
+        long total = (long)r->trail_dropped + r->trail_length - r->trail_tip;
+        
+        // First point of the first new segment, as an absolute index
+        long start = canvas->drawn[i] - 1;
+        if (start < r->trail_dropped) start = r->trail_dropped;
+        
+        if (start + 1 < total) {
+            int j = (int)(start - r->trail_dropped);
+            int last = (int)(total - 1 - r->trail_dropped);
+            int px1 = viewport_px(view, r->trail_x[j]);
+            int py1 = viewport_py(view, r->trail_y[j]);
+            for (j++; j <= last; j++) {
+                int px2 = viewport_px(view, r->trail_x[j]);
+                int py2 = viewport_py(view, r->trail_y[j]);
+                if (px2 == px1 && py2 == py1 && j < last) continue;
+                canvas_line(canvas, px1, py1, px2, py2);
+                px1 = px2;
+                py1 = py2;
             }
         }
+        if (total > canvas->drawn[i]) canvas->drawn[i] = total;
     }
+}
+
+/**
+ * Composite one incremental frame: grid, faded trail layer, rockets, bodies
+ */
+void render_composite(const TrailCanvas *canvas, const Body *bodies, int n_bodies,
+                      const Rocket *rockets, int n_rockets, Pixel *img,
+                      const Viewport *view) {
+    clear_view(img, view);
     
-    // Draw celestial bodies (planets and stars)
-    for (int i = 0; i < n_bodies; i++) {
-        int px = (int)(bodies[i].x * scale + WIDTH / 2);
-        int py = (int)(bodies[i].y * scale + HEIGHT / 2);
+    // Only rows a trail has touched; colour as in the full renderer:
+    // (brightness, brightness / 2, brightness / 2)
+    for (int y = 0; y < canvas->height; y++) {
+        if (!canvas->rows[y]) continue;
         
-        if (px >= 0 && px < WIDTH && py >= 0 && py < HEIGHT) {
-            // Central body is larger
-            int radius = (i == 0) ? 8 : 4;
+        const uint32_t *stamp = &canvas->stamp[(long)y * canvas->width];
+        Pixel *row = &img[(long)y * view->stride];
+        for (int x = 0; x < canvas->width; x++) {
+            if (!stamp[x]) continue;
             
-            if (i == 0) {
-                // Central star: yellow
-                draw_circle(img, px, py, radius, 255, 255, 100);
-            } else {
-                // Orbiting bodies: blue shades
-                unsigned char r = 100 + i * 30;
-                draw_circle(img, px, py, radius, r, 150, 255);
-            }
+            uint32_t age = canvas->frame - stamp[x];
+            unsigned char level = canvas->fade[(age < TRAIL_FADE_FRAMES) ?
+                                               age : TRAIL_FADE_FRAMES - 1];
+            row[x].r = level;
+            row[x].g = level / 2;
+            row[x].b = level / 2;
         }
     }
-}
\ No newline at end of file
+    draw_grid(img, view, GRID_LEVEL);
+    
+    // Open segments of decimated trails move with their rocket and are
+    // drawn fresh each frame instead of into the layer
+    unsigned char newest = canvas->fade[0];
+    for (int i = 0; i < n_rockets; i++) {
+        const Rocket *r = &rockets[i];
+        if (!r->trail_tip) continue;
+        draw_line(img, view, viewport_px(view, r->trail_anchor_x),
+                  viewport_py(view, r->trail_anchor_y), viewport_px(view, r->x),
+                  viewport_py(view, r->y), newest, newest / 2, newest / 2);
+    }
+    
+    for (int i = 0; i < n_rockets; i++) {
+        draw_rocket(&rockets[i], img, view);
+    }
+    draw_bodies(bodies, n_bodies, img, view);
+}
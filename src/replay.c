@@ -0,0 +1,293 @@
+/**
+ * replay.c - Replay Mode
+ * Renders frames of a saved run without simulating it again:
+ * ./bin/nbody --mode replay (or L at the prompt)
+ *
+ * Every rocket of rocket_trails.bin holds one point per trail_stride
+ * steps from its start until it was deactivated (trail_tolerance must be
+ * 0, since simplified trails keep points at irregular steps). Frame k of
+ * the run was drawn after k * frame_interval steps, so the points it
+ * showed are known from the point count alone: the first
+ * steps / trail_stride + 1, less the ones the in-memory window of
+ * TRAIL_WINDOW points had dropped by then. They are drawn straight from
+ * the mapped file, with render() as the simulation did; with float64
+ * trails and trail_stride=1 the frames are bitwise those of the run.
+ *
+ * The bodies come from ephemeris_file when it matches the run. Otherwise
+ * they are integrated alone, once, keeping only the frame steps (no
+ * rockets: the cost of a few bodies, not of the run).
+ *
+ * Frames are independent, so replay_threads workers draw whole frames
+ * at once, each into its own image. The view (width, height, scale,
+ * center) and the range replay_first..replay_last come from the config,
+ * so any part of a run can be drawn again at any size.
+ */
+
+#include "nbody.h"
+
+/**
+ * First point still in the trail window once `n` points were recorded
+ * The window drops its older half whenever a point arrives while it is
+ * full (see slide_trail_window())
+ */
+static long window_start(long n) {
+    const long half = TRAIL_WINDOW / 2;
+    if (n <= TRAIL_WINDOW) return 0;
+    return ((n - TRAIL_WINDOW - 1) / half + 1) * half;
+}
+
+/**
+ * Open a saved run for replay
+ */
+int replay_open(Replay *replay, const char *trails_file, const char *bodies_file,
+                const SimConfig *config) {
+    memset(replay, 0, sizeof(Replay));
+    if (config->trail_tolerance > 0.0) {
+        printf("Error: Replay needs trails sampled every trail_stride steps "
+               "(trail_tolerance=0)\n");
+        return -1;
+    }
+    if (trail_file_open(&replay->trails, trails_file) != 0) {
+        return -1;
+    }
+    replay->n_rockets = trail_file_count(&replay->trails);
+    replay->steps = config->steps;
+    replay->trail_stride = config->trail_stride;
+    replay->frame_interval = (config->save_interval > 0) ? config->save_interval :
+                             config->steps / config->frames;
+    if (replay->frame_interval < 1) replay->frame_interval = 1;
+    replay->n_frames = (config->steps + replay->frame_interval - 1) / replay->frame_interval;
+    
+    // Initial bodies, as the simulation loaded them
+    SimState scratch;
+    sim_state_init(&scratch);
+    if (load_bodies(bodies_file, &scratch) < 0) {
+        init_bodies_default(&scratch);
+    }
+    int n = scratch.n_bodies;
+    replay->n_bodies = n;
+    replay->bodies = (Body *)malloc((n > 0 ? n : 1) * sizeof(Body));
+    if (replay->bodies) {
+        memcpy(replay->bodies, scratch.bodies, n * sizeof(Body));
+    }
+    sim_state_free(&scratch);
+    if (!replay->bodies) {
+        printf("Error: Memory allocation failed\n");
+        replay_close(replay);
+        return -1;
+    }
+    
+    // Body positions: the stored ephemeris, or only the frame steps
+    int stored = config->ephemeris_file[0] != '\0' &&
+                 ephemeris_open(&replay->ephemeris, config->ephemeris_file, replay->bodies,
+                                replay->n_bodies, config) == 0;
+    if (!stored && ephemeris_build(&replay->ephemeris, replay->bodies, replay->n_bodies,
+                                   config, replay->frame_interval) != 0) {
+        printf("Error: Could not integrate the bodies for the replay\n");
+        replay_close(replay);
+        return -1;
+    }
+    
+    // A trail longer than the run allows was recorded with other settings
+    long most = (long)config->steps / replay->trail_stride + 1;
+    for (int i = 0; i < replay->n_rockets; i++) {
+        if ((long)replay->trails.index[i].length > most) {
+            printf("Warning: %s holds more points than steps=%d, trail_stride=%d give; "
+                   "replay with the config of the recorded run\n",
+                   trails_file, config->steps, config->trail_stride);
+            break;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Draw one frame of the run
+ */
+int replay_render(const Replay *replay, int frame, Pixel *img, const Viewport *view,
+                  int threads) {
+    int step = frame * replay->frame_interval;
+    if (step > replay->steps) step = replay->steps;
+    int n_bodies = replay->n_bodies, n_rockets = replay->n_rockets;
+    const TrailFile *file = &replay->trails;
+    int wide = (file->header->elem_size == 8);
+    
+    Body *bodies = (Body *)malloc((n_bodies > 0 ? n_bodies : 1) * sizeof(Body));
+    double *body_xy = (double *)malloc((n_bodies > 0 ? n_bodies : 1) * 2 * sizeof(double));
+    Rocket *rockets = (Rocket *)calloc(n_rockets > 0 ? n_rockets : 1, sizeof(Rocket));
+    if (!bodies || !body_xy || !rockets) {
+        free(bodies);
+        free(body_xy);
+        free(rockets);
+        return -1;
+    }
+    
+    // Bodies after `step` steps
+    ParticleSoA soa;
+    memset(&soa, 0, sizeof(soa));
+    soa.x = body_xy;
+    soa.y = body_xy + n_bodies;
+    soa.n = n_bodies;
+    ephemeris_bodies(&replay->ephemeris, step, &soa);
+    for (int b = 0; b < n_bodies; b++) {
+        bodies[b] = replay->bodies[b];
+        bodies[b].x = soa.x[b];
+        bodies[b].y = soa.y[b];
+    }
+    
+    // Each rocket's trail window as it stood at `step`
+    long recorded = (long)step / replay->trail_stride + 1;
+    long total = 0;
+    for (int i = 0; i < n_rockets; i++) {
+        long length = (long)file->index[i].length;
+        long n = (recorded < length) ? recorded : length;
+        long start = window_start(n);
+        rockets[i].trail_length = (int)(n - start);
+        rockets[i].trail_dropped = (int)start;
+        total += n - start;
+    }
+    
+    // float32 trails are widened into one buffer for the frame
+    double *wide_xy = NULL;
+    if (!wide) {
+        wide_xy = (double *)malloc((total > 0 ? total : 1) * 2 * sizeof(double));
+        if (!wide_xy) {
+            free(bodies);
+            free(body_xy);
+            free(rockets);
+            return -1;
+        }
+    }
+    
+    long offset = 0;
+    for (int i = 0; i < n_rockets; i++) {
+        Rocket *r = &rockets[i];
+        const TrailIndexEntry *e = &file->index[i];
+        long start = r->trail_dropped, n = r->trail_length;
+        if (wide) {
+            // Read in place; render() does not write to trails
+            r->trail_x = (double *)(file->base + e->x_offset) + start;
+            r->trail_y = (double *)(file->base + e->y_offset) + start;
+        } else {
+            const float *fx = (const float *)(file->base + e->x_offset) + start;
+            const float *fy = (const float *)(file->base + e->y_offset) + start;
+            r->trail_x = wide_xy + 2 * offset;
+            r->trail_y = r->trail_x + n;
+            for (long k = 0; k < n; k++) {
+                r->trail_x[k] = fx[k];
+                r->trail_y[k] = fy[k];
+            }
+            offset += n;
+        }
+        if (n > 0) {
+            r->x = r->trail_x[n - 1];
+            r->y = r->trail_y[n - 1];
+        }
+        r->active = (n > 0 && (long)e->length > recorded);
+    }
+    
+    render(bodies, n_bodies, rockets, n_rockets, img, view, threads);
+    
+    free(wide_xy);
+    free(bodies);
+    free(body_xy);
+    free(rockets);
+    return 0;
+}
+
+/**
+ * Release a replay
+ */
+void replay_close(Replay *replay) {
+    trail_file_close(&replay->trails);
+    ephemeris_free(&replay->ephemeris);
+    free(replay->bodies);
+    memset(replay, 0, sizeof(Replay));
+}
+
+/**
+ * Render a range of frames of a saved run
+ */
+int replay_run(const SimConfig *config, const char *trails_file, const char *bodies_file,
+               const char *output_dir, int quiet) {
+    Replay replay;
+    if (replay_open(&replay, trails_file, bodies_file, config) != 0) {
+        return 1;
+    }
+    
+    int first = config->replay_first;
+    int last = (config->replay_last < 0 || config->replay_last >= replay.n_frames) ?
+               replay.n_frames - 1 : config->replay_last;
+    if (first > last) {
+        printf("Error: No frames in %d..%d (the run has %d)\n", config->replay_first,
+               config->replay_last, replay.n_frames);
+        replay_close(&replay);
+        return 1;
+    }
+    int count = last - first + 1;
+    
+    Viewport view;
+    viewport_init(&view, config->width, config->height, config->scale,
+                  config->center_x, config->center_y);
+    if (config->render_mode != RENDER_FULL) {
+        printf("Warning: Replay draws full frames, render_mode ignored\n");
+    }
+    if (config->video_output != VIDEO_BMP) {
+        printf("Warning: Replay writes BMP frames, video_output ignored\n");
+    }
+    
+    // Whole frames per worker; a single worker tiles each frame instead
+    int workers = (config->replay_threads > 0) ? config->replay_threads : max_threads();
+    if (workers > count) workers = count;
+    int render_threads = (workers > 1) ? 1 : config->render_threads;
+    
+    if (!quiet) {
+        printf("\n====================================\n");
+        printf("Replay\n");
+        printf("====================================\n");
+        printf("Trails: %s (%d rockets, %s)\n", trails_file, replay.n_rockets,
+               (replay.trails.header->elem_size == 8) ? "float64" : "float32");
+        printf("Bodies: %d, %s\n", replay.n_bodies,
+               replay.ephemeris.map ? config->ephemeris_file : "integrated for the frame steps");
+        printf("Frames: %d-%d of %d, every %d steps\n", first, last, replay.n_frames,
+               replay.frame_interval);
+        printf("Image: %dx%d, scale %.2f px/unit, center (%.2f, %.2f)\n",
+               view.width, view.height, view.scale, view.center_x, view.center_y);
+        printf("Workers: %d\n", OMP_THREADS(workers));
+        printf("====================================\n\n");
+    }
+    
+    double started = profile_clock();
+    int failed = 0;
+    #pragma omp parallel if(workers > 1) num_threads(OMP_THREADS(workers)) reduction(+:failed)
+    {
+        Pixel *img = (Pixel *)malloc((size_t)view.width * view.height * sizeof(Pixel));
+        
+        #pragma omp for schedule(dynamic, 1)
+        for (int frame = first; frame <= last; frame++) {
+            char name[32], filename[PATH_LEN];
+            snprintf(name, sizeof(name), "frame_%04d.bmp", frame);
+            output_path(filename, sizeof(filename), output_dir, name);
+            if (!img || replay_render(&replay, frame, img, &view, render_threads) != 0 ||
+                write_bmp(filename, img, view.width, view.height) != 0) {
+                failed++;
+            }
+        }
+        free(img);
+    }
+    double seconds = profile_clock() - started;
+    
+    printf("\n====================================\n");
+    printf("Replay Complete!\n");
+    printf("====================================\n");
+    printf("Frames: %d written, %d failed, %.3f s (%.1f frames/s)\n", count - failed, failed,
+           seconds, (seconds > 0.0) ? count / seconds : 0.0);
+    if (!quiet) {
+        printf("  - %s%sframe_%04d.bmp .. frame_%04d.bmp\n", output_dir,
+               (output_dir[0] && output_dir[strlen(output_dir) - 1] != '/') ? "/" : "",
+               first, last);
+    }
+    
+    replay_close(&replay);
+    return (failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,284 @@
+/**
+ * state.c - Simulation State Management
+ * Heap-backed, growable storage for bodies and rockets
+ */
+
+#include "nbody.h"
+
+/**
+ * Grow a typed array to hold at least `needed` elements
+ * Capacity doubles so repeated appends stay amortized O(1)
+ */
+static int grow_array(void **data, int *capacity, int needed, size_t elem_size) {
+    if (needed <= *capacity) return 0;
+    
+    int new_capacity = (*capacity > 0) ? *capacity : INITIAL_CAPACITY;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    
+    void *p = realloc(*data, (size_t)new_capacity * elem_size);
+    if (!p) {
+        printf("Error: Memory allocation failed (%d elements)\n", new_capacity);
+        return -1;
+    }
+    
+    *data = p;
+    *capacity = new_capacity;
+    return 0;
+}
+
+/**
+ * Initialize an empty simulation state
+ */
+void sim_state_init(SimState *state) {
+    memset(state, 0, sizeof(SimState));
+}
+
+/**
+ * Ensure room for at least `capacity` bodies
+ */
+int sim_state_reserve_bodies(SimState *state, int capacity) {
+    return grow_array((void **)&state->bodies, &state->body_capacity,
+                      capacity, sizeof(Body));
+}
+
+/**
+ * Ensure room for at least `capacity` rockets
+ */
+int sim_state_reserve_rockets(SimState *state, int capacity) {
+    return grow_array((void **)&state->rockets, &state->rocket_capacity,
+                      capacity, sizeof(Rocket));
+}
+
+/**
+ * Append a zeroed body, growing storage if needed
+ * Returns NULL if memory could not be allocated
+ */
+Body *sim_state_add_body(SimState *state) {
+    if (sim_state_reserve_bodies(state, state->n_bodies + 1) != 0) {
+        return NULL;
+    }
+    
+    Body *b = &state->bodies[state->n_bodies++];
+    memset(b, 0, sizeof(Body));
+    return b;
+}
+
+/**
+ * Append a zeroed rocket, growing storage if needed
+ * Returns NULL if memory could not be allocated
+ */
+Rocket *sim_state_add_rocket(SimState *state) {
+    if (sim_state_reserve_rockets(state, state->n_rockets + 1) != 0) {
+        return NULL;
+    }
+    
+    Rocket *r = &state->rockets[state->n_rockets++];
+    memset(r, 0, sizeof(Rocket));
+    return r;
+}
+
+/**
+ * Allocate the trail window and store the starting position as point 0
+ */
+int rocket_trail_init(Rocket *rocket) {
+    rocket->trail_x = (double *)malloc(TRAIL_WINDOW * sizeof(double));
+    rocket->trail_y = (double *)malloc(TRAIL_WINDOW * sizeof(double));
+    rocket->trail_length = 0;
+    rocket->trail_flushed = 0;
+    rocket->trail_dropped = 0;
+    rocket->trail_skipped = 0;
+    rocket->trail_tip = 0;
+    rocket->dropped_path = 0.0;
+    rocket->dropped_max_dist = 0.0;
+    
+    if (!rocket->trail_x || !rocket->trail_y) {
+        free(rocket->trail_x);
+        free(rocket->trail_y);
+        rocket->trail_x = NULL;
+        rocket->trail_y = NULL;
+        rocket->trail_capacity = 0;
+        return -1;
+    }
+    
+    rocket->trail_capacity = TRAIL_WINDOW;
+    rocket->trail_x[0] = rocket->x;
+    rocket->trail_y[0] = rocket->y;
+    rocket->trail_length = 1;
+    return 0;
+}
+
+/**
+ * Release all memory owned by the state, including rocket trails
+ */
+void sim_state_free(SimState *state) {
+    for (int i = 0; i < state->n_rockets; i++) {
+        free(state->rockets[i].trail_x);
+        free(state->rockets[i].trail_y);
+    }
+    free(state->bodies);
+    free(state->rockets);
+    soa_free(&state->body_soa);
+    soa_free(&state->rocket_soa);
+    quadtree_free(&state->tree);
+    block_steps_free(&state->blocks);
+    events_free(&state->events);
+    sim_state_init(state);
+}
+
+/**
+ * Copy the AoS view into SoA physics storage
+ * Call after loading/initializing and before the first sim_step()
+ */
+int sim_state_pack(SimState *state) {
+    state->forces_valid = 0;
+    state->events.live_valid = 0;
+    if (soa_from_bodies(&state->body_soa, state->bodies, state->n_bodies) != 0) {
+        return -1;
+    }
+    return soa_from_rockets(&state->rocket_soa, state->rockets, state->n_rockets);
+}
+
+/**
+ * Copy SoA physics storage back into the AoS view
+ * Call before rendering, logging or saving
+ */
+void sim_state_unpack(SimState *state) {
+    soa_to_bodies(&state->body_soa, state->bodies);
+    soa_to_rockets(&state->rocket_soa, state->rockets);
+}
+
+/* ============================================================================
+ * STRUCTURE-OF-ARRAYS STORAGE
+ * ============================================================================ */
+
+/**
+ * Allocate an aligned column, copying `n` existing elements across
+ */
+static int realloc_column(void **column, int n, int capacity, size_t elem_size) {
+    void *p = NULL;
+    if (posix_memalign(&p, SOA_ALIGNMENT, (size_t)capacity * elem_size) != 0) {
+        return -1;
+    }
+    
+    if (*column && n > 0) {
+        memcpy(p, *column, (size_t)n * elem_size);
+    }
+    free(*column);
+    *column = p;
+    return 0;
+}
+
+/**
+ * Ensure every SoA column can hold at least `capacity` particles
+ */
+int soa_reserve(ParticleSoA *p, int capacity) {
+    if (capacity <= p->capacity) return 0;
+    
+    int new_capacity = (p->capacity > 0) ? p->capacity : INITIAL_CAPACITY;
+    while (new_capacity < capacity) {
+        new_capacity *= 2;
+    }
+    
+    double **columns[] = {&p->x, &p->y, &p->vx, &p->vy, &p->ax, &p->ay, &p->mass};
+    for (size_t c = 0; c < sizeof(columns) / sizeof(columns[0]); c++) {
+        if (realloc_column((void **)columns[c], p->n, new_capacity, sizeof(double)) != 0) {
+            printf("Error: Memory allocation failed (%d particles)\n", new_capacity);
+            return -1;
+        }
+    }
+    if (realloc_column((void **)&p->active, p->n, new_capacity, 1) != 0) {
+        printf("Error: Memory allocation failed (%d particles)\n", new_capacity);
+        return -1;
+    }
+    
+    p->capacity = new_capacity;
+    return 0;
+}
+
+/**
+ * Free all SoA columns and reset to empty
+ */
+void soa_free(ParticleSoA *p) {
+    free(p->x);
+    free(p->y);
+    free(p->vx);
+    free(p->vy);
+    free(p->ax);
+    free(p->ay);
+    free(p->mass);
+    free(p->active);
+    memset(p, 0, sizeof(ParticleSoA));
+}
+
+/**
+ * Gather a body array into SoA columns
+ */
+int soa_from_bodies(ParticleSoA *p, const Body *bodies, int n) {
+    if (soa_reserve(p, n) != 0) return -1;
+    
+    for (int i = 0; i < n; i++) {
+        p->x[i] = bodies[i].x;
+        p->y[i] = bodies[i].y;
+        p->vx[i] = bodies[i].vx;
+        p->vy[i] = bodies[i].vy;
+        p->ax[i] = bodies[i].ax;
+        p->ay[i] = bodies[i].ay;
+        p->mass[i] = bodies[i].mass;
+        p->active[i] = 1;
+    }
+    p->n = n;
+    return 0;
+}
+
+/**
+ * Scatter SoA columns back into a body array
+ */
+void soa_to_bodies(const ParticleSoA *p, Body *bodies) {
+    for (int i = 0; i < p->n; i++) {
+        bodies[i].x = p->x[i];
+        bodies[i].y = p->y[i];
+        bodies[i].vx = p->vx[i];
+        bodies[i].vy = p->vy[i];
+        bodies[i].ax = p->ax[i];
+        bodies[i].ay = p->ay[i];
+        bodies[i].mass = p->mass[i];
+    }
+}
+
+/**
+ * Gather the hot fields of a rocket array into SoA columns
+ */
+int soa_from_rockets(ParticleSoA *p, const Rocket *rockets, int n) {
+    if (soa_reserve(p, n) != 0) return -1;
+    
+    for (int i = 0; i < n; i++) {
+        p->x[i] = rockets[i].x;
+        p->y[i] = rockets[i].y;
+        p->vx[i] = rockets[i].vx;
+        p->vy[i] = rockets[i].vy;
+        p->ax[i] = rockets[i].ax;
+        p->ay[i] = rockets[i].ay;
+        p->mass[i] = 0.0;
+        p->active[i] = rockets[i].active ? 1 : 0;
+    }
+    p->n = n;
+    return 0;
+}
+
+/**
+ * Scatter SoA columns back into a rocket array
+ * Trail arrays are cold data and are recorded separately
+ */
+void soa_to_rockets(const ParticleSoA *p, Rocket *rockets) {
+    for (int i = 0; i < p->n; i++) {
+        rockets[i].x = p->x[i];
+        rockets[i].y = p->y[i];
+        rockets[i].vx = p->vx[i];
+        rockets[i].vy = p->vy[i];
+        rockets[i].ax = p->ax[i];
+        rockets[i].ay = p->ay[i];
+        rockets[i].active = p->active[i];
+    }
+}
@@ -0,0 +1,302 @@
+/**
+ * timestep.c - Rocket Block Time-Steps
+ * Per-rocket power-of-two time-steps inside one global step
+ *
+ * Rocket i is integrated with its own KDK leapfrog step
+ * dt_i = dt / 2^level[i]. Within a global step, time is counted in
+ * integer ticks of dt / 2^BLOCK_MAX_LEVEL. Blocks are aligned to their
+ * own length, so the next event is the next multiple of the shortest
+ * active block and every block ends exactly on the global step boundary.
+ *
+ * Only rockets whose block ends at the current tick are "due": they are
+ * gathered into a compact SoA, their accelerations are computed with the
+ * usual kernels, and the result is scattered back. Rockets far from the
+ * bodies take long blocks and cost few force evaluations.
+ *
+ * A tick is due for every level at or finer than the one its alignment
+ * gives, so with the live rockets kept finest level first the due set
+ * is always a prefix of that order. Each tick visits only that prefix
+ * and re-sorts it by the new levels (a rocket coarsens by one level at
+ * most, onto the level right behind the prefix), so a step costs
+ * O(live rockets + due rockets summed over ticks), not O(ticks * rockets).
+ *
+ * The level follows the acceleration/jerk criterion
+ *     dt_i = eta * |a| / |j|,  j ~ (a(t + dt_i) - a(t)) / dt_i
+ * A rocket may move to a finer level at any block end, and to the next
+ * coarser level when the current tick is aligned to the doubled block.
+ *
+ * Body positions at intermediate ticks are predicted from the start of
+ * the step: x(t + tau) = x + v tau + a tau^2 / 2. At tau = dt this is the
+ * KDK drift, so rockets and bodies agree on the step boundary. With
+ * solver=bh the tree is built once per step and only refitted to the
+ * predicted positions at later ticks.
+ */
+
+#include "nbody.h"
+
+/**
+ * Initialize an empty schedule
+ */
+void block_steps_init(BlockSteps *blocks) {
+    memset(blocks, 0, sizeof(BlockSteps));
+}
+
+/**
+ * Free all schedule memory
+ */
+void block_steps_free(BlockSteps *blocks) {
+    free(blocks->level);
+    free(blocks->order);
+    free(blocks->due);
+    soa_free(&blocks->due_soa);
+    soa_free(&blocks->body_pred);
+    block_steps_init(blocks);
+}
+
+/**
+ * Ensure room for `n` rockets; new rockets start on the finest level
+ */
+static int block_steps_reserve(BlockSteps *blocks, int n) {
+    if (n <= blocks->capacity) return 0;
+    
+    unsigned char *level = (unsigned char *)realloc(blocks->level, n);
+    if (!level) return -1;
+    blocks->level = level;
+    
+    int *order = (int *)realloc(blocks->order, n * sizeof(int));
+    if (!order) return -1;
+    blocks->order = order;
+    
+    int *due = (int *)realloc(blocks->due, n * sizeof(int));
+    if (!due) return -1;
+    blocks->due = due;
+    
+    for (int i = blocks->capacity; i < n; i++) {
+        blocks->level[i] = BLOCK_MAX_LEVEL;
+    }
+    blocks->capacity = n;
+    return 0;
+}
+
+/**
+ * Put every rocket on the finest level
+ * Levels then relax towards the criterion one block at a time
+ */
+int block_steps_reset(BlockSteps *blocks, int n_rockets) {
+    if (block_steps_reserve(blocks, n_rockets) != 0) {
+        printf("Error: Memory allocation failed (%d rockets)\n", n_rockets);
+        return -1;
+    }
+    memset(blocks->level, BLOCK_MAX_LEVEL, blocks->capacity);
+    return 0;
+}
+
+/**
+ * Level from the acceleration/jerk criterion (0 when the jerk vanishes)
+ */
+int rocket_block_level(double ax, double ay, double jx, double jy,
+                       double dt, double eta) {
+    double a_sq = ax * ax + ay * ay;
+    double j_sq = jx * jx + jy * jy;
+    if (j_sq <= 0.0) return 0;
+    
+    double ideal = eta * sqrt(a_sq / j_sq);
+    int level = 0;
+    double step = dt;
+    while (step > ideal && level < BLOCK_MAX_LEVEL) {
+        step *= 0.5;
+        level++;
+    }
+    return level;
+}
+
+/**
+ * Rocket accelerations for the compacted due set
+ * `tree_state` is 0 before the step's tree is built, 1 once it is (later
+ * ticks only refit it) and -1 if it could not be (direct sums instead)
+ */
+static void due_rocket_forces(ParticleSoA *due, ParticleSoA *bodies, QuadTree *tree,
+                              int *tree_state, const SimConfig *config, Profile *profile) {
+    PROFILE_BEGIN(profile, started);
+    if (config->solver == SOLVER_BH && *tree_state == 0) {
+        *tree_state = (quadtree_build(tree, bodies) == 0) ? 1 : -1;
+        if (*tree_state < 0) {
+            printf("Error: Barnes-Hut tree allocation failed, summing rocket forces directly\n");
+        }
+    } else if (config->solver == SOLVER_BH && *tree_state > 0) {
+        quadtree_refit(tree, bodies);
+    }
+    
+    if (config->solver == SOLVER_BH && *tree_state > 0) {
+        compute_rocket_forces_bh(due, bodies, tree, config->g,
+                                 config->theta, config->threads);
+    } else if (config->threads > 0) {
+        compute_rocket_forces_threaded(due, bodies, config->g, config->threads,
+                                       config->precision);
+    } else {
+        rocket_force_kernel_sized(config->precision, bodies->n)(due, bodies, config->g, 0, due->n);
+    }
+    PROFILE_COUNT(profile, (long long)due->n * bodies->n);
+    PROFILE_END(profile, started, PROFILE_ROCKET_FORCES);
+}
+
+/**
+ * Sort `n` rockets by level, finest first, into `out`, and add them to
+ * the level counts (a stable counting sort)
+ */
+static void sort_by_level(BlockSteps *blocks, const int *in, int n, int *out) {
+    int count[BLOCK_MAX_LEVEL + 1], start[BLOCK_MAX_LEVEL + 1];
+    memset(count, 0, sizeof(count));
+    for (int k = 0; k < n; k++) count[blocks->level[in[k]]]++;
+    
+    int offset = 0;
+    for (int level = BLOCK_MAX_LEVEL; level >= 0; level--) {
+        start[level] = offset;
+        offset += count[level];
+        blocks->count[level] += count[level];
+    }
+    for (int k = 0; k < n; k++) out[start[blocks->level[in[k]]]++] = in[k];
+}
+
+/**
+ * Order this step's live rockets finest level first
+ * Returns the number of rockets
+ */
+static int order_live_rockets(SimState *state) {
+    BlockSteps *blocks = &state->blocks;
+    const RocketEvents *ev = &state->events;
+    const ParticleSoA *r = &state->rocket_soa;
+    
+    // The live list when it is current, else the active flags
+    int n = 0;
+    if (ev->live_valid) {
+        memcpy(blocks->due, ev->live, ev->n_live * sizeof(int));
+        n = ev->n_live;
+    } else {
+        for (int i = 0; i < r->n; i++) {
+            if (r->active[i]) blocks->due[n++] = i;
+        }
+    }
+    memset(blocks->count, 0, sizeof(blocks->count));
+    sort_by_level(blocks, blocks->due, n, blocks->order);
+    return n;
+}
+
+/**
+ * Advance active rockets across one global step on their block steps
+ */
+int advance_rockets_block(SimState *state, const SimConfig *config) {
+    ParticleSoA *r = &state->rocket_soa;
+    const ParticleSoA *b = &state->body_soa;
+    BlockSteps *blocks = &state->blocks;
+    ParticleSoA *due = &blocks->due_soa;
+    ParticleSoA *pred = &blocks->body_pred;
+    
+    if (block_steps_reserve(blocks, r->n) != 0 ||
+        soa_reserve(due, r->n) != 0 || soa_reserve(pred, b->n) != 0) {
+        printf("Error: Memory allocation failed (block time-steps)\n");
+        return -1;
+    }
+    
+    pred->n = b->n;
+    for (int k = 0; k < b->n; k++) {
+        pred->mass[k] = b->mass[k];
+        pred->active[k] = 1;
+    }
+    
+    const int ticks = 1 << BLOCK_MAX_LEVEL;
+    double tick_dt = config->dt / ticks;
+    int n_live = order_live_rockets(state);
+    int *order = blocks->order;
+    
+    // Opening half-kick of every block starting with this step
+    for (int k = 0; k < n_live; k++) {
+        int i = order[k];
+        double half = 0.5 * tick_dt * (1 << (BLOCK_MAX_LEVEL - blocks->level[i]));
+        r->vx[i] += r->ax[i] * half;
+        r->vy[i] += r->ay[i] * half;
+    }
+    
+    int now = 0, tree_state = 0;
+    while (now < ticks && n_live > 0) {
+        // Next event: end of the shortest block, on the finest occupied level
+        int finest = BLOCK_MAX_LEVEL;
+        while (blocks->count[finest] == 0) finest--;
+        int span_min = 1 << (BLOCK_MAX_LEVEL - finest);
+        int next = (now / span_min + 1) * span_min;
+        
+        // Levels whose blocks end at `next`: the first n_due of `order`
+        int coarsest = finest;
+        while (coarsest > 0 && next % (1 << (BLOCK_MAX_LEVEL - coarsest + 1)) == 0) {
+            coarsest--;
+        }
+        int n_due = 0;
+        for (int level = coarsest; level <= BLOCK_MAX_LEVEL; level++) {
+            n_due += blocks->count[level];
+            blocks->count[level] = 0;
+        }
+        
+        // Drift due rockets across their block and gather them
+        for (int k = 0; k < n_due; k++) {
+            int i = order[k];
+            double dt_i = tick_dt * (1 << (BLOCK_MAX_LEVEL - blocks->level[i]));
+            r->x[i] += r->vx[i] * dt_i;
+            r->y[i] += r->vy[i] * dt_i;
+            
+            due->x[k] = r->x[i];
+            due->y[k] = r->y[i];
+            due->active[k] = 1;
+        }
+        due->n = n_due;
+        
+        // Bodies at the event time
+        double tau = tick_dt * next;
+        for (int k = 0; k < b->n; k++) {
+            pred->x[k] = b->x[k] + b->vx[k] * tau + 0.5 * b->ax[k] * tau * tau;
+            pred->y[k] = b->y[k] + b->vy[k] * tau + 0.5 * b->ay[k] * tau * tau;
+        }
+        
+        due_rocket_forces(due, pred, &state->tree, &tree_state, config, state->profile);
+        blocks->force_evals += n_due;
+        
+        // Closing half-kick, new level, and opening half-kick of the next block
+        for (int k = 0; k < n_due; k++) {
+            int i = order[k];
+            int level = blocks->level[i];
+            int span = 1 << (BLOCK_MAX_LEVEL - level);
+            double dt_i = tick_dt * span;
+            
+            r->vx[i] += due->ax[k] * 0.5 * dt_i;
+            r->vy[i] += due->ay[k] * 0.5 * dt_i;
+            
+            double jx = (due->ax[k] - r->ax[i]) / dt_i;
+            double jy = (due->ay[k] - r->ay[i]) / dt_i;
+            int want = rocket_block_level(due->ax[k], due->ay[k], jx, jy,
+                                          config->dt, config->eta);
+            if (want > level) {
+                level = want;
+            } else if (want < level && next % (2 * span) == 0) {
+                level--;
+            }
+            blocks->level[i] = (unsigned char)level;
+            
+            r->ax[i] = due->ax[k];
+            r->ay[i] = due->ay[k];
+            
+            // Step boundary: leave the rocket synchronised
+            if (next < ticks) {
+                double half = 0.5 * tick_dt * (1 << (BLOCK_MAX_LEVEL - level));
+                r->vx[i] += r->ax[i] * half;
+                r->vy[i] += r->ay[i] * half;
+            }
+        }
+        
+        // Re-sort the prefix; rockets that coarsened past it end up just
+        // before the (coarser) rockets that follow it
+        sort_by_level(blocks, order, n_due, blocks->due);
+        memcpy(order, blocks->due, n_due * sizeof(int));
+        
+        now = next;
+    }
+    return 0;
+}
@@ -0,0 +1,528 @@
+/**
+ * trail_io.c - Trajectory Files and Streaming Trail Writer
+ * Writes rocket trails to disk in fixed-size chunks during the run, and
+ * reads and writes the indexed v2 trajectory format
+ *
+ * Trajectory file v2 (rocket_trails.bin):
+ *
+ *   TrailFileHeader      64 bytes: magic, version, elem_size, n_rockets,
+ *                        index and data offsets
+ *   TrailIndexEntry[n]   x/y column offsets and length per rocket
+ *   columns              x[length] then y[length] per rocket, float64 or
+ *                        float32, each starting on a TRAIL_ALIGN boundary
+ *
+ * The index gives O(1) access to any rocket, and aligned columns can be
+ * read in place from a read-only mmap() without copying.
+ *
+ * Streaming: rockets keep only a TRAIL_WINDOW-point window in memory for
+ * rendering. Whenever a rocket has TRAIL_CHUNK points that are not yet
+ * on disk, the sink appends them to a spool file as one chunk record:
+ *
+ *   spool header:  "TRSP" magic, int n_rockets
+ *   chunk record:  int rocket, int count, count x doubles, count y doubles
+ *
+ * Chunks are flushed as they are written, so a crashed run leaves a
+ * spool holding every complete chunk; trail_spool_convert() recovers it,
+ * from the shell with
+ *
+ *   ./bin/convert_input --recover-trails rocket_trails.bin.part rocket_trails.bin
+ *
+ * after which analyze_trails, plot_trails and replay read it as usual.
+ * On close the spool is rewritten rocket by rocket into a v2 file and
+ * removed. Memory use is bounded by the window and does not grow with
+ * the number of steps. A run resumed from a checkpoint cuts the spool
+ * back to the size recorded in the checkpoint and appends from there.
+ */
+
+#include "nbody.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CONVERT_BLOCK 1024     // Points converted per float32 write
+
+static const char spool_magic[4] = {'T', 'R', 'S', 'P'};
+
+/* ============================================================================
+ * V2 WRITER
+ * ============================================================================ */
+
+/**
+ * Round `pos` up to the next TRAIL_ALIGN boundary
+ */
+static uint64_t align_up(uint64_t pos) {
+    return (pos + TRAIL_ALIGN - 1) & ~(uint64_t)(TRAIL_ALIGN - 1);
+}
+
+/**
+ * Bytes per stored coordinate for a precision in bits (64 or 32)
+ */
+static int elem_size_for(int precision) {
+    return (precision == 32) ? 4 : 8;
+}
+
+/**
+ * Write zero bytes until the file position reaches `target`
+ */
+static int pad_to(FILE *out, uint64_t *pos, uint64_t target) {
+    static const unsigned char zeros[TRAIL_ALIGN] = {0};
+    while (*pos < target) {
+        size_t n = (target - *pos < TRAIL_ALIGN) ? (size_t)(target - *pos) : TRAIL_ALIGN;
+        if (fwrite(zeros, 1, n, out) != n) return -1;
+        *pos += n;
+    }
+    return 0;
+}
+
+/**
+ * Append `count` coordinates, narrowing to float32 if requested
+ */
+static int write_column(FILE *out, uint64_t *pos, const double *src, long count,
+                        int elem_size) {
+    if (elem_size == 8) {
+        if (fwrite(src, sizeof(double), count, out) != (size_t)count) return -1;
+    } else {
+        float block[CONVERT_BLOCK];
+        for (long k = 0; k < count; k += CONVERT_BLOCK) {
+            long m = (count - k < CONVERT_BLOCK) ? count - k : CONVERT_BLOCK;
+            for (long j = 0; j < m; j++) {
+                block[j] = (float)src[k + j];
+            }
+            if (fwrite(block, sizeof(float), m, out) != (size_t)m) return -1;
+        }
+    }
+    *pos += (uint64_t)count * elem_size;
+    return 0;
+}
+
+/**
+ * Fill the index from the trail lengths and write header + index
+ * Returns 0 on success with the file positioned at the first column
+ */
+static int write_header_index(FILE *out, uint64_t *pos, TrailIndexEntry *index,
+                              int n, int elem_size) {
+    TrailFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRAIL_MAGIC, sizeof(header.magic));
+    header.version = TRAIL_VERSION;
+    header.elem_size = (uint32_t)elem_size;
+    header.n_rockets = (uint64_t)n;
+    header.index_offset = sizeof(TrailFileHeader);
+    header.data_offset = align_up(header.index_offset + (uint64_t)n * sizeof(TrailIndexEntry));
+    
+    uint64_t at = header.data_offset;
+    for (int i = 0; i < n; i++) {
+        index[i].x_offset = at;
+        at = align_up(at + index[i].length * elem_size);
+        index[i].y_offset = at;
+        at = align_up(at + index[i].length * elem_size);
+    }
+    
+    if (fwrite(&header, sizeof(header), 1, out) != 1) return -1;
+    if (n > 0 && fwrite(index, sizeof(TrailIndexEntry), n, out) != (size_t)n) return -1;
+    *pos = header.index_offset + (uint64_t)n * sizeof(TrailIndexEntry);
+    return pad_to(out, pos, header.data_offset);
+}
+
+/**
+ * Write the in-memory trail windows as a v2 trajectory file
+ */
+int write_trail_file(const char *filename, const Rocket *rockets, int n, int precision) {
+    int elem_size = elem_size_for(precision);
+    TrailIndexEntry *index = (TrailIndexEntry *)calloc(n + 1, sizeof(TrailIndexEntry));
+    FILE *out = fopen(filename, "wb");
+    if (!index || !out) {
+        printf("Error: Could not create %s\n", filename);
+        free(index);
+        if (out) fclose(out);
+        return -1;
+    }
+    
+    for (int i = 0; i < n; i++) {
+        index[i].length = (uint64_t)rockets[i].trail_length;
+    }
+    
+    uint64_t pos = 0;
+    int status = write_header_index(out, &pos, index, n, elem_size);
+    for (int i = 0; i < n && status == 0; i++) {
+        long len = rockets[i].trail_length;
+        if (pad_to(out, &pos, index[i].x_offset) != 0 ||
+            write_column(out, &pos, rockets[i].trail_x, len, elem_size) != 0 ||
+            pad_to(out, &pos, index[i].y_offset) != 0 ||
+            write_column(out, &pos, rockets[i].trail_y, len, elem_size) != 0) {
+            status = -1;
+        }
+    }
+    
+    if (fclose(out) != 0) status = -1;
+    free(index);
+    return status;
+}
+
+/* ============================================================================
+ * V2 READER
+ * ============================================================================ */
+
+/**
+ * Map the file and validate the header and every index entry
+ */
+int trail_file_open(TrailFile *file, const char *filename) {
+    memset(file, 0, sizeof(TrailFile));
+    
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Could not open %s\n", filename);
+        char spool[PATH_LEN];
+        snprintf(spool, sizeof(spool), "%s.part", filename);
+        if (access(spool, R_OK) == 0) {
+            printf("  %s was left by an interrupted run; recover it with\n"
+                   "  ./bin/convert_input --recover-trails %s %s\n", spool, spool, filename);
+        }
+        return -1;
+    }
+    
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(TrailFileHeader)) {
+        printf("Error: %s is not a trajectory file\n", filename);
+        close(fd);
+        return -1;
+    }
+    
+    void *base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // The mapping stays valid
+    if (base == MAP_FAILED) {
+        printf("Error: Could not map %s\n", filename);
+        return -1;
+    }
+    
+    file->base = (const unsigned char *)base;
+    file->size = (size_t)st.st_size;
+    file->header = (const TrailFileHeader *)base;
+    
+    const TrailFileHeader *h = file->header;
+    int valid = memcmp(h->magic, TRAIL_MAGIC, sizeof(h->magic)) == 0 &&
+                h->version == TRAIL_VERSION &&
+                (h->elem_size == 8 || h->elem_size == 4) &&
+                h->index_offset % sizeof(uint64_t) == 0 && h->index_offset <= file->size &&
+                h->n_rockets <= (file->size - h->index_offset) / sizeof(TrailIndexEntry);
+    
+    if (valid) {
+        file->index = (const TrailIndexEntry *)(file->base + h->index_offset);
+        for (uint64_t i = 0; i < h->n_rockets && valid; i++) {
+            const TrailIndexEntry *e = &file->index[i];
+            uint64_t bytes = e->length * h->elem_size;
+            valid = e->length <= file->size / h->elem_size &&
+                    e->x_offset % TRAIL_ALIGN == 0 && e->y_offset % TRAIL_ALIGN == 0 &&
+                    e->x_offset <= file->size - bytes && e->y_offset <= file->size - bytes;
+        }
+    }
+    
+    if (!valid) {
+        if (memcmp(h->magic, TRAIL_MAGIC, sizeof(h->magic)) != 0) {
+            printf("Error: %s is not a v%d trajectory file (re-run the simulation)\n",
+                   filename, TRAIL_VERSION);
+        } else {
+            printf("Error: %s is corrupt or has an unsupported version\n", filename);
+        }
+        trail_file_close(file);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Unmap the file
+ */
+void trail_file_close(TrailFile *file) {
+    if (file->base) munmap((void *)file->base, file->size);
+    memset(file, 0, sizeof(TrailFile));
+}
+
+/**
+ * Number of rockets in the index
+ */
+int trail_file_count(const TrailFile *file) {
+    return (int)file->header->n_rockets;
+}
+
+/**
+ * Trail length of one rocket
+ */
+long trail_file_length(const TrailFile *file, int rocket) {
+    return (long)file->index[rocket].length;
+}
+
+/**
+ * Point j of one rocket, widening float32 storage to double
+ */
+void trail_file_point(const TrailFile *file, int rocket, long j, double *x, double *y) {
+    const TrailIndexEntry *e = &file->index[rocket];
+    if (file->header->elem_size == 8) {
+        *x = ((const double *)(file->base + e->x_offset))[j];
+        *y = ((const double *)(file->base + e->y_offset))[j];
+    } else {
+        *x = ((const float *)(file->base + e->x_offset))[j];
+        *y = ((const float *)(file->base + e->y_offset))[j];
+    }
+}
+
+/**
+ * In-place float64 x column (NULL for float32 files)
+ */
+const double *trail_file_x(const TrailFile *file, int rocket) {
+    if (file->header->elem_size != 8) return NULL;
+    return (const double *)(file->base + file->index[rocket].x_offset);
+}
+
+/**
+ * In-place float64 y column (NULL for float32 files)
+ */
+const double *trail_file_y(const TrailFile *file, int rocket) {
+    if (file->header->elem_size != 8) return NULL;
+    return (const double *)(file->base + file->index[rocket].y_offset);
+}
+
+/* ============================================================================
+ * STREAMING TRAIL SINK
+ * ============================================================================ */
+
+/**
+ * Open the spool file next to `filename`
+ */
+int trail_sink_open(TrailSink *sink, const char *filename, int n_rockets, int precision) {
+    memset(sink, 0, sizeof(TrailSink));
+    snprintf(sink->path, sizeof(sink->path), "%s", filename);
+    snprintf(sink->spool_path, sizeof(sink->spool_path), "%s.part", filename);
+    sink->n_rockets = n_rockets;
+    sink->precision = precision;
+    
+    sink->spool = fopen(sink->spool_path, "wb");
+    if (!sink->spool) {
+        printf("Error: Could not create %s\n", sink->spool_path);
+        return -1;
+    }
+    
+    fwrite(spool_magic, 1, sizeof(spool_magic), sink->spool);
+    fwrite(&n_rockets, sizeof(int), 1, sink->spool);
+    return 0;
+}
+
+/**
+ * Reopen an existing spool, cut back to a checkpoint's offset
+ */
+int trail_sink_resume(TrailSink *sink, const char *filename, int n_rockets, int precision,
+                      long offset, long long points) {
+    memset(sink, 0, sizeof(TrailSink));
+    snprintf(sink->path, sizeof(sink->path), "%s", filename);
+    snprintf(sink->spool_path, sizeof(sink->spool_path), "%s.part", filename);
+    sink->n_rockets = n_rockets;
+    sink->precision = precision;
+    sink->points = points;
+    
+    sink->spool = fopen(sink->spool_path, "r+b");
+    if (!sink->spool) {
+        printf("Error: Could not reopen %s\n", sink->spool_path);
+        return -1;
+    }
+    
+    char magic[4];
+    int count = 0;
+    if (fread(magic, 1, sizeof(magic), sink->spool) != sizeof(magic) ||
+        memcmp(magic, spool_magic, sizeof(magic)) != 0 ||
+        fread(&count, sizeof(int), 1, sink->spool) != 1 || count != n_rockets ||
+        offset < (long)(sizeof(magic) + sizeof(int))) {
+        printf("Error: %s does not match the checkpoint\n", sink->spool_path);
+        fclose(sink->spool);
+        sink->spool = NULL;
+        return -1;
+    }
+    
+    // Chunks written after the checkpoint are written again
+    if (ftruncate(fileno(sink->spool), offset) != 0 || fseek(sink->spool, offset, SEEK_SET) != 0) {
+        printf("Error: Could not rewind %s\n", sink->spool_path);
+        fclose(sink->spool);
+        sink->spool = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Sync the spool for a checkpoint and return its size
+ */
+long trail_sink_sync(TrailSink *sink) {
+    if (!sink->spool) return -1;
+    if (fflush(sink->spool) != 0 || fsync(fileno(sink->spool)) != 0) return -1;
+    return ftell(sink->spool);
+}
+
+/**
+ * Append the unwritten trail points of each rocket as chunk records
+ */
+void trail_sink_flush(TrailSink *sink, Rocket *rockets, int n, int final) {
+    if (!sink->spool) return;
+    
+    int wrote = 0;
+    int limit = (n < sink->n_rockets) ? n : sink->n_rockets;
+    
+    for (int i = 0; i < limit; i++) {
+        Rocket *r = &rockets[i];
+        // A provisional tip still moves; it is written with the final chunk
+        int end = r->trail_length - (final ? 0 : r->trail_tip);
+        int count = end - r->trail_flushed;
+        if (count <= 0 || (!final && count < TRAIL_CHUNK)) continue;
+        
+        fwrite(&i, sizeof(int), 1, sink->spool);
+        fwrite(&count, sizeof(int), 1, sink->spool);
+        fwrite(r->trail_x + r->trail_flushed, sizeof(double), count, sink->spool);
+        fwrite(r->trail_y + r->trail_flushed, sizeof(double), count, sink->spool);
+        
+        r->trail_flushed = end;
+        sink->points += count;
+        wrote = 1;
+    }
+    
+    // Keep the spool on disk current so a crash loses at most a chunk
+    if (wrote) fflush(sink->spool);
+}
+
+/**
+ * Flush everything, convert the spool into the final file, remove it
+ */
+int trail_sink_close(TrailSink *sink, Rocket *rockets, int n) {
+    if (!sink->spool) return -1;
+    
+    trail_sink_flush(sink, rockets, n, 1);
+    int failed = ferror(sink->spool);
+    fclose(sink->spool);
+    sink->spool = NULL;
+    
+    if (failed || trail_spool_convert(sink->spool_path, sink->path, sink->precision) < 0) {
+        printf("Error: Trail spool kept at %s\n", sink->spool_path);
+        return -1;
+    }
+    
+    remove(sink->spool_path);
+    return 0;
+}
+
+/**
+ * Copy one column (x or y) of every chunk of a rocket to `out`
+ * `column` is 0 for x and 1 for y
+ */
+static int copy_chunks(FILE *in, FILE *out, uint64_t *pos, const long *offsets,
+                       const int *counts, int first, int last, int column,
+                       int elem_size, double *buffer) {
+    for (int c = first; c < last; c++) {
+        long at = offsets[c] + (long)column * counts[c] * (long)sizeof(double);
+        if (fseek(in, at, SEEK_SET) != 0) return -1;
+        if (fread(buffer, sizeof(double), counts[c], in) != (size_t)counts[c]) return -1;
+        if (write_column(out, pos, buffer, counts[c], elem_size) != 0) return -1;
+    }
+    return 0;
+}
+
+/**
+ * Rewrite a spool as a v2 trajectory file
+ * A truncated final chunk (crashed run) is ignored.
+ */
+int trail_spool_convert(const char *spool_path, const char *filename, int precision) {
+    FILE *in = fopen(spool_path, "rb");
+    if (!in) {
+        printf("Error: Could not open %s\n", spool_path);
+        return -1;
+    }
+    
+    char magic[4];
+    int n_rockets;
+    if (fread(magic, 1, 4, in) != 4 || memcmp(magic, spool_magic, 4) != 0 ||
+        fread(&n_rockets, sizeof(int), 1, in) != 1 || n_rockets < 0) {
+        printf("Error: %s is not a trail spool\n", spool_path);
+        fclose(in);
+        return -1;
+    }
+    
+    // Pass 1: count chunks per rocket
+    int *per_rocket = (int *)calloc(n_rockets + 1, sizeof(int));
+    if (!per_rocket) {
+        fclose(in);
+        return -1;
+    }
+    
+    fseek(in, 0, SEEK_END);
+    long file_size = ftell(in);
+    long data_start = 4 + (long)sizeof(int);
+    fseek(in, data_start, SEEK_SET);
+    
+    int n_chunks = 0;
+    int max_count = 0;
+    int header[2];
+    while (fread(header, sizeof(int), 2, in) == 2) {
+        long end = ftell(in) + 2L * header[1] * (long)sizeof(double);
+        if (header[0] < 0 || header[0] >= n_rockets || header[1] <= 0 || end > file_size) break;
+        
+        per_rocket[header[0] + 1]++;
+        if (header[1] > max_count) max_count = header[1];
+        n_chunks++;
+        fseek(in, end, SEEK_SET);
+    }
+    
+    // Prefix sums give each rocket's range in the chunk arrays
+    for (int r = 0; r < n_rockets; r++) {
+        per_rocket[r + 1] += per_rocket[r];
+    }
+    
+    long *offsets = (long *)malloc((n_chunks + 1) * sizeof(long));
+    int *counts = (int *)malloc((n_chunks + 1) * sizeof(int));
+    int *fill = (int *)malloc((n_rockets + 1) * sizeof(int));
+    double *buffer = (double *)malloc((max_count + 1) * sizeof(double));
+    TrailIndexEntry *index = (TrailIndexEntry *)calloc(n_rockets + 1, sizeof(TrailIndexEntry));
+    FILE *out = fopen(filename, "wb");
+    int status = (offsets && counts && fill && buffer && index && out) ? 0 : -1;
+    
+    if (status == 0) {
+        // Pass 2: chunk offsets grouped by rocket, in time order
+        memcpy(fill, per_rocket, n_rockets * sizeof(int));
+        fseek(in, data_start, SEEK_SET);
+        for (int c = 0; c < n_chunks; c++) {
+            if (fread(header, sizeof(int), 2, in) != 2) {
+                status = -1;
+                break;
+            }
+            int slot = fill[header[0]]++;
+            offsets[slot] = ftell(in);
+            counts[slot] = header[1];
+            index[header[0]].length += (uint64_t)header[1];
+            fseek(in, 2L * header[1] * (long)sizeof(double), SEEK_CUR);
+        }
+    }
+    
+    int elem_size = elem_size_for(precision);
+    uint64_t pos = 0;
+    if (status == 0) {
+        status = write_header_index(out, &pos, index, n_rockets, elem_size);
+    }
+    for (int r = 0; r < n_rockets && status == 0; r++) {
+        int first = per_rocket[r];
+        int last = per_rocket[r + 1];
+        if (pad_to(out, &pos, index[r].x_offset) != 0 ||
+            copy_chunks(in, out, &pos, offsets, counts, first, last, 0, elem_size, buffer) != 0 ||
+            pad_to(out, &pos, index[r].y_offset) != 0 ||
+            copy_chunks(in, out, &pos, offsets, counts, first, last, 1, elem_size, buffer) != 0) {
+            status = -1;
+        }
+    }
+    
+    if (out && fclose(out) != 0) status = -1;
+    if (status != 0) printf("Error: Could not convert %s to %s\n", spool_path, filename);
+    
+    free(per_rocket);
+    free(offsets);
+    free(counts);
+    free(fill);
+    free(buffer);
+    free(index);
+    fclose(in);
+    return (status == 0) ? n_rockets : -1;
+}
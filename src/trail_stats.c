@@ -0,0 +1,225 @@
+/**
+ * trail_stats.c - Trajectory Statistics
+ * Path length, distance range and bounding box of a trail
+ *
+ * Shared by rocket_stats.csv (save_trajectory_stats) and the
+ * analyze_trails tool. Points are taken in blocks: one pass over a block
+ * computes the squared distances, the bounding box and every segment
+ * length, four points per vector with AVX2 when the CPU has it (runtime
+ * dispatch as in physics_simd.c). Only the running sum of the segment
+ * lengths is scalar, added in path order, so the path length and every
+ * other value are bitwise what a plain point-by-point loop gives.
+ *
+ * Distances are compared squared; sqrt() is monotonic, so the square
+ * root of the largest square is the largest distance.
+ */
+
+#include "nbody.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_STATS 1
+#endif
+
+#define TRAIL_STATS_BLOCK 256     // Points per block (segment lengths on the stack)
+
+/**
+ * Ranges of one block of points
+ */
+typedef struct {
+    double min_d2, max_d2;
+    double min_x, max_x, min_y, max_y;
+} BlockRange;
+
+typedef void (*BlockKernel)(const double *x, const double *y, int n, double *seg,
+                            BlockRange *range);
+
+/**
+ * Ranges of points [begin, n) and segment lengths seg[k] = |p[k] - p[k-1]|
+ * for k in [max(begin, 1), n), merged into `range`
+ */
+static void block_tail(const double *x, const double *y, int begin, int seg_begin, int n,
+                       double *seg, BlockRange *range) {
+    for (int k = begin; k < n; k++) {
+        double d2 = x[k] * x[k] + y[k] * y[k];
+        if (d2 < range->min_d2) range->min_d2 = d2;
+        if (d2 > range->max_d2) range->max_d2 = d2;
+        if (x[k] < range->min_x) range->min_x = x[k];
+        if (x[k] > range->max_x) range->max_x = x[k];
+        if (y[k] < range->min_y) range->min_y = y[k];
+        if (y[k] > range->max_y) range->max_y = y[k];
+    }
+    for (int k = (seg_begin > 1) ? seg_begin : 1; k < n; k++) {
+        double dx = x[k] - x[k - 1];
+        double dy = y[k] - y[k - 1];
+        seg[k] = sqrt(dx * dx + dy * dy);
+    }
+}
+
+/**
+ * Start a block range that any point replaces
+ */
+static void block_range_init(BlockRange *range) {
+    range->min_d2 = INFINITY;
+    range->max_d2 = -INFINITY;
+    range->min_x = range->min_y = INFINITY;
+    range->max_x = range->max_y = -INFINITY;
+}
+
+/**
+ * Reference block kernel
+ */
+static void block_scalar(const double *x, const double *y, int n, double *seg,
+                         BlockRange *range) {
+    block_range_init(range);
+    block_tail(x, y, 0, 1, n, seg, range);
+}
+
+#ifdef HAVE_X86_STATS
+/**
+ * Smallest and largest lane of a vector
+ */
+__attribute__((target("avx2")))
+static void lanes_min_max(__m256d lo, __m256d hi, double *min, double *max) {
+    double l[4], h[4];
+    _mm256_storeu_pd(l, lo);
+    _mm256_storeu_pd(h, hi);
+    for (int k = 0; k < 4; k++) {
+        if (l[k] < *min) *min = l[k];
+        if (h[k] > *max) *max = h[k];
+    }
+}
+
+/**
+ * AVX2 block kernel: four points, or four segments, per vector
+ * No FMA, so every value is rounded as in block_scalar()
+ */
+__attribute__((target("avx2")))
+static void block_avx2(const double *x, const double *y, int n, double *seg,
+                       BlockRange *range) {
+    block_range_init(range);
+    __m256d lo_d2 = _mm256_set1_pd(INFINITY), hi_d2 = _mm256_set1_pd(-INFINITY);
+    __m256d lo_x = lo_d2, hi_x = hi_d2, lo_y = lo_d2, hi_y = hi_d2;
+    
+    int k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m256d vx = _mm256_loadu_pd(x + k);
+        __m256d vy = _mm256_loadu_pd(y + k);
+        __m256d d2 = _mm256_add_pd(_mm256_mul_pd(vx, vx), _mm256_mul_pd(vy, vy));
+        lo_d2 = _mm256_min_pd(lo_d2, d2);
+        hi_d2 = _mm256_max_pd(hi_d2, d2);
+        lo_x = _mm256_min_pd(lo_x, vx);
+        hi_x = _mm256_max_pd(hi_x, vx);
+        lo_y = _mm256_min_pd(lo_y, vy);
+        hi_y = _mm256_max_pd(hi_y, vy);
+    }
+    
+    int j = 1;
+    for (; j + 4 <= n; j += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + j), _mm256_loadu_pd(x + j - 1));
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + j), _mm256_loadu_pd(y + j - 1));
+        __m256d d2 = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+        _mm256_storeu_pd(seg + j, _mm256_sqrt_pd(d2));
+    }
+    
+    lanes_min_max(lo_d2, hi_d2, &range->min_d2, &range->max_d2);
+    lanes_min_max(lo_x, hi_x, &range->min_x, &range->max_x);
+    lanes_min_max(lo_y, hi_y, &range->min_y, &range->max_y);
+    block_tail(x, y, k, j, n, seg, range);
+}
+#endif
+
+/**
+ * Widest block kernel the CPU supports
+ */
+static BlockKernel block_kernel(void) {
+#ifdef HAVE_X86_STATS
+    if (__builtin_cpu_supports("avx2")) return block_avx2;
+#endif
+    return block_scalar;
+}
+
+/**
+ * Name of the statistics kernel in use
+ */
+const char *trail_stats_kernel(void) {
+    return (block_kernel() == block_scalar) ? "scalar" : "avx2";
+}
+
+/**
+ * Start empty statistics
+ */
+void trail_stats_init(TrailStats *stats) {
+    memset(stats, 0, sizeof(TrailStats));
+    stats->min_d2 = INFINITY;
+    stats->min_x = stats->min_y = INFINITY;
+    stats->max_x = stats->max_y = -INFINITY;
+}
+
+/**
+ * Add `n` points, continuing the path from the last point added
+ */
+void trail_stats_add(TrailStats *stats, const double *x, const double *y, long n) {
+    BlockKernel kernel = block_kernel();
+    double seg[TRAIL_STATS_BLOCK];
+    
+    for (long b = 0; b < n; b += TRAIL_STATS_BLOCK) {
+        int m = (n - b < TRAIL_STATS_BLOCK) ? (int)(n - b) : TRAIL_STATS_BLOCK;
+        const double *bx = x + b, *by = y + b;
+        BlockRange range;
+        kernel(bx, by, m, seg, &range);
+        
+        // Segments summed in path order, the first one from the last block
+        double path = stats->path_length;
+        if (stats->points > 0) {
+            double dx = bx[0] - stats->last_x;
+            double dy = by[0] - stats->last_y;
+            path += sqrt(dx * dx + dy * dy);
+        } else {
+            stats->first_x = bx[0];
+            stats->first_y = by[0];
+        }
+        for (int k = 1; k < m; k++) path += seg[k];
+        stats->path_length = path;
+        
+        if (range.min_d2 < stats->min_d2) stats->min_d2 = range.min_d2;
+        if (range.max_d2 > stats->max_d2) stats->max_d2 = range.max_d2;
+        if (range.min_x < stats->min_x) stats->min_x = range.min_x;
+        if (range.max_x > stats->max_x) stats->max_x = range.max_x;
+        if (range.min_y < stats->min_y) stats->min_y = range.min_y;
+        if (range.max_y > stats->max_y) stats->max_y = range.max_y;
+        stats->last_x = bx[m - 1];
+        stats->last_y = by[m - 1];
+        stats->points += m;
+    }
+}
+
+/**
+ * Add float32 points, widened a block at a time
+ */
+void trail_stats_add_float(TrailStats *stats, const float *x, const float *y, long n) {
+    double bx[TRAIL_STATS_BLOCK], by[TRAIL_STATS_BLOCK];
+    for (long b = 0; b < n; b += TRAIL_STATS_BLOCK) {
+        int m = (n - b < TRAIL_STATS_BLOCK) ? (int)(n - b) : TRAIL_STATS_BLOCK;
+        for (int k = 0; k < m; k++) {
+            bx[k] = x[b + k];
+            by[k] = y[b + k];
+        }
+        trail_stats_add(stats, bx, by, m);
+    }
+}
+
+/**
+ * Statistics of one rocket of a mapped trajectory file, read in place
+ */
+void trail_stats_file(const TrailFile *file, int rocket, TrailStats *stats) {
+    trail_stats_init(stats);
+    const TrailIndexEntry *e = &file->index[rocket];
+    long n = (long)e->length;
+    if (file->header->elem_size == 8) {
+        trail_stats_add(stats, trail_file_x(file, rocket), trail_file_y(file, rocket), n);
+    } else {
+        trail_stats_add_float(stats, (const float *)(file->base + e->x_offset),
+                              (const float *)(file->base + e->y_offset), n);
+    }
+}
@@ -0,0 +1,204 @@
+/**
+ * video_out.c - Direct Video Output
+ * Stream frames to an encoder instead of writing one BMP per frame
+ *
+ * Two sinks share one interface:
+ * - ffmpeg: raw bgr24 frames are piped into an ffmpeg subprocess, which
+ *   picks the container and codec from the output file name. Pixel is
+ *   already B, G, R and rows are stored top to bottom, so a frame is one
+ *   fwrite() of the image.
+ * - Y4M: an uncompressed YUV4MPEG2 stream (4:4:4, BT.601 studio range)
+ *   written to a file, or to stdout with video_file=-. Any player or
+ *   encoder can read it, e.g. `./bin/nbody | ffmpeg -i - out.mp4`.
+ *
+ * When the stream goes to stdout, the console messages of the simulation
+ * are moved to stderr so they cannot corrupt it. main() does this with
+ * video_take_stdout() right after reading the config, before anything
+ * else is printed, and hands the saved descriptor to video_open().
+ *
+ * A Y4M file can be resumed after a checkpoint: frames have a fixed size,
+ * so the file is cut back to the frames the checkpoint covers and the
+ * resumed run appends the rest.
+ */
+
+#include "nbody.h"
+#include <signal.h>
+#include <unistd.h>
+
+/**
+ * Open an ffmpeg subprocess reading raw frames on its stdin
+ */
+static FILE *open_ffmpeg(const char *filename, int w, int h, int fps) {
+    if (strchr(filename, '\'')) {
+        printf("Error: Video file name may not contain quotes: %s\n", filename);
+        return NULL;
+    }
+    if (system("command -v ffmpeg > /dev/null 2>&1") != 0) {
+        printf("Error: ffmpeg not found (video_output=y4m needs no encoder)\n");
+        return NULL;
+    }
+    
+    // yuv420p needs even dimensions; odd image sizes get one black edge
+    // The filter is quoted: the shell popen() runs rejects bare parentheses
+    char command[512];
+    snprintf(command, sizeof(command),
+             "ffmpeg -loglevel error -y -f rawvideo -pixel_format bgr24 "
+             "-video_size %dx%d -framerate %d -i - "
+             "-vf 'pad=ceil(iw/2)*2:ceil(ih/2)*2' -pix_fmt yuv420p '%s'",
+             w, h, fps, filename);
+    
+    // A dead encoder must surface as a write error, not kill the simulation
+    signal(SIGPIPE, SIG_IGN);
+    return popen(command, "w");
+}
+
+/**
+ * Take over stdout for a video stream; console output goes to stderr
+ * The flush comes after the switch: on a pipe stdout is fully buffered,
+ * so what load_config() printed is still buffered and goes to stderr
+ */
+int video_take_stdout(void) {
+    int fd = dup(STDOUT_FILENO);
+    if (fd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        if (fd >= 0) close(fd);
+        printf("Error: Could not move console output to stderr\n");
+        return -1;
+    }
+    fflush(stdout);
+    return fd;
+}
+
+/**
+ * Open a video sink (0 on success, -1 on failure)
+ */
+int video_open(VideoSink *video, int kind, const char *filename, int w, int h, int fps,
+               int stdout_fd) {
+    memset(video, 0, sizeof(VideoSink));
+    video->kind = kind;
+    video->width = w;
+    video->height = h;
+    if (fps < 1) fps = VIDEO_FPS;
+    
+    if (kind == VIDEO_FFMPEG) {
+        video->out = open_ffmpeg(filename, w, h, fps);
+        video->is_pipe = 1;
+    } else if (kind == VIDEO_Y4M) {
+        video->planes = (unsigned char *)malloc((size_t)w * h * 3);
+        if (!video->planes) {
+            printf("Error: Memory allocation failed (video frame)\n");
+            return -1;
+        }
+        video->is_file = (strcmp(filename, "-") != 0);
+        video->out = video->is_file ? fopen(filename, "wb") :
+                     (stdout_fd >= 0) ? fdopen(stdout_fd, "wb") : NULL;
+    } else {
+        printf("Error: Unknown video output %d\n", kind);
+        return -1;
+    }
+    
+    if (!video->out) {
+        printf("Error: Could not open video output %s\n", filename);
+        free(video->planes);
+        video->planes = NULL;
+        return -1;
+    }
+    
+    if (kind == VIDEO_Y4M) {
+        fprintf(video->out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", w, h, fps);
+    }
+    return 0;
+}
+
+/**
+ * Reopen a Y4M file at the end of the frames a checkpoint covers
+ */
+int video_resume_y4m(VideoSink *video, const char *filename, int w, int h,
+                     long offset, long frames) {
+    memset(video, 0, sizeof(VideoSink));
+    video->kind = VIDEO_Y4M;
+    video->is_file = 1;
+    video->width = w;
+    video->height = h;
+    video->frames = frames;
+    
+    video->planes = (unsigned char *)malloc((size_t)w * h * 3);
+    if (!video->planes) {
+        printf("Error: Memory allocation failed (video frame)\n");
+        return -1;
+    }
+    
+    // Frames written after the checkpoint are written again
+    if (truncate(filename, offset) != 0 || !(video->out = fopen(filename, "ab"))) {
+        printf("Error: Could not resume video file %s\n", filename);
+        free(video->planes);
+        video->planes = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Flush and sync a Y4M file; its size is where a resumed run continues
+ */
+long video_sync(VideoSink *video) {
+    if (!video->out || !video->is_file) return -1;
+    if (fflush(video->out) != 0 || fsync(fileno(video->out)) != 0) return -1;
+    return ftell(video->out);
+}
+
+/**
+ * Y4M frame: BGR -> Y, Cb, Cr planes (integer BT.601, studio range)
+ */
+static int write_y4m_frame(VideoSink *video, const Pixel *img) {
+    long n = (long)video->width * video->height;
+    unsigned char *py = video->planes;
+    unsigned char *pu = py + n;
+    unsigned char *pv = pu + n;
+    
+    for (long k = 0; k < n; k++) {
+        int r = img[k].r, g = img[k].g, b = img[k].b;
+        py[k] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        pu[k] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        pv[k] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+    
+    fputs("FRAME\n", video->out);
+    return (fwrite(video->planes, 1, 3 * n, video->out) == (size_t)(3 * n)) ? 0 : -1;
+}
+
+/**
+ * Append one frame (0 on success, -1 on write failure)
+ */
+int video_write_frame(VideoSink *video, const Pixel *img) {
+    if (!video->out) return -1;
+    
+    int status;
+    if (video->kind == VIDEO_Y4M) {
+        status = write_y4m_frame(video, img);
+    } else {
+        size_t n = (size_t)video->width * video->height;
+        status = (fwrite(img, sizeof(Pixel), n, video->out) == n) ? 0 : -1;
+    }
+    
+    if (status == 0) video->frames++;
+    return status;
+}
+
+/**
+ * Finish the stream; for ffmpeg this waits for the encoder to exit
+ * Returns 0 on success, -1 if the stream or the encoder failed
+ */
+int video_close(VideoSink *video) {
+    int status = 0;
+    if (video->out) {
+        if (video->is_pipe) {
+            status = (pclose(video->out) == 0) ? 0 : -1;
+        } else {
+            status = (fclose(video->out) == 0) ? 0 : -1;
+        }
+    }
+    free(video->planes);
+    video->out = NULL;
+    video->planes = NULL;
+    return status;
+}
@@ -68,14 +68,19 @@ void create_test_files() {
  * Test 1: Load bodies from file
  */
 void test_load_bodies() {
-    Body bodies[MAX_BODIES];
-    int n = load_bodies(TEST_DIR "test_bodies.txt", bodies, MAX_BODIES);
+    SimState state;
+    sim_state_init(&state);
+    int n = load_bodies(TEST_DIR "test_bodies.txt", &state);
+    Body *bodies = state.bodies;
     
     int passed = (n == 3) && 
+                 (state.n_bodies == 3) &&
                  (bodies[0].mass == 100.0) &&
                  (bodies[1].x == 2.0) &&
                  (bodies[2].x == -2.0);
     
+    sim_state_free(&state);
+    
     test_result("Load bodies from file", passed);
 }
 
@@ -83,20 +88,20 @@ void test_load_bodies() {
  * Test 2: Load rockets from file
  */
 void test_load_rockets() {
-    Rocket rockets[MAX_ROCKETS];
-    int n = load_rockets(TEST_DIR "test_rockets.txt", rockets, MAX_ROCKETS);
+    SimState state;
+    sim_state_init(&state);
+    int n = load_rockets(TEST_DIR "test_rockets.txt", &state);
+    Rocket *rockets = state.rockets;
     
     int passed = (n == 2) &&
+                 (state.n_rockets == 2) &&
                  (rockets[0].x == 2.0) &&
                  (rockets[1].x == -3.0) &&
                  (rockets[0].trail_x != NULL) &&
                  (rockets[1].trail_x != NULL);
     
     // Clean up
-    for (int i = 0; i < n; i++) {
-        free(rockets[i].trail_x);
-        free(rockets[i].trail_y);
-    }
+    sim_state_free(&state);
     
     test_result("Load rockets from file", passed);
 }
@@ -105,7 +110,8 @@ void test_load_rockets() {
  * Test 3: Load configuration
  */
 void test_load_config() {
-    SimConfig config = {DT, STEPS, FRAMES, 0, G};
+    SimConfig config;
+    sim_config_default(&config);
     int result = load_config(TEST_DIR "test_config.txt", &config);
     
     int passed = (result == 0) &&
@@ -122,10 +128,12 @@ void test_load_config() {
  * Test 4: Handle missing files gracefully
  */
 void test_missing_files() {
-    Body bodies[MAX_BODIES];
-    SimConfig config = {DT, STEPS, FRAMES, 0, G};
+    SimState state;
+    sim_state_init(&state);
+    SimConfig config;
+    sim_config_default(&config);
     
-    int bodies_result = load_bodies("nonexistent.txt", bodies, MAX_BODIES);
+    int bodies_result = load_bodies("nonexistent.txt", &state);
     int config_result = load_config("nonexistent.txt", &config);
     
     // Should return -1 for missing files, not crash
@@ -159,31 +167,34 @@ void test_binary_trajectory() {
     // Save to binary file
     save_rocket_trails_bin(TEST_DIR "test_trails.bin", rockets, 1);
     
-    // Read back and verify
-    FILE *f = fopen(TEST_DIR "test_trails.bin", "rb");
+    // Read back and verify through the mapped v2 file
+    TrailFile file;
     int passed = 0;
     
-    if (f) {
-        int n_rockets;
-        fread(&n_rockets, sizeof(int), 1, f);
-        
-        int trail_length;
-        fread(&trail_length, sizeof(int), 1, f);
-        
-        double *read_x = (double *)malloc(trail_length * sizeof(double));
-        double *read_y = (double *)malloc(trail_length * sizeof(double));
-        
-        fread(read_x, sizeof(double), trail_length, f);
-        fread(read_y, sizeof(double), trail_length, f);
+    if (trail_file_open(&file, TEST_DIR "test_trails.bin") == 0) {
+        const double *read_x = trail_file_x(&file, 0);
+        const double *read_y = trail_file_y(&file, 0);
         
-        passed = (n_rockets == 1) &&
-                 (trail_length == 100) &&
+        passed = (trail_file_count(&file) == 1) &&
+                 (trail_file_length(&file, 0) == 100) &&
+                 read_x && read_y &&
+                 ((uintptr_t)read_x % TRAIL_ALIGN == 0) &&
                  (read_x[0] == 0.0) &&
                  (read_y[99] == 19.8);
         
-        free(read_x);
-        free(read_y);
-        fclose(f);
+        trail_file_close(&file);
+    }
+    
+    // float32 columns, read through the precision-independent accessor
+    if (write_trail_file(TEST_DIR "test_trails32.bin", rockets, 1, 32) == 0 &&
+        trail_file_open(&file, TEST_DIR "test_trails32.bin") == 0) {
+        double x, y;
+        trail_file_point(&file, 0, 99, &x, &y);
+        passed = passed && (trail_file_x(&file, 0) == NULL) &&
+                 (fabs(x - 9.9) < 1e-5) && (fabs(y - 19.8) < 1e-5);
+        trail_file_close(&file);
+    } else {
+        passed = 0;
     }
     
     free(rockets[0].trail_x);
@@ -249,11 +260,15 @@ void test_comment_handling() {
         fclose(f);
     }
     
-    Body bodies[MAX_BODIES];
-    int n = load_bodies(TEST_DIR "test_comments.txt", bodies, MAX_BODIES);
+    SimState state;
+    sim_state_init(&state);
+    int n = load_bodies(TEST_DIR "test_comments.txt", &state);
+    Body *bodies = state.bodies;
     
     int passed = (n == 2) && (bodies[0].mass == 50.0) && (bodies[1].x == 1.0);
     
+    sim_state_free(&state);
+    
     test_result("Comment and whitespace handling", passed);
 }
 
@@ -282,6 +297,454 @@ void test_config_validation() {
     test_result("Configuration parameter parsing", passed);
 }
 
+/**
+ * Test 9: Load more entities than the initial capacity
+ * Storage must grow instead of silently truncating the file
+ */
+void test_load_large_file() {
+    int n_expected = INITIAL_CAPACITY * 40;
+    
+    FILE *f = fopen(TEST_DIR "test_many_bodies.txt", "w");
+    if (f) {
+        fprintf(f, "# Many bodies\n");
+        for (int i = 0; i < n_expected; i++) {
+            fprintf(f, "%d.0 0.0 0.0 0.0 1.0\n", i);
+        }
+        fclose(f);
+    }
+    
+    SimState state;
+    sim_state_init(&state);
+    int n = load_bodies(TEST_DIR "test_many_bodies.txt", &state);
+    
+    int passed = (n == n_expected) &&
+                 (state.body_capacity >= n_expected) &&
+                 (state.bodies[n_expected - 1].x == n_expected - 1);
+    
+    sim_state_free(&state);
+    
+    test_result("Load beyond initial capacity", passed);
+}
+
+/**
+ * Copy the x column of rocket `index` out of a trail file (NULL on failure)
+ */
+static double *read_trail_x(const char *filename, int index, int *length) {
+    TrailFile file;
+    *length = -1;
+    if (trail_file_open(&file, filename) != 0) return NULL;
+    
+    double *x = NULL;
+    if (index < trail_file_count(&file)) {
+        long len = trail_file_length(&file, index);
+        x = (double *)malloc((len + 1) * sizeof(double));
+        for (long j = 0; x && j < len; j++) {
+            double y;
+            trail_file_point(&file, index, j, &x[j], &y);
+        }
+        *length = (int)len;
+    }
+    trail_file_close(&file);
+    return x;
+}
+
+/**
+ * Test 10: Streaming trail sink
+ * Runs past the in-memory trail window; the file must hold every point,
+ * and a spool left mid-run must convert to the flushed prefix
+ */
+void test_trail_sink_streaming() {
+    SimState state;
+    sim_state_init(&state);
+    
+    for (int i = 0; i < 2; i++) {
+        Rocket *r = sim_state_add_rocket(&state);
+        r->y = i;
+        r->vx = 0.001;
+        r->active = 1;
+        rocket_trail_init(r);
+    }
+    
+    SimConfig config;
+    sim_config_default(&config);
+    int steps = 3 * TRAIL_WINDOW;
+    
+    TrailSink sink;
+    int passed = (trail_sink_open(&sink, TEST_DIR "stream_trails.bin", 2, 64) == 0) &&
+                 (sim_state_pack(&state) == 0);
+    state.trail_sink = &sink;
+    
+    for (int s = 0; s < steps && passed; s++) {
+        sim_step(&state, &config);
+        if (s == TRAIL_WINDOW) {
+            // Recover what a crash at this point would leave behind
+            int flushed = state.rockets[0].trail_dropped + state.rockets[0].trail_flushed;
+            int len = 0;
+            trail_spool_convert(sink.spool_path, TEST_DIR "recovered_trails.bin", 64);
+            double *x = read_trail_x(TEST_DIR "recovered_trails.bin", 0, &len);
+            passed = x && (len == flushed) && (len % TRAIL_CHUNK == 0) && (len > 0);
+            free(x);
+        }
+    }
+    
+    passed = passed && (state.rockets[0].trail_length <= TRAIL_WINDOW) &&
+             (trail_sink_close(&sink, state.rockets, state.n_rockets) == 0);
+    
+    int len = 0;
+    double *x = read_trail_x(TEST_DIR "stream_trails.bin", 1, &len);
+    passed = passed && x && (len == steps + 1) && (x[0] == 0.0) &&
+             (fabs(x[steps] - steps * config.dt * 0.001) < 1e-9);
+    free(x);
+    
+    FILE *spool = fopen(TEST_DIR "stream_trails.bin.part", "rb");
+    passed = passed && (spool == NULL);
+    if (spool) fclose(spool);
+    
+    sim_state_free(&state);
+    
+    test_result("Streaming trail sink beyond memory window", passed);
+}
+
+/**
+ * Test 11: BMP output layout (header, bottom-up rows, row padding)
+ */
+void test_bmp_output() {
+    // Width 3: 9 pixel bytes padded to 12 per row
+    Pixel img[3 * 2];
+    for (int i = 0; i < 6; i++) {
+        img[i].r = (unsigned char)(10 * i);
+        img[i].g = (unsigned char)(10 * i + 1);
+        img[i].b = (unsigned char)(10 * i + 2);
+    }
+    
+    int passed = (write_bmp(TEST_DIR "test_image.bmp", img, 3, 2) == 0);
+    
+    unsigned char data[128];
+    size_t size = 0;
+    FILE *f = fopen(TEST_DIR "test_image.bmp", "rb");
+    if (f) {
+        size = fread(data, 1, sizeof(data), f);
+        fclose(f);
+    }
+    
+    passed = passed && (size == (size_t)bmp_file_size(3, 2)) && (size == 54 + 24);
+    if (passed) {
+        int width = data[18] | (data[19] << 8);
+        int height = data[22] | (data[23] << 8);
+        passed = data[0] == 'B' && data[1] == 'M' && data[10] == 54 &&
+                 width == 3 && height == 2 && data[28] == 24;
+        
+        // First stored row is the bottom image row (pixels 3..5), as B, G, R
+        const unsigned char *row0 = data + 54;
+        const unsigned char *row1 = data + 54 + 12;
+        passed = passed && row0[0] == img[3].b && row0[1] == img[3].g &&
+                 row0[2] == img[3].r && row0[8] == img[5].r &&
+                 row0[9] == 0 && row0[11] == 0 &&
+                 row1[0] == img[0].b && row1[8] == img[2].r;
+    }
+    
+    test_result("BMP output layout", passed);
+}
+
+/**
+ * Test 12: Y4M video stream (header, frame marker, BT.601 planes)
+ */
+void test_y4m_output() {
+    // Top row white, bottom row black
+    Pixel img[2 * 2];
+    memset(img, 0, sizeof(img));
+    memset(img, 255, 2 * sizeof(Pixel));
+    
+    VideoSink video;
+    int passed = (video_open(&video, VIDEO_Y4M, TEST_DIR "test_video.y4m", 2, 2, 25, -1) == 0);
+    passed = passed && (video_write_frame(&video, img) == 0);
+    passed = passed && (video_write_frame(&video, img) == 0);
+    passed = passed && (video.frames == 2);
+    passed = (video_close(&video) == 0) && passed;
+    
+    unsigned char data[256];
+    size_t size = 0;
+    FILE *f = fopen(TEST_DIR "test_video.y4m", "rb");
+    if (f) {
+        size = fread(data, 1, sizeof(data), f);
+        fclose(f);
+    }
+    
+    const char *header = "YUV4MPEG2 W2 H2 F25:1 Ip A1:1 C444\n";
+    size_t header_len = strlen(header);
+    size_t frame_len = 6 + 2 * 2 * 3;
+    passed = passed && (size == header_len + 2 * frame_len) &&
+             memcmp(data, header, header_len) == 0;
+    if (passed) {
+        const unsigned char *frame = data + header_len + frame_len;
+        const unsigned char *y = frame + 6;
+        passed = memcmp(frame, "FRAME\n", 6) == 0 &&
+                 y[0] == 235 && y[1] == 235 && y[2] == 16 && y[3] == 16;
+        for (int k = 4; k < 12 && passed; k++) {
+            passed = (y[k] == 128);
+        }
+    }
+    
+    test_result("Y4M video stream", passed);
+}
+
+/**
+ * Test 13: Single options (batch manifest overrides)
+ */
+void test_config_set_option() {
+    SimConfig config;
+    sim_config_default(&config);
+    
+    int passed = config_set_option(&config, "dt", "0.005") == 0 &&
+                 config_set_option(&config, "integrator", "euler") == 0 &&
+                 config_set_option(&config, "batch_threads", "3") == 0 &&
+                 config.dt == 0.005 && config.integrator == INTEGRATOR_EULER &&
+                 config.batch_threads == 3;
+    
+    // Unknown keys and unparsable numbers are reported, the config is kept
+    passed = passed &&
+             config_set_option(&config, "no_such_key", "1") == -1 &&
+             config_set_option(&config, "steps", "many") == -1 &&
+             config.steps == STEPS;
+    
+    test_result("Single configuration options", passed);
+}
+
+/**
+ * Test 14: Output paths (nbody --output <dir>)
+ */
+void test_output_path() {
+    char path[PATH_LEN];
+    int passed = 1;
+    
+    output_path(path, sizeof(path), "", "frames.log");
+    passed = passed && strcmp(path, "frames.log") == 0;
+    output_path(path, sizeof(path), "jobs/42", "frames.log");
+    passed = passed && strcmp(path, "jobs/42/frames.log") == 0;
+    output_path(path, sizeof(path), "jobs/42/", "frames.log");
+    passed = passed && strcmp(path, "jobs/42/frames.log") == 0;
+    
+    // Absolute names and stdout are not moved
+    output_path(path, sizeof(path), "jobs/42", "/tmp/run.y4m");
+    passed = passed && strcmp(path, "/tmp/run.y4m") == 0;
+    output_path(path, sizeof(path), "jobs/42", "-");
+    passed = passed && strcmp(path, "-") == 0;
+    
+    test_result("Output directory paths", passed);
+}
+
+/**
+ * Test 15: Fast text parser
+ * Every number must be bitwise what strtod() gives, and lines follow the
+ * old sscanf() rules
+ */
+void test_fast_text_parser() {
+    const char *cases[] = {
+        "0", "-0", "+1.5", "2.", ".25", "-.5e-3", "1e", "1e+", "6.674e-11",
+        "0.1", "9007199254740993", "123456789012345678901234", "1e400", "4.9e-324",
+        "2.2250738585072014e-308", "0x1p3", "inf", "1.0abc"
+    };
+    int passed = 1;
+    char text[64];
+    
+    for (int i = 0; i < 20000 + (int)(sizeof(cases) / sizeof(cases[0])); i++) {
+        const char *s = text;
+        if (i < (int)(sizeof(cases) / sizeof(cases[0]))) {
+            s = cases[i];
+        } else {
+            const char *formats[] = {"%.17g", "%.3f", "%.6e", "%g"};
+            double v = (rand() / (double)RAND_MAX - 0.5) * pow(10.0, rand() % 40 - 20);
+            snprintf(text, sizeof(text), formats[i % 4], v);
+        }
+        double fast = 0.0;
+        char *end = NULL;
+        double slow = strtod(s, &end);
+        const char *stop = input_parse_double(s, &fast);
+        passed = passed && stop == end && memcmp(&fast, &slow, sizeof(double)) == 0;
+    }
+    passed = passed && input_parse_double("abc", &(double){0}) == NULL;
+    
+    // Short lines and a bad field are skipped; text after the last field is not read
+    FILE *f = fopen(TEST_DIR "test_parser.txt", "w");
+    if (f) {
+        fprintf(f, "# x y vx vy\n");
+        fprintf(f, "1.0 2.0 3.0\n");
+        fprintf(f, "1.0 two 3.0 4.0\n");
+        fprintf(f, "\t-1.5  2.5\t0.125 1e-3 trailing words\r\n");
+        fprintf(f, "\n");
+        fprintf(f, "7 8 9 10");
+        fclose(f);
+    }
+    SimState state;
+    sim_state_init(&state);
+    int n = load_rockets(TEST_DIR "test_parser.txt", &state);
+    passed = passed && n == 2 &&
+             state.rockets[0].x == -1.5 && state.rockets[0].vy == 1e-3 &&
+             state.rockets[1].x == 7.0 && state.rockets[1].vy == 10.0;
+    sim_state_free(&state);
+    
+    // A pipe cannot be rewound: the bytes probed for the binary magic
+    // must still be parsed (the comment and part of the first rocket)
+    FILE *pipe = popen("cat " TEST_DIR "test_rockets.txt", "r");
+    double *values = NULL;
+    long count = pipe ? input_read(pipe, "pipe", INPUT_ROCKET_FIELDS, &values) : -1;
+    if (pipe) pclose(pipe);
+    passed = passed && count == 2 && values[0] == 2.0 && values[3] == 1.732 &&
+             values[4] == -3.0;
+    free(values);
+    
+    test_result("Fast text parser matches strtod", passed);
+}
+
+/**
+ * Test 16: Binary bodies and rockets files
+ */
+void test_binary_input() {
+    SimState text, binary;
+    sim_state_init(&text);
+    sim_state_init(&binary);
+    int passed = load_bodies(TEST_DIR "test_bodies.txt", &text) == 3 &&
+                 load_rockets(TEST_DIR "test_rockets.txt", &text) == 2 &&
+                 input_write_bodies(TEST_DIR "test_bodies.bin", text.bodies, text.n_bodies) == 0 &&
+                 input_write_rockets(TEST_DIR "test_rockets.bin", text.rockets,
+                                     text.n_rockets) == 0 &&
+                 load_bodies(TEST_DIR "test_bodies.bin", &binary) == 3 &&
+                 load_rockets(TEST_DIR "test_rockets.bin", &binary) == 2;
+    
+    for (int i = 0; passed && i < 3; i++) {
+        passed = binary.bodies[i].x == text.bodies[i].x &&
+                 binary.bodies[i].vy == text.bodies[i].vy &&
+                 binary.bodies[i].mass == text.bodies[i].mass;
+    }
+    for (int i = 0; passed && i < 2; i++) {
+        passed = binary.rockets[i].x == text.rockets[i].x &&
+                 binary.rockets[i].vy == text.rockets[i].vy &&
+                 binary.rockets[i].active && binary.rockets[i].trail_length == 1;
+    }
+    sim_state_free(&text);
+    sim_state_free(&binary);
+    
+    // A rockets file is not a bodies file, and a cut-off file is refused
+    sim_state_init(&binary);
+    passed = passed && load_bodies(TEST_DIR "test_rockets.bin", &binary) == -1;
+    FILE *in = fopen(TEST_DIR "test_rockets.bin", "rb");
+    FILE *out = fopen(TEST_DIR "test_truncated.bin", "wb");
+    if (in && out) {
+        char bytes[sizeof(InputHeader) + 3 * sizeof(double)];
+        size_t got = fread(bytes, 1, sizeof(bytes), in);
+        fwrite(bytes, 1, got, out);
+    }
+    if (in) fclose(in);
+    if (out) fclose(out);
+    passed = passed && load_rockets(TEST_DIR "test_truncated.bin", &binary) == -1 &&
+             binary.n_rockets == 0;
+    sim_state_free(&binary);
+    
+    test_result("Binary bodies and rockets input", passed);
+}
+
+/**
+ * Test 17: Trail statistics
+ * Blocked statistics are bitwise those of a plain point-by-point loop,
+ * also when added in chunks or from float32 columns
+ */
+void test_trail_stats() {
+    const long n = 1003;
+    double *x = (double *)malloc(n * sizeof(double));
+    double *y = (double *)malloc(n * sizeof(double));
+    float *fx = (float *)malloc(n * sizeof(float));
+    float *fy = (float *)malloc(n * sizeof(float));
+    int passed = x && y && fx && fy;
+    
+    double path = 0.0, max_dist = 0.0, min_dist = INFINITY;
+    double min_x = INFINITY, max_x = -INFINITY;
+    for (long j = 0; passed && j < n; j++) {
+        x[j] = 10.0 * sin(0.01 * j) + (rand() / (double)RAND_MAX - 0.5);
+        y[j] = 7.0 * cos(0.013 * j) + (rand() / (double)RAND_MAX - 0.5);
+        fx[j] = (float)x[j];
+        fy[j] = (float)y[j];
+        double dist = sqrt(x[j] * x[j] + y[j] * y[j]);
+        if (dist > max_dist) max_dist = dist;
+        if (dist < min_dist) min_dist = dist;
+        if (x[j] < min_x) min_x = x[j];
+        if (x[j] > max_x) max_x = x[j];
+        if (j > 0) {
+            double dx = x[j] - x[j - 1], dy = y[j] - y[j - 1];
+            path += sqrt(dx * dx + dy * dy);
+        }
+    }
+    
+    TrailStats whole, chunked, narrow;
+    trail_stats_init(&whole);
+    trail_stats_init(&chunked);
+    trail_stats_init(&narrow);
+    if (passed) {
+        trail_stats_add(&whole, x, y, n);
+        trail_stats_add(&chunked, x, y, 1);
+        trail_stats_add(&chunked, x + 1, y + 1, 300);
+        trail_stats_add(&chunked, x + 301, y + 301, n - 301);
+        trail_stats_add_float(&narrow, fx, fy, n);
+    }
+    passed = passed && whole.points == n && whole.path_length == path &&
+             sqrt(whole.max_d2) == max_dist && sqrt(whole.min_d2) == min_dist &&
+             whole.min_x == min_x && whole.max_x == max_x &&
+             whole.first_x == x[0] && whole.last_y == y[n - 1] &&
+             memcmp(&whole, &chunked, sizeof(TrailStats)) == 0 &&
+             narrow.points == n && fabs(narrow.path_length - path) < 1e-3 * path;
+    printf("  %s kernel, path %.6f\n", trail_stats_kernel(), whole.path_length);
+    
+    free(x);
+    free(y);
+    free(fx);
+    free(fy);
+    test_result("Trail statistics match a plain loop", passed);
+}
+
+/**
+ * Test 18: ffmpeg pipe
+ * The encoder command must get through /bin/sh: a stub ffmpeg on PATH
+ * receives the raw frames and exits cleanly
+ */
+void test_ffmpeg_pipe() {
+    const int w = 3, h = 2;
+    system("mkdir -p " TEST_DIR "stub_bin");
+    FILE *f = fopen(TEST_DIR "stub_bin/ffmpeg", "w");
+    if (f) {
+        // The last argument is the output file; frames go there raw
+        fprintf(f, "#!/bin/sh\nfor arg; do out=$arg; done\ncat > \"$out\"\n");
+        fclose(f);
+    }
+    system("chmod +x " TEST_DIR "stub_bin/ffmpeg");
+    
+    const char *old_path = getenv("PATH");
+    char saved[4096], path[4096 + 64];
+    snprintf(saved, sizeof(saved), "%s", old_path ? old_path : "");
+    snprintf(path, sizeof(path), TEST_DIR "stub_bin:%s", saved);
+    setenv("PATH", path, 1);
+    
+    Pixel img[3 * 2];
+    memset(img, 7, sizeof(img));
+    VideoSink video;
+    int passed = (video_open(&video, VIDEO_FFMPEG, TEST_DIR "test_video.raw", w, h, 25, -1) == 0);
+    passed = passed && (video_write_frame(&video, img) == 0);
+    passed = passed && (video_write_frame(&video, img) == 0);
+    passed = (video_close(&video) == 0) && passed;
+    setenv("PATH", saved, 1);
+    
+    long size = -1;
+    f = fopen(TEST_DIR "test_video.raw", "rb");
+    if (f) {
+        fseek(f, 0, SEEK_END);
+        size = ftell(f);
+        fclose(f);
+    }
+    passed = passed && size == 2L * w * h * (long)sizeof(Pixel);
+    
+    remove(TEST_DIR "test_video.raw");
+    system("rm -rf " TEST_DIR "stub_bin");
+    test_result("ffmpeg pipe through the shell", passed);
+}
+
 int main() {
     printf("\n");
     printf("====================================\n");
@@ -300,6 +763,16 @@ int main() {
     test_save_rocket_data();
     test_comment_handling();
     test_config_validation();
+    test_load_large_file();
+    test_trail_sink_streaming();
+    test_bmp_output();
+    test_y4m_output();
+    test_config_set_option();
+    test_output_path();
+    test_fast_text_parser();
+    test_binary_input();
+    test_trail_stats();
+    test_ffmpeg_pipe();
     
     printf("\n====================================\n");
     printf("Results: %d/%d tests passed\n", tests_passed, tests_run);
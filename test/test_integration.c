@@ -31,29 +31,29 @@ void test_result(const char *test_name, int passed) {
  * Test initialization → simulation → output generation
  */
 void test_complete_workflow() {
-    Body bodies[MAX_BODIES];
-    Rocket rockets[MAX_ROCKETS];
-    int n_bodies, n_rockets;
+    SimState state;
+    sim_state_init(&state);
+    SimConfig config;
+    sim_config_default(&config);
+    config.steps = 100;
     
     // Initialize default configuration
-    init_bodies_default(bodies, &n_bodies);
-    init_rockets_default(rockets, &n_rockets);
+    init_bodies_default(&state);
+    init_rockets_default(&state);
+    sim_state_pack(&state);
     
     // Run short simulation
-    for (int step = 0; step < 100; step++) {
-        update_bodies(bodies, n_bodies, 0.01, 1.0);
-        update_rockets(rockets, n_rockets, bodies, n_bodies, 0.01, 1.0);
+    for (int step = 0; step < config.steps; step++) {
+        sim_step(&state, &config);
     }
+    sim_state_unpack(&state);
     
     // Verify simulation ran
-    int passed = (rockets[0].trail_length > 1) &&
-                 (rockets[0].active == 1);
+    int passed = (state.rockets[0].trail_length > 1) &&
+                 (state.rockets[0].active == 1);
     
     // Clean up
-    for (int i = 0; i < n_rockets; i++) {
-        free(rockets[i].trail_x);
-        free(rockets[i].trail_y);
-    }
+    sim_state_free(&state);
     
     test_result("Complete simulation workflow", passed);
 }
@@ -268,34 +268,26 @@ void test_file_io_roundtrip() {
     // Save to binary
     save_rocket_trails_bin(TEST_DIR "roundtrip.bin", rockets, 2);
     
-    // Read back
-    FILE *f = fopen(TEST_DIR "roundtrip.bin", "rb");
+    // Read back, visiting rockets out of order through the index
+    TrailFile file;
     int passed = 0;
     
-    if (f) {
-        int n;
-        fread(&n, sizeof(int), 1, f);
+    if (trail_file_open(&file, TEST_DIR "roundtrip.bin") == 0) {
+        int n = trail_file_count(&file);
         
         passed = (n == 2);
         
-        for (int i = 0; i < n && passed; i++) {
-            int len;
-            double *tx = (double *)malloc(50 * sizeof(double));
-            double *ty = (double *)malloc(50 * sizeof(double));
-            
-            fread(&len, sizeof(int), 1, f);
-            fread(tx, sizeof(double), len, f);
-            fread(ty, sizeof(double), len, f);
+        for (int i = n - 1; i >= 0 && passed; i--) {
+            long len = trail_file_length(&file, i);
+            const double *tx = trail_file_x(&file, i);
+            const double *ty = trail_file_y(&file, i);
             
-            passed = passed && (len == 50) && 
+            passed = passed && (len == 50) && tx && ty &&
                      (fabs(tx[0] - i) < EPSILON) &&
                      (fabs(ty[49] - (9.8 + i)) < EPSILON);
-            
-            free(tx);
-            free(ty);
         }
         
-        fclose(f);
+        trail_file_close(&file);
     }
     
     for (int i = 0; i < 2; i++) {
@@ -347,6 +339,1124 @@ void test_escape_velocity() {
     test_result("Escape velocity verification", passed);
 }
 
+/**
+ * Build a reproducible state with several body and rocket chunks
+ */
+static void build_parallel_state(SimState *state, int n_bodies, int n_rockets) {
+    sim_state_init(state);
+    
+    for (int i = 0; i < n_bodies; i++) {
+        Body *b = sim_state_add_body(state);
+        double angle = 2.0 * M_PI * i / n_bodies;
+        double radius = 2.0 + (i % 17) * 0.3;
+        b->x = radius * cos(angle);
+        b->y = radius * sin(angle);
+        b->vx = -sin(angle);
+        b->vy = cos(angle);
+        b->mass = (i == 0) ? 100.0 : 0.5;
+    }
+    
+    for (int i = 0; i < n_rockets; i++) {
+        Rocket *r = sim_state_add_rocket(state);
+        r->x = 4.0 + (i % 100) * 0.05;
+        r->y = -3.0 + (i / 100) * 0.05;
+        r->vx = 0.3;
+        r->vy = 1.5;
+        r->active = 1;
+    }
+    
+    sim_state_pack(state);
+}
+
+/**
+ * Test 8: Threaded step determinism
+ * Results must be bitwise-identical for any thread count
+ */
+void test_parallel_determinism() {
+    int thread_counts[] = {0, 1, 3, 8};
+    int n_bodies = 150;
+    int n_rockets = 2500;
+    
+    SimState ref;
+    build_parallel_state(&ref, n_bodies, n_rockets);
+    SimConfig config;
+    sim_config_default(&config);
+    config.dt = 0.005;
+    config.steps = 50;
+    config.threads = thread_counts[0];
+    for (int step = 0; step < config.steps; step++) {
+        sim_step(&ref, &config);
+    }
+    
+    int passed = 1;
+    for (int t = 1; t < 4; t++) {
+        SimState state;
+        build_parallel_state(&state, n_bodies, n_rockets);
+        config.threads = thread_counts[t];
+        for (int step = 0; step < config.steps; step++) {
+            sim_step(&state, &config);
+        }
+        
+        size_t body_bytes = n_bodies * sizeof(double);
+        size_t rocket_bytes = n_rockets * sizeof(double);
+        passed = passed &&
+                 memcmp(ref.body_soa.x, state.body_soa.x, body_bytes) == 0 &&
+                 memcmp(ref.body_soa.vy, state.body_soa.vy, body_bytes) == 0 &&
+                 memcmp(ref.rocket_soa.x, state.rocket_soa.x, rocket_bytes) == 0 &&
+                 memcmp(ref.rocket_soa.vy, state.rocket_soa.vy, rocket_bytes) == 0;
+        
+        sim_state_free(&state);
+    }
+    
+    sim_state_free(&ref);
+    
+    test_result("Threaded step bitwise determinism", passed);
+}
+
+/**
+ * Read a whole file into a new buffer (NULL on failure)
+ */
+static unsigned char *read_file(const char *filename, long *size) {
+    FILE *f = fopen(filename, "rb");
+    if (!f) return NULL;
+    
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char *data = (unsigned char *)malloc(*size);
+    if (data && fread(data, 1, *size, f) != (size_t)*size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    return data;
+}
+
+/**
+ * Test 9: Asynchronous frame pipeline
+ * Frames queued while stepping continues must match frames rendered
+ * synchronously at the same steps
+ */
+void test_frame_pipeline() {
+    const int n_frames = 6;
+    const int frame_interval = 20;
+    SimState state;
+    build_parallel_state(&state, 3, 4);
+    for (int i = 0; i < state.n_rockets; i++) {
+        rocket_trail_init(&state.rockets[i]);
+    }
+    
+    SimConfig config;
+    sim_config_default(&config);
+    
+    Viewport view;
+    viewport_init(&view, WIDTH, HEIGHT, 50.0, 0.0, 0.0);
+    
+    // Two slots for six frames forces the simulation to wait on workers
+    FramePipeline pipeline;
+    int passed = (frame_pipeline_start(&pipeline, 2, 2, &view, 1, NULL) == 0);
+    Pixel *img = (Pixel *)malloc(WIDTH * HEIGHT * sizeof(Pixel));
+    passed = passed && img;
+    
+    for (int f = 0; f < n_frames && passed; f++) {
+        for (int step = 0; step < frame_interval; step++) {
+            sim_step(&state, &config);
+        }
+        sim_state_unpack(&state);
+        
+        char name[64];
+        sprintf(name, TEST_DIR "async_%d.bmp", f);
+        passed = frame_pipeline_submit(&pipeline, name, NULL, state.bodies, state.n_bodies,
+                                       state.rockets, state.n_rockets) == 0;
+        
+        sprintf(name, TEST_DIR "sync_%d.bmp", f);
+        render(state.bodies, state.n_bodies, state.rockets, state.n_rockets, img, &view, 1);
+        passed = passed && write_bmp(name, img, WIDTH, HEIGHT) == 0;
+    }
+    passed = (frame_pipeline_finish(&pipeline) == 0) && passed;
+    
+    for (int f = 0; f < n_frames && passed; f++) {
+        char name[64];
+        long async_size = 0, sync_size = 0;
+        sprintf(name, TEST_DIR "async_%d.bmp", f);
+        unsigned char *a = read_file(name, &async_size);
+        sprintf(name, TEST_DIR "sync_%d.bmp", f);
+        unsigned char *b = read_file(name, &sync_size);
+        
+        passed = a && b && async_size == sync_size &&
+                 memcmp(a, b, async_size) == 0;
+        free(a);
+        free(b);
+    }
+    
+    free(img);
+    sim_state_free(&state);
+    
+    test_result("Asynchronous frame pipeline output", passed);
+}
+
+/**
+ * Test 10: Incremental trail rendering
+ * Only new segments are drawn, and older ones fade by age
+ */
+void test_incremental_render() {
+    Rocket rocket;
+    memset(&rocket, 0, sizeof(Rocket));
+    double xs[3] = {0.0, 1.0, 2.0};
+    double ys[3] = {0.0, 0.0, 0.0};
+    rocket.trail_x = xs;
+    rocket.trail_y = ys;
+    rocket.trail_capacity = 3;
+    rocket.trail_length = 2;
+    
+    Viewport view;
+    viewport_init(&view, WIDTH, HEIGHT, 50.0, 0.0, 0.0);
+    
+    TrailCanvas canvas;
+    Pixel *img = (Pixel *)malloc(WIDTH * HEIGHT * sizeof(Pixel));
+    int passed = img && (trail_canvas_init(&canvas, &view, 1, 0.5) == 0);
+    if (passed) {
+        // Scale 50: (0,0)-(1,0) covers x 400..450, (1,0)-(2,0) covers 450..500
+        long y0 = (long)(HEIGHT / 2) * WIDTH;
+        trail_canvas_update(&canvas, &rocket, 1, &view);
+        passed = canvas.stamp[y0 + 420] == 1 && canvas.stamp[y0 + 470] == 0 &&
+                 canvas.drawn[0] == 2;
+        
+        rocket.trail_length = 3;
+        trail_canvas_update(&canvas, &rocket, 1, &view);
+        passed = passed && canvas.stamp[y0 + 420] == 1 &&
+                 canvas.stamp[y0 + 470] == 2 && canvas.drawn[0] == 3;
+        
+        // One frame old: half brightness; newest: full brightness
+        render_composite(&canvas, NULL, 0, &rocket, 0, img, &view);
+        passed = passed && img[y0 + 420].r == 128 && img[y0 + 420].g == 64 &&
+                 img[y0 + 470].r == 255 && img[y0 + 470].b == 127 &&
+                 img[y0 + WIDTH * 10 + 420].r == 0;
+        
+        trail_canvas_free(&canvas);
+    }
+    free(img);
+    
+    test_result("Incremental trail rendering", passed);
+}
+
+/**
+ * Test 11: Runtime viewport with a row stride
+ * An off-center view drawn into a wider buffer must match the same view
+ * drawn contiguously and leave the padding untouched
+ */
+void test_viewport_stride() {
+    SimState state;
+    build_parallel_state(&state, 3, 4);
+    for (int i = 0; i < state.n_rockets; i++) {
+        rocket_trail_init(&state.rockets[i]);
+    }
+    SimConfig config;
+    sim_config_default(&config);
+    for (int step = 0; step < 200; step++) {
+        sim_step(&state, &config);
+    }
+    sim_state_unpack(&state);
+    
+    const int w = 121, h = 90, stride = 128;
+    Viewport view;
+    viewport_init(&view, w, h, 0.0, 0.5, -0.25);
+    
+    // Default scale keeps the field of view: 50 px/unit at 800, so 90/800 of it
+    int passed = fabs(view.scale - 50.0 * h / 800) < 1e-12 &&
+                 viewport_px(&view, 0.5) == w / 2 && viewport_py(&view, -0.25) == h / 2;
+    
+    Pixel *flat = (Pixel *)malloc(w * h * sizeof(Pixel));
+    Pixel *wide = (Pixel *)malloc(stride * h * sizeof(Pixel));
+    passed = passed && flat && wide;
+    if (passed) {
+        render(state.bodies, state.n_bodies, state.rockets, state.n_rockets, flat, &view, 1);
+        
+        memset(wide, 0xAB, stride * h * sizeof(Pixel));
+        Viewport strided = view;
+        strided.stride = stride;
+        render(state.bodies, state.n_bodies, state.rockets, state.n_rockets, wide, &strided, 1);
+        
+        long lit = 0;
+        for (int y = 0; y < h && passed; y++) {
+            passed = memcmp(&wide[y * stride], &flat[y * w], w * sizeof(Pixel)) == 0;
+            for (int x = w; x < stride && passed; x++) {
+                passed = wide[y * stride + x].r == 0xAB && wide[y * stride + x].b == 0xAB;
+            }
+            for (int x = 0; x < w; x++) {
+                lit += flat[y * w + x].r > 20;
+            }
+        }
+        // Something brighter than the grid (level 20) was drawn
+        passed = passed && lit > 0;
+    }
+    
+    free(flat);
+    free(wide);
+    sim_state_free(&state);
+    
+    test_result("Viewport with row stride", passed);
+}
+
+/**
+ * Test 12: Tiled rasterizer
+ * Clipped, tile-parallel lines and circles must match draw_line() and
+ * draw_circle() pixel for pixel, including primitives that cross tile
+ * edges or leave the image
+ */
+void test_tiled_rasterizer() {
+    const int w = 300, h = 200, n = 2000;
+    Viewport view;
+    viewport_init(&view, w, h, 0.0, 0.0, 0.0);
+    
+    Pixel *expected = (Pixel *)calloc(w * h, sizeof(Pixel));
+    Pixel *tiled = (Pixel *)calloc(w * h, sizeof(Pixel));
+    Rasterizer ras;
+    int passed = expected && tiled && raster_begin(&ras, tiled, &view, 3) == 0;
+    
+    if (passed) {
+        srand(12345);
+        for (int i = 0; i < n; i++) {
+            RasterPrim *p = raster_reserve(&ras, 1);
+            p->kind = (i % 10 == 9) ? RASTER_CIRCLE : RASTER_LINE;
+            p->x0 = rand() % (w + 400) - 200;
+            p->y0 = rand() % (h + 400) - 200;
+            p->x1 = (p->kind == RASTER_CIRCLE) ? rand() % 12 : rand() % (w + 400) - 200;
+            p->y1 = rand() % (h + 400) - 200;
+            p->color.r = (unsigned char)i;
+            p->color.g = (unsigned char)(i >> 8);
+            p->color.b = (unsigned char)(p->kind * 100);
+            
+            if (p->kind == RASTER_CIRCLE) {
+                draw_circle(expected, &view, p->x0, p->y0, p->x1,
+                            p->color.r, p->color.g, p->color.b);
+            } else {
+                draw_line(expected, &view, p->x0, p->y0, p->x1, p->y1,
+                          p->color.r, p->color.g, p->color.b);
+            }
+            raster_commit(&ras, 1);
+            
+            // Several flushes: later batches must draw over earlier ones
+            if (i % 700 == 699) raster_flush(&ras);
+        }
+        raster_end(&ras);
+        passed = memcmp(expected, tiled, w * h * sizeof(Pixel)) == 0;
+    }
+    
+    // Whole frames: any thread count gives the same image
+    SimState state;
+    build_parallel_state(&state, 3, 6);
+    for (int i = 0; i < state.n_rockets; i++) {
+        rocket_trail_init(&state.rockets[i]);
+    }
+    SimConfig config;
+    sim_config_default(&config);
+    for (int step = 0; step < 300; step++) {
+        sim_step(&state, &config);
+    }
+    sim_state_unpack(&state);
+    
+    Pixel *serial = (Pixel *)malloc(WIDTH * HEIGHT * sizeof(Pixel));
+    Pixel *threaded = (Pixel *)malloc(WIDTH * HEIGHT * sizeof(Pixel));
+    passed = passed && serial && threaded;
+    if (passed) {
+        Viewport full;
+        viewport_init(&full, WIDTH, HEIGHT, 0.0, 0.0, 0.0);
+        render(state.bodies, state.n_bodies, state.rockets, state.n_rockets, serial, &full, 1);
+        render(state.bodies, state.n_bodies, state.rockets, state.n_rockets, threaded, &full, 4);
+        passed = memcmp(serial, threaded, WIDTH * HEIGHT * sizeof(Pixel)) == 0;
+    }
+    
+    free(expected);
+    free(tiled);
+    free(serial);
+    free(threaded);
+    sim_state_free(&state);
+    
+    test_result("Tiled rasterizer matches per-pixel drawing", passed);
+}
+
+/**
+ * Test 13: Density rendering
+ * The heatmap must not depend on the splat thread count, must leave its
+ * buffers clear for the next frame, and must skip inactive particles
+ */
+void test_density_render() {
+    const int w = 160, h = 120, n = 20000;
+    Viewport view;
+    viewport_init(&view, w, h, 10.0, 0.5, -0.25);
+    
+    double *x = (double *)malloc(n * sizeof(double));
+    double *y = (double *)malloc(n * sizeof(double));
+    unsigned char *active = (unsigned char *)malloc(n);
+    Pixel *serial = (Pixel *)malloc(w * h * sizeof(Pixel));
+    Pixel *threaded = (Pixel *)malloc(w * h * sizeof(Pixel));
+    Pixel *again = (Pixel *)malloc(w * h * sizeof(Pixel));
+    DensityMap one, three;
+    int passed = x && y && active && serial && threaded && again &&
+                 density_init(&one, &view, 1) == 0 && density_init(&three, &view, 3) == 0;
+    
+    if (passed) {
+        // Clustered points, some off-image, every fifth one inactive
+        srand(777);
+        for (int i = 0; i < n; i++) {
+            double r = 9.0 * rand() / RAND_MAX;
+            double a = 6.283185307 * rand() / RAND_MAX;
+            x[i] = 0.5 + r * r / 9.0 * cos(a);
+            y[i] = -0.25 + r * sin(a);
+            active[i] = (i % 5 != 0);
+        }
+        
+        render_density(&one, NULL, 0, x, y, active, n, serial, &view);
+        render_density(&three, NULL, 0, x, y, active, n, threaded, &view);
+        render_density(&three, NULL, 0, x, y, active, n, again, &view);
+        passed = memcmp(serial, threaded, w * h * sizeof(Pixel)) == 0 &&
+                 memcmp(serial, again, w * h * sizeof(Pixel)) == 0;
+        int lit = 0;
+        for (int p = 0; p < w * h; p++) {
+            if (serial[p].r > GRID_LEVEL) lit++;
+        }
+        passed = passed && lit > w * h / 10;
+        
+        // Move the active particles off the image: only the grid is left,
+        // so inactive particles (and the previous frame) leave no trace
+        for (int i = 0; i < n; i++) {
+            if (active[i]) x[i] = 1e30;
+        }
+        render_density(&three, NULL, 0, x, y, active, n, again, &view);
+        for (int p = 0; p < w * h; p++) {
+            if (again[p].r > GRID_LEVEL) passed = 0;
+        }
+        
+        density_free(&one);
+        density_free(&three);
+    }
+    
+    free(x);
+    free(y);
+    free(active);
+    free(serial);
+    free(threaded);
+    free(again);
+    
+    test_result("Density render independent of thread count", passed);
+}
+
+/**
+ * Test 14: Checkpoint and resume
+ * A run restored from a mid-run checkpoint must finish bit for bit
+ * where the uninterrupted run does
+ */
+void test_checkpoint_resume() {
+    const int n_bodies = 20, n_rockets = 300, steps = 60, split = 25;
+    SimConfig config;
+    sim_config_default(&config);
+    config.dt = 0.005;
+    config.steps = steps;
+    config.block_steps = 1;
+    
+    SimState ref;
+    build_parallel_state(&ref, n_bodies, n_rockets);
+    for (int step = 0; step < steps; step++) {
+        sim_step(&ref, &config);
+    }
+    
+    SimState first, resumed;
+    build_parallel_state(&first, n_bodies, n_rockets);
+    sim_state_init(&resumed);
+    for (int step = 0; step < split; step++) {
+        sim_step(&first, &config);
+    }
+    sim_state_unpack(&first);
+    
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    header.step = split;
+    SimConfig loaded;
+    int passed = checkpoint_save(TEST_DIR "checkpoint.bin", &header, &first, &config, NULL) == 0;
+    sim_state_free(&first);
+    passed = passed &&
+             checkpoint_load(TEST_DIR "checkpoint.bin", &header, &resumed, &loaded) == 0 &&
+             header.step == split && loaded.steps == steps && resumed.n_rockets == n_rockets;
+    
+    if (passed) {
+        for (int step = split; step < steps; step++) {
+            sim_step(&resumed, &loaded);
+        }
+        size_t body_bytes = n_bodies * sizeof(double);
+        size_t rocket_bytes = n_rockets * sizeof(double);
+        passed = resumed.time == ref.time &&
+                 memcmp(ref.body_soa.x, resumed.body_soa.x, body_bytes) == 0 &&
+                 memcmp(ref.body_soa.vy, resumed.body_soa.vy, body_bytes) == 0 &&
+                 memcmp(ref.rocket_soa.x, resumed.rocket_soa.x, rocket_bytes) == 0 &&
+                 memcmp(ref.rocket_soa.vy, resumed.rocket_soa.vy, rocket_bytes) == 0;
+        sim_state_free(&resumed);
+    }
+    sim_state_free(&ref);
+    
+    test_result("Checkpoint resume bitwise continuation", passed);
+}
+
+/**
+ * Test 15: Rocket-only steps against a body ephemeris
+ * Rockets must follow exactly the trajectories of a full run, for each
+ * integrator and solver
+ */
+void test_body_ephemeris() {
+    const int n_bodies = 12, n_rockets = 200, steps = 40;
+    int integrators[] = {INTEGRATOR_KDK, INTEGRATOR_EULER, INTEGRATOR_KDK};
+    int solvers[] = {SOLVER_DIRECT, SOLVER_DIRECT, SOLVER_BH};
+    int passed = 1;
+    
+    for (int c = 0; c < 3; c++) {
+        SimConfig config;
+        sim_config_default(&config);
+        config.dt = 0.005;
+        config.steps = steps;
+        config.integrator = integrators[c];
+        config.solver = solvers[c];
+        
+        SimState full, rockets_only;
+        build_parallel_state(&full, n_bodies, n_rockets);
+        build_parallel_state(&rockets_only, n_bodies, n_rockets);
+        BodyEphemeris eph;
+        if (!ephemeris_supported(&config) ||
+            ephemeris_build(&eph, full.bodies, n_bodies, &config, 1) != 0) {
+            passed = 0;
+        } else {
+            rockets_only.ephemeris = &eph;
+            for (int step = 0; step < steps; step++) {
+                sim_step(&full, &config);
+                sim_step(&rockets_only, &config);
+            }
+            size_t bytes = n_rockets * sizeof(double);
+            passed = passed &&
+                     memcmp(full.rocket_soa.x, rockets_only.rocket_soa.x, bytes) == 0 &&
+                     memcmp(full.rocket_soa.vy, rockets_only.rocket_soa.vy, bytes) == 0 &&
+                     memcmp(full.body_soa.x, rockets_only.body_soa.x,
+                            n_bodies * sizeof(double)) == 0;
+            ephemeris_free(&eph);
+        }
+        sim_state_free(&full);
+        sim_state_free(&rockets_only);
+    }
+    
+    // Block time-steps predict bodies between steps: not supported
+    SimConfig block;
+    sim_config_default(&block);
+    block.block_steps = 1;
+    passed = passed && !ephemeris_supported(&block);
+    
+    test_result("Body ephemeris rocket-only steps", passed);
+}
+
+/**
+ * Test 16: Ephemeris files
+ * A mapped stride-1 file reproduces a full run exactly, a stride-4 file
+ * comes close, and a file for other settings is refused
+ */
+void test_ephemeris_file() {
+    const char *file = TEST_DIR "bodies.eph";
+    const int n_bodies = 12, n_rockets = 200, steps = 40;
+    int strides[] = {1, 4};
+    double max_error[2] = {0.0, 0.0};
+    int passed = 1;
+    
+    for (int c = 0; c < 2; c++) {
+        SimConfig config;
+        sim_config_default(&config);
+        config.dt = 0.005;
+        config.steps = steps;
+        config.ephemeris_stride = strides[c];
+        
+        SimState full, rockets_only;
+        build_parallel_state(&full, n_bodies, n_rockets);
+        build_parallel_state(&rockets_only, n_bodies, n_rockets);
+        BodyEphemeris eph;
+        if (ephemeris_write(file, full.bodies, n_bodies, &config, strides[c]) != 0 ||
+            ephemeris_open(&eph, file, full.bodies, n_bodies, &config) != 0) {
+            passed = 0;
+        } else {
+            rockets_only.ephemeris = &eph;
+            for (int step = 0; step < steps; step++) {
+                sim_step(&full, &config);
+                sim_step(&rockets_only, &config);
+            }
+            for (int i = 0; i < n_rockets; i++) {
+                double dx = full.rocket_soa.x[i] - rockets_only.rocket_soa.x[i];
+                double dy = full.rocket_soa.y[i] - rockets_only.rocket_soa.y[i];
+                double error = sqrt(dx * dx + dy * dy);
+                if (error > max_error[c]) max_error[c] = error;
+            }
+            ephemeris_free(&eph);
+        }
+        sim_state_free(&full);
+        sim_state_free(&rockets_only);
+    }
+    printf("  Rocket position error: stride 1 %.3e, stride 4 %.3e\n",
+           max_error[0], max_error[1]);
+    passed = passed && max_error[0] == 0.0 && max_error[1] < 1e-6;
+    
+    // The stride-4 file must not serve a run with another dt or stride
+    SimState state;
+    build_parallel_state(&state, n_bodies, 0);
+    SimConfig other;
+    sim_config_default(&other);
+    other.dt = 0.01;
+    other.steps = steps;
+    other.ephemeris_stride = 4;
+    BodyEphemeris eph;
+    passed = passed && ephemeris_open(&eph, file, state.bodies, n_bodies, &other) != 0;
+    other.dt = 0.005;
+    other.ephemeris_stride = 1;
+    passed = passed && ephemeris_open(&eph, file, state.bodies, n_bodies, &other) != 0;
+    sim_state_free(&state);
+    remove(file);
+    
+    test_result("Ephemeris file round trip", passed);
+}
+
+/**
+ * Test 17: Phase timers
+ * Timing a run must not change it; the phases add up to no more than the
+ * wall time and every force evaluation is counted once
+ */
+void test_phase_timers() {
+    const int n_bodies = 20, n_rockets = 300, steps = 30;
+    SimConfig config;
+    sim_config_default(&config);
+    config.dt = 0.005;
+    
+    SimState timed, plain;
+    build_parallel_state(&timed, n_bodies, n_rockets);
+    build_parallel_state(&plain, n_bodies, n_rockets);
+    Profile profile;
+    profile_init(&profile);
+    timed.profile = &profile;
+    int passed = 1;
+#ifdef NBODY_PROFILE
+    const char *file = TEST_DIR "timing.csv";
+    passed = profile_open_csv(&profile, file) == 0;
+#endif
+
+    for (int step = 0; step < steps; step++) {
+        sim_step(&timed, &config);
+        sim_step(&plain, &config);
+        if (step % 10 == 9) profile_frame(&profile, step / 10, step + 1, timed.time);
+    }
+    profile_close(&profile);
+    
+    for (int i = 0; i < n_rockets; i++) {
+        if (timed.rocket_soa.x[i] != plain.rocket_soa.x[i] ||
+            timed.rocket_soa.y[i] != plain.rocket_soa.y[i]) {
+            passed = 0;
+        }
+    }
+
+#ifdef NBODY_PROFILE
+    // KDK evaluates the forces once per step plus once to start
+    long long expected = (long long)(steps + 1) *
+                         (n_bodies * (n_bodies - 1) + n_rockets * n_bodies);
+    double total = 0.0;
+    for (int k = 0; k < PROFILE_PHASES; k++) {
+        if (profile.seconds[k] < 0.0) passed = 0;
+        total += profile.seconds[k];
+    }
+    double wall = profile_clock() - profile.start;
+    printf("  Interactions: %lld (expected %lld), phases %.3e s of %.3e s\n",
+           profile.interactions, expected, total, wall);
+    passed = passed && profile.interactions == expected && total <= wall &&
+             profile.seconds[PROFILE_BODY_FORCES] > 0.0 && profile.seconds[PROFILE_TRAILS] > 0.0;
+    
+    // Header plus one row per frame
+    FILE *f = fopen(file, "r");
+    int lines = 0;
+    char line[512];
+    while (f && fgets(line, sizeof(line), f)) lines++;
+    if (f) fclose(f);
+    passed = passed && lines == 1 + steps / 10;
+    remove(file);
+#else
+    printf("  Timers compiled out (PROFILE=0), checking the results only\n");
+#endif
+
+    sim_state_free(&timed);
+    sim_state_free(&plain);
+    test_result("Phase timers", passed);
+}
+
+/**
+ * Total body momentum
+ */
+static void body_momentum(const SimState *state, double *px, double *py) {
+    const ParticleSoA *b = &state->body_soa;
+    *px = 0.0;
+    *py = 0.0;
+    for (int i = 0; i < b->n; i++) {
+        *px += b->mass[i] * b->vx[i];
+        *py += b->mass[i] * b->vy[i];
+    }
+}
+
+/**
+ * Test 18: Precision modes against double
+ * Accuracy report: energy and momentum drift of the bodies and the
+ * rocket positions after a run, per precision mode; threaded float runs
+ * must still match the serial ones bit for bit
+ */
+void test_precision_modes() {
+    const int n_bodies = 60, n_rockets = 500, steps = 200;
+    const char *names[3] = {"double", "mixed", "float"};
+    double energy_drift[3], momentum_drift[3], rocket_error[3];
+    SimState states[3];
+    int passed = 1;
+    
+    for (int p = 0; p < 3; p++) {
+        SimConfig config;
+        sim_config_default(&config);
+        config.dt = 0.002;
+        config.precision = p;
+        
+        build_parallel_state(&states[p], n_bodies, n_rockets);
+        double e0 = compute_energy(&states[p].body_soa, config.g);
+        double px0, py0;
+        body_momentum(&states[p], &px0, &py0);
+        for (int step = 0; step < steps; step++) {
+            sim_step(&states[p], &config);
+        }
+        double e1 = compute_energy(&states[p].body_soa, config.g);
+        double px1, py1;
+        body_momentum(&states[p], &px1, &py1);
+        energy_drift[p] = fabs((e1 - e0) / e0);
+        momentum_drift[p] = sqrt((px1 - px0) * (px1 - px0) + (py1 - py0) * (py1 - py0));
+        
+        rocket_error[p] = 0.0;
+        for (int i = 0; i < n_rockets; i++) {
+            double dx = states[p].rocket_soa.x[i] - states[0].rocket_soa.x[i];
+            double dy = states[p].rocket_soa.y[i] - states[0].rocket_soa.y[i];
+            double error = sqrt(dx * dx + dy * dy);
+            if (error > rocket_error[p]) rocket_error[p] = error;
+        }
+        printf("  %-6s energy drift %.3e, momentum drift %.3e, rocket error %.3e\n",
+               names[p], energy_drift[p], momentum_drift[p], rocket_error[p]);
+    }
+    
+    // The ring is chaotic (close encounters), so only mixed precision is
+    // held to the double energy drift; both must keep momentum and rockets
+    if (fabs(energy_drift[1] - energy_drift[0]) > 1e-3) passed = 0;
+    for (int p = 1; p < 3; p++) {
+        if (momentum_drift[p] > 1e-3 || rocket_error[p] > 1e-3) passed = 0;
+    }
+    
+    // Threaded mixed precision matches serial mixed precision exactly
+    SimConfig config;
+    sim_config_default(&config);
+    config.dt = 0.002;
+    config.precision = PRECISION_MIXED;
+    config.threads = 2;
+    SimState threaded;
+    build_parallel_state(&threaded, n_bodies, n_rockets);
+    for (int step = 0; step < steps; step++) {
+        sim_step(&threaded, &config);
+    }
+    for (int i = 0; i < n_rockets; i++) {
+        if (threaded.rocket_soa.x[i] != states[1].rocket_soa.x[i] ||
+            threaded.rocket_soa.y[i] != states[1].rocket_soa.y[i]) {
+            passed = 0;
+        }
+    }
+    for (int i = 0; i < n_bodies; i++) {
+        if (threaded.body_soa.x[i] != states[1].body_soa.x[i]) passed = 0;
+    }
+    
+    sim_state_free(&threaded);
+    for (int p = 0; p < 3; p++) sim_state_free(&states[p]);
+    test_result("Precision modes against double", passed);
+}
+
+/**
+ * Distance from (x, y) to the segment (ax, ay)-(bx, by)
+ */
+static double segment_distance(double x, double y, double ax, double ay,
+                               double bx, double by) {
+    double dx = bx - ax, dy = by - ay;
+    double len2 = dx * dx + dy * dy;
+    double t = (len2 > 0.0) ? ((x - ax) * dx + (y - ay) * dy) / len2 : 0.0;
+    if (t < 0.0) t = 0.0;
+    if (t > 1.0) t = 1.0;
+    double ex = ax + t * dx - x, ey = ay + t * dy - y;
+    return sqrt(ex * ex + ey * ey);
+}
+
+/**
+ * Eccentric orbits around one central body, each rocket with a trail
+ */
+static void build_trail_state(SimState *state, int n_rockets) {
+    sim_state_init(state);
+    Body *b = sim_state_add_body(state);
+    b->mass = 100.0;
+    for (int i = 0; i < n_rockets; i++) {
+        Rocket *r = sim_state_add_rocket(state);
+        double angle = 2.0 * M_PI * i / n_rockets;
+        double radius = 4.0 + (i % 7);
+        r->x = radius * cos(angle);
+        r->y = radius * sin(angle);
+        r->vx = -0.8 * sqrt(100.0 / radius) * sin(angle);
+        r->vy = 0.8 * sqrt(100.0 / radius) * cos(angle);
+        r->active = 1;
+        rocket_trail_init(r);
+    }
+    sim_state_pack(state);
+}
+
+/**
+ * Test 19: Trail decimation
+ * A decimated trail keeps far fewer points, stays within the tolerance
+ * of the full-resolution path, ends at the rocket and still counts every
+ * sample in the statistics
+ */
+void test_trail_decimation() {
+    const int n_rockets = 40, steps = 2000;
+    SimConfig config;
+    sim_config_default(&config);
+    SimState full, decimated, strided;
+    build_trail_state(&full, n_rockets);
+    build_trail_state(&decimated, n_rockets);
+    build_trail_state(&strided, n_rockets);
+    
+    SimConfig decimate = config, stride = config;
+    decimate.trail_tolerance = 0.5;
+    stride.trail_stride = 10;
+    for (int step = 0; step < steps; step++) {
+        sim_step(&full, &config);
+        sim_step(&decimated, &decimate);
+        sim_step(&strided, &stride);
+    }
+    
+    Viewport view;
+    viewport_init(&view, config.width, config.height, config.scale, 0.0, 0.0);
+    double tolerance = decimate.trail_tolerance / view.scale;
+    
+    int passed = 1;
+    long kept = 0, sampled = 0;
+    double worst = 0.0;
+    for (int i = 0; i < n_rockets; i++) {
+        const Rocket *f = &full.rockets[i];
+        const Rocket *d = &decimated.rockets[i];
+        const Rocket *s = &strided.rockets[i];
+        long samples = (long)f->trail_dropped + f->trail_length;
+        if (f->trail_dropped != 0 ||
+            (long)d->trail_dropped + d->trail_length + d->trail_skipped != samples ||
+            (long)s->trail_dropped + s->trail_length + s->trail_skipped != samples ||
+            s->trail_length != (samples + 9) / 10) {
+            passed = 0;
+            continue;
+        }
+        kept += d->trail_length;
+        sampled += samples;
+        
+        // Same final point, every full-resolution point near the polyline
+        int last = d->trail_length - 1;
+        if (d->trail_x[last] != f->trail_x[f->trail_length - 1] ||
+            d->trail_y[last] != f->trail_y[f->trail_length - 1]) {
+            passed = 0;
+        }
+        for (int j = 0; j < f->trail_length; j++) {
+            double nearest = INFINITY;
+            for (int k = 0; k < last; k++) {
+                double dist = segment_distance(f->trail_x[j], f->trail_y[j],
+                                               d->trail_x[k], d->trail_y[k],
+                                               d->trail_x[k + 1], d->trail_y[k + 1]);
+                if (dist < nearest) nearest = dist;
+            }
+            if (nearest > worst) worst = nearest;
+        }
+    }
+    printf("  %ld of %ld points kept (%.1fx fewer), worst deviation %.2f px\n",
+           kept, sampled, kept ? (double)sampled / kept : 0.0, worst * view.scale);
+    
+    // Each segment's samples lie within the tolerance of its first
+    // direction, so within twice the tolerance of the stored chord
+    passed = passed && kept > 0 && 5 * kept <= sampled && worst <= 2.0 * tolerance;
+    
+    sim_state_free(&full);
+    sim_state_free(&decimated);
+    sim_state_free(&strided);
+    test_result("Trail decimation", passed);
+}
+
+/**
+ * A central body, a ring of small bodies and rockets thrown out at
+ * different speeds: some orbit, some escape, some hit a body
+ */
+static void build_event_state(SimState *state, int n_rockets) {
+    sim_state_init(state);
+    Body *center = sim_state_add_body(state);
+    center->mass = 100.0;
+    for (int k = 0; k < 19; k++) {
+        Body *b = sim_state_add_body(state);
+        double angle = 2.0 * M_PI * k / 19;
+        b->x = 6.0 * cos(angle);
+        b->y = 6.0 * sin(angle);
+        b->vx = -sqrt(100.0 / 6.0) * sin(angle);
+        b->vy = sqrt(100.0 / 6.0) * cos(angle);
+        b->mass = 0.01;
+    }
+    for (int i = 0; i < n_rockets; i++) {
+        Rocket *r = sim_state_add_rocket(state);
+        double angle = 2.0 * M_PI * i / n_rockets;
+        double radius = 3.0 + (i % 8);
+        double speed = (0.3 + 0.15 * (i % 11)) * sqrt(100.0 / radius);
+        r->x = radius * cos(angle);
+        r->y = radius * sin(angle);
+        r->vx = -speed * sin(angle);
+        r->vy = speed * cos(angle);
+        r->active = 1;
+    }
+    sim_state_pack(state);
+}
+
+/**
+ * Check the events of the last step and the rockets still live
+ * Every collision names the lowest body in reach, no live rocket is
+ * past an event, and the live list holds exactly the active rockets
+ */
+static int check_events_step(const SimState *state, const SimConfig *config) {
+    const RocketEvents *ev = &state->events;
+    const ParticleSoA *r = &state->rocket_soa;
+    const ParticleSoA *b = &state->body_soa;
+    double reach = config->collision_radius;
+    int ok = ev->live_valid;
+    
+    for (int k = 0; k < ev->n_pending; k++) {
+        const RocketEvent *e = &ev->pending[k];
+        if (e->kind != EVENT_COLLISION) continue;
+        int first = -1;
+        for (int j = 0; j < b->n && first < 0; j++) {
+            double dx = e->x - b->x[j], dy = e->y - b->y[j];
+            if (dx * dx + dy * dy < reach * reach) first = j;
+        }
+        ok = ok && e->detail == first && r->active[e->rocket] == 0;
+    }
+    
+    int live = 0;
+    for (int i = 0; i < r->n; i++) {
+        if (!r->active[i]) continue;
+        ok = ok && live < ev->n_live && ev->live[live] == i;
+        live++;
+        
+        double d = sqrt(r->x[i] * r->x[i] + r->y[i] * r->y[i]);
+        ok = ok && d <= config->escape_radius;
+        for (int j = 0; j < b->n; j++) {
+            double dx = r->x[i] - b->x[j], dy = r->y[i] - b->y[j];
+            ok = ok && dx * dx + dy * dy >= reach * reach;
+        }
+        const EventRegion *stop = &config->regions[1];
+        ok = ok && !(r->x[i] >= stop->x0 && r->x[i] <= stop->x1 &&
+                     r->y[i] >= stop->y0 && r->y[i] <= stop->y1);
+    }
+    return ok && live == ev->n_live;
+}
+
+/**
+ * Test 20: Rocket events
+ * Escapes, collisions (on the body grid) and region entries are found
+ * and logged asynchronously, and the rockets left on the compacted live
+ * list follow the same paths as in a run without events
+ */
+void test_rocket_events() {
+    const int n_rockets = 400, steps = 1500;
+    SimConfig config, plain;
+    sim_config_default(&config);
+    config.escape_radius = 15.0;
+    config.collision_radius = 0.4;
+    config_set_option(&config, "region", "-2,-2,2,2");
+    config_set_option(&config, "region", "12,-20,20,20,stop");
+    plain = config;
+    plain.escape_radius = 0.0;
+    plain.collision_radius = 0.0;
+    plain.n_regions = 0;
+    
+    SimState state, reference;
+    build_event_state(&state, n_rockets);
+    build_event_state(&reference, n_rockets);
+    
+    EventLog log;
+    int passed = config.n_regions == 2 && config.regions[1].stop &&
+                 event_log_open(&log, TEST_DIR "events.csv", 0, -1) == 0;
+    state.events.log = &log;
+    int compacted = 0;
+    for (int step = 0; step < steps && passed; step++) {
+        sim_step(&state, &config);
+        sim_step(&reference, &plain);
+        passed = check_events_step(&state, &config);
+        if (events_force_rockets(&state) != &state.rocket_soa) compacted = 1;
+    }
+    state.events.log = NULL;
+    passed = event_log_close(&log) == 0 && passed;
+    
+    // Live rockets match the run that kept every rocket
+    double worst = 0.0;
+    for (int k = 0; k < state.events.n_live; k++) {
+        int i = state.events.live[k];
+        double dx = state.rocket_soa.x[i] - reference.rocket_soa.x[i];
+        double dy = state.rocket_soa.y[i] - reference.rocket_soa.y[i];
+        double d = sqrt(dx * dx + dy * dy);
+        if (d > worst) worst = d;
+    }
+    
+    // One CSV line per event after the header
+    const int64_t *counts = state.events.counts;
+    long long total = counts[EVENT_ESCAPE] + counts[EVENT_COLLISION] + counts[EVENT_REGION];
+    long long lines = 0;
+    char line[256], header[256] = "";
+    FILE *f = fopen(TEST_DIR "events.csv", "r");
+    if (f) {
+        if (fgets(header, sizeof(header), f)) {
+            while (fgets(line, sizeof(line), f)) lines++;
+        }
+        fclose(f);
+    }
+    printf("  %lld escapes, %lld collisions, %lld region entries, %d of %d live, "
+           "worst drift %.1e\n", (long long)counts[EVENT_ESCAPE],
+           (long long)counts[EVENT_COLLISION], (long long)counts[EVENT_REGION],
+           state.events.n_live, n_rockets, worst);
+    
+    passed = passed && compacted && counts[EVENT_ESCAPE] > 0 && counts[EVENT_COLLISION] > 0 &&
+             counts[EVENT_REGION] > 0 && state.events.steps == steps && worst < 1e-6 &&
+             lines == total && strncmp(header, "Step,Time,Rocket,Event", 22) == 0;
+    
+    sim_state_free(&state);
+    sim_state_free(&reference);
+    test_result("Rocket events", passed);
+}
+
+/**
+ * Test 21: Replay matches the simulated frames
+ * Frames drawn from the saved trails, with bodies integrated alone, are
+ * bitwise the frames of the run, also after the trail window has slid
+ */
+void test_replay_frames() {
+    const int n_rockets = 40;
+    SimConfig config;
+    sim_config_default(&config);
+    config.steps = 8000;
+    config.save_interval = 2000;
+    config.width = 200;
+    config.height = 200;
+    Viewport view;
+    viewport_init(&view, config.width, config.height, config.scale, 0.0, 0.0);
+    size_t pixels = (size_t)view.width * view.height;
+    
+    FILE *f = fopen(TEST_DIR "replay_bodies.txt", "w");
+    if (f) {
+        fprintf(f, "0 0 0 0 100\n");
+        fclose(f);
+    }
+    
+    // Simulate, keeping the frames the run draws
+    SimState state;
+    build_trail_state(&state, n_rockets);
+    TrailSink sink;
+    int passed = trail_sink_open(&sink, TEST_DIR "replay.bin", n_rockets, 64) == 0;
+    state.trail_sink = passed ? &sink : NULL;
+    int n_frames = config.steps / config.save_interval;
+    Pixel *frames = (Pixel *)malloc(pixels * n_frames * sizeof(Pixel));
+    Pixel *img = (Pixel *)malloc(pixels * sizeof(Pixel));
+    passed = passed && frames && img;
+    for (int step = 0; step < config.steps && passed; step++) {
+        if (step % config.save_interval == 0) {
+            sim_state_unpack(&state);
+            render(state.bodies, state.n_bodies, state.rockets, n_rockets,
+                   frames + pixels * (step / config.save_interval), &view, 1);
+        }
+        sim_step(&state, &config);
+    }
+    sim_state_unpack(&state);
+    int slid = state.rockets[0].trail_dropped > 0;
+    passed = passed && trail_sink_close(&sink, state.rockets, n_rockets) == 0;
+    state.trail_sink = NULL;
+    
+    // Replay every frame and compare
+    Replay replay;
+    int same = 0;
+    if (passed && replay_open(&replay, TEST_DIR "replay.bin", TEST_DIR "replay_bodies.txt",
+                              &config) == 0) {
+        passed = replay.n_frames == n_frames && replay.n_rockets == n_rockets;
+        for (int k = 0; k < n_frames && passed; k++) {
+            passed = replay_render(&replay, k, img, &view, 1) == 0;
+            if (passed && memcmp(img, frames + pixels * k, pixels * sizeof(Pixel)) == 0) same++;
+        }
+        replay_close(&replay);
+    } else {
+        passed = 0;
+    }
+    printf("  %d of %d frames identical, trail window %s\n", same, n_frames,
+           slid ? "slid" : "did not slide");
+    passed = passed && slid && same == n_frames;
+    
+    free(frames);
+    free(img);
+    sim_state_free(&state);
+    test_result("Replay matches the simulated frames", passed);
+}
+
+/**
+ * Test 22: Y4M stream on stdout
+ * A --verbose run piping video_file=- must put nothing but the stream on
+ * stdout: the header first, then whole frames (needs bin/nbody)
+ */
+void test_y4m_stdout() {
+    const int width = 16, height = 8, frames = 4;
+    FILE *f = fopen(TEST_DIR "pipe_config.txt", "w");
+    if (f) {
+        fprintf(f, "steps=40\nframes=%d\nsave_interval=0\nwidth=%d\nheight=%d\n"
+                   "video_output=y4m\nvideo_file=-\n", frames, width, height);
+        fclose(f);
+    }
+    f = fopen(TEST_DIR "pipe_bodies.txt", "w");
+    if (f) {
+        fprintf(f, "0 0 0 0 100\n5 0 0 4.4 1\n");
+        fclose(f);
+    }
+    // Enough rockets that the --verbose listing overflows the stdio buffer
+    f = fopen(TEST_DIR "pipe_rockets.txt", "w");
+    if (f) {
+        for (int i = 0; i < 400; i++) fprintf(f, "%.3f 0 0 %.3f\n", 2.0 + 0.01 * i, 7.0);
+        fclose(f);
+    }
+    
+    FILE *run = popen("./bin/nbody --verbose --mode simulate --config " TEST_DIR "pipe_config.txt"
+                      " --bodies " TEST_DIR "pipe_bodies.txt --rockets " TEST_DIR "pipe_rockets.txt"
+                      " --output " TEST_DIR "pipe_run 2> /dev/null", "r");
+    char header[64] = "", expected[64], marker[8];
+    int passed = run != NULL, read_frames = 0;
+    if (run) {
+        passed = fgets(header, sizeof(header), run) != NULL;
+        snprintf(expected, sizeof(expected), "YUV4MPEG2 W%d H%d ", width, height);
+        passed = passed && strncmp(header, expected, strlen(expected)) == 0;
+        
+        size_t frame_size = (size_t)width * height * 3;
+        unsigned char *planes = (unsigned char *)malloc(frame_size);
+        while (passed && planes && fread(marker, 1, 6, run) == 6) {
+            if (memcmp(marker, "FRAME\n", 6) != 0 || fread(planes, 1, frame_size, run) != frame_size) {
+                passed = 0;
+            }
+            read_frames++;
+        }
+        free(planes);
+        passed = (pclose(run) == 0) && passed;
+    }
+    printf("  Header: %.*s, %d frames\n", (int)strcspn(header, "\n"), header, read_frames);
+    passed = passed && read_frames == frames;
+    
+    system("rm -rf " TEST_DIR "pipe_run");
+    remove(TEST_DIR "pipe_config.txt");
+    remove(TEST_DIR "pipe_bodies.txt");
+    remove(TEST_DIR "pipe_rockets.txt");
+    test_result("Y4M stream on stdout", passed);
+}
+
 int main() {
     printf("\n");
     printf("====================================\n");
@@ -364,6 +1474,21 @@ int main() {
     test_multiple_rockets();
     test_file_io_roundtrip();
     test_escape_velocity();
+    test_parallel_determinism();
+    test_frame_pipeline();
+    test_incremental_render();
+    test_viewport_stride();
+    test_tiled_rasterizer();
+    test_density_render();
+    test_checkpoint_resume();
+    test_body_ephemeris();
+    test_ephemeris_file();
+    test_phase_timers();
+    test_precision_modes();
+    test_trail_decimation();
+    test_rocket_events();
+    test_replay_frames();
+    test_y4m_stdout();
     
     printf("\n====================================\n");
     printf("Results: %d/%d tests passed\n", tests_passed, tests_run);
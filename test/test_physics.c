@@ -119,49 +119,126 @@ void test_circular_orbit() {
     test_result("Circular orbit stability", passed);
 }
 
+/**
+ * Relative energy drift of a two-body orbit run through sim_step()
+ */
+static double two_body_energy_drift(int integrator, int precision, double dt, int steps) {
+    SimState state;
+    sim_state_init(&state);
+    
+    Body *star = sim_state_add_body(&state);
+    Body *planet = sim_state_add_body(&state);
+    star->mass = 100.0;
+    planet->x = 3.0;
+    planet->vy = 5.0;
+    planet->mass = 1.0;
+    
+    SimConfig config;
+    sim_config_default(&config);
+    config.dt = dt;
+    config.integrator = integrator;
+    config.precision = precision;
+    
+    double drift = 1.0;
+    if (sim_state_pack(&state) == 0) {
+        double E0 = compute_energy(&state.body_soa, config.g);
+        for (int i = 0; i < steps; i++) {
+            sim_step(&state, &config);
+        }
+        double E1 = compute_energy(&state.body_soa, config.g);
+        drift = fabs((E1 - E0) / E0);
+    }
+    
+    sim_state_free(&state);
+    return drift;
+}
+
 /**
  * Test 4: Energy conservation
  * Total energy should remain approximately constant
  */
 void test_energy_conservation() {
-    Body bodies[2];
-    
-    bodies[0].x = 0.0;
-    bodies[0].y = 0.0;
-    bodies[0].vx = 0.0;
-    bodies[0].vy = 0.0;
-    bodies[0].mass = 100.0;
+    // Simulate for some time with the default (KDK leapfrog) integrator
+    double energy_error = two_body_energy_drift(INTEGRATOR_KDK, PRECISION_DOUBLE, 0.01, 1000);
     
-    bodies[1].x = 3.0;
-    bodies[1].y = 0.0;
-    bodies[1].vx = 0.0;
-    bodies[1].vy = 5.0;
-    bodies[1].mass = 1.0;
+    // Energy should be conserved within reasonable tolerance
+    int passed = energy_error < 0.01;  // Within 1% error
     
-    // Calculate initial energy
-    double ke0 = 0.5 * bodies[1].mass * (bodies[1].vx * bodies[1].vx + 
-                                         bodies[1].vy * bodies[1].vy);
-    double r0 = sqrt(bodies[1].x * bodies[1].x + bodies[1].y * bodies[1].y);
-    double pe0 = -1.0 * bodies[0].mass * bodies[1].mass / r0;
-    double E0 = ke0 + pe0;
+    test_result("Energy conservation", passed);
+}
+
+/**
+ * KDK leapfrog is second order: at 4x the time step it should still
+ * beat semi-implicit Euler over the same simulated time
+ */
+void test_kdk_larger_dt() {
+    double euler = two_body_energy_drift(INTEGRATOR_EULER, PRECISION_DOUBLE, 0.01, 1000);
+    double kdk = two_body_energy_drift(INTEGRATOR_KDK, PRECISION_DOUBLE, 0.04, 250);
     
-    // Simulate for some time
-    for (int i = 0; i < 1000; i++) {
-        update_bodies(bodies, 2, 0.01, 1.0);
+    printf("    energy drift: euler dt=0.01 %.2e, kdk dt=0.04 %.2e\n", euler, kdk);
+    test_result("KDK leapfrog at 4x dt beats Euler", kdk < euler);
+}
+
+/**
+ * Relative drift in the specific orbital energy of a rocket on the
+ * e = 0.6 orbit of init_rockets_default(), over ten orbits (t = 70)
+ */
+static double rocket_orbit_drift(int block_steps, double dt, long long *evals) {
+    SimState state;
+    sim_state_init(&state);
+    
+    Body *star = sim_state_add_body(&state);
+    star->mass = 100.0;
+    Rocket *rocket = sim_state_add_rocket(&state);
+    rocket->x = 2.0;
+    rocket->vy = sqrt(100.0 * 1.6 / 2.0);
+    rocket->active = 1;
+    
+    SimConfig config;
+    sim_config_default(&config);
+    config.dt = dt;
+    config.block_steps = block_steps;
+    int steps = (int)(70.0 / dt + 0.5);
+    
+    double drift = 1.0;
+    *evals = 0;
+    if (sim_state_pack(&state) == 0) {
+        ParticleSoA *r = &state.rocket_soa;
+        double r0 = sqrt(r->x[0] * r->x[0] + r->y[0] * r->y[0] + SOFTENING * SOFTENING);
+        double E0 = 0.5 * (r->vx[0] * r->vx[0] + r->vy[0] * r->vy[0]) - 100.0 / r0;
+        
+        for (int i = 0; i < steps; i++) {
+            sim_step(&state, &config);
+        }
+        
+        double r1 = sqrt(r->x[0] * r->x[0] + r->y[0] * r->y[0] + SOFTENING * SOFTENING);
+        double E1 = 0.5 * (r->vx[0] * r->vx[0] + r->vy[0] * r->vy[0]) - 100.0 / r1;
+        drift = fabs((E1 - E0) / E0);
+        *evals = block_steps ? state.blocks.force_evals : steps;
     }
     
-    // Calculate final energy
-    double ke1 = 0.5 * bodies[1].mass * (bodies[1].vx * bodies[1].vx + 
-                                         bodies[1].vy * bodies[1].vy);
-    double r1 = sqrt(bodies[1].x * bodies[1].x + bodies[1].y * bodies[1].y);
-    double pe1 = -1.0 * bodies[0].mass * bodies[1].mass / r1;
-    double E1 = ke1 + pe1;
+    sim_state_free(&state);
+    return drift;
+}
+
+/**
+ * Block time-steps: a coarse global dt with per-rocket sub-steps should
+ * beat a fine global dt on accuracy while evaluating far fewer forces
+ */
+void test_block_timesteps() {
+    long long block_evals, global_evals;
+    double block = rocket_orbit_drift(1, 0.1, &block_evals);
+    double global = rocket_orbit_drift(0, 0.005, &global_evals);
     
-    // Energy should be conserved within reasonable tolerance
-    double energy_error = fabs((E1 - E0) / E0);
-    int passed = energy_error < 0.01;  // Within 1% error
+    printf("    block dt=0.1: drift %.2e, %lld evals; global dt=0.005: drift %.2e, %lld evals\n",
+           block, block_evals, global, global_evals);
     
-    test_result("Energy conservation", passed);
+    // Criterion: strong jerk pushes to finer levels, none means level 0
+    int levels_ok = rocket_block_level(1.0, 0.0, 1000.0, 0.0, 0.1, 0.02) > 0 &&
+                    rocket_block_level(1.0, 0.0, 0.0, 0.0, 0.1, 0.02) == 0;
+    
+    test_result("Rocket block time-steps", levels_ok && block < global &&
+                block_evals < global_evals / 2);
 }
 
 /**
@@ -224,6 +301,396 @@ void test_multi_body() {
     test_result("Multi-body force symmetry", passed);
 }
 
+/**
+ * Test 7: Structure-of-arrays storage
+ * Columns must be aligned and pack/unpack must round-trip the AoS view
+ */
+void test_soa_roundtrip() {
+    Body bodies[3];
+    for (int i = 0; i < 3; i++) {
+        bodies[i].x = i * 1.5;
+        bodies[i].y = -i * 0.5;
+        bodies[i].vx = 0.1 * i;
+        bodies[i].vy = -0.2 * i;
+        bodies[i].ax = 0.0;
+        bodies[i].ay = 0.0;
+        bodies[i].mass = 10.0 + i;
+    }
+    
+    ParticleSoA soa = {0};
+    int passed = (soa_from_bodies(&soa, bodies, 3) == 0) && (soa.n == 3);
+    
+    passed = passed &&
+             ((size_t)soa.x % SOA_ALIGNMENT == 0) &&
+             ((size_t)soa.mass % SOA_ALIGNMENT == 0);
+    
+    // Kernel result on SoA must match the AoS entry point exactly
+    compute_forces_soa(&soa, 1.0);
+    compute_forces(bodies, 3, 1.0);
+    
+    Body out[3];
+    soa_to_bodies(&soa, out);
+    for (int i = 0; i < 3 && passed; i++) {
+        passed = (out[i].x == bodies[i].x) &&
+                 (out[i].mass == bodies[i].mass) &&
+                 (out[i].ax == bodies[i].ax) &&
+                 (out[i].ay == bodies[i].ay);
+    }
+    
+    soa_free(&soa);
+    
+    test_result("SoA storage round-trip", passed);
+}
+
+/**
+ * Test 8: SIMD rocket kernels agree with the scalar path
+ * Every kernel supported on this CPU must match within tolerance and
+ * leave inactive rockets untouched
+ */
+void test_simd_rocket_kernels() {
+    int n_rockets = 1003;  // Not a multiple of any vector width
+    ParticleSoA bodies = {0};
+    ParticleSoA ref = {0};
+    ParticleSoA vec = {0};
+    soa_reserve(&bodies, 5);
+    soa_reserve(&ref, n_rockets);
+    soa_reserve(&vec, n_rockets);
+    
+    // Deterministic pseudo-random layout
+    unsigned int seed = 12345;
+    for (int j = 0; j < 5; j++) {
+        seed = seed * 1103515245u + 12345u;
+        bodies.x[j] = ((seed >> 8) % 2000) / 100.0 - 10.0;
+        seed = seed * 1103515245u + 12345u;
+        bodies.y[j] = ((seed >> 8) % 2000) / 100.0 - 10.0;
+        bodies.mass[j] = 1.0 + j * 20.0;
+    }
+    bodies.n = 5;
+    
+    for (int i = 0; i < n_rockets; i++) {
+        seed = seed * 1103515245u + 12345u;
+        ref.x[i] = ((seed >> 8) % 4000) / 100.0 - 20.0;
+        seed = seed * 1103515245u + 12345u;
+        ref.y[i] = ((seed >> 8) % 4000) / 100.0 - 20.0;
+        ref.ax[i] = -7.0;
+        ref.ay[i] = -7.0;
+        ref.active[i] = (i % 7 != 3);
+    }
+    ref.n = n_rockets;
+    
+    compute_rocket_forces_scalar(&ref, &bodies, 1.0, 0, n_rockets);
+    
+    int passed = 1;
+    int kinds[] = {KERNEL_AVX2, KERNEL_AVX512, KERNEL_NEON};
+    for (int k = 0; k < 3; k++) {
+        if (select_rocket_kernel(kinds[k]) != kinds[k]) continue;
+        
+        for (int i = 0; i < n_rockets; i++) {
+            vec.x[i] = ref.x[i];
+            vec.y[i] = ref.y[i];
+            vec.ax[i] = -7.0;
+            vec.ay[i] = -7.0;
+            vec.active[i] = ref.active[i];
+        }
+        vec.n = n_rockets;
+        
+        compute_rocket_forces_soa(&vec, &bodies, 1.0);
+        
+        double max_err = 0.0;
+        for (int i = 0; i < n_rockets; i++) {
+            double mag = sqrt(ref.ax[i] * ref.ax[i] + ref.ay[i] * ref.ay[i]);
+            double err = sqrt((vec.ax[i] - ref.ax[i]) * (vec.ax[i] - ref.ax[i]) +
+                              (vec.ay[i] - ref.ay[i]) * (vec.ay[i] - ref.ay[i]));
+            if (mag > 0.0) err /= mag;
+            if (err > max_err) max_err = err;
+            
+            if (!ref.active[i] && (vec.ax[i] != -7.0 || vec.ay[i] != -7.0)) {
+                passed = 0;
+            }
+        }
+        
+        printf("    %s kernel: max relative error %.2e\n",
+               rocket_kernel_name(kinds[k]), max_err);
+        if (max_err > 1e-10) passed = 0;
+    }
+    
+    select_rocket_kernel(KERNEL_AUTO);
+    
+    soa_free(&bodies);
+    soa_free(&ref);
+    soa_free(&vec);
+    
+    test_result("SIMD rocket kernels match scalar", passed);
+}
+
+/**
+ * Maximum acceleration error of `test` against `ref`, relative to the
+ * mean acceleration magnitude (per-particle ratios blow up where the
+ * net force nearly cancels)
+ */
+static double max_accel_error(const ParticleSoA *ref, const ParticleSoA *test) {
+    double max_err = 0.0;
+    double mean_mag = 0.0;
+    int count = 0;
+    for (int i = 0; i < ref->n; i++) {
+        if (!ref->active[i]) continue;
+        double ex = test->ax[i] - ref->ax[i];
+        double ey = test->ay[i] - ref->ay[i];
+        double err = sqrt(ex * ex + ey * ey);
+        if (err > max_err) max_err = err;
+        mean_mag += sqrt(ref->ax[i] * ref->ax[i] + ref->ay[i] * ref->ay[i]);
+        count++;
+    }
+    mean_mag = (count > 0) ? mean_mag / count : 1.0;
+    return (mean_mag > 0.0) ? max_err / mean_mag : max_err;
+}
+
+/**
+ * Test 9: Barnes-Hut solver accuracy
+ * theta=0 must reproduce the direct sum; theta=0.5 must stay close
+ * for both bodies and rockets walking the same tree
+ */
+void test_barnes_hut() {
+    int n = 400;
+    ParticleSoA direct = {0}, tree_b = {0};
+    ParticleSoA rockets_ref = {0}, rockets_bh = {0};
+    soa_reserve(&direct, n);
+    soa_reserve(&tree_b, n);
+    soa_reserve(&rockets_ref, n);
+    soa_reserve(&rockets_bh, n);
+    
+    unsigned int seed = 777;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        direct.x[i] = ((seed >> 8) % 10000) / 500.0 - 10.0;
+        seed = seed * 1103515245u + 12345u;
+        direct.y[i] = ((seed >> 8) % 10000) / 500.0 - 10.0;
+        direct.mass[i] = 1.0 + (i % 5);
+        direct.active[i] = 1;
+        
+        seed = seed * 1103515245u + 12345u;
+        rockets_ref.x[i] = ((seed >> 8) % 10000) / 400.0 - 12.5;
+        seed = seed * 1103515245u + 12345u;
+        rockets_ref.y[i] = ((seed >> 8) % 10000) / 400.0 - 12.5;
+        rockets_ref.active[i] = 1;
+    }
+    direct.n = n;
+    rockets_ref.n = n;
+    
+    for (int i = 0; i < n; i++) {
+        tree_b.x[i] = direct.x[i];
+        tree_b.y[i] = direct.y[i];
+        tree_b.mass[i] = direct.mass[i];
+        tree_b.active[i] = 1;
+        rockets_bh.x[i] = rockets_ref.x[i];
+        rockets_bh.y[i] = rockets_ref.y[i];
+        rockets_bh.active[i] = 1;
+    }
+    tree_b.n = n;
+    rockets_bh.n = n;
+    
+    compute_forces_soa(&direct, 1.0);
+    compute_rocket_forces_scalar(&rockets_ref, &direct, 1.0, 0, n);
+    
+    QuadTree tree;
+    quadtree_init(&tree);
+    
+    // theta = 0 opens every cell: same as the direct sum
+    compute_forces_bh(&tree_b, &tree, 1.0, 0.0, 0);
+    double exact_err = max_accel_error(&direct, &tree_b);
+    
+    // theta = 0.5: approximate, tree shared with the rockets
+    compute_forces_bh(&tree_b, &tree, 1.0, 0.5, 0);
+    double body_err = max_accel_error(&direct, &tree_b);
+    compute_rocket_forces_bh(&rockets_bh, &tree_b, &tree, 1.0, 0.5, 0);
+    double rocket_err = max_accel_error(&rockets_ref, &rockets_bh);
+    
+    printf("    theta=0 error %.2e, theta=0.5 body error %.2e, rocket error %.2e\n",
+           exact_err, body_err, rocket_err);
+    
+    int passed = (exact_err < 1e-10) && (body_err < 0.02) && (rocket_err < 0.02);
+    
+    quadtree_free(&tree);
+    soa_free(&direct);
+    soa_free(&tree_b);
+    soa_free(&rockets_ref);
+    soa_free(&rockets_bh);
+    
+    test_result("Barnes-Hut solver accuracy", passed);
+}
+
+/**
+ * Fill `rockets` with the test layout shifted by `offset`, inactive
+ * rockets marked with acceleration -7
+ */
+static void float_kernel_rockets(ParticleSoA *rockets, int n, double offset) {
+    unsigned int seed = 4242;
+    for (int i = 0; i < n; i++) {
+        seed = seed * 1103515245u + 12345u;
+        rockets->x[i] = offset + ((seed >> 8) % 4000) / 100.0 - 20.0;
+        seed = seed * 1103515245u + 12345u;
+        rockets->y[i] = offset + ((seed >> 8) % 4000) / 100.0 - 20.0;
+        rockets->ax[i] = -7.0;
+        rockets->ay[i] = -7.0;
+        rockets->active[i] = (i % 5 != 2);
+    }
+    rockets->n = n;
+}
+
+/**
+ * Test 10: Mixed and single precision force kernels
+ * Every float kernel must match the double result to float accuracy and
+ * leave inactive rockets alone; far from the origin only mixed precision
+ * (differences taken in double) keeps that accuracy
+ */
+void test_float_kernels() {
+    int n_rockets = 1013;  // Not a multiple of any vector width
+    double offsets[2] = {0.0, 1.0e4};
+    ParticleSoA bodies = {0}, ref = {0}, vec = {0};
+    soa_reserve(&bodies, 7);
+    soa_reserve(&ref, n_rockets);
+    soa_reserve(&vec, n_rockets);
+    int passed = 1;
+    
+    int kinds[] = {KERNEL_SCALAR, KERNEL_AVX2, KERNEL_AVX512, KERNEL_NEON};
+    for (int o = 0; o < 2; o++) {
+        for (int j = 0; j < 7; j++) {
+            bodies.x[j] = offsets[o] + 3.0 * cos(j * 0.9) * (1 + j % 3);
+            bodies.y[j] = offsets[o] + 3.0 * sin(j * 0.9) * (1 + j % 3);
+            bodies.mass[j] = 1.0 + j * 10.0;
+        }
+        bodies.n = 7;
+        float_kernel_rockets(&ref, n_rockets, offsets[o]);
+        compute_rocket_forces_scalar(&ref, &bodies, 1.0, 0, n_rockets);
+        
+        for (int k = 0; k < 4; k++) {
+            if (select_rocket_kernel(kinds[k]) != kinds[k]) continue;
+            
+            double err[2];
+            int precisions[2] = {PRECISION_MIXED, PRECISION_FLOAT};
+            for (int p = 0; p < 2; p++) {
+                float_kernel_rockets(&vec, n_rockets, offsets[o]);
+                rocket_force_kernel_for(precisions[p])(&vec, &bodies, 1.0, 0, n_rockets);
+                err[p] = max_accel_error(&ref, &vec);
+                for (int i = 0; i < n_rockets; i++) {
+                    if (!vec.active[i] && (vec.ax[i] != -7.0 || vec.ay[i] != -7.0)) passed = 0;
+                }
+            }
+            printf("    %s at offset %g: mixed error %.2e, float error %.2e\n",
+                   rocket_kernel_name(kinds[k]), offsets[o], err[0], err[1]);
+            // Float rounding near a body's softening core reaches ~1e-5
+            if (err[0] > 1e-4) passed = 0;
+            if (o == 0 && err[1] > 1e-4) passed = 0;
+            if (o == 1 && err[1] <= err[0]) passed = 0;
+        }
+    }
+    select_rocket_kernel(KERNEL_AUTO);
+    
+    // Float body forces against the double pair sum
+    ParticleSoA pairs = {0}, gather = {0};
+    soa_reserve(&pairs, 300);
+    soa_reserve(&gather, 300);
+    for (int i = 0; i < 300; i++) {
+        pairs.x[i] = gather.x[i] = 8.0 * cos(i * 2.4) * sqrt(i / 300.0);
+        pairs.y[i] = gather.y[i] = 8.0 * sin(i * 2.4) * sqrt(i / 300.0);
+        pairs.mass[i] = gather.mass[i] = 1.0 + (i % 3);
+        pairs.active[i] = gather.active[i] = 1;
+    }
+    pairs.n = gather.n = 300;
+    compute_forces_soa(&pairs, 1.0);
+    compute_forces_float(&gather, 1.0, 0, PRECISION_MIXED);
+    double body_err = max_accel_error(&pairs, &gather);
+    printf("    body forces: mixed error %.2e\n", body_err);
+    passed = passed && body_err < 1e-5;
+    
+    soa_free(&pairs);
+    soa_free(&gather);
+    soa_free(&bodies);
+    soa_free(&ref);
+    soa_free(&vec);
+    test_result("Mixed and single precision kernels", passed);
+}
+
+/**
+ * Test 11: Energy conservation in every precision mode
+ * The two-body orbit of Test 4, with float forces
+ */
+void test_precision_energy() {
+    double drift[3];
+    for (int p = 0; p < 3; p++) {
+        drift[p] = two_body_energy_drift(INTEGRATOR_KDK, p, 0.01, 1000);
+    }
+    printf("    energy drift: double %.3e, mixed %.3e, float %.3e\n",
+           drift[PRECISION_DOUBLE], drift[PRECISION_MIXED], drift[PRECISION_FLOAT]);
+    
+    // Within the Test 4 tolerance and close to the double drift
+    int passed = 1;
+    for (int p = 1; p < 3; p++) {
+        if (drift[p] > 0.01 || fabs(drift[p] - drift[PRECISION_DOUBLE]) > 1e-4) passed = 0;
+    }
+    test_result("Energy conservation in float precision", passed);
+}
+
+/**
+ * Test 12: Body-count specialized rocket kernels
+ * For 1 to FIXED_BODIES_MAX bodies every specialized kernel must give
+ * bitwise the generic result of its kind; larger counts and the float
+ * modes fall back to the generic kernels
+ */
+void test_fixed_kernels() {
+    int n_rockets = 1013;  // Not a multiple of any vector width
+    ParticleSoA bodies = {0}, ref = {0}, fixed = {0};
+    soa_reserve(&bodies, FIXED_BODIES_MAX + 1);
+    soa_reserve(&ref, n_rockets);
+    soa_reserve(&fixed, n_rockets);
+    for (int j = 0; j <= FIXED_BODIES_MAX; j++) {
+        bodies.x[j] = 3.0 * cos(j * 0.9) * (1 + j % 3);
+        bodies.y[j] = 3.0 * sin(j * 0.9) * (1 + j % 3);
+        bodies.mass[j] = 1.0 + j * 10.0;
+    }
+    int passed = 1, checked = 0;
+    
+    int kinds[] = {KERNEL_SCALAR, KERNEL_AVX2, KERNEL_AVX512, KERNEL_NEON};
+    for (int k = 0; k < 4; k++) {
+        if (select_rocket_kernel(kinds[k]) != kinds[k]) continue;
+        
+        for (int n = 1; n <= FIXED_BODIES_MAX; n++) {
+            bodies.n = n;
+            RocketForceKernel kernel = rocket_force_kernel_sized(PRECISION_DOUBLE, n);
+            if (!kernel || kernel == rocket_force_kernel()) {
+                passed = 0;
+                continue;
+            }
+            float_kernel_rockets(&ref, n_rockets, 0.0);
+            float_kernel_rockets(&fixed, n_rockets, 0.0);
+            rocket_force_kernel()(&ref, &bodies, 1.0, 0, n_rockets);
+            kernel(&fixed, &bodies, 1.0, 0, n_rockets);
+            if (memcmp(ref.ax, fixed.ax, n_rockets * sizeof(double)) != 0 ||
+                memcmp(ref.ay, fixed.ay, n_rockets * sizeof(double)) != 0) {
+                printf("    %s with %d bodies differs from the generic kernel\n",
+                       rocket_kernel_name(kinds[k]), n);
+                passed = 0;
+            }
+            checked++;
+        }
+        
+        if (rocket_force_kernel_fixed(kinds[k], FIXED_BODIES_MAX + 1) != NULL ||
+            rocket_force_kernel_sized(PRECISION_DOUBLE, FIXED_BODIES_MAX + 1) !=
+                rocket_force_kernel() ||
+            rocket_force_kernel_sized(PRECISION_MIXED, 3) !=
+                rocket_force_kernel_for(PRECISION_MIXED)) {
+            passed = 0;
+        }
+    }
+    select_rocket_kernel(KERNEL_AUTO);
+    printf("    %d specialized kernels bitwise identical to the generic ones\n", checked);
+    
+    soa_free(&bodies);
+    soa_free(&ref);
+    soa_free(&fixed);
+    test_result("Body-count specialized kernels", passed);
+}
+
 int main() {
     printf("\n");
     printf("====================================\n");
@@ -234,8 +701,16 @@ int main() {
     test_force_symmetry();
     test_circular_orbit();
     test_energy_conservation();
+    test_kdk_larger_dt();
+    test_block_timesteps();
     test_rocket_forces();
     test_multi_body();
+    test_soa_roundtrip();
+    test_simd_rocket_kernels();
+    test_barnes_hut();
+    test_float_kernels();
+    test_precision_energy();
+    test_fixed_kernels();
     
     printf("\n====================================\n");
     printf("Results: %d/%d tests passed\n", tests_passed, tests_run);
@@ -1,27 +1,90 @@
 /**
  * Exercise 2.2 - Binary Trajectory Analysis Program
- * 
+ *
  * This program reads the binary trajectory file generated by the simulation
  * and computes statistical summaries of rocket trajectories.
- * 
- * Usage: gcc -o analyze_trails analyze_trails.c -lm
- *        ./analyze_trails rocket_trails.bin
+ *
+ * The v2 trajectory file is memory-mapped: trails are read in place and
+ * the per-rocket index gives direct access to any single rocket. The
+ * statistics come from trail_stats.c, like rocket_stats.csv.
+ *
+ * Given several files (a parameter sweep), or --summary / --list, the
+ * files are analyzed in parallel, one per thread, and every rocket of
+ * every file becomes one row of a single CSV, written in input order:
+ *
+ *   File,RocketID,Points,PathLength,MinDistance,MaxDistance,
+ *   FinalDistance,MinX,MaxX,MinY,MaxY
+ *
+ * Usage: make tools
+ *        ./bin/analyze_trails rocket_trails.bin [rocket_id]
+ *        ./bin/analyze_trails [--summary out.csv] [--threads N] [--list paths.txt]
+ *                             run1/rocket_trails.bin run2/rocket_trails.bin ...
  */
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <math.h>
+#include "nbody.h"
 
-int main(int argc, char *argv[]) {
-    const char *filename = "rocket_trails.bin";
+#define SUMMARY_FILE "trail_summary.csv"
+
+/**
+ * One trail file of a sweep and its summary rows
+ */
+typedef struct {
+    const char *path;
+    char *rows;             // CSV rows (open_memstream)
+    size_t rows_size;
+    int n_rockets;          // -1 if the file could not be read
+    long long points;
+    double longest_path;    // Longest path of any rocket, and that rocket
+    int longest_rocket;
+    double farthest;        // Largest distance from the origin reached
+    int done;
+} SweepFile;
+
+/**
+ * Monotonic wall-clock time in seconds
+ */
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Print the statistics of one rocket's trail, read in place
+ */
+static void analyze_rocket(const TrailFile *file, int i) {
+    TrailStats stats;
+    trail_stats_file(file, i, &stats);
     
-    if (argc > 1) {
-        filename = argv[1];
+    printf("Rocket %d:\n", i);
+    printf("  Trail points: %ld\n", stats.points);
+    if (stats.points == 0) {
+        printf("\n");
+        return;
     }
     
-    FILE *f = fopen(filename, "rb");
-    if (!f) {
-        printf("Error: Could not open %s\n", filename);
+    // Initial and final positions
+    printf("  Initial position: (%.3f, %.3f)\n", stats.first_x, stats.first_y);
+    printf("  Final position: (%.3f, %.3f)\n", stats.last_x, stats.last_y);
+    
+    double final_dist = sqrt(stats.last_x * stats.last_x + stats.last_y * stats.last_y);
+    
+    printf("  Total trajectory length: %.3f\n", stats.path_length);
+    printf("  Distance from origin:\n");
+    printf("    Minimum: %.3f\n", sqrt(stats.min_d2));
+    printf("    Maximum: %.3f\n", sqrt(stats.max_d2));
+    printf("    Final: %.3f\n", final_dist);
+    printf("  Bounding box: X[%.3f, %.3f], Y[%.3f, %.3f]\n",
+           stats.min_x, stats.max_x, stats.min_y, stats.max_y);
+    printf("\n");
+}
+
+/**
+ * Report of every rocket (or only `only`) of one file
+ */
+static int analyze_file(const char *filename, int only) {
+    TrailFile file;
+    if (trail_file_open(&file, filename) != 0) {
         return 1;
     }
     
@@ -30,103 +93,238 @@ int main(int argc, char *argv[]) {
     printf("====================================\n");
     printf("Reading from: %s\n\n", filename);
     
-    // Read number of rockets
-    int n_rockets;
-    if (fread(&n_rockets, sizeof(int), 1, f) != 1) {
-        printf("Error reading number of rockets\n");
-        fclose(f);
-        return 1;
+    int n_rockets = trail_file_count(&file);
+    printf("Number of rockets: %d\n", n_rockets);
+    printf("Format: v%d, %s columns\n\n", TRAIL_VERSION,
+           (file.header->elem_size == 8) ? "float64" : "float32");
+    
+    if (only >= 0) {
+        // Direct access through the index, no scan of earlier rockets
+        if (only < n_rockets) {
+            analyze_rocket(&file, only);
+        } else {
+            printf("Error: Rocket %d not in file\n", only);
+        }
+    } else {
+        for (int i = 0; i < n_rockets; i++) {
+            analyze_rocket(&file, i);
+        }
     }
     
-    printf("Number of rockets: %d\n\n", n_rockets);
+    trail_file_close(&file);
+    
+    printf("====================================\n");
+    printf("Analysis complete!\n");
+    printf("====================================\n");
+    
+    return 0;
+}
+
+/**
+ * Summary rows of every rocket in one file of a sweep
+ */
+static void summarize_file(SweepFile *sf) {
+    sf->n_rockets = -1;
+    TrailFile file;
+    if (trail_file_open(&file, sf->path) != 0) return;
+    
+    FILE *mem = open_memstream(&sf->rows, &sf->rows_size);
+    if (!mem) {
+        printf("Error: %s: could not store its summary\n", sf->path);
+        trail_file_close(&file);
+        return;
+    }
     
-    // Analyze each rocket
+    int n_rockets = trail_file_count(&file);
     for (int i = 0; i < n_rockets; i++) {
-        int trail_length;
-        if (fread(&trail_length, sizeof(int), 1, f) != 1) {
-            printf("Error reading trail length for rocket %d\n", i);
-            break;
-        }
-        
-        // Allocate memory for trajectory
-        double *trail_x = (double *)malloc(trail_length * sizeof(double));
-        double *trail_y = (double *)malloc(trail_length * sizeof(double));
-        
-        if (!trail_x || !trail_y) {
-            printf("Memory allocation failed\n");
-            break;
+        TrailStats s;
+        trail_stats_file(&file, i, &s);
+        sf->points += s.points;
+        if (s.points == 0) {
+            fprintf(mem, "%s,%d,0,0,,,,,,,\n", sf->path, i);
+            continue;
         }
         
-        // Read trajectory data
-        if (fread(trail_x, sizeof(double), trail_length, f) != trail_length ||
-            fread(trail_y, sizeof(double), trail_length, f) != trail_length) {
-            printf("Error reading trajectory data for rocket %d\n", i);
-            free(trail_x);
-            free(trail_y);
-            break;
+        double max_dist = sqrt(s.max_d2);
+        if (s.path_length > sf->longest_path || sf->longest_rocket < 0) {
+            sf->longest_path = s.path_length;
+            sf->longest_rocket = i;
         }
+        if (max_dist > sf->farthest) sf->farthest = max_dist;
+        fprintf(mem, "%s,%d,%ld,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n",
+                sf->path, i, s.points, s.path_length, sqrt(s.min_d2), max_dist,
+                sqrt(s.last_x * s.last_x + s.last_y * s.last_y),
+                s.min_x, s.max_x, s.min_y, s.max_y);
+    }
+    trail_file_close(&file);
+    if (fclose(mem) == 0) sf->n_rockets = n_rockets;
+    else printf("Error: %s: could not store its summary\n", sf->path);
+}
+
+/**
+ * Append the non-comment lines of a path list to `paths`
+ * Returns the new number of paths, or -1
+ */
+static int read_path_list(const char *filename, char ***paths, int n, int *capacity) {
+    FILE *f = fopen(filename, "r");
+    if (!f) {
+        printf("Error: Could not open %s\n", filename);
+        return -1;
+    }
+    
+    char line[1024];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
         
-        // Compute statistics
-        printf("Rocket %d:\n", i);
-        printf("  Trail points: %d\n", trail_length);
-        
-        // Initial and final positions
-        printf("  Initial position: (%.3f, %.3f)\n", trail_x[0], trail_y[0]);
-        printf("  Final position: (%.3f, %.3f)\n", 
-               trail_x[trail_length-1], trail_y[trail_length-1]);
-        
-        // Total trajectory length
-        double total_length = 0.0;
-        for (int j = 1; j < trail_length; j++) {
-            double dx = trail_x[j] - trail_x[j-1];
-            double dy = trail_y[j] - trail_y[j-1];
-            total_length += sqrt(dx * dx + dy * dy);
+        if (n == *capacity) {
+            int grown_capacity = *capacity ? 2 * *capacity : INITIAL_CAPACITY;
+            char **grown = (char **)realloc(*paths, grown_capacity * sizeof(char *));
+            if (!grown) {
+                printf("Error: Memory allocation failed (%d paths)\n", grown_capacity);
+                fclose(f);
+                return -1;
+            }
+            *paths = grown;
+            *capacity = grown_capacity;
         }
-        printf("  Total trajectory length: %.3f\n", total_length);
-        
-        // Distance from origin (min, max, final)
-        double min_dist = 1e9, max_dist = 0.0;
-        for (int j = 0; j < trail_length; j++) {
-            double dist = sqrt(trail_x[j] * trail_x[j] + 
-                             trail_y[j] * trail_y[j]);
-            if (dist < min_dist) min_dist = dist;
-            if (dist > max_dist) max_dist = dist;
+        (*paths)[n] = strdup(line);
+        if (!(*paths)[n]) {
+            fclose(f);
+            return -1;
         }
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+/**
+ * Analyze every file of a sweep in parallel into one summary CSV
+ */
+static int summarize_sweep(char **paths, int n, const char *out_file, int threads) {
+    SweepFile *files = (SweepFile *)calloc(n > 0 ? n : 1, sizeof(SweepFile));
+    FILE *out = fopen(out_file, "w");
+    if (!files || !out) {
+        printf("Error: Could not create %s\n", out_file);
+        free(files);
+        if (out) fclose(out);
+        return 1;
+    }
+    fprintf(out, "File,RocketID,Points,PathLength,MinDistance,MaxDistance,FinalDistance,"
+            "MinX,MaxX,MinY,MaxY\n");
+    
+    int workers = (threads > 0) ? threads : max_threads();
+    printf("Analyzing %d trail file(s) on %d thread(s), %s kernel\n",
+           n, OMP_THREADS(workers), trail_stats_kernel());
+    double start = now_seconds();
+    
+    // One file per worker, taken in input order; finished rows are
+    // written as soon as all earlier files are out
+    int next_write = 0;
+    #pragma omp parallel for schedule(dynamic, 1) if(workers > 1) num_threads(OMP_THREADS(workers))
+    for (int k = 0; k < n; k++) {
+        files[k].path = paths[k];
+        files[k].longest_rocket = -1;
+        summarize_file(&files[k]);
         
-        double final_dist = sqrt(trail_x[trail_length-1] * trail_x[trail_length-1] +
-                                trail_y[trail_length-1] * trail_y[trail_length-1]);
-        
-        printf("  Distance from origin:\n");
-        printf("    Minimum: %.3f\n", min_dist);
-        printf("    Maximum: %.3f\n", max_dist);
-        printf("    Final: %.3f\n", final_dist);
-        
-        // Bounding box
-        double min_x = trail_x[0], max_x = trail_x[0];
-        double min_y = trail_y[0], max_y = trail_y[0];
-        
-        for (int j = 1; j < trail_length; j++) {
-            if (trail_x[j] < min_x) min_x = trail_x[j];
-            if (trail_x[j] > max_x) max_x = trail_x[j];
-            if (trail_y[j] < min_y) min_y = trail_y[j];
-            if (trail_y[j] > max_y) max_y = trail_y[j];
+        #pragma omp critical(sweep_output)
+        {
+            files[k].done = 1;
+            while (next_write < n && files[next_write].done) {
+                SweepFile *sf = &files[next_write++];
+                if (sf->rows) fwrite(sf->rows, 1, sf->rows_size, out);
+                free(sf->rows);
+                sf->rows = NULL;
+            }
         }
-        
-        printf("  Bounding box: X[%.3f, %.3f], Y[%.3f, %.3f]\n",
-               min_x, max_x, min_y, max_y);
-        
-        printf("\n");
-        
-        // Clean up
-        free(trail_x);
-        free(trail_y);
     }
     
-    fclose(f);
+    int write_failed = (fclose(out) != 0);
+    double seconds = now_seconds() - start;
     
+    int failed = 0, longest_file = -1, farthest_file = -1;
+    long long rockets = 0, points = 0;
+    for (int k = 0; k < n; k++) {
+        const SweepFile *sf = &files[k];
+        if (sf->n_rockets < 0) {
+            failed++;
+            continue;
+        }
+        rockets += sf->n_rockets;
+        points += sf->points;
+        if (sf->longest_rocket >= 0 &&
+            (longest_file < 0 || sf->longest_path > files[longest_file].longest_path)) {
+            longest_file = k;
+        }
+        if (farthest_file < 0 || sf->farthest > files[farthest_file].farthest) farthest_file = k;
+    }
+    
+    printf("\n====================================\n");
+    printf("Sweep Analysis Complete\n");
     printf("====================================\n");
-    printf("Analysis complete!\n");
-    printf("====================================\n");
+    printf("Files: %d analyzed, %d unreadable\n", n - failed, failed);
+    printf("Rockets: %lld, trail points: %lld\n", rockets, points);
+    printf("Time: %.3f s (%.1f M points/s)\n", seconds,
+           (seconds > 0.0) ? points / seconds * 1e-6 : 0.0);
+    if (longest_file >= 0) {
+        printf("Longest path: %.3f (rocket %d of %s)\n", files[longest_file].longest_path,
+               files[longest_file].longest_rocket, files[longest_file].path);
+    }
+    if (farthest_file >= 0) {
+        printf("Farthest distance: %.3f (%s)\n", files[farthest_file].farthest,
+               files[farthest_file].path);
+    }
+    if (write_failed) printf("Error: Could not write %s\n", out_file);
+    else printf("Summary: %s\n", out_file);
     
-    return 0;
-}
\ No newline at end of file
+    free(files);
+    return (failed > 0 || write_failed) ? 1 : 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *summary = NULL;
+    int threads = 0, sweep = 0;
+    char **paths = NULL;
+    int n = 0, capacity = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "--summary") == 0 || strcmp(argv[i], "--threads") == 0 ||
+             strcmp(argv[i], "--list") == 0) && i + 1 >= argc) {
+            printf("Error: %s needs a value\n", argv[i]);
+            return 1;
+        }
+        if (strcmp(argv[i], "--summary") == 0) {
+            summary = argv[++i];
+            sweep = 1;
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--list") == 0) {
+            n = read_path_list(argv[++i], &paths, n, &capacity);
+            if (n < 0) return 1;
+            sweep = 1;
+        } else {
+            if (n == capacity) {
+                capacity = capacity ? 2 * capacity : INITIAL_CAPACITY;
+                char **grown = (char **)realloc(paths, capacity * sizeof(char *));
+                if (!grown) return 1;
+                paths = grown;
+            }
+            paths[n++] = strdup(argv[i]);
+        }
+    }
+    
+    // One file: the per-rocket report, as before; an optional second
+    // argument selects a single rocket
+    int status;
+    if (!sweep && n <= 2 && (n < 2 || strspn(paths[1], "0123456789") == strlen(paths[1]))) {
+        status = analyze_file(n > 0 ? paths[0] : "rocket_trails.bin",
+                              n > 1 ? atoi(paths[1]) : -1);
+    } else {
+        status = summarize_sweep(paths, n, summary ? summary : SUMMARY_FILE, threads);
+    }
+    
+    for (int k = 0; k < n; k++) free(paths[k]);
+    free(paths);
+    return status;
+}
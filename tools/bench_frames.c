@@ -0,0 +1,221 @@
+/**
+ * Frame Output Benchmark
+ *
+ * Measures how fast the simulator turns state into BMP frames. The
+ * default scenario is advanced for a number of steps so rockets carry
+ * realistic trails, then the same frame is rendered and written
+ * repeatedly. Render, encode and write are timed separately, and
+ * together as the per-frame cost seen by the main loop.
+ *
+ * The incremental renderer is timed in steady state: its trail layer is
+ * primed once, so each frame is the fade and composite pass. A 256x256
+ * thumbnail of the same view is timed as well, and the tiled rasterizer
+ * on all available threads when there is more than one. The density
+ * heatmap is timed on the scenario's rockets and on a synthetic cloud of
+ * DENSITY_BENCH_POINTS particles.
+ *
+ * Usage: make bench
+ *        ./bin/bench_frames [frames] [warmup_steps] [output.bmp]
+ */
+
+#include "nbody.h"
+
+#define DENSITY_BENCH_POINTS 1000000
+
+/**
+ * Monotonic wall-clock time in seconds
+ */
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Print one benchmark line
+ */
+static void report(const char *what, int frames, double seconds) {
+    double fps = (seconds > 0.0) ? frames / seconds : 0.0;
+    printf("  %-22s %8.1f frames/s  (%.3f ms/frame)\n",
+           what, fps, 1e3 * seconds / frames);
+}
+
+int main(int argc, char *argv[]) {
+    int frames = 200;
+    int warmup = 2000;
+    const char *output_file = "output/bench_frame.bmp";
+    
+    if (argc > 1) frames = atoi(argv[1]);
+    if (argc > 2) warmup = atoi(argv[2]);
+    if (argc > 3) output_file = argv[3];
+    if (frames < 1) frames = 1;
+    
+    SimState state;
+    sim_state_init(&state);
+    
+    SimConfig config;
+    sim_config_default(&config);
+    load_config("config/config.txt", &config);
+    
+    if (load_bodies("config/bodies.txt", &state) < 0) {
+        init_bodies_default(&state);
+    }
+    if (load_rockets("config/rockets.txt", &state) < 0) {
+        init_rockets_default(&state);
+    }
+    
+    Viewport view;
+    viewport_init(&view, config.width, config.height, config.scale,
+                  config.center_x, config.center_y);
+    int w = view.width, h = view.height;
+    
+    Pixel *img = (Pixel *)malloc((size_t)w * h * sizeof(Pixel));
+    unsigned char *buffer = (unsigned char *)malloc(bmp_file_size(w, h));
+    if (!img || !buffer || sim_state_pack(&state) != 0) {
+        printf("Error: Memory allocation failed\n");
+        free(img);
+        free(buffer);
+        sim_state_free(&state);
+        return 1;
+    }
+    
+    printf("====================================\n");
+    printf("Frame Output Benchmark\n");
+    printf("====================================\n");
+    printf("Image: %dx%d (%ld bytes per BMP)\n", w, h, bmp_file_size(w, h));
+    printf("Bodies: %d, Rockets: %d\n", state.n_bodies, state.n_rockets);
+    printf("Warm-up steps: %d\n", warmup);
+    printf("Frames: %d -> %s\n\n", frames, output_file);
+    
+    // Grow trails so the render cost is representative
+    for (int step = 0; step < warmup; step++) {
+        sim_step(&state, &config);
+    }
+    sim_state_unpack(&state);
+    
+    double t0 = now_seconds();
+    for (int f = 0; f < frames; f++) {
+        render(state.bodies, state.n_bodies, state.rockets, state.n_rockets,
+               img, &view, 1);
+    }
+    double t_render = now_seconds() - t0;
+    
+    int tiled_threads = max_threads();
+    double t_tiled = -1.0;
+    if (tiled_threads > 1) {
+        t0 = now_seconds();
+        for (int f = 0; f < frames; f++) {
+            render(state.bodies, state.n_bodies, state.rockets, state.n_rockets,
+                   img, &view, tiled_threads);
+        }
+        t_tiled = now_seconds() - t0;
+    }
+    
+    // Same field of view, drawn directly at thumbnail size
+    Viewport thumb;
+    viewport_init(&thumb, 256, 256, view.scale * 256 / ((w < h) ? w : h),
+                  view.center_x, view.center_y);
+    t0 = now_seconds();
+    for (int f = 0; f < frames; f++) {
+        render(state.bodies, state.n_bodies, state.rockets, state.n_rockets,
+               img, &thumb, 1);
+    }
+    double t_thumb = now_seconds() - t0;
+    
+    TrailCanvas canvas;
+    double t_incremental = -1.0;
+    if (trail_canvas_init(&canvas, &view, state.n_rockets, config.trail_decay) == 0) {
+        trail_canvas_update(&canvas, state.rockets, state.n_rockets, &view);
+        t0 = now_seconds();
+        for (int f = 0; f < frames; f++) {
+            trail_canvas_update(&canvas, state.rockets, state.n_rockets, &view);
+            render_composite(&canvas, state.bodies, state.n_bodies,
+                             state.rockets, state.n_rockets, img, &view);
+        }
+        t_incremental = now_seconds() - t0;
+        trail_canvas_free(&canvas);
+    }
+    
+    DensityMap density;
+    double t_density = -1.0, t_cloud = -1.0;
+    double *cloud_x = (double *)malloc(DENSITY_BENCH_POINTS * sizeof(double));
+    double *cloud_y = (double *)malloc(DENSITY_BENCH_POINTS * sizeof(double));
+    if (cloud_x && cloud_y && density_init(&density, &view, config.render_threads) == 0) {
+        ParticleSoA *soa = &state.rocket_soa;
+        t0 = now_seconds();
+        for (int f = 0; f < frames; f++) {
+            render_density(&density, state.bodies, state.n_bodies, soa->x, soa->y,
+                           soa->active, soa->n, img, &view);
+        }
+        t_density = now_seconds() - t0;
+        
+        // Uniform disc filling most of the view
+        srand(1);
+        double radius = 0.45 * ((w < h) ? w : h) / view.scale;
+        for (int i = 0; i < DENSITY_BENCH_POINTS; i++) {
+            double r = radius * sqrt((double)rand() / RAND_MAX);
+            double a = 6.283185307 * rand() / RAND_MAX;
+            cloud_x[i] = view.center_x + r * cos(a);
+            cloud_y[i] = view.center_y + r * sin(a);
+        }
+        t0 = now_seconds();
+        for (int f = 0; f < frames; f++) {
+            render_density(&density, state.bodies, state.n_bodies, cloud_x, cloud_y,
+                           NULL, DENSITY_BENCH_POINTS, img, &view);
+        }
+        t_cloud = now_seconds() - t0;
+        density_free(&density);
+    }
+    free(cloud_x);
+    free(cloud_y);
+    
+    t0 = now_seconds();
+    for (int f = 0; f < frames; f++) {
+        bmp_encode(img, w, h, buffer);
+    }
+    double t_encode = now_seconds() - t0;
+    
+    int failed = 0;
+    t0 = now_seconds();
+    for (int f = 0; f < frames && !failed; f++) {
+        failed = write_bmp(output_file, img, w, h) != 0;
+    }
+    double t_write = now_seconds() - t0;
+    
+    t0 = now_seconds();
+    for (int f = 0; f < frames && !failed; f++) {
+        render(state.bodies, state.n_bodies, state.rockets, state.n_rockets,
+               img, &view, config.render_threads);
+        failed = write_bmp(output_file, img, w, h) != 0;
+    }
+    double t_frame = now_seconds() - t0;
+    
+    if (!failed) {
+        printf("Results:\n");
+        report("render (full)", frames, t_render);
+        if (t_tiled >= 0.0) {
+            char label[32];
+            snprintf(label, sizeof(label), "render (%d threads)", tiled_threads);
+            report(label, frames, t_tiled);
+        }
+        report("render (256x256 thumb)", frames, t_thumb);
+        if (t_incremental >= 0.0) {
+            report("render (incremental)", frames, t_incremental);
+        }
+        if (t_density >= 0.0) {
+            report("render (density)", frames, t_density);
+            report("density (1M points)", frames, t_cloud);
+        }
+        report("bmp_encode (memory)", frames, t_encode);
+        report("write_bmp (file)", frames, t_write);
+        report("render + write_bmp", frames, t_frame);
+        printf("  write throughput: %.1f MB/s\n",
+               frames * (double)bmp_file_size(w, h) / t_write / 1e6);
+    }
+    
+    free(img);
+    free(buffer);
+    sim_state_free(&state);
+    
+    return failed ? 1 : 0;
+}
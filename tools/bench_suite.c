@@ -0,0 +1,387 @@
+/**
+ * Kernel Benchmark Suite
+ *
+ * Times the simulator's hot paths over a sweep of problem sizes
+ * N = 10, 100, ... up to max_n (default 10^6):
+ *
+ *   compute_forces (direct)       N bodies, O(N^2) pair sum (N <= 10^4)
+ *   compute_forces (direct-mixed) the same in float (precision=mixed)
+ *   compute_forces (barnes-hut)   N bodies, tree build and walk
+ *   compute_rocket_forces         N rockets against BENCH_FIELD_BODIES bodies
+ *                                 (soa: double kernel, mixed: float kernel)
+ *   compute_rocket_forces         N rockets against BENCH_FEW_BODIES bodies, one
+ *                                 thread (generic-5: generic kernel, fixed-5:
+ *                                 body-count specialized kernel, and the speedup)
+ *   render                        N rockets with short trails, default view
+ *   write_bmp                     an image of about N pixels
+ *
+ * The forces are the SoA kernels that sim_step() uses (compute_forces()
+ * and compute_rocket_forces() are AoS adapters around them that also
+ * copy the particles in and out). Each case is run BENCH_WARMUP times
+ * untimed (once if that run alone exceeds the budget), then repeated
+ * until it has BENCH_MAX_REPS samples or at least BENCH_MIN_REPS samples
+ * and the time budget is spent. The median, p99
+ * (nearest rank) and minimum go to the console and to a JSON file for
+ * tracking regressions between releases.
+ *
+ * Usage: make bench
+ *        ./bin/bench_suite [output.json] [max_n] [threads] [budget_seconds]
+ */
+
+#include "nbody.h"
+
+#define BENCH_WARMUP 2            // Untimed runs before sampling (1 for slow cases)
+#define BENCH_MIN_REPS 3          // Samples taken even past the budget
+#define BENCH_MAX_REPS 101        // Samples at most
+#define BENCH_BUDGET 0.5          // Default seconds of samples per case
+#define BENCH_DIRECT_MAX 10000    // Largest N for the O(N^2) body sum
+#define BENCH_FIELD_BODIES 16     // Bodies acting on the rockets
+#define BENCH_FEW_BODIES 5        // Bodies of the specialized-kernel cases (as config/bodies.txt)
+#define BENCH_TRAIL 8             // Trail points per rocket in the render case
+#define BENCH_BMP_FILE "bench_suite.bmp"  // Written next to the JSON file
+
+/**
+ * Everything a case reads, for one problem size
+ */
+typedef struct {
+    Body *bodies;           // N bodies (body cases) or BENCH_FIELD_BODIES
+    int n_bodies;
+    ParticleSoA body_soa;
+    Rocket *rockets;        // N rockets, trails in `trail_pool`
+    int n_rockets;
+    double *trail_pool;
+    ParticleSoA rocket_soa;
+    QuadTree tree;
+    Pixel *img;
+    Viewport view;
+    char bmp_file[PATH_LEN]; // write_bmp target
+    int threads;
+    int precision;          // PRECISION_* of the force cases
+    RocketForceKernel kernel; // Kernel of the few-bodies cases
+    double median;          // Median seconds of the last case
+    int failed;             // A case reported an error
+} BenchData;
+
+/**
+ * Monotonic wall-clock time in seconds
+ */
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Uniform random number in [0, 1)
+ */
+static double uniform(void) {
+    return rand() / (RAND_MAX + 1.0);
+}
+
+/**
+ * Direct O(N^2) body forces
+ */
+static void run_direct(BenchData *d) {
+    if (d->precision != PRECISION_DOUBLE) compute_forces_float(&d->body_soa, G, d->threads,
+                                                               d->precision);
+    else if (d->threads > 1) compute_forces_threaded(&d->body_soa, G, d->threads);
+    else compute_forces_soa(&d->body_soa, G);
+}
+
+/**
+ * Barnes-Hut body forces, tree build included
+ */
+static void run_barnes_hut(BenchData *d) {
+    if (compute_forces_bh(&d->body_soa, &d->tree, G, THETA, d->threads) != 0) d->failed = 1;
+}
+
+/**
+ * Rocket forces from the dispatched (SIMD) kernel
+ */
+static void run_rockets(BenchData *d) {
+    if (d->threads > 1) {
+        compute_rocket_forces_threaded(&d->rocket_soa, &d->body_soa, G, d->threads,
+                                       d->precision);
+    } else {
+        rocket_force_kernel_for(d->precision)(&d->rocket_soa, &d->body_soa, G,
+                                              0, d->rocket_soa.n);
+    }
+}
+
+/**
+ * Rocket forces from one given kernel, serial
+ */
+static void run_kernel(BenchData *d) {
+    d->kernel(&d->rocket_soa, &d->body_soa, G, 0, d->rocket_soa.n);
+}
+
+/**
+ * Render one frame
+ */
+static void run_render(BenchData *d) {
+    render(d->bodies, d->n_bodies, d->rockets, d->n_rockets, d->img, &d->view, d->threads);
+}
+
+/**
+ * Encode and write one BMP file
+ */
+static void run_write(BenchData *d) {
+    if (write_bmp(d->bmp_file, d->img, d->view.width, d->view.height) != 0) d->failed = 1;
+}
+
+/**
+ * Bodies scattered over a disc of radius `radius` (x, y, mass)
+ */
+static int make_bodies(BenchData *d, int n, double radius) {
+    d->bodies = (Body *)calloc(n, sizeof(Body));
+    if (!d->bodies) return -1;
+    for (int i = 0; i < n; i++) {
+        double r = radius * sqrt(uniform());
+        double a = 2.0 * M_PI * uniform();
+        d->bodies[i].x = r * cos(a);
+        d->bodies[i].y = r * sin(a);
+        d->bodies[i].mass = 100.0 / n;
+    }
+    d->n_bodies = n;
+    return soa_from_bodies(&d->body_soa, d->bodies, n);
+}
+
+/**
+ * Rockets inside the default view, each with a short straight trail
+ */
+static int make_rockets(BenchData *d, int n) {
+    d->rockets = (Rocket *)calloc(n, sizeof(Rocket));
+    d->trail_pool = (double *)malloc((size_t)n * 2 * BENCH_TRAIL * sizeof(double));
+    if (!d->rockets || !d->trail_pool) return -1;
+    for (int i = 0; i < n; i++) {
+        Rocket *r = &d->rockets[i];
+        double radius = 7.0 * sqrt(uniform());
+        double a = 2.0 * M_PI * uniform();
+        r->x = radius * cos(a);
+        r->y = radius * sin(a);
+        r->vx = -sin(a);
+        r->vy = cos(a);
+        r->active = 1;
+        r->trail_x = d->trail_pool + (size_t)i * 2 * BENCH_TRAIL;
+        r->trail_y = r->trail_x + BENCH_TRAIL;
+        r->trail_capacity = BENCH_TRAIL;
+        r->trail_length = BENCH_TRAIL;
+        for (int k = 0; k < BENCH_TRAIL; k++) {
+            r->trail_x[k] = r->x - (BENCH_TRAIL - 1 - k) * 0.05 * r->vx;
+            r->trail_y[k] = r->y - (BENCH_TRAIL - 1 - k) * 0.05 * r->vy;
+        }
+    }
+    d->n_rockets = n;
+    return soa_from_rockets(&d->rocket_soa, d->rockets, n);
+}
+
+/**
+ * Release the particles of one problem size
+ */
+static void free_data(BenchData *d) {
+    free(d->bodies);
+    free(d->rockets);
+    free(d->trail_pool);
+    soa_free(&d->body_soa);
+    soa_free(&d->rocket_soa);
+    quadtree_free(&d->tree);
+    free(d->img);
+    d->bodies = NULL;
+    d->rockets = NULL;
+    d->trail_pool = NULL;
+    d->img = NULL;
+    d->n_bodies = d->n_rockets = 0;
+}
+
+/**
+ * qsort() order for samples
+ */
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * Time one case and report it; returns 0, or -1 if the case failed
+ */
+static int bench_case(FILE *json, int *first, const char *name, const char *variant,
+                      const char *unit, long n, void (*run)(BenchData *), BenchData *d,
+                      double budget) {
+    double samples[BENCH_MAX_REPS];
+    int reps = 0, warmup = 0;
+    
+    d->failed = 0;
+    double start = now_seconds();
+    while (warmup < BENCH_WARMUP && !d->failed &&
+           (warmup == 0 || now_seconds() - start < budget)) {
+        run(d);
+        warmup++;
+    }
+    
+    start = now_seconds();
+    while (!d->failed && reps < BENCH_MAX_REPS &&
+           (reps < BENCH_MIN_REPS || now_seconds() - start < budget)) {
+        double t0 = now_seconds();
+        run(d);
+        samples[reps++] = now_seconds() - t0;
+    }
+    if (d->failed || reps == 0) {
+        printf("  %-32s %9ld  failed\n", name, n);
+        return -1;
+    }
+    
+    qsort(samples, reps, sizeof(double), compare_doubles);
+    double median = (reps % 2) ? samples[reps / 2] :
+                    0.5 * (samples[reps / 2 - 1] + samples[reps / 2]);
+    double p99 = samples[(int)ceil(0.99 * reps) - 1];
+    double rate = (median > 0.0) ? n / median : 0.0;
+    d->median = median;
+    
+    char label[64];
+    snprintf(label, sizeof(label), "%s (%s)", name, variant);
+    printf("  %-32s %9ld  %10.4f ms  %10.4f ms  %10.3e %s/s  (%d reps)\n",
+           label, n, 1e3 * median, 1e3 * p99, rate, unit, reps);
+    
+    fprintf(json, "%s\n    {\"name\": \"%s\", \"variant\": \"%s\", \"n\": %ld, "
+            "\"unit\": \"%s\", \"warmup\": %d, \"reps\": %d, \"median_s\": %.9e, "
+            "\"p99_s\": %.9e, \"min_s\": %.9e, \"per_second\": %.6e}",
+            *first ? "" : ",", name, variant, n, unit, warmup, reps,
+            median, p99, samples[0], rate);
+    *first = 0;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *json_file = "output/bench.json";
+    long max_n = 1000000;
+    int threads = 1;
+    double budget = BENCH_BUDGET;
+    
+    if (argc > 1) json_file = argv[1];
+    if (argc > 2) max_n = atol(argv[2]);
+    if (argc > 3) threads = atoi(argv[3]);
+    if (argc > 4) budget = atof(argv[4]);
+    if (max_n < 10) max_n = 10;
+    if (threads < 1) threads = 1;
+    
+    FILE *json = fopen(json_file, "w");
+    if (!json) {
+        printf("Error: Could not create %s\n", json_file);
+        return 1;
+    }
+    
+    time_t now = time(NULL);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+    const char *kernel = rocket_kernel_name(rocket_kernel_kind());
+    
+    printf("====================================\n");
+    printf("Kernel Benchmark Suite\n");
+    printf("====================================\n");
+    printf("Sizes: 10 .. %ld, threads: %d, rocket kernel: %s\n", max_n, threads, kernel);
+    printf("Warm-up: up to %d runs, samples: %d..%d within %.2f s per case\n\n",
+           BENCH_WARMUP, BENCH_MIN_REPS, BENCH_MAX_REPS, budget);
+    printf("  %-32s %9s  %13s  %13s  %s\n", "case", "N", "median", "p99", "throughput");
+    
+    fprintf(json, "{\n  \"suite\": \"nbody-kernels\",\n  \"version\": 1,\n");
+    fprintf(json, "  \"date\": \"%s\",\n  \"compiler\": \"%s\",\n", date, __VERSION__);
+    fprintf(json, "  \"threads\": %d,\n  \"rocket_kernel\": \"%s\",\n", threads, kernel);
+    fprintf(json, "  \"budget_s\": %.3f,\n  \"results\": [", budget);
+    
+    BenchData d;
+    memset(&d, 0, sizeof(d));
+    d.threads = threads;
+    quadtree_init(&d.tree);
+    const char *slash = strrchr(json_file, '/');
+    char dir[PATH_LEN];
+    snprintf(dir, sizeof(dir), "%.*s", slash ? (int)(slash - json_file) : 0, json_file);
+    output_path(d.bmp_file, sizeof(d.bmp_file), dir, BENCH_BMP_FILE);
+    int first = 1, failed = 0;
+    srand(1);
+    
+    for (long n = 10; n <= max_n; n *= 10) {
+        // Bodies against bodies
+        if (make_bodies(&d, (int)n, 10.0) != 0) {
+            printf("Error: Memory allocation failed (%ld bodies)\n", n);
+            failed = 1;
+            break;
+        }
+        if (n <= BENCH_DIRECT_MAX) {
+            d.precision = PRECISION_DOUBLE;
+            failed |= bench_case(json, &first, "compute_forces", "direct", "bodies", n,
+                                 run_direct, &d, budget) != 0;
+            d.precision = PRECISION_MIXED;
+            failed |= bench_case(json, &first, "compute_forces", "direct-mixed", "bodies", n,
+                                 run_direct, &d, budget) != 0;
+        }
+        failed |= bench_case(json, &first, "compute_forces", "barnes-hut", "bodies", n,
+                             run_barnes_hut, &d, budget) != 0;
+        free_data(&d);
+        
+        // Rockets in a fixed field, then drawn
+        viewport_init(&d.view, WIDTH, HEIGHT, 0.0, 0.0, 0.0);
+        d.img = (Pixel *)malloc((size_t)d.view.width * d.view.height * sizeof(Pixel));
+        if (!d.img || make_bodies(&d, BENCH_FIELD_BODIES, 5.0) != 0 ||
+            make_rockets(&d, (int)n) != 0) {
+            printf("Error: Memory allocation failed (%ld rockets)\n", n);
+            failed = 1;
+            break;
+        }
+        d.precision = PRECISION_DOUBLE;
+        failed |= bench_case(json, &first, "compute_rocket_forces", "soa", "rockets", n,
+                             run_rockets, &d, budget) != 0;
+        d.precision = PRECISION_MIXED;
+        failed |= bench_case(json, &first, "compute_rocket_forces", "mixed", "rockets", n,
+                             run_rockets, &d, budget) != 0;
+        failed |= bench_case(json, &first, "render", "rockets", "rockets", n,
+                             run_render, &d, budget) != 0;
+        free_data(&d);
+        
+        // Rockets around a few bodies: generic against specialized kernel
+        if (make_bodies(&d, BENCH_FEW_BODIES, 5.0) != 0 || make_rockets(&d, (int)n) != 0) {
+            printf("Error: Memory allocation failed (%ld rockets)\n", n);
+            failed = 1;
+            break;
+        }
+        char generic_name[32], fixed_name[32];
+        snprintf(generic_name, sizeof(generic_name), "generic-%d", BENCH_FEW_BODIES);
+        snprintf(fixed_name, sizeof(fixed_name), "fixed-%d", BENCH_FEW_BODIES);
+        d.kernel = rocket_force_kernel();
+        failed |= bench_case(json, &first, "compute_rocket_forces", generic_name, "rockets", n,
+                             run_kernel, &d, budget) != 0;
+        double generic = d.median;
+        d.kernel = rocket_force_kernel_sized(PRECISION_DOUBLE, BENCH_FEW_BODIES);
+        failed |= bench_case(json, &first, "compute_rocket_forces", fixed_name, "rockets", n,
+                             run_kernel, &d, budget) != 0;
+        if (generic > 0.0 && d.median > 0.0) {
+            printf("  %-32s %9ld  %.2fx\n", "  specialized speedup", n, generic / d.median);
+        }
+        free_data(&d);
+        
+        // An image of about n pixels, from a rendered frame
+        int side = (int)sqrt((double)n);
+        if (side < 16) side = 16;
+        if (side > MAX_IMAGE_SIZE) side = MAX_IMAGE_SIZE;
+        viewport_init(&d.view, side, side, 0.0, 0.0, 0.0);
+        d.img = (Pixel *)malloc((size_t)side * side * sizeof(Pixel));
+        if (!d.img || make_bodies(&d, BENCH_FIELD_BODIES, 5.0) != 0) {
+            printf("Error: Memory allocation failed (%dx%d image)\n", side, side);
+            failed = 1;
+            break;
+        }
+        run_render(&d);
+        failed |= bench_case(json, &first, "write_bmp", "file", "pixels",
+                             (long)side * side, run_write, &d, budget) != 0;
+        free_data(&d);
+    }
+    free_data(&d);
+    
+    fprintf(json, "\n  ]\n}\n");
+    if (fclose(json) != 0) {
+        printf("Error: Could not write %s\n", json_file);
+        return 1;
+    }
+    printf("\nResults: %s\n", json_file);
+    
+    return failed ? 1 : 0;
+}
@@ -4,131 +4,27 @@
  * This program reads saved trajectory data and renders it to a BMP image
  * without re-running the simulation.
  * 
- * Usage: gcc -o plot_trails plot_trails.c -lm
- *        ./plot_trails rocket_trails.bin output.bmp
- */
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <math.h>
-#include <string.h>
-
-#define WIDTH 800
-#define HEIGHT 800
-
-typedef struct {
-    unsigned char b, g, r;
-} Pixel;
-
-/**
- * Write BMP file
- */
-void write_bmp(const char *filename, Pixel *img, int w, int h) {
-    FILE *f = fopen(filename, "wb");
-    if (!f) {
-        printf("Error: Could not open file %s\n", filename);
-        return;
-    }
-    
-    int row_size = (w * 3 + 3) & ~3;
-    int img_size = row_size * h;
-    int file_size = 54 + img_size;
-    
-    unsigned char header[54] = {
-        'B','M',
-        file_size & 0xFF, (file_size >> 8) & 0xFF, (file_size >> 16) & 0xFF, (file_size >> 24) & 0xFF,
-        0,0,0,0,
-        54,0,0,0,
-        40,0,0,0,
-        w & 0xFF, (w >> 8) & 0xFF, (w >> 16) & 0xFF, (w >> 24) & 0xFF,
-        h & 0xFF, (h >> 8) & 0xFF, (h >> 16) & 0xFF, (h >> 24) & 0xFF,
-        1,0,
-        24,0,
-        0,0,0,0,
-        img_size & 0xFF, (img_size >> 8) & 0xFF, (img_size >> 16) & 0xFF, (img_size >> 24) & 0xFF,
-        0,0,0,0,
-        0,0,0,0,
-        0,0,0,0,
-        0,0,0,0
-    };
-    
-    fwrite(header, 1, 54, f);
-    
-    unsigned char padding[3] = {0, 0, 0};
-    int pad_size = row_size - w * 3;
-    
-    for (int y = h - 1; y >= 0; y--) {
-        for (int x = 0; x < w; x++) {
-            Pixel *p = &img[y * w + x];
-            fwrite(p, 3, 1, f);
-        }
-        if (pad_size > 0) {
-            fwrite(padding, 1, pad_size, f);
-        }
-    }
-    
-    fclose(f);
-}
-
-/**
- * Draw a line using Bresenham's algorithm
+ * The v2 trajectory file is memory-mapped and trails are drawn straight
+ * from the mapping, without loading them into memory first. Drawing and
+ * BMP output are shared with the simulator (render.c, bmp_io.c).
+ * 
+ * Image size, scale and center are read from the simulator's config file
+ * (width, height, scale, center_x, center_y), so the plot matches the frames.
+ * 
+ * Usage: make tools
+ *        ./bin/plot_trails rocket_trails.bin output.bmp [config.txt]
  */
-void draw_line(Pixel *img, int x1, int y1, int x2, int y2, 
-               unsigned char r, unsigned char g, unsigned char b) {
-    int dx = abs(x2 - x1);
-    int dy = abs(y2 - y1);
-    int sx = (x1 < x2) ? 1 : -1;
-    int sy = (y1 < y2) ? 1 : -1;
-    int err = dx - dy;
-    
-    int x = x1, y = y1;
-    while (1) {
-        if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) {
-            img[y * WIDTH + x].r = r;
-            img[y * WIDTH + x].g = g;
-            img[y * WIDTH + x].b = b;
-        }
-        
-        if (x == x2 && y == y2) break;
-        
-        int e2 = 2 * err;
-        if (e2 > -dy) {
-            err -= dy;
-            x += sx;
-        }
-        if (e2 < dx) {
-            err += dx;
-            y += sy;
-        }
-    }
-}
 
-/**
- * Draw a filled circle
- */
-void draw_circle(Pixel *img, int cx, int cy, int radius,
-                unsigned char r, unsigned char g, unsigned char b) {
-    for (int dy = -radius; dy <= radius; dy++) {
-        for (int dx = -radius; dx <= radius; dx++) {
-            if (dx * dx + dy * dy <= radius * radius) {
-                int x = cx + dx;
-                int y = cy + dy;
-                if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) {
-                    img[y * WIDTH + x].r = r;
-                    img[y * WIDTH + x].g = g;
-                    img[y * WIDTH + x].b = b;
-                }
-            }
-        }
-    }
-}
+#include "nbody.h"
 
 int main(int argc, char *argv[]) {
     const char *input_file = "rocket_trails.bin";
     const char *output_file = "plotted_trails.bmp";
+    const char *config_file = "config.txt";
     
     if (argc > 1) input_file = argv[1];
     if (argc > 2) output_file = argv[2];
+    if (argc > 3) config_file = argv[3];
     
     printf("====================================\n");
     printf("Trajectory Plotting Tool\n");
@@ -136,51 +32,38 @@ int main(int argc, char *argv[]) {
     printf("Input: %s\n", input_file);
     printf("Output: %s\n\n", output_file);
     
-    // Open binary file
-    FILE *f = fopen(input_file, "rb");
-    if (!f) {
-        printf("Error: Could not open %s\n", input_file);
-        return 1;
-    }
+    SimConfig config;
+    sim_config_default(&config);
+    load_config(config_file, &config);
+    
+    Viewport view;
+    viewport_init(&view, config.width, config.height, config.scale,
+                  config.center_x, config.center_y);
     
-    // Read number of rockets
-    int n_rockets;
-    if (fread(&n_rockets, sizeof(int), 1, f) != 1) {
-        printf("Error reading file\n");
-        fclose(f);
+    // Map the trajectory file
+    TrailFile file;
+    if (trail_file_open(&file, input_file) != 0) {
         return 1;
     }
     
+    int n_rockets = trail_file_count(&file);
+    
     printf("Loading %d rocket trajectories...\n", n_rockets);
     
     // Allocate image
-    Pixel *img = (Pixel *)calloc(WIDTH * HEIGHT, sizeof(Pixel));
+    Pixel *img = (Pixel *)calloc((size_t)view.width * view.height, sizeof(Pixel));
     if (!img) {
         printf("Memory allocation failed\n");
-        fclose(f);
+        trail_file_close(&file);
         return 1;
     }
     
     // Draw grid
-    for (int i = 0; i < WIDTH; i += 50) {
-        for (int j = 0; j < HEIGHT; j++) {
-            img[j * WIDTH + i].r = 30;
-            img[j * WIDTH + i].g = 30;
-            img[j * WIDTH + i].b = 30;
-        }
-    }
-    for (int j = 0; j < HEIGHT; j += 50) {
-        for (int i = 0; i < WIDTH; i++) {
-            img[j * WIDTH + i].r = 30;
-            img[j * WIDTH + i].g = 30;
-            img[j * WIDTH + i].b = 30;
-        }
-    }
+    draw_grid(img, &view, 30);
     
-    // Draw center marker
-    draw_circle(img, WIDTH/2, HEIGHT/2, 5, 255, 255, 100);
-    
-    double scale = 50.0;
+    // Draw center marker (world origin)
+    draw_circle(img, &view, viewport_px(&view, 0.0), viewport_py(&view, 0.0),
+                viewport_radius(&view, 5), 255, 255, 100);
     
     // Colors for different rockets
     unsigned char colors[][3] = {
@@ -196,31 +79,12 @@ int main(int argc, char *argv[]) {
         {255, 100, 150}   // Pink
     };
     
-    // Load and plot each rocket
+    // Plot each rocket straight from the mapped file
     for (int i = 0; i < n_rockets; i++) {
-        int trail_length;
-        if (fread(&trail_length, sizeof(int), 1, f) != 1) {
-            printf("Error reading rocket %d\n", i);
-            break;
-        }
+        long trail_length = trail_file_length(&file, i);
+        if (trail_length == 0) continue;
         
-        double *trail_x = (double *)malloc(trail_length * sizeof(double));
-        double *trail_y = (double *)malloc(trail_length * sizeof(double));
-        
-        if (!trail_x || !trail_y) {
-            printf("Memory allocation failed\n");
-            break;
-        }
-        
-        if (fread(trail_x, sizeof(double), trail_length, f) != trail_length ||
-            fread(trail_y, sizeof(double), trail_length, f) != trail_length) {
-            printf("Error reading trajectory %d\n", i);
-            free(trail_x);
-            free(trail_y);
-            break;
-        }
-        
-        printf("  Rocket %d: %d points\n", i, trail_length);
+        printf("  Rocket %d: %ld points\n", i, trail_length);
         
         // Choose color
         unsigned char r = colors[i % 10][0];
@@ -228,40 +92,49 @@ int main(int argc, char *argv[]) {
         unsigned char b = colors[i % 10][2];
         
         // Draw trajectory
-        for (int j = 0; j < trail_length - 1; j++) {
-            int px1 = (int)(trail_x[j] * scale + WIDTH / 2);
-            int py1 = (int)(trail_y[j] * scale + HEIGHT / 2);
-            int px2 = (int)(trail_x[j + 1] * scale + WIDTH / 2);
-            int py2 = (int)(trail_y[j + 1] * scale + HEIGHT / 2);
+        double x1, y1, x2, y2;
+        trail_file_point(&file, i, 0, &x1, &y1);
+        for (long j = 0; j < trail_length - 1; j++) {
+            trail_file_point(&file, i, j + 1, &x2, &y2);
+            
+            int px1 = viewport_px(&view, x1);
+            int py1 = viewport_py(&view, y1);
+            int px2 = viewport_px(&view, x2);
+            int py2 = viewport_py(&view, y2);
             
             // Gradient effect
-            int brightness = 100 + (155 * j) / trail_length;
+            int brightness = 100 + (int)((155 * j) / trail_length);
             unsigned char br = (r * brightness) / 255;
             unsigned char bg = (g * brightness) / 255;
             unsigned char bb = (b * brightness) / 255;
             
-            draw_line(img, px1, py1, px2, py2, br, bg, bb);
+            draw_line(img, &view, px1, py1, px2, py2, br, bg, bb);
+            x1 = x2;
+            y1 = y2;
         }
         
         // Mark start position
-        int start_x = (int)(trail_x[0] * scale + WIDTH / 2);
-        int start_y = (int)(trail_y[0] * scale + HEIGHT / 2);
-        draw_circle(img, start_x, start_y, 4, 100, 255, 100);
+        double sx, sy, ex, ey;
+        trail_file_point(&file, i, 0, &sx, &sy);
+        trail_file_point(&file, i, trail_length - 1, &ex, &ey);
+        int start_x = viewport_px(&view, sx);
+        int start_y = viewport_py(&view, sy);
+        draw_circle(img, &view, start_x, start_y, viewport_radius(&view, 4), 100, 255, 100);
         
         // Mark end position
-        int end_x = (int)(trail_x[trail_length-1] * scale + WIDTH / 2);
-        int end_y = (int)(trail_y[trail_length-1] * scale + HEIGHT / 2);
-        draw_circle(img, end_x, end_y, 6, r, g, b);
-        
-        free(trail_x);
-        free(trail_y);
+        int end_x = viewport_px(&view, ex);
+        int end_y = viewport_py(&view, ey);
+        draw_circle(img, &view, end_x, end_y, viewport_radius(&view, 6), r, g, b);
     }
     
-    fclose(f);
+    trail_file_close(&file);
     
     // Write output image
-    write_bmp(output_file, img, WIDTH, HEIGHT);
+    int status = write_bmp(output_file, img, view.width, view.height);
     free(img);
+    if (status != 0) {
+        return 1;
+    }
     
     printf("\n====================================\n");
     printf("Plotted trajectories saved to:\n");